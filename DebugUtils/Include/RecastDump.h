@@ -38,5 +38,6 @@ bool duDumpCompactHeightfield(struct rcCompactHeightfield& chf, duFileIO* io);
 bool duReadCompactHeightfield(struct rcCompactHeightfield& chf, duFileIO* io);
 
 void duLogBuildTimes(rcContext& ctx, const int totalTileUsec);
+void duLogAllocStats(rcContext& ctx);
 
 #endif // RECAST_DUMP_H
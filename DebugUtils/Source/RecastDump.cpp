@@ -407,6 +407,44 @@ bool duReadCompactHeightfield(struct rcCompactHeightfield& chf, duFileIO* io)
 }
 
 
+struct BuildStage
+{
+	rcTimerLabel label;
+	const char* name;
+};
+
+static const BuildStage s_buildStages[] =
+{
+	{ RC_TIMER_RASTERIZE_TRIANGLES,		"- Rasterize" },
+	{ RC_TIMER_BUILD_COMPACTHEIGHTFIELD,	"- Build Compact" },
+	{ RC_TIMER_FILTER_BORDER,				"- Filter Border" },
+	{ RC_TIMER_FILTER_WALKABLE,			"- Filter Walkable" },
+	{ RC_TIMER_ERODE_AREA,				"- Erode Area" },
+	{ RC_TIMER_MEDIAN_AREA,				"- Median Area" },
+	{ RC_TIMER_MARK_BOX_AREA,				"- Mark Box Area" },
+	{ RC_TIMER_MARK_CONVEXPOLY_AREA,		"- Mark Convex Area" },
+	{ RC_TIMER_MARK_CYLINDER_AREA,		"- Mark Cylinder Area" },
+	{ RC_TIMER_BUILD_DISTANCEFIELD,		"- Build Distance Field" },
+	{ RC_TIMER_BUILD_DISTANCEFIELD_DIST,	"    - Distance" },
+	{ RC_TIMER_BUILD_DISTANCEFIELD_BLUR,	"    - Blur" },
+	{ RC_TIMER_BUILD_REGIONS,				"- Build Regions" },
+	{ RC_TIMER_BUILD_REGIONS_WATERSHED,	"    - Watershed" },
+	{ RC_TIMER_BUILD_REGIONS_EXPAND,		"      - Expand" },
+	{ RC_TIMER_BUILD_REGIONS_FLOOD,		"      - Find Basins" },
+	{ RC_TIMER_BUILD_REGIONS_STITCH,		"      - Stitch" },
+	{ RC_TIMER_BUILD_REGIONS_FILTER,		"    - Filter" },
+	{ RC_TIMER_BUILD_LAYERS,				"- Build Layers" },
+	{ RC_TIMER_BUILD_CONTOURS,			"- Build Contours" },
+	{ RC_TIMER_BUILD_CONTOURS_TRACE,		"    - Trace" },
+	{ RC_TIMER_BUILD_CONTOURS_SIMPLIFY,	"    - Simplify" },
+	{ RC_TIMER_BUILD_POLYMESH,			"- Build Polymesh" },
+	{ RC_TIMER_BUILD_POLYMESHDETAIL,		"- Build Polymesh Detail" },
+	{ RC_TIMER_MERGE_POLYMESH,			"- Merge Polymeshes" },
+	{ RC_TIMER_MERGE_POLYMESHDETAIL,		"- Merge Polymesh Details" },
+};
+
+static const int s_buildStageCount = sizeof(s_buildStages) / sizeof(s_buildStages[0]);
+
 static void logLine(rcContext& ctx, rcTimerLabel label, const char* name, const float pc)
 {
 	const int t = ctx.getAccumulatedTime(label);
@@ -419,31 +457,24 @@ void duLogBuildTimes(rcContext& ctx, const int totalTimeUsec)
 	const float pc = 100.0f / totalTimeUsec;
  
 	ctx.log(RC_LOG_PROGRESS, "Build Times");
-	logLine(ctx, RC_TIMER_RASTERIZE_TRIANGLES,		"- Rasterize", pc);
-	logLine(ctx, RC_TIMER_BUILD_COMPACTHEIGHTFIELD,	"- Build Compact", pc);
-	logLine(ctx, RC_TIMER_FILTER_BORDER,				"- Filter Border", pc);
-	logLine(ctx, RC_TIMER_FILTER_WALKABLE,			"- Filter Walkable", pc);
-	logLine(ctx, RC_TIMER_ERODE_AREA,				"- Erode Area", pc);
-	logLine(ctx, RC_TIMER_MEDIAN_AREA,				"- Median Area", pc);
-	logLine(ctx, RC_TIMER_MARK_BOX_AREA,				"- Mark Box Area", pc);
-	logLine(ctx, RC_TIMER_MARK_CONVEXPOLY_AREA,		"- Mark Convex Area", pc);
-	logLine(ctx, RC_TIMER_MARK_CYLINDER_AREA,		"- Mark Cylinder Area", pc);
-	logLine(ctx, RC_TIMER_BUILD_DISTANCEFIELD,		"- Build Distance Field", pc);
-	logLine(ctx, RC_TIMER_BUILD_DISTANCEFIELD_DIST,	"    - Distance", pc);
-	logLine(ctx, RC_TIMER_BUILD_DISTANCEFIELD_BLUR,	"    - Blur", pc);
-	logLine(ctx, RC_TIMER_BUILD_REGIONS,				"- Build Regions", pc);
-	logLine(ctx, RC_TIMER_BUILD_REGIONS_WATERSHED,	"    - Watershed", pc);
-	logLine(ctx, RC_TIMER_BUILD_REGIONS_EXPAND,		"      - Expand", pc);
-	logLine(ctx, RC_TIMER_BUILD_REGIONS_FLOOD,		"      - Find Basins", pc);
-	logLine(ctx, RC_TIMER_BUILD_REGIONS_FILTER,		"    - Filter", pc);
-	logLine(ctx, RC_TIMER_BUILD_LAYERS,				"- Build Layers", pc);
-	logLine(ctx, RC_TIMER_BUILD_CONTOURS,			"- Build Contours", pc);
-	logLine(ctx, RC_TIMER_BUILD_CONTOURS_TRACE,		"    - Trace", pc);
-	logLine(ctx, RC_TIMER_BUILD_CONTOURS_SIMPLIFY,	"    - Simplify", pc);
-	logLine(ctx, RC_TIMER_BUILD_POLYMESH,			"- Build Polymesh", pc);
-	logLine(ctx, RC_TIMER_BUILD_POLYMESHDETAIL,		"- Build Polymesh Detail", pc);
-	logLine(ctx, RC_TIMER_MERGE_POLYMESH,			"- Merge Polymeshes", pc);
-	logLine(ctx, RC_TIMER_MERGE_POLYMESHDETAIL,		"- Merge Polymesh Details", pc);
+	for (int i = 0; i < s_buildStageCount; ++i)
+		logLine(ctx, s_buildStages[i].label, s_buildStages[i].name, pc);
 	ctx.log(RC_LOG_PROGRESS, "=== TOTAL:\t%.2fms", totalTimeUsec/1000.0f);
 }
 
+static void logAllocLine(rcContext& ctx, const char* name, const rcAllocCounters& counters)
+{
+	if (counters.allocCount == 0 && counters.peakBytes == 0) return;
+	ctx.log(RC_LOG_PROGRESS, "%s:\t%d allocs\t%.1fkB live\t%.1fkB peak", name, counters.allocCount,
+			counters.liveBytes/1024.0f, counters.peakBytes/1024.0f);
+}
+
+void duLogAllocStats(rcContext& ctx)
+{
+	ctx.log(RC_LOG_PROGRESS, "Memory Usage");
+	for (int i = 0; i < s_buildStageCount; ++i)
+		logAllocLine(ctx, s_buildStages[i].name, ctx.getAllocStats(s_buildStages[i].label));
+	logAllocLine(ctx, "=== PERM", ctx.getAllocStats(RC_ALLOC_PERM));
+	logAllocLine(ctx, "=== TEMP", ctx.getAllocStats(RC_ALLOC_TEMP));
+}
+
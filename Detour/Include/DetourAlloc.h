@@ -46,6 +46,31 @@ typedef void (dtFreeFunc)(void* ptr);
 ///  @param[in]		freeFunc	The memory de-allocation function to be used by #dtFree
 void dtAllocSetCustom(dtAllocFunc *allocFunc, dtFreeFunc *freeFunc);
 
+/// Observes the memory allocated and freed through #dtAlloc and #dtFree on a thread.
+/// The tracker is unbound while its functions run, so it may allocate through #dtAlloc itself.
+/// @see dtAllocSetThreadTracker
+class dtAllocTracker
+{
+public:
+	virtual ~dtAllocTracker() {}
+
+	/// Called after a memory block was allocated.
+	///  @param[in]		ptr		The allocated memory block.
+	///  @param[in]		size	The requested size of the block, in bytes.
+	///  @param[in]		hint	The hint the block was allocated with.
+	virtual void trackAlloc(void* ptr, size_t size, dtAllocHint hint) = 0;
+
+	/// Called before a memory block is freed, including blocks that were allocated before 
+	/// the tracker was bound or on other threads.
+	///  @param[in]		ptr		The memory block about to be freed.
+	virtual void trackFree(void* ptr) = 0;
+};
+
+/// Binds an allocation tracker to the calling thread. Allocations made by other threads are not tracked.
+///  @param[in]		tracker		The tracker to bind, or null to track nothing.
+///  @return The tracker previously bound to the calling thread.
+dtAllocTracker* dtAllocSetThreadTracker(dtAllocTracker* tracker);
+
 /// Allocates a memory block.
 ///  @param[in]		size	The size, in bytes of memory, to allocate.
 ///  @param[in]		hint	A hint to the allocator on how long the memory is expected to be in use.
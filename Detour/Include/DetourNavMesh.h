@@ -99,7 +99,10 @@ static const int DT_MAX_AREAS = 64;
 enum dtTileFlags
 {
 	/// The navigation mesh owns the tile memory and is responsible for freeing it.
-	DT_TILE_FREE_DATA = 0x01
+	DT_TILE_FREE_DATA = 0x01,
+
+	/// The tile was removed, and is kept until the readers are done with it. (See dtNavMesh::initReaders.)
+	DT_TILE_REMOVED = 0x02
 };
 
 /// Vertex flags returned by dtNavMeshQuery::findStraightPath.
@@ -118,10 +121,11 @@ enum dtStraightPathOptions
 };
 
 
-/// Options for dtNavMeshQuery::initSlicedFindPath and updateSlicedFindPath
+/// Options for dtNavMeshQuery::findPath, initSlicedFindPath and updateSlicedFindPath
 enum dtFindPathOptions
 {
-	DT_FINDPATH_ANY_ANGLE	= 0x02		///< use raycasts during pathfind to "shortcut" (raycast still consider costs)
+	DT_FINDPATH_ANY_ANGLE	= 0x02,		///< use raycasts during pathfind to "shortcut" (raycast still consider costs)
+	DT_FINDPATH_BIDIRECTIONAL	= 0x04	///< search from both the start and the end polygon (dtNavMeshQuery::findPath only)
 };
 
 /// Options for dtNavMeshQuery::raycast
@@ -360,6 +364,14 @@ public:
 	/// The navigation mesh initialization params.
 	const dtNavMeshParams* getParams() const;
 
+	/// Indexes the tiles of a grid of locations directly, instead of by a hash of their location.
+	///  @param[in]	minX	The x-location of the first tile of the grid.
+	///  @param[in]	minY	The y-location of the first tile of the grid.
+	///  @param[in]	width	The number of tiles along the x-axis. [Limit: > 0]
+	///  @param[in]	height	The number of tiles along the y-axis. [Limit: > 0]
+	/// @return The status flags for the operation.
+	dtStatus initTileGrid(const int minX, const int minY, const int width, const int height);
+
 	/// Adds a tile to the navigation mesh.
 	///  @param[in]		data		Data for the new tile mesh. (See: #dtCreateNavMeshData)
 	///  @param[in]		dataSize	Data size of the new tile mesh.
@@ -378,6 +390,28 @@ public:
 
 	/// @}
 
+	/// @{
+	/// @name Concurrent Reads
+
+	/// Lets queries on other threads read the navigation mesh while tiles are added and removed.
+	///  @param[in]	maxReaders	The number of reader indices. [Limit: > 0]
+	/// @return The status flags for the operation.
+	dtStatus initReaders(const int maxReaders);
+
+	/// Marks the start of the reads of a reader, before it uses the navigation mesh.
+	///  @param[in]	reader	The index of the reader. [Limit: 0 <= value < maxReaders]
+	void beginRead(const int reader) const;
+
+	/// Marks the end of the reads of a reader, after which it keeps no tile, polygon or link pointer.
+	///  @param[in]	reader	The index of the reader. [Limit: 0 <= value < maxReaders]
+	void endRead(const int reader) const;
+
+	/// Frees the removed tiles and links which no reader can be reading anymore.
+	/// @return The number of removed tiles and links which are still kept for the readers.
+	int reclaim();
+
+	/// @}
+
 	/// @{
 	/// @name Query Functions
 
@@ -616,6 +650,9 @@ private:
 	/// Returns pointer to tile in the tile array.
 	dtMeshTile* getTile(int i);
 
+	/// Returns the head of the list of the tiles at a location, in the grid or in the hash lookup.
+	dtMeshTile** getTileList(const int x, const int y) const;
+
 	/// Returns neighbour tile based on side.
 	int getTilesAt(const int x, const int y,
 				   dtMeshTile** tiles, const int maxTiles) const;
@@ -641,6 +678,17 @@ private:
 	
 	/// Removes external links at specified side.
 	void unconnectLinks(dtMeshTile* tile, dtMeshTile* target);
+	/// Returns the number of links from a tile to another.
+	int countLinks(const dtMeshTile* tile, const dtMeshTile* target) const;
+
+	/// Changes the salt of a tile, which invalidates the references to it.
+	void updateSalt(dtMeshTile* tile);
+	/// Resets a removed tile, frees its data if it owns it and puts it back in the free list.
+	void freeTile(dtMeshTile* tile);
+	/// Makes room for the specified number of retired items.
+	bool reserveRetired(const int count);
+	/// Keeps a removed tile, or one of its links, until the readers of the current epoch are done.
+	void retire(dtMeshTile* tile, const unsigned int link);
 	
 
 	// TODO: These methods are duplicates from dtNavMeshQuery, but are needed for off-mesh connection finding.
@@ -664,8 +712,18 @@ private:
 	int m_tileLutMask;					///< Tile hash lookup mask.
 
 	dtMeshTile** m_posLookup;			///< Tile hash lookup.
+	dtMeshTile** m_gridLookup;			///< Tile grid lookup, null without grid. [Size: m_gridWidth * m_gridHeight]
+	int m_gridMinX, m_gridMinY;			///< The location of the first tile of the grid.
+	int m_gridWidth, m_gridHeight;		///< The number of tiles of the grid.
 	dtMeshTile* m_nextFree;				///< Freelist of tiles.
 	dtMeshTile* m_tiles;				///< List of tiles.
+
+	unsigned int* m_readerEpochs;		///< The epoch each reader is reading in, or zero. [Size: m_maxReaders]
+	int m_maxReaders;					///< The number of readers, zero if there are no concurrent reads.
+	unsigned int m_epoch;				///< The current epoch, advanced after each tile removal.
+	struct dtRetiredItem* m_retired;	///< Removed tiles and links kept for the readers, oldest first.
+	int m_retiredCount;					///< The number of retired items.
+	int m_retiredCapacity;				///< The allocated size of the retired items.
 		
 #ifndef DT_POLYREF64
 	unsigned int m_saltBits;			///< Number of salt bits in the tile ID.
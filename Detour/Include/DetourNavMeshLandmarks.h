@@ -0,0 +1,235 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURNAVMESHLANDMARKS_H
+#define DETOURNAVMESHLANDMARKS_H
+
+#include "DetourNavMesh.h"
+#include "DetourStatus.h"
+
+/// The maximum number of landmarks of a dtNavMeshLandmarks object.
+/// @ingroup detour
+static const int DT_MAX_LANDMARKS = 16;
+
+/// A magic number used to detect compatibility of stored tile landmark distances.
+static const int DT_LANDMARKS_MAGIC = 'D'<<24 | 'N'<<16 | 'L'<<8 | 'M';
+
+/// A version number used to detect compatibility of stored tile landmark distances.
+static const int DT_LANDMARKS_VERSION = 1;
+
+/// Configuration parameters of a dtNavMeshLandmarks object.
+/// @see dtNavMeshLandmarks::init()
+/// @ingroup detour
+struct dtNavMeshLandmarksParams
+{
+	float scale;								///< The length of a unit of the stored distances. [Limit: > 0]
+	int landmarkCount;							///< The number of landmarks. [Limit: 1 <= value <= #DT_MAX_LANDMARKS]
+	float positions[DT_MAX_LANDMARKS*3];		///< The positions of the landmarks. [(x, y, z) * landmarkCount]
+};
+
+/// Distances from a few landmark polygons of a navigation mesh, which give dtNavMeshQuery
+/// a better lower bound of the remaining path cost than the straight line distance.
+/// @ingroup detour
+class dtNavMeshLandmarks
+{
+public:
+	dtNavMeshLandmarks();
+	~dtNavMeshLandmarks();
+
+	/// @{
+	/// @name Initialization and Tile Management
+
+	/// Picks landmarks spread over the navigation mesh and computes the distances of all its tiles.
+	///  @param[in]	nav				The navigation mesh. It must stay valid while the object is used.
+	///  @param[in]	landmarkCount	The number of landmarks. [Limit: 1 <= value <= #DT_MAX_LANDMARKS]
+	/// @return The status flags for the operation.
+	dtStatus build(const dtNavMesh* nav, const int landmarkCount);
+
+	/// Initializes the object without computing any distance, to restore stored tile distances.
+	///  @param[in]	nav			The navigation mesh. It must stay valid while the object is used.
+	///  @param[in]	params		The parameters of the stored distances. (Obtained from #getParams.)
+	/// @return The status flags for the operation.
+	dtStatus init(const dtNavMesh* nav, const dtNavMeshLandmarksParams* params);
+
+	/// The parameters the object was built or initialized with.
+	/// @return The parameters of the object.
+	const dtNavMeshLandmarksParams* getParams() const { return &m_params; }
+
+	/// Computes the distances of a tile which was added to the navigation mesh.
+	///  @param[in]	ref		The reference of the tile.
+	/// @return The status flags for the operation.
+	dtStatus addTile(dtTileRef ref);
+
+	/// Forgets the distances of a tile which was removed from the navigation mesh.
+	///  @param[in]	ref		The reference the tile had.
+	/// @return The status flags for the operation.
+	dtStatus removeTile(dtTileRef ref);
+
+	/// @}
+	/// @{
+	/// @name Serialization
+
+	/// Gets the size of the buffer required by #storeTileLandmarks to store the specified tile's distances.
+	///  @param[in]	tile	The tile.
+	/// @return The size of the buffer required to store the distances.
+	int getTileLandmarksSize(const dtMeshTile* tile) const;
+
+	/// Stores the landmark distances of the tile in the specified buffer.
+	///  @param[in]		tile			The tile.
+	///  @param[out]	data			The buffer to store the tile's distances in.
+	///  @param[in]		maxDataSize		The size of the data buffer. [Limit: >= #getTileLandmarksSize]
+	/// @return The status flags for the operation.
+	dtStatus storeTileLandmarks(const dtMeshTile* tile, unsigned char* data, const int maxDataSize) const;
+
+	/// Restores the landmark distances of the tile.
+	///  @param[in]	tile			The tile.
+	///  @param[in]	data			The distances. (Obtained from #storeTileLandmarks.)
+	///  @param[in]	maxDataSize		The size of the distances within the data buffer.
+	/// @return The status flags for the operation.
+	dtStatus restoreTileLandmarks(const dtMeshTile* tile, const unsigned char* data, const int maxDataSize);
+
+	/// @}
+	/// @{
+	/// @name Distance Bounds
+
+	/// Gets the range of the distances of a polygon to each landmark.
+	///  @param[in]	ref		The reference of the polygon.
+	/// @return The ranges, or null if the polygon's tile has no distances. [(min, max) * landmarkCount]
+	const unsigned short* getPolyBounds(dtPolyRef ref) const;
+
+	/// Returns a lower bound of the length of any path between two polygons.
+	///  @param[in]	from	The distance ranges of the first polygon. (Obtained from #getPolyBounds.)
+	///  @param[in]	to		The distance ranges of the second polygon. (Obtained from #getPolyBounds.)
+	/// @return The lower bound of the path length.
+	float getDistanceBound(const unsigned short* from, const unsigned short* to) const;
+
+	/// Gets the navigation mesh the distances are computed on.
+	/// @return The navigation mesh of the object.
+	const dtNavMesh* getNavMesh() const { return m_nav; }
+
+	/// @}
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtNavMeshLandmarks(const dtNavMeshLandmarks&);
+	dtNavMeshLandmarks& operator=(const dtNavMeshLandmarks&);
+
+	/// Allocates the tile array and frees the previous distances.
+	dtStatus reset(const dtNavMesh* nav);
+
+	/// Allocates the distances of a tile, all unknown.
+	dtStatus allocTile(const dtMeshTile* tile);
+
+	/// Frees the distances of a tile.
+	void freeTile(struct dtLandmarkTile& ltile);
+
+	/// Updates the path vertices of a tile and the one way off-mesh connections ending on its polygons.
+	dtStatus updateLinks(const dtMeshTile* tile);
+
+	/// Updates the centers and radii of the path vertices of a tile.
+	void updatePoints(const dtMeshTile* tile);
+
+	/// Updates the connections ending in the tiles around a location, and marks their ranges to be recomputed.
+	dtStatus updateNeighbourhood(const int x, const int y);
+
+	/// Gets the path vertices of a polygon.
+	int getPolyVertices(const dtMeshTile* tile, unsigned int ip, struct dtLandmarkVertex* verts, const int maxVerts) const;
+
+	/// Recomputes the distance ranges of the polygons of a tile.
+	void updateBounds(const dtMeshTile* tile);
+
+	/// Recomputes the distance ranges of the tiles marked as dirty.
+	void updateDirtyBounds();
+
+	/// Queues a vertex to propagate its distance.
+	bool push(const unsigned int dist, const unsigned int tile, const unsigned int index);
+
+	/// Removes the nearest vertex from the queue.
+	void pop(struct dtLandmarkHeapItem& top);
+
+	/// Lowers the distance of a vertex and queues it, if the new distance is shorter.
+	bool relax(const struct dtLandmarkVertex& vert, unsigned int dist, const int landmark);
+
+	/// Propagates the queued distances of a landmark.
+	dtStatus propagate(const int landmark);
+
+	/// Queues the polygon containing a landmark at distance zero, if it is in the tile.
+	dtStatus seedLandmark(const dtMeshTile* tile, const int landmark);
+
+	const dtNavMesh* m_nav;					///< The navigation mesh.
+	dtNavMeshLandmarksParams m_params;		///< The parameters of the distances.
+	struct dtLandmarkTile* m_tiles;			///< The distances of each tile. [Size: dtNavMesh::getMaxTiles]
+	int m_maxTiles;							///< The size of the tile array.
+
+	struct dtLandmarkHeapItem* m_heap;		///< The queue of vertices to propagate the distance of.
+	int m_heapSize;							///< The number of items in the queue.
+	int m_heapCapacity;						///< The allocated size of the queue.
+};
+
+/// Allocates a landmark object using the Detour allocator.
+/// @return A landmark object that is ready for building, or null on failure.
+/// @ingroup detour
+dtNavMeshLandmarks* dtAllocNavMeshLandmarks();
+
+/// Frees the specified landmark object using the Detour allocator.
+///  @param[in]	landmarks	A landmark object allocated using #dtAllocNavMeshLandmarks
+/// @ingroup detour
+void dtFreeNavMeshLandmarks(dtNavMeshLandmarks* landmarks);
+
+#endif // DETOURNAVMESHLANDMARKS_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtNavMeshLandmarks
+@par
+
+The object stores, for each polygon, the range of the shortest path distances
+from each landmark to the polygon's portal edges and off-mesh connection end
+points. Since a path can't be shorter than the difference of the distances of
+its ends to a landmark, the ranges of two polygons give a lower bound of the
+cost of any path between them. It is much tighter than the straight line
+distance when the path has to go around walls, so dtNavMeshQuery::findPath
+visits fewer nodes when it is given the object with
+dtNavMeshQuery::setLandmarks().
+
+The distances are measured on the xz-plane between the middles of the
+portals, where the path queries place their nodes, with one-way off-mesh
+connections taken as bidirectional. They bound the path costs of any filter
+whose costs are at least the travelled distance, the same assumption as the
+straight line heuristic, but not the length of the straight path, which cuts
+the corners. They are stored as 16 bit integers of
+dtNavMeshLandmarksParams::scale, about 4 times the navigation mesh diagonal
+at most, which makes 2 bytes per landmark for each of the
+#DT_VERTS_PER_POLYGON edges of a polygon and 4 bytes per landmark for its
+range.
+
+The distances stay a valid bound when tiles are removed, since paths can only
+get longer, but every tile added to the navigation mesh must be passed to
+addTile(), which updates the distances it shortens in the other tiles. Tiles
+which the object does not know give no bound. A tile's distances are stored
+with storeTileLandmarks() and restored with restoreTileLandmarks() once all
+the tiles are in the navigation mesh.
+
+@see dtNavMeshQuery::setLandmarks
+
+*/
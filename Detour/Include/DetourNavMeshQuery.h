@@ -27,6 +27,7 @@
 // On certain platforms indirect or virtual function call is expensive. The default
 // setting is to use non-virtual functions, the actual implementations of the functions
 // are declared as inline for maximum speed. 
+// dtNavMeshQuery::findPathT calls the filter without virtual dispatch in either setting.
 
 //#define DT_VIRTUAL_QUERYFILTER 1
 
@@ -146,6 +147,69 @@ struct dtRaycastHit
 	float pathCost;
 };
 
+/// A ray of a batch, see dtNavMeshQuery::raycastBatch.
+/// @ingroup detour
+struct dtRaycastRequest
+{
+	/// The reference id of the start polygon.
+	dtPolyRef startRef;
+
+	/// A position within the start polygon representing the start of the ray. [(x, y, z)]
+	float startPos[3];
+
+	/// The position to cast the ray toward. [(x, y, z)]
+	float endPos[3];
+
+	/// The polygon filter to apply to the ray.
+	const dtQueryFilter* filter;
+
+	/// The parent of the start polygon, used for the cost calculation. [opt]
+	dtPolyRef prevRef;
+};
+
+/// A path query of a batch, see dtNavMeshQuery::findPathBatch.
+/// @ingroup detour
+struct dtPathRequest
+{
+	/// The reference id of the start polygon.
+	dtPolyRef startRef;
+
+	/// The reference id of the end polygon.
+	dtPolyRef endRef;
+
+	/// A position within the start polygon. [(x, y, z)]
+	float startPos[3];
+
+	/// A position within the end polygon. [(x, y, z)]
+	float endPos[3];
+
+	/// The polygon filter to apply to the query.
+	const dtQueryFilter* filter;
+};
+
+/// The result of a path query of a batch, filled by dtNavMeshQuery::findPathBatch.
+/// @ingroup detour
+struct dtPathResult
+{
+	/// The status flags of the polygon path, as returned by dtNavMeshQuery::findPath.
+	dtStatus pathStatus;
+
+	/// The index of the first polygon of the path in the batch path array.
+	int pathOffset;
+
+	/// The number of polygons in the path.
+	int pathCount;
+
+	/// The status flags of the straight path, as returned by dtNavMeshQuery::findStraightPath.
+	dtStatus straightPathStatus;
+
+	/// The index of the first point of the straight path in the batch straight path arrays.
+	int straightPathOffset;
+
+	/// The number of points in the straight path.
+	int straightPathCount;
+};
+
 /// Provides custom polygon query behavior.
 /// Used by dtNavMeshQuery::queryPolygons.
 /// @ingroup detour
@@ -187,10 +251,30 @@ public:
 	///  							[(polyRef) * @p pathCount]
 	///  @param[out]	pathCount	The number of polygons returned in the @p path array.
 	///  @param[in]		maxPath		The maximum number of polygons the @p path array can hold. [Limit: >= 1]
+	///  @param[in]		options		Query options. (see: #dtFindPathOptions)
 	dtStatus findPath(dtPolyRef startRef, dtPolyRef endRef,
 					  const float* startPos, const float* endPos,
 					  const dtQueryFilter* filter,
-					  dtPolyRef* path, int* pathCount, const int maxPath) const;
+					  dtPolyRef* path, int* pathCount, const int maxPath,
+					  const unsigned int options = 0) const;
+
+	/// Finds a path from the start polygon to the end polygon, calling the filter without virtual dispatch.
+	/// Only instantiated for dtQueryFilter.
+	///  @param[in]		startRef	The reference id of the start polygon.
+	///  @param[in]		endRef		The reference id of the end polygon.
+	///  @param[in]		startPos	A position within the start polygon. [(x, y, z)]
+	///  @param[in]		endPos		A position within the end polygon. [(x, y, z)]
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[out]	path		An ordered list of polygon references representing the path. (Start to end.) 
+	///  							[(polyRef) * @p pathCount]
+	///  @param[out]	pathCount	The number of polygons returned in the @p path array.
+	///  @param[in]		maxPath		The maximum number of polygons the @p path array can hold. [Limit: >= 1]
+	/// @returns The status flags for the query.
+	template <class Filter>
+	dtStatus findPathT(dtPolyRef startRef, dtPolyRef endRef,
+					   const float* startPos, const float* endPos,
+					   const Filter* filter,
+					   dtPolyRef* path, int* pathCount, const int maxPath) const;
 
 	/// Finds the straight path from the start to the end position within the polygon corridor.
 	///  @param[in]		startPos			Path start position. [(x, y, z)]
@@ -209,6 +293,45 @@ public:
 							  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
 							  int* straightPathCount, const int maxStraightPath, const int options = 0) const;
 
+	/// Finds the straight path from the start to the end position within the polygon corridor,
+	/// reusing the portals of the corridor kept in a portal cache.
+	///  @param[in]		startPos			Path start position. [(x, y, z)]
+	///  @param[in]		endPos				Path end position. [(x, y, z)]
+	///  @param[in]		path				An array of polygon references that represent the path corridor.
+	///  @param[in]		pathSize			The number of polygons in the @p path array.
+	///  @param[in,out]	portals				The portals of the previous path, updated to the portals of @p path. [opt]
+	///  @param[out]	straightPath		Points describing the straight path. [(x, y, z) * @p straightPathCount].
+	///  @param[out]	straightPathFlags	Flags describing each point. (See: #dtStraightPathFlags) [opt]
+	///  @param[out]	straightPathRefs	The reference id of the polygon that is being entered at each point. [opt]
+	///  @param[out]	straightPathCount	The number of points in the straight path.
+	///  @param[in]		maxStraightPath		The maximum number of points the straight path arrays can hold.  [Limit: > 0]
+	///  @param[in]		options				Query options. (see: #dtStraightPathOptions)
+	/// @returns The status flags for the query.
+	dtStatus findStraightPath(const float* startPos, const float* endPos,
+							  const dtPolyRef* path, const int pathSize, class dtPortalCache* portals,
+							  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
+							  int* straightPathCount, const int maxStraightPath, const int options = 0) const;
+
+	/// Finds the polygon paths, and optionally the straight paths, of a batch of path queries.
+	///  @param[in]		requests			The path queries. [(dtPathRequest) * @p requestCount]
+	///  @param[in]		requestCount		The number of path queries.
+	///  @param[out]	results				The results of the queries, in the order of @p requests.
+	///  									[(dtPathResult) * @p requestCount]
+	///  @param[out]	path				The polygon paths of all the queries, see dtPathResult::pathOffset.
+	///  									[(polyRef) * @p maxPath]
+	///  @param[in]		maxPath				The maximum number of polygons the @p path array can hold. [Limit: >= 1]
+	///  @param[out]	straightPath		The straight paths of all the queries, see dtPathResult::straightPathOffset.
+	///  									[(x, y, z) * @p maxStraightPath] [opt]
+	///  @param[out]	straightPathFlags	Flags describing each point. (See: #dtStraightPathFlags) [opt]
+	///  @param[out]	straightPathRefs	The reference id of the polygon that is being entered at each point. [opt]
+	///  @param[in]		maxStraightPath		The maximum number of points the straight path arrays can hold.
+	///  @param[in]		options				Straight path query options. (see: #dtStraightPathOptions)
+	/// @returns The status flags for the batch.
+	dtStatus findPathBatch(const dtPathRequest* requests, const int requestCount, dtPathResult* results,
+						   dtPolyRef* path, const int maxPath,
+						   float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
+						   const int maxStraightPath, const int options = 0) const;
+
 	///@}
 	/// @name Sliced Pathfinding Functions
 	/// Common use case:
@@ -422,6 +545,17 @@ public:
 					 const dtQueryFilter* filter, const unsigned int options,
 					 dtRaycastHit* hit, dtPolyRef prevRef = 0) const;
 
+	/// Casts a batch of 'walkability' rays along the surface of the navigation mesh.
+	///  @param[in]		requests		The rays. [(dtRaycastRequest) * @p requestCount]
+	///  @param[in]		requestCount	The number of rays.
+	///  @param[in]		options			govern how the raycasts behave. See dtRaycastOptions
+	///  @param[in,out]	hits			The hit of each ray, in the order of @p requests. The path and maxPath
+	///  								of each hit are set by the caller, as for raycast(). [(dtRaycastHit) * @p requestCount]
+	///  @param[out]	statuses		The status flags of each ray, as returned by raycast(). [(dtStatus) * @p requestCount] [opt]
+	/// @returns The status flags for the batch.
+	dtStatus raycastBatch(const dtRaycastRequest* requests, const int requestCount, const unsigned int options,
+						  dtRaycastHit* hits, dtStatus* statuses) const;
+
 
 	/// Finds the distance from the specified position to the nearest polygon wall.
 	///  @param[in]		startRef		The reference id of the polygon containing @p centerPos.
@@ -515,11 +649,31 @@ public:
 	/// Gets the node pool.
 	/// @returns The node pool.
 	class dtNodePool* getNodePool() const { return m_nodePool; }
+
+	/// Gets the node pool of the search from the end polygon of a bidirectional path query.
+	/// @returns The node pool, or null before the first bidirectional query.
+	class dtNodePool* getReverseNodePool() const { return m_reverseNodePool; }
 	
 	/// Gets the navigation mesh the query object is using.
 	/// @return The navigation mesh the query object is using.
 	const dtNavMesh* getAttachedNavMesh() const { return m_nav; }
 
+	/// Sets the landmark distances which bound the remaining cost of findPath and sliced path queries.
+	///  @param[in]		landmarks	The landmarks of the navigation mesh, or null to only use the straight line distance.
+	void setLandmarks(const class dtNavMeshLandmarks* landmarks) { m_landmarks = landmarks; }
+
+	/// Gets the landmark distances of the path queries.
+	/// @return The landmark distances, or null if there are none.
+	const class dtNavMeshLandmarks* getLandmarks() const { return m_landmarks; }
+
+	/// Sets the wall field which narrows the search of findDistanceToWall.
+	///  @param[in]		field		The wall field of the navigation mesh, or null to search the whole radius.
+	void setWallField(const class dtNavMeshWallField* field) { m_wallField = field; }
+
+	/// Gets the wall field of findDistanceToWall.
+	/// @return The wall field, or null if there is none.
+	const class dtNavMeshWallField* getWallField() const { return m_wallField; }
+
 	/// @}
 	
 private:
@@ -549,15 +703,68 @@ private:
 						  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
 						  int* straightPathCount, const int maxStraightPath) const;
 
+	// Keeps the portals of a portal cache which are still those of a path.
+	void updatePortalCache(class dtPortalCache* portals, const dtPolyRef* path, const int pathSize) const;
+
+	// Returns the portal between path[i] and path[i+1], from the portal cache if there is one.
+	dtStatus getPathPortal(class dtPortalCache* portals, const dtPolyRef* path, const int i,
+						   float* left, float* right, unsigned char& toType,
+						   unsigned char& fromArea, unsigned char& toArea) const;
+
 	// Appends intermediate portal points to a straight path.
-	dtStatus appendPortals(const int startIdx, const int endIdx, const float* endPos, const dtPolyRef* path,
+	dtStatus appendPortals(class dtPortalCache* portals, const int startIdx, const int endIdx, const float* endPos, const dtPolyRef* path,
 						   float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
 						   int* straightPathCount, const int maxStraightPath, const int options) const;
 
+	// Casts a ray, reading the polygons from the polygon cache of a raycast batch if there is one.
+	dtStatus raycastPolys(dtPolyRef startRef, const float* startPos, const float* endPos,
+						  const dtQueryFilter* filter, const unsigned int options,
+						  dtRaycastHit* hit, dtPolyRef prevRef, struct dtRaycastPoly* polyCache) const;
+
+	// Returns the landmark distance ranges of the end polygon of a path query, or null if there are none.
+	const unsigned short* getLandmarkBounds(dtPolyRef endRef) const;
+
+	// Returns the estimated cost from a node to the end of a path query.
+	float getHeuristic(dtPolyRef ref, const float* pos, const float* endPos, const unsigned short* endBounds) const;
+
+	// The search of findPath and findPathT, once the input is checked.
+	template <class Filter>
+	dtStatus searchPath(dtPolyRef startRef, dtPolyRef endRef,
+						const float* startPos, const float* endPos,
+						const Filter* filter,
+						dtPolyRef* path, int* pathCount, const int maxPath) const;
+
 	// Gets the path leading to the specified end node.
 	dtStatus getPathToNode(struct dtNode* endNode, dtPolyRef* path, int* pathCount, int maxPath) const;
+
+	// Finds the distance to the nearest wall within a radius, found is set if there is one.
+	dtStatus searchDistanceToWall(dtPolyRef startRef, const float* centerPos, const float maxRadius,
+								  const dtQueryFilter* filter,
+								  float* hitDist, float* hitPos, float* hitNormal, bool* found) const;
+
+	// Frees the node pool and the open list of the search from the end of bidirectional queries.
+	void freeReverseSearch() const;
+
+	// Bidirectional version of findPath, see DT_FINDPATH_BIDIRECTIONAL.
+	dtStatus findPathBidirectional(dtPolyRef startRef, dtPolyRef endRef,
+								   const float* startPos, const float* endPos,
+								   const dtQueryFilter* filter,
+								   dtPolyRef* path, int* pathCount, const int maxPath) const;
+
+	// Expands a node of one of the searches of findPathBidirectional.
+	void expandBidirectionalNode(struct dtNode* bestNode, const bool reverse, struct dtBidirectionalSearch& search) const;
+
+	// Returns the cost of the path through the adjacent nodes of the searches from the start and the end.
+	float getMeetingCost(const struct dtNode* forwardNode, const struct dtNode* reverseNode,
+						 const dtQueryFilter* filter) const;
+
+	// Gets the path through the adjacent nodes of the searches from the start and the end.
+	dtStatus getPathThroughNodes(struct dtNode* forwardNode, struct dtNode* reverseNode,
+								 dtPolyRef* path, int* pathCount, int maxPath) const;
 	
 	const dtNavMesh* m_nav;				///< Pointer to navmesh data.
+	const class dtNavMeshLandmarks* m_landmarks;	///< Landmark distances of the path queries, or null.
+	const class dtNavMeshWallField* m_wallField;	///< Nearest walls of findDistanceToWall, or null.
 
 	struct dtQueryData
 	{
@@ -575,6 +782,9 @@ private:
 	class dtNodePool* m_tinyNodePool;	///< Pointer to small node pool.
 	class dtNodePool* m_nodePool;		///< Pointer to node pool.
 	class dtNodeQueue* m_openList;		///< Pointer to open list queue.
+	// Allocated by the first bidirectional path query, which is const.
+	mutable class dtNodePool* m_reverseNodePool;	///< Pointer to node pool of the search from the end of a bidirectional query.
+	mutable class dtNodeQueue* m_reverseOpenList;	///< Pointer to open list queue of the search from the end of a bidirectional query.
 };
 
 /// Allocates a query object using the Detour allocator.
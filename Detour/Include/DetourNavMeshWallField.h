@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURNAVMESHWALLFIELD_H
+#define DETOURNAVMESHWALLFIELD_H
+
+#include "DetourNavMesh.h"
+#include "DetourStatus.h"
+
+class dtQueryFilter;
+
+/// Configuration parameters of a dtNavMeshWallField object.
+/// @see dtNavMeshWallField::build()
+/// @ingroup detour
+struct dtNavMeshWallFieldParams
+{
+	float cellSize;					///< The xz-size of the cells of the field. [Limit: > 0] [Units: wu]
+	unsigned short includeFlags;	///< The include flags of the filters the walls are found for. (See dtQueryFilter)
+	unsigned short excludeFlags;	///< The exclude flags of the filters the walls are found for. (See dtQueryFilter)
+};
+
+/// The nearest wall of each cell of a grid over the tiles of a navigation mesh,
+/// which lets dtNavMeshQuery::findDistanceToWall start its search with a small radius.
+/// @ingroup detour
+class dtNavMeshWallField
+{
+public:
+	dtNavMeshWallField();
+	~dtNavMeshWallField();
+
+	/// @{
+	/// @name Initialization and Tile Management
+
+	/// Finds the nearest walls of the cells of all the tiles of the navigation mesh.
+	///  @param[in]	nav			The navigation mesh. It must stay valid while the object is used.
+	///  @param[in]	params		The parameters of the field.
+	/// @return The status flags for the operation.
+	dtStatus build(const dtNavMesh* nav, const dtNavMeshWallFieldParams* params);
+
+	/// The parameters the field was built with.
+	/// @return The parameters of the field.
+	const dtNavMeshWallFieldParams* getParams() const { return &m_params; }
+
+	/// Finds the nearest walls of a tile which was added to the navigation mesh, and of its neighbours.
+	///  @param[in]	ref		The reference of the tile.
+	/// @return The status flags for the operation.
+	dtStatus addTile(dtTileRef ref);
+
+	/// Forgets the walls of a tile which was removed from the navigation mesh, and updates its neighbours.
+	///  @param[in]	ref		The reference the tile had.
+	/// @return The status flags for the operation.
+	dtStatus removeTile(dtTileRef ref);
+
+	/// @}
+	/// @{
+	/// @name Wall Distances
+
+	/// Returns true if the walls of the field are those of a filter.
+	///  @param[in]	filter	The filter.
+	/// @return True if the filter has the flags of the field.
+	bool matchesFilter(const dtQueryFilter* filter) const;
+
+	/// Gets the distance to the wall of the tile of a polygon nearest to the cell of a position.
+	///  @param[in]		ref		The reference of the polygon containing the position.
+	///  @param[in]		pos		The position. [(x, y, z)]
+	///  @param[out]	dist	The distance on the xz-plane from the position to the wall.
+	/// @return True if the field knows a wall of the tile.
+	bool getWallDistance(dtPolyRef ref, const float* pos, float* dist) const;
+
+	/// Gets the navigation mesh the field is built on.
+	/// @return The navigation mesh of the field.
+	const dtNavMesh* getNavMesh() const { return m_nav; }
+
+	/// The memory used by the field.
+	/// @return The size of the allocated memory, in bytes.
+	int getMemoryUsed() const;
+
+	/// @}
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtNavMeshWallField(const dtNavMeshWallField&);
+	dtNavMeshWallField& operator=(const dtNavMeshWallField&);
+
+	/// Frees the walls of a tile.
+	void freeTile(struct dtWallFieldTile& wtile);
+
+	/// Finds the walls of a tile and the nearest one of each cell.
+	dtStatus buildTile(const dtMeshTile* tile);
+
+	/// Rebuilds the tiles around a location.
+	dtStatus buildNeighbours(const int x, const int y);
+
+	const dtNavMesh* m_nav;					///< The navigation mesh.
+	dtNavMeshWallFieldParams m_params;		///< The parameters of the field.
+	struct dtWallFieldTile* m_tiles;		///< The walls of each tile. [Size: dtNavMesh::getMaxTiles]
+	int m_maxTiles;							///< The size of the tile array.
+};
+
+/// Allocates a wall field object using the Detour allocator.
+/// @return A wall field object that is ready for building, or null on failure.
+/// @ingroup detour
+dtNavMeshWallField* dtAllocNavMeshWallField();
+
+/// Frees the specified wall field object using the Detour allocator.
+///  @param[in]	field	A wall field object allocated using #dtAllocNavMeshWallField
+/// @ingroup detour
+void dtFreeNavMeshWallField(dtNavMeshWallField* field);
+
+#endif // DETOURNAVMESHWALLFIELD_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtNavMeshWallField
+@par
+
+The field divides the xz-bounds of each tile into cells of
+dtNavMeshWallFieldParams::cellSize, and stores for each cell the index of
+the wall edge of the tile nearest to its center. Wall edges are the edges of
+the polygons passing the flags of the field which don't lead to another
+polygon passing them, as for dtNavMeshQuery::findDistanceToWall with a
+filter of the same flags. The field takes 2 bytes per cell and 24 bytes per
+wall edge, see getMemoryUsed().
+
+dtNavMeshQuery::findDistanceToWall searches for the walls within the circle
+it is given, and expands to the polygons whose portals touch the circle,
+shrinking it to the nearest wall found so far. Given the field with
+dtNavMeshQuery::setWallField(), it first searches within the distance to the
+wall of the cell of the center, which covers far fewer polygons in open
+areas, and only searches the whole circle if that finds no wall, e.g. when
+the wall is on another level of the tile. Since any wall found this way is
+at least as near as the nearest wall the whole search would find, the
+results are the same, the field only changes how fast they are found.
+
+For the same reason a field which is out of date gives the same results, but
+it should be told about the tiles added to and removed from the navigation
+mesh with addTile() and removeTile(), which also update the walls of the
+neighbour tiles. Only the walls of a polygon's own tile are considered, so
+the cells near the tile borders may point to farther walls than those of the
+neighbour tiles.
+
+@see dtNavMeshQuery::setWallField, dtNavMeshQuery::findDistanceToWall
+
+*/
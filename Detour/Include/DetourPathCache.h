@@ -0,0 +1,181 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURPATHCACHE_H
+#define DETOURPATHCACHE_H
+
+#include "DetourNavMesh.h"
+#include "DetourStatus.h"
+
+class dtNavMeshQuery;
+class dtQueryFilter;
+
+/// A function returning the current time in any unit, used to measure the latency of the path cache.
+/// @see dtPathCache::setTimer
+typedef double (dtPathCacheTimerFunc)();
+
+/// Counters of a dtPathCache, since it was initialized or since dtPathCache::resetStats was called.
+/// @ingroup detour
+struct dtPathCacheStats
+{
+	unsigned int hits;			///< Queries answered from the cache.
+	unsigned int misses;		///< Queries passed to dtNavMeshQuery::findPath.
+	unsigned int stale;			///< Cached paths dropped because a tile they cross was removed. (Counted in the misses.)
+	unsigned int stores;		///< Paths added to the cache.
+	unsigned int evictions;		///< Least recently used paths dropped to make room for new ones.
+	double hitTime;				///< Total time of the hits, in the unit of the timer. (Zero without timer.)
+	double missTime;			///< Total time of the misses, in the unit of the timer. (Zero without timer.)
+};
+
+/// A cache of the polygon paths found between polygons, for agents which travel
+/// the same routes over and over.
+/// @ingroup detour
+class dtPathCache
+{
+public:
+	dtPathCache();
+	~dtPathCache();
+
+	/// Initializes the cache.
+	///  @param[in]	nav				The navigation mesh the paths are found on.
+	///  @param[in]	maxPaths		The maximum number of cached paths. [Limit: 0 < value < 65535]
+	///  @param[in]	maxPathSize		The maximum number of polygons of a cached path. Longer paths are not cached. [Limit: > 0]
+	/// @returns The status flags for the operation.
+	dtStatus init(const dtNavMesh* nav, const int maxPaths, const int maxPathSize);
+
+	/// Finds a polygon path from the start to the end polygon, from the cache if it holds one
+	/// for the same polygons and filter, otherwise with dtNavMeshQuery::findPath, whose complete
+	/// paths are then cached.
+	///  @param[in]		query		The query object to find the paths with. It must use the cache's navigation mesh.
+	///  @param[in]		startRef	The reference id of the start polygon.
+	///  @param[in]		endRef		The reference id of the end polygon.
+	///  @param[in]		startPos	A position within the start polygon. [(x, y, z)]
+	///  @param[in]		endPos		A position within the end polygon. [(x, y, z)]
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[out]	path		An ordered list of polygon references representing the path. (Start to end.)
+	///  							[(polyRef) * @p pathCount]
+	///  @param[out]	pathCount	The number of polygons returned in the @p path array.
+	///  @param[in]		maxPath		The maximum number of polygons the @p path array can hold. [Limit: >= 1]
+	/// @returns The status flags for the query.
+	dtStatus findPath(const dtNavMeshQuery* query, dtPolyRef startRef, dtPolyRef endRef,
+					  const float* startPos, const float* endPos, const dtQueryFilter* filter,
+					  dtPolyRef* path, int* pathCount, const int maxPath);
+
+	/// Removes all the cached paths.
+	void clear();
+
+	/// Returns the signature of a filter, which is part of the key of the cached paths.
+	///  @param[in]	filter	The filter.
+	/// @returns The hash of the filter's flags and area costs.
+	static unsigned int getFilterSignature(const dtQueryFilter* filter);
+
+	/// Sets the function used to measure the latency of the queries, or null not to measure it.
+	///  @param[in]	timer	The timer function.
+	void setTimer(dtPathCacheTimerFunc* timer) { m_timer = timer; }
+
+	/// The counters of the cache.
+	/// @returns The counters since the cache was initialized or the last call to #resetStats.
+	const dtPathCacheStats& getStats() const { return m_stats; }
+
+	/// Resets the counters of the cache.
+	void resetStats();
+
+	/// The number of paths in the cache.
+	/// @returns The number of cached paths.
+	int getPathCount() const { return m_pathCount; }
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtPathCache(const dtPathCache&);
+	dtPathCache& operator=(const dtPathCache&);
+
+	/// Finds the cached path of a key, or returns -1.
+	int findEntry(dtPolyRef startRef, dtPolyRef endRef, unsigned int signature) const;
+
+	/// Returns true if all the polygons of a cached path are still in the navigation mesh.
+	bool isEntryValid(const int idx) const;
+
+	/// Removes a path from the cache.
+	void removeEntry(const int idx);
+
+	/// Adds a path to the cache, evicting the least recently used one if it is full.
+	void addEntry(dtPolyRef startRef, dtPolyRef endRef, unsigned int signature, const dtPolyRef* path, const int pathCount);
+
+	/// Makes a path the most recently used one.
+	void touchEntry(const int idx);
+
+	void unlinkLru(const int idx);
+	void linkLru(const int idx);
+
+	const dtNavMesh* m_nav;
+	struct dtPathCacheEntry* m_entries;	///< The cached paths. [Size: m_maxPaths]
+	dtPolyRef* m_paths;					///< The polygons of the cached paths. [Size: m_maxPaths * m_maxPathSize]
+	unsigned short* m_buckets;			///< The first entry of each hash bucket. [Size: m_hashSize]
+	int m_maxPaths;
+	int m_maxPathSize;
+	int m_hashSize;
+	int m_pathCount;
+	unsigned short m_free;				///< The first unused entry.
+	unsigned short m_lruHead;			///< The most recently used entry.
+	unsigned short m_lruTail;			///< The least recently used entry.
+
+	dtPathCacheTimerFunc* m_timer;
+	dtPathCacheStats m_stats;
+};
+
+/// Allocates a path cache object using the Detour allocator.
+/// @return An allocated path cache object, or null on failure.
+/// @ingroup detour
+dtPathCache* dtAllocPathCache();
+
+/// Frees the specified path cache object using the Detour allocator.
+///  @param[in]	cache	A path cache object allocated using #dtAllocPathCache
+/// @ingroup detour
+void dtFreePathCache(dtPathCache* cache);
+
+#endif // DETOURPATHCACHE_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtPathCache
+@par
+
+The cache keeps the most recently used polygon paths, keyed by their start
+and end polygons and the signature of their filter. The start and end
+positions are not part of the key, so a cached path is the one found for the
+positions of the first query between the two polygons. Only complete paths
+are cached.
+
+A cached path is checked when it is used. If any of its polygons is no longer
+valid, e.g. because dtNavMesh::removeTile removed its tile, which changes the
+tile's salt, the path is dropped and found again. Tiles added to the
+navigation mesh don't invalidate the cached paths, even where they would make
+them shorter, call clear() for the paths to take them into account.
+
+The signature of a filter covers the fields of dtQueryFilter. A custom filter
+with state of its own, see #DT_VIRTUAL_QUERYFILTER, should get a cache of its
+own.
+
+@see dtNavMeshQuery::findPath
+
+*/
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURPORTALCACHE_H
+#define DETOURPORTALCACHE_H
+
+#include "DetourNavMesh.h"
+#include "DetourStatus.h"
+
+/// The portals between the polygons of a path corridor, kept across calls to
+/// dtNavMeshQuery::findStraightPath while the corridor doesn't change.
+/// @ingroup detour
+class dtPortalCache
+{
+public:
+	dtPortalCache();
+	~dtPortalCache();
+
+	/// Initializes the cache.
+	///  @param[in]	maxPathSize		The maximum number of polygons of the cached path. The portals
+	///  							past them are not cached. [Limit: > 0]
+	/// @returns The status flags for the operation.
+	dtStatus init(const int maxPathSize);
+
+	/// Removes the cached portals.
+	void clear();
+
+	/// The number of cached portals.
+	/// @returns The number of portals extracted for the current path.
+	int getPortalCount() const { return m_portalCount; }
+
+	/// The number of portals extracted from the navigation mesh since the cache was initialized.
+	/// @returns The number of extracted portals.
+	unsigned int getExtractCount() const { return m_extractCount; }
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtPortalCache(const dtPortalCache&);
+	dtPortalCache& operator=(const dtPortalCache&);
+
+	friend class dtNavMeshQuery;
+
+	const dtNavMesh* m_nav;			///< The navigation mesh of the cached portals.
+	dtPolyRef* m_path;				///< The polygons of the path. [Size: m_maxPathSize]
+	unsigned char* m_types;			///< The type of the polygon each portal leads to. [Size: m_maxPathSize]
+	unsigned char* m_areas;			///< The area of each polygon of the path. [Size: m_maxPathSize]
+	float* m_left;					///< The left point of each portal. [(x, y, z) * m_maxPathSize]
+	float* m_right;					///< The right point of each portal. [(x, y, z) * m_maxPathSize]
+	int m_maxPathSize;
+	int m_pathSize;					///< The number of polygons of the path in m_path.
+	int m_portalCount;				///< The number of portals extracted, from the start of the path.
+	unsigned int m_extractCount;
+};
+
+/// Allocates a portal cache object using the Detour allocator.
+/// @return An allocated portal cache object, or null on failure.
+/// @ingroup detour
+dtPortalCache* dtAllocPortalCache();
+
+/// Frees the specified portal cache object using the Detour allocator.
+///  @param[in]	cache	A portal cache object allocated using #dtAllocPortalCache
+/// @ingroup detour
+void dtFreePortalCache(dtPortalCache* cache);
+
+#endif // DETOURPORTALCACHE_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtPortalCache
+@par
+
+dtNavMeshQuery::findStraightPath gets the portal between each pair of
+polygons of the path, walking the links of the first polygon, and gets them
+again for the polygons it goes back to each time the funnel moves its apex.
+Given a portal cache, the portals are extracted once, in order along the path
+and only as far as the funnel goes, into contiguous arrays which the funnel
+then reads.
+
+The cache is updated by each call with the path it is given. Portals are kept
+for the polygons the path has in common with the cached path, including when
+polygons were removed from the start of the path, as dtPathCorridor does as
+the agent moves. A portal is dropped when one of its polygons is no longer
+valid, e.g. because dtNavMesh::removeTile removed its tile. The areas of the
+polygons are cached with the portals, call clear() after changing them with
+dtNavMesh::setPolyArea.
+
+A cache holds the portals of one path at a time, e.g. one per path corridor.
+
+@see dtNavMeshQuery::findStraightPath, dtPathCorridor::findCorners
+
+*/
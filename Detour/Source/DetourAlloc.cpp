@@ -32,19 +32,52 @@ static void dtFreeDefault(void *ptr)
 static dtAllocFunc* sAllocFunc = dtAllocDefault;
 static dtFreeFunc* sFreeFunc = dtFreeDefault;
 
+// Thread local storage without relying on C++11.
+#if defined(_MSC_VER)
+#	define DT_THREAD_LOCAL __declspec(thread)
+#else
+#	define DT_THREAD_LOCAL __thread
+#endif
+
+// The allocation tracker bound to the calling thread.
+static DT_THREAD_LOCAL dtAllocTracker* sThreadTracker = 0;
+
 void dtAllocSetCustom(dtAllocFunc *allocFunc, dtFreeFunc *freeFunc)
 {
 	sAllocFunc = allocFunc ? allocFunc : dtAllocDefault;
 	sFreeFunc = freeFunc ? freeFunc : dtFreeDefault;
 }
 
+dtAllocTracker* dtAllocSetThreadTracker(dtAllocTracker* tracker)
+{
+	dtAllocTracker* previous = sThreadTracker;
+	sThreadTracker = tracker;
+	return previous;
+}
+
 void* dtAlloc(size_t size, dtAllocHint hint)
 {
-	return sAllocFunc(size, hint);
+	void* ptr = sAllocFunc(size, hint);
+	if (sThreadTracker && ptr)
+	{
+		dtAllocTracker* tracker = sThreadTracker;
+		sThreadTracker = 0;
+		tracker->trackAlloc(ptr, size, hint);
+		sThreadTracker = tracker;
+	}
+	return ptr;
 }
 
 void dtFree(void* ptr)
 {
-	if (ptr)
-		sFreeFunc(ptr);
+	if (!ptr)
+		return;
+	if (sThreadTracker)
+	{
+		dtAllocTracker* tracker = sThreadTracker;
+		sThreadTracker = 0;
+		tracker->trackFree(ptr);
+		sThreadTracker = tracker;
+	}
+	sFreeFunc(ptr);
 }
@@ -27,6 +27,10 @@
 #include "DetourAssert.h"
 #include <new>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 
 inline bool overlapSlabs(const float* amin, const float* amax,
 						 const float* bmin, const float* bmax,
@@ -134,6 +138,51 @@ inline void freeLink(dtMeshTile* tile, unsigned int link)
 	tile->linksFreeList = link;
 }
 
+// Memory ordering between the thread changing the tiles and the threads reading them.
+// The readers use plain loads, and rely on the dependency of the loaded data on the
+// index or pointer published by dtPublish().
+#if defined(_MSC_VER)
+inline unsigned int dtLoadEpoch(unsigned int* p)
+{
+	return (unsigned int)_InterlockedOr((volatile long*)p, 0);
+}
+inline void dtStoreEpoch(unsigned int* p, unsigned int v)
+{
+	_InterlockedExchange((volatile long*)p, (long)v);
+}
+template<class T> inline void dtPublish(T* p, T v)
+{
+	_ReadWriteBarrier();
+	*(volatile T*)p = v;
+}
+#elif defined(__GNUC__) || defined(__clang__)
+inline unsigned int dtLoadEpoch(unsigned int* p)
+{
+	return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+inline void dtStoreEpoch(unsigned int* p, unsigned int v)
+{
+	__atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+}
+template<class T> inline void dtPublish(T* p, T v)
+{
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+#else
+// No concurrent reads on other compilers.
+inline unsigned int dtLoadEpoch(unsigned int* p) { return *(volatile unsigned int*)p; }
+inline void dtStoreEpoch(unsigned int* p, unsigned int v) { *(volatile unsigned int*)p = v; }
+template<class T> inline void dtPublish(T* p, T v) { *(volatile T*)p = v; }
+#endif
+
+// A removed tile, or link of a tile, which readers may still be reading.
+struct dtRetiredItem
+{
+	dtMeshTile* tile;
+	unsigned int link;		// The link, or DT_NULL_LINK for the tile itself.
+	unsigned int epoch;		// The epoch it was removed in.
+};
+
 
 dtNavMesh* dtAllocNavMesh()
 {
@@ -181,6 +230,7 @@ Notes:
   to have only a single tile.
 - This class does not implement any asynchronous methods. So the ::dtStatus result of all methods will 
   always contain either a success or failure flag.
+- Queries can run on other threads while tiles are added and removed, see #initReaders.
 
 @see dtNavMeshQuery, dtCreateNavMeshData, dtNavMeshCreateParams, #dtAllocNavMesh, #dtFreeNavMesh
 */
@@ -192,8 +242,19 @@ dtNavMesh::dtNavMesh() :
 	m_tileLutSize(0),
 	m_tileLutMask(0),
 	m_posLookup(0),
+	m_gridLookup(0),
+	m_gridMinX(0),
+	m_gridMinY(0),
+	m_gridWidth(0),
+	m_gridHeight(0),
 	m_nextFree(0),
-	m_tiles(0)
+	m_tiles(0),
+	m_readerEpochs(0),
+	m_maxReaders(0),
+	m_epoch(1),
+	m_retired(0),
+	m_retiredCount(0),
+	m_retiredCapacity(0)
 {
 #ifndef DT_POLYREF64
 	m_saltBits = 0;
@@ -218,7 +279,10 @@ dtNavMesh::~dtNavMesh()
 		}
 	}
 	dtFree(m_posLookup);
+	dtFree(m_gridLookup);
 	dtFree(m_tiles);
+	dtFree(m_readerEpochs);
+	dtFree(m_retired);
 }
 		
 dtStatus dtNavMesh::init(const dtNavMeshParams* params)
@@ -300,6 +364,76 @@ const dtNavMeshParams* dtNavMesh::getParams() const
 	return &m_params;
 }
 
+/// @par
+///
+/// The grid lookup skips the hash of the location, the walk over the other
+/// locations with the same hash and the check of their location, for the tiles
+/// which are inside the grid. It costs a pointer per location, which suits
+/// meshes where most locations of the grid have tiles. The tiles outside the
+/// grid are still found with the hash lookup.
+///
+/// The tiles already in the navigation mesh are moved to the grid. The
+/// function must not be called while readers are reading. (See #initReaders.)
+dtStatus dtNavMesh::initTileGrid(const int minX, const int minY, const int width, const int height)
+{
+	if (!m_posLookup || width <= 0 || height <= 0 || width > 0x7fffffff / height)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtMeshTile** gridLookup = (dtMeshTile**)dtAlloc(sizeof(dtMeshTile*)*width*height, DT_ALLOC_PERM);
+	if (!gridLookup)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	memset(gridLookup, 0, sizeof(dtMeshTile*)*width*height);
+
+	// Gather the tiles in the order of their lists, which keeps the order of the
+	// layers of a location when the tiles are inserted again.
+	dtMeshTile** tiles = (dtMeshTile**)dtAlloc(sizeof(dtMeshTile*)*dtMax(m_maxTiles, 1), DT_ALLOC_TEMP);
+	if (!tiles)
+	{
+		dtFree(gridLookup);
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+	int ntiles = 0;
+	for (int i = 0; i < m_gridWidth*m_gridHeight; ++i)
+	{
+		for (dtMeshTile* tile = m_gridLookup[i]; tile; tile = tile->next)
+			tiles[ntiles++] = tile;
+	}
+	for (int i = 0; i < m_tileLutSize; ++i)
+	{
+		for (dtMeshTile* tile = m_posLookup[i]; tile; tile = tile->next)
+			tiles[ntiles++] = tile;
+	}
+
+	dtFree(m_gridLookup);
+	m_gridLookup = gridLookup;
+	m_gridMinX = minX;
+	m_gridMinY = minY;
+	m_gridWidth = width;
+	m_gridHeight = height;
+
+	// Insert the tiles again, in the grid or in the hash lookup, from the back of their lists.
+	memset(m_posLookup, 0, sizeof(dtMeshTile*)*m_tileLutSize);
+	for (int i = ntiles-1; i >= 0; --i)
+	{
+		dtMeshTile* tile = tiles[i];
+		dtMeshTile** list = getTileList(tile->header->x, tile->header->y);
+		tile->next = *list;
+		*list = tile;
+	}
+	dtFree(tiles);
+
+	return DT_SUCCESS;
+}
+
+dtMeshTile** dtNavMesh::getTileList(const int x, const int y) const
+{
+	const unsigned int gx = (unsigned int)x - (unsigned int)m_gridMinX;
+	const unsigned int gy = (unsigned int)y - (unsigned int)m_gridMinY;
+	if (gx < (unsigned int)m_gridWidth && gy < (unsigned int)m_gridHeight)
+		return &m_gridLookup[gy*(unsigned int)m_gridWidth + gx];
+	return &m_posLookup[computeTileHash(x, y, m_tileLutMask)];
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 int dtNavMesh::findConnectingPolys(const float* va, const float* vb,
 								   const dtMeshTile* tile, int side,
@@ -375,7 +509,11 @@ void dtNavMesh::unconnectLinks(dtMeshTile* tile, dtMeshTile* target)
 					poly->firstLink = nj;
 				else
 					tile->links[pj].next = nj;
-				freeLink(tile, j);
+				// A reader may be on the link, keep it and its next link as they are.
+				if (m_maxReaders)
+					retire(tile, j);
+				else
+					freeLink(tile, j);
 				j = nj;
 			}
 			else
@@ -388,6 +526,22 @@ void dtNavMesh::unconnectLinks(dtMeshTile* tile, dtMeshTile* target)
 	}
 }
 
+int dtNavMesh::countLinks(const dtMeshTile* tile, const dtMeshTile* target) const
+{
+	const unsigned int targetNum = decodePolyIdTile(getTileRef(target));
+
+	int n = 0;
+	for (int i = 0; i < tile->header->polyCount; ++i)
+	{
+		for (unsigned int j = tile->polys[i].firstLink; j != DT_NULL_LINK; j = tile->links[j].next)
+		{
+			if (decodePolyIdTile(tile->links[j].ref) == targetNum)
+				n++;
+		}
+	}
+	return n;
+}
+
 void dtNavMesh::connectExtLinks(dtMeshTile* tile, dtMeshTile* target, int side)
 {
 	if (!tile) return;
@@ -426,9 +580,6 @@ void dtNavMesh::connectExtLinks(dtMeshTile* tile, dtMeshTile* target, int side)
 					link->ref = nei[k];
 					link->edge = (unsigned char)j;
 					link->side = (unsigned char)dir;
-					
-					link->next = poly->firstLink;
-					poly->firstLink = idx;
 
 					// Compress portal limits to a byte value.
 					if (dir == 0 || dir == 4)
@@ -449,6 +600,10 @@ void dtNavMesh::connectExtLinks(dtMeshTile* tile, dtMeshTile* target, int side)
 						link->bmin = (unsigned char)roundf(dtClamp(tmin, 0.0f, 1.0f)*255.0f);
 						link->bmax = (unsigned char)roundf(dtClamp(tmax, 0.0f, 1.0f)*255.0f);
 					}
+
+					// Add to linked list, once the link is complete for the readers.
+					link->next = poly->firstLink;
+					dtPublish(&poly->firstLink, idx);
 				}
 			}
 		}
@@ -500,7 +655,7 @@ void dtNavMesh::connectExtOffMeshLinks(dtMeshTile* tile, dtMeshTile* target, int
 			link->bmin = link->bmax = 0;
 			// Add to linked list.
 			link->next = targetPoly->firstLink;
-			targetPoly->firstLink = idx;
+			dtPublish(&targetPoly->firstLink, idx);
 		}
 		
 		// Link target poly to off-mesh connection.
@@ -518,7 +673,7 @@ void dtNavMesh::connectExtOffMeshLinks(dtMeshTile* tile, dtMeshTile* target, int
 				link->bmin = link->bmax = 0;
 				// Add to linked list.
 				link->next = landPoly->firstLink;
-				landPoly->firstLink = tidx;
+				dtPublish(&landPoly->firstLink, tidx);
 			}
 		}
 	}
@@ -929,6 +1084,10 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	// Make sure the location is free.
 	if (getTileAt(header->x, header->y, header->layer))
 		return DT_FAILURE | DT_ALREADY_OCCUPIED;
+
+	// Free the removed tiles the readers are done with.
+	if (m_maxReaders)
+		reclaim();
 		
 	// Allocate a tile.
 	dtMeshTile* tile = 0;
@@ -973,11 +1132,6 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	if (!tile)
 		return DT_FAILURE | DT_OUT_OF_MEMORY;
 	
-	// Insert tile into the position lut.
-	int h = computeTileHash(header->x, header->y, m_tileLutMask);
-	tile->next = m_posLookup[h];
-	m_posLookup[h] = tile;
-	
 	// Patch header pointers.
 	const int headerSize = dtAlign4(sizeof(dtMeshHeader));
 	const int vertsSize = dtAlign4(sizeof(float)*3*header->vertCount);
@@ -1013,7 +1167,7 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	tile->header = header;
 	tile->data = data;
 	tile->dataSize = dataSize;
-	tile->flags = flags;
+	tile->flags = flags & ~DT_TILE_REMOVED;
 
 	connectIntLinks(tile);
 
@@ -1051,6 +1205,11 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 			connectExtOffMeshLinks(neis[j], tile, dtOppositeTile(i));
 		}
 	}
+
+	// Insert tile into the position lut, last so that readers find it complete.
+	dtMeshTile** list = getTileList(header->x, header->y);
+	tile->next = *list;
+	dtPublish(list, tile);
 	
 	if (result)
 		*result = getTileRef(tile);
@@ -1060,9 +1219,8 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 
 const dtMeshTile* dtNavMesh::getTileAt(const int x, const int y, const int layer) const
 {
-	// Find tile based on hash.
-	int h = computeTileHash(x,y,m_tileLutMask);
-	dtMeshTile* tile = m_posLookup[h];
+	// Find tile based on location.
+	dtMeshTile* tile = *getTileList(x, y);
 	while (tile)
 	{
 		if (tile->header &&
@@ -1099,9 +1257,8 @@ int dtNavMesh::getTilesAt(const int x, const int y, dtMeshTile** tiles, const in
 {
 	int n = 0;
 	
-	// Find tile based on hash.
-	int h = computeTileHash(x,y,m_tileLutMask);
-	dtMeshTile* tile = m_posLookup[h];
+	// Find tile based on location.
+	dtMeshTile* tile = *getTileList(x, y);
 	while (tile)
 	{
 		if (tile->header &&
@@ -1125,9 +1282,8 @@ int dtNavMesh::getTilesAt(const int x, const int y, dtMeshTile const** tiles, co
 {
 	int n = 0;
 	
-	// Find tile based on hash.
-	int h = computeTileHash(x,y,m_tileLutMask);
-	dtMeshTile* tile = m_posLookup[h];
+	// Find tile based on location.
+	dtMeshTile* tile = *getTileList(x, y);
 	while (tile)
 	{
 		if (tile->header &&
@@ -1146,9 +1302,8 @@ int dtNavMesh::getTilesAt(const int x, const int y, dtMeshTile const** tiles, co
 
 dtTileRef dtNavMesh::getTileRefAt(const int x, const int y, const int layer) const
 {
-	// Find tile based on hash.
-	int h = computeTileHash(x,y,m_tileLutMask);
-	dtMeshTile* tile = m_posLookup[h];
+	// Find tile based on location.
+	dtMeshTile* tile = *getTileList(x, y);
 	while (tile)
 	{
 		if (tile->header &&
@@ -1250,31 +1405,53 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	if ((int)tileIndex >= m_maxTiles)
 		return DT_FAILURE | DT_INVALID_PARAM;
 	dtMeshTile* tile = &m_tiles[tileIndex];
-	if (tile->salt != tileSalt)
+	if (tile->salt != tileSalt || !tile->header)
 		return DT_FAILURE | DT_INVALID_PARAM;
-	
-	// Remove tile from hash lookup.
-	int h = computeTileHash(tile->header->x,tile->header->y,m_tileLutMask);
+
+	// Find the tile in the position lookup. A removed tile the readers still use is not there.
+	dtMeshTile** list = getTileList(tile->header->x, tile->header->y);
 	dtMeshTile* prev = 0;
-	dtMeshTile* cur = m_posLookup[h];
-	while (cur)
+	dtMeshTile* cur = *list;
+	while (cur && cur != tile)
 	{
-		if (cur == tile)
-		{
-			if (prev)
-				prev->next = cur->next;
-			else
-				m_posLookup[h] = cur->next;
-			break;
-		}
 		prev = cur;
 		cur = cur->next;
 	}
-	
-	// Remove connections to neighbour tiles.
+	if (!cur)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
 	static const int MAX_NEIS = 32;
 	dtMeshTile* neis[MAX_NEIS];
 	int nneis;
+
+	if (m_maxReaders)
+	{
+		// Make room for the tile and the links to it, so that the removal can't fail halfway.
+		reclaim();
+		int count = 1;
+		nneis = getTilesAt(tile->header->x, tile->header->y, neis, MAX_NEIS);
+		for (int j = 0; j < nneis; ++j)
+		{
+			if (neis[j] != tile)
+				count += countLinks(neis[j], tile);
+		}
+		for (int i = 0; i < 8; ++i)
+		{
+			nneis = getNeighbourTilesAt(tile->header->x, tile->header->y, i, neis, MAX_NEIS);
+			for (int j = 0; j < nneis; ++j)
+				count += countLinks(neis[j], tile);
+		}
+		if (!reserveRetired(count))
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
+	// Remove tile from the position lookup. Its next pointer is left for the readers walking the list.
+	if (prev)
+		prev->next = tile->next;
+	else
+		*list = tile->next;
+	
+	// Remove connections to neighbour tiles.
 	
 	// Disconnect from other layers in current tile.
 	nneis = getTilesAt(tile->header->x, tile->header->y, neis, MAX_NEIS);
@@ -1292,13 +1469,8 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 			unconnectLinks(neis[j], tile);
 	}
 		
-	// Reset tile.
 	if (tile->flags & DT_TILE_FREE_DATA)
 	{
-		// Owns data
-		dtFree(tile->data);
-		tile->data = 0;
-		tile->dataSize = 0;
 		if (data) *data = 0;
 		if (dataSize) *dataSize = 0;
 	}
@@ -1308,6 +1480,47 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 		if (dataSize) *dataSize = tile->dataSize;
 	}
 
+	updateSalt(tile);
+
+	if (m_maxReaders)
+	{
+		// Keep the tile until the readers of this epoch are done, and start a new epoch.
+		// The readers of the new one see the flag and skip the tile in the tile array.
+		tile->flags |= DT_TILE_REMOVED;
+		retire(tile, DT_NULL_LINK);
+		dtStoreEpoch(&m_epoch, m_epoch+1);
+		reclaim();
+	}
+	else
+	{
+		freeTile(tile);
+	}
+
+	return DT_SUCCESS;
+}
+
+void dtNavMesh::updateSalt(dtMeshTile* tile)
+{
+	// Update salt, salt should never be zero.
+#ifdef DT_POLYREF64
+	tile->salt = (tile->salt+1) & ((1<<DT_SALT_BITS)-1);
+#else
+	tile->salt = (tile->salt+1) & ((1<<m_saltBits)-1);
+#endif
+	if (tile->salt == 0)
+		tile->salt++;
+}
+
+void dtNavMesh::freeTile(dtMeshTile* tile)
+{
+	// Reset tile.
+	if (tile->flags & DT_TILE_FREE_DATA)
+	{
+		// Owns data
+		dtFree(tile->data);
+	}
+	tile->data = 0;
+	tile->dataSize = 0;
 	tile->header = 0;
 	tile->flags = 0;
 	tile->linksFreeList = 0;
@@ -1320,22 +1533,146 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	tile->bvTree = 0;
 	tile->offMeshCons = 0;
 
-	// Update salt, salt should never be zero.
-#ifdef DT_POLYREF64
-	tile->salt = (tile->salt+1) & ((1<<DT_SALT_BITS)-1);
-#else
-	tile->salt = (tile->salt+1) & ((1<<m_saltBits)-1);
-#endif
-	if (tile->salt == 0)
-		tile->salt++;
-
 	// Add to free list.
 	tile->next = m_nextFree;
 	m_nextFree = tile;
+}
 
+/// @par
+///
+/// Without readers, the navigation mesh must not be used by other threads while
+/// tiles are added or removed. With them, one thread can add and remove tiles
+/// while queries run on others, as long as each thread reads between
+/// #beginRead and #endRead with a reader index of its own, e.g. around the
+/// queries of a frame.
+///
+/// A removed tile is taken out of the hash lookup and its reference becomes
+/// invalid at once, but its memory, and the memory of the links of the other
+/// tiles to it, are only freed or reused once every reader which began
+/// reading before the removal has ended. #removeTile and #addTile do it when
+/// they can, #reclaim does it otherwise. Tile data that the navigation mesh
+/// doesn't own, returned by #removeTile, must be kept until #reclaim returns
+/// zero.
+///
+/// A reader sees each tile, and each link, either as it was or as it is after
+/// the change. It may follow links into a tile being removed, so readers
+/// should check the polygon references they keep with #isValidPolyRef, as
+/// usual. #getTile also returns the removed tiles which are not freed yet,
+/// with the #DT_TILE_REMOVED flag, which readers going through the tile array
+/// must skip.
+///
+/// A tile reference which is still in use can't be restored with the lastRef
+/// parameter of #addTile.
+dtStatus dtNavMesh::initReaders(const int maxReaders)
+{
+	if (maxReaders <= 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	unsigned int* readerEpochs = (unsigned int*)dtAlloc(sizeof(unsigned int)*maxReaders, DT_ALLOC_PERM);
+	if (!readerEpochs)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	memset(readerEpochs, 0, sizeof(unsigned int)*maxReaders);
+
+	// Changing the number of readers requires that none is reading.
+	reclaim();
+	dtAssert(m_retiredCount == 0);
+	dtFree(m_readerEpochs);
+	m_readerEpochs = readerEpochs;
+	m_maxReaders = maxReaders;
 	return DT_SUCCESS;
 }
 
+void dtNavMesh::beginRead(const int reader) const
+{
+	dtAssert(reader >= 0 && reader < m_maxReaders);
+	unsigned int* readerEpoch = &m_readerEpochs[reader];
+	unsigned int* epoch = const_cast<unsigned int*>(&m_epoch);
+
+	// Enter the current epoch. If a removal started a new one meanwhile, the
+	// tile could be freed before this reader was seen, so enter the new one.
+	unsigned int e = dtLoadEpoch(epoch);
+	for (;;)
+	{
+		dtStoreEpoch(readerEpoch, e);
+		const unsigned int current = dtLoadEpoch(epoch);
+		if (current == e)
+			break;
+		e = current;
+	}
+}
+
+void dtNavMesh::endRead(const int reader) const
+{
+	dtAssert(reader >= 0 && reader < m_maxReaders);
+	dtStoreEpoch(&m_readerEpochs[reader], 0);
+}
+
+bool dtNavMesh::reserveRetired(const int count)
+{
+	if (m_retiredCount + count <= m_retiredCapacity)
+		return true;
+
+	int capacity = dtMax(m_retiredCapacity*2, 64);
+	while (capacity < m_retiredCount + count)
+		capacity *= 2;
+	dtRetiredItem* retired = (dtRetiredItem*)dtAlloc(sizeof(dtRetiredItem)*capacity, DT_ALLOC_PERM);
+	if (!retired)
+		return false;
+	if (m_retiredCount)
+		memcpy(retired, m_retired, sizeof(dtRetiredItem)*m_retiredCount);
+	dtFree(m_retired);
+	m_retired = retired;
+	m_retiredCapacity = capacity;
+	return true;
+}
+
+void dtNavMesh::retire(dtMeshTile* tile, const unsigned int link)
+{
+	dtAssert(m_retiredCount < m_retiredCapacity);
+	dtRetiredItem& item = m_retired[m_retiredCount++];
+	item.tile = tile;
+	item.link = link;
+	item.epoch = m_epoch;
+}
+
+/// @par
+///
+/// The items are freed in the order they were removed, so the links of a tile
+/// are freed before the tile.
+int dtNavMesh::reclaim()
+{
+	if (!m_retiredCount)
+		return 0;
+
+	// The oldest epoch a reader may be reading in.
+	unsigned int oldest = dtLoadEpoch(&m_epoch);
+	for (int i = 0; i < m_maxReaders; ++i)
+	{
+		const unsigned int e = dtLoadEpoch(&m_readerEpochs[i]);
+		if (e && e < oldest)
+			oldest = e;
+	}
+
+	int n = 0;
+	while (n < m_retiredCount && m_retired[n].epoch < oldest)
+	{
+		const dtRetiredItem& item = m_retired[n++];
+		if (item.link == DT_NULL_LINK)
+		{
+			// The references got from #getTile while the tile was kept become invalid too.
+			updateSalt(item.tile);
+			freeTile(item.tile);
+		}
+		else
+			freeLink(item.tile, item.link);
+	}
+	m_retiredCount -= n;
+	if (n && m_retiredCount)
+		memmove(m_retired, &m_retired[n], sizeof(dtRetiredItem)*m_retiredCount);
+
+	return m_retiredCount;
+}
+
 dtTileRef dtNavMesh::getTileRef(const dtMeshTile* tile) const
 {
 	if (!tile) return 0;
@@ -0,0 +1,985 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <float.h>
+#include <string.h>
+#include "DetourNavMeshLandmarks.h"
+#include "DetourNavMesh.h"
+#include "DetourCommon.h"
+#include "DetourMath.h"
+#include "DetourAlloc.h"
+#include "DetourAssert.h"
+#include <new>
+
+// Distance of the vertices not connected to a landmark.
+static const unsigned short DT_LANDMARK_UNKNOWN = 0xffff;
+// Largest stored distance. Longer distances are clamped, which keeps the bounds valid.
+static const unsigned int DT_LANDMARK_MAX_DIST = 0xfffe;
+// Maximum number of path vertices of a polygon: its edges and the off-mesh connection end points on it.
+static const int DT_LANDMARK_MAX_POLY_VERTS = DT_VERTS_PER_POLYGON + 32;
+
+// A one way off-mesh connection ending on a polygon of the tile. The polygon has
+// no link to the connection, so it is found from the connection's links.
+struct dtLandmarkLanding
+{
+	dtPolyRef con;				// The connection polygon.
+	unsigned short poly;		// The index of the polygon in the tile.
+};
+
+// The landmark distances of a tile.
+struct dtLandmarkTile
+{
+	unsigned int salt;				// Salt of the tile the distances belong to.
+	int x, y, layer;				// Location of the tile, which stays known after it is removed.
+	int polyCount;					// Number of polygons of the tile.
+	unsigned short* dists;			// Distances of the path vertices. [landmarkCount * polyCount * DT_VERTS_PER_POLYGON]
+	unsigned short* bounds;			// Distance ranges of the polygons. [(min, max) * landmarkCount * polyCount]
+	float* points;					// Centers and radii of the path vertices. [(x, y, z, r) * polyCount * DT_VERTS_PER_POLYGON]
+	dtLandmarkLanding* landings;	// One way off-mesh connections ending in the tile.
+	int landingCount;
+	bool dirty;						// True if the ranges need to be recomputed.
+};
+
+// Where a path can enter or leave a polygon: a portal edge of the polygon, or an end
+// point of an off-mesh connection. The path queries place their nodes at the middle of
+// the portals, which are within a radius of the vertex's center. The vertex is identified
+// by its tile and its index in the tile's distances, polygon * DT_VERTS_PER_POLYGON + edge.
+struct dtLandmarkVertex
+{
+	unsigned int tile;
+	unsigned int index;
+	const float* point;		// Center and radius. [(x, y, z, r)]
+};
+
+struct dtLandmarkHeapItem
+{
+	unsigned int dist;
+	unsigned int tile;
+	unsigned int index;
+};
+
+dtNavMeshLandmarks* dtAllocNavMeshLandmarks()
+{
+	void* mem = dtAlloc(sizeof(dtNavMeshLandmarks), DT_ALLOC_PERM);
+	if (!mem) return 0;
+	return new(mem) dtNavMeshLandmarks;
+}
+
+void dtFreeNavMeshLandmarks(dtNavMeshLandmarks* landmarks)
+{
+	if (!landmarks) return;
+	landmarks->~dtNavMeshLandmarks();
+	dtFree(landmarks);
+}
+
+// Returns the shortest distance on the xz-plane between the nodes of two path vertices.
+static inline float getVertexDistance(const float* a, const float* b)
+{
+	return dtMax(dtVdist2D(a, b) - a[3] - b[3], 0.0f);
+}
+
+// Gets the middle of the portal of a link, as dtNavMeshQuery::getPortalPoints clamps it.
+static void getLinkMidPoint(const dtMeshTile* tile, const dtPoly* poly, const dtLink* link, float* mid)
+{
+	const float* v0 = &tile->verts[poly->verts[link->edge] * 3];
+	const float* v1 = &tile->verts[poly->verts[(link->edge + 1) % poly->vertCount] * 3];
+	float tmin = 0.0f, tmax = 1.0f;
+	if (link->side != 0xff && (link->bmin != 0 || link->bmax != 255))
+	{
+		const float s = 1.0f / 255.0f;
+		tmin = link->bmin * s;
+		tmax = link->bmax * s;
+	}
+	dtVlerp(mid, v0, v1, (tmin + tmax) * 0.5f);
+}
+
+static inline bool isTileKnown(const dtLandmarkTile& ltile, unsigned int salt)
+{
+	return ltile.dists != 0 && ltile.salt == salt;
+}
+
+dtNavMeshLandmarks::dtNavMeshLandmarks() :
+	m_nav(0),
+	m_tiles(0),
+	m_maxTiles(0),
+	m_heap(0),
+	m_heapSize(0),
+	m_heapCapacity(0)
+{
+	memset(&m_params, 0, sizeof(m_params));
+}
+
+dtNavMeshLandmarks::~dtNavMeshLandmarks()
+{
+	for (int i = 0; i < m_maxTiles; ++i)
+		freeTile(m_tiles[i]);
+	dtFree(m_tiles);
+	dtFree(m_heap);
+}
+
+dtStatus dtNavMeshLandmarks::reset(const dtNavMesh* nav)
+{
+	for (int i = 0; i < m_maxTiles; ++i)
+		freeTile(m_tiles[i]);
+	dtFree(m_tiles);
+	m_tiles = 0;
+	m_maxTiles = 0;
+	m_nav = 0;
+	memset(&m_params, 0, sizeof(m_params));
+
+	const int maxTiles = nav->getMaxTiles();
+	m_tiles = (dtLandmarkTile*)dtAlloc(sizeof(dtLandmarkTile) * dtMax(maxTiles, 1), DT_ALLOC_PERM);
+	if (!m_tiles)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	memset(m_tiles, 0, sizeof(dtLandmarkTile) * dtMax(maxTiles, 1));
+	m_maxTiles = maxTiles;
+	m_nav = nav;
+	return DT_SUCCESS;
+}
+
+void dtNavMeshLandmarks::freeTile(dtLandmarkTile& ltile)
+{
+	dtFree(ltile.dists);
+	dtFree(ltile.landings);
+	memset(&ltile, 0, sizeof(dtLandmarkTile));
+}
+
+dtStatus dtNavMeshLandmarks::allocTile(const dtMeshTile* tile)
+{
+	const dtTileRef ref = m_nav->getTileRef(tile);
+	dtLandmarkTile& ltile = m_tiles[m_nav->decodePolyIdTile(ref)];
+	freeTile(ltile);
+
+	const int polyCount = tile->header->polyCount;
+	const int distCount = m_params.landmarkCount * polyCount * DT_VERTS_PER_POLYGON;
+	const int boundCount = m_params.landmarkCount * polyCount * 2;
+	const int pointCount = polyCount * DT_VERTS_PER_POLYGON * 4;
+	const int distSize = dtAlign4(sizeof(unsigned short) * (distCount + boundCount));
+	unsigned char* mem = (unsigned char*)dtAlloc(distSize + sizeof(float) * pointCount, DT_ALLOC_PERM);
+	if (!mem)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	memset(mem, 0xff, distSize);
+
+	ltile.salt = m_nav->decodePolyIdSalt(ref);
+	ltile.x = tile->header->x;
+	ltile.y = tile->header->y;
+	ltile.layer = tile->header->layer;
+	ltile.polyCount = polyCount;
+	ltile.dists = (unsigned short*)mem;
+	ltile.bounds = ltile.dists + distCount;
+	ltile.points = (float*)(mem + distSize);
+	ltile.dirty = true;
+	return DT_SUCCESS;
+}
+
+void dtNavMeshLandmarks::updatePoints(const dtMeshTile* tile)
+{
+	const dtPolyRef base = m_nav->getPolyRefBase(tile);
+	dtLandmarkTile& ltile = m_tiles[m_nav->decodePolyIdTile(base)];
+	memset(ltile.points, 0, sizeof(float) * ltile.polyCount * DT_VERTS_PER_POLYGON * 4);
+
+	for (int i = 0; i < ltile.polyCount; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+		float* points = &ltile.points[i * DT_VERTS_PER_POLYGON * 4];
+		if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+		{
+			dtVcopy(&points[0], &tile->verts[poly->verts[0] * 3]);
+			dtVcopy(&points[4], &tile->verts[poly->verts[1] * 3]);
+			continue;
+		}
+
+		for (int j = 0; j < (int)poly->vertCount; ++j)
+		{
+			float* point = &points[j * 4];
+			dtVlerp(point, &tile->verts[poly->verts[j] * 3], &tile->verts[poly->verts[(j + 1) % poly->vertCount] * 3], 0.5f);
+			if (!(poly->neis[j] & DT_EXT_LINK))
+				continue;
+
+			// Portals at the tile border are clamped to the part of the edge the polygons share,
+			// from either side. The radius covers the middles of all of them.
+			const dtPolyRef ref = base | (dtPolyRef)i;
+			for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+			{
+				const dtLink* link = &tile->links[k];
+				if (link->edge != j)
+					continue;
+				float mid[3];
+				getLinkMidPoint(tile, poly, link, mid);
+				point[3] = dtMax(point[3], dtVdist2D(point, mid));
+
+				const dtMeshTile* neiTile = 0;
+				const dtPoly* neiPoly = 0;
+				m_nav->getTileAndPolyByRefUnsafe(link->ref, &neiTile, &neiPoly);
+				for (unsigned int l = neiPoly->firstLink; l != DT_NULL_LINK; l = neiTile->links[l].next)
+				{
+					const dtLink* neiLink = &neiTile->links[l];
+					if (neiLink->ref != ref || neiLink->edge >= neiPoly->vertCount)
+						continue;
+					getLinkMidPoint(neiTile, neiPoly, neiLink, mid);
+					point[3] = dtMax(point[3], dtVdist2D(point, mid));
+				}
+			}
+		}
+	}
+}
+
+dtStatus dtNavMeshLandmarks::updateLinks(const dtMeshTile* tile)
+{
+	const dtTileRef ref = m_nav->getTileRef(tile);
+	const unsigned int it = m_nav->decodePolyIdTile(ref);
+	dtLandmarkTile& ltile = m_tiles[it];
+	if (!isTileKnown(ltile, m_nav->decodePolyIdSalt(ref)))
+		return DT_SUCCESS;
+
+	updatePoints(tile);
+
+	dtFree(ltile.landings);
+	ltile.landings = 0;
+	ltile.landingCount = 0;
+
+	// Connections end at most one tile away from their start. The first pass counts them.
+	static const int MAX_NEIS = 32;
+	const dtMeshTile* neis[MAX_NEIS];
+	int count = 0;
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		if (pass == 1)
+		{
+			if (count == 0)
+				break;
+			ltile.landings = (dtLandmarkLanding*)dtAlloc(sizeof(dtLandmarkLanding) * count, DT_ALLOC_PERM);
+			if (!ltile.landings)
+				return DT_FAILURE | DT_OUT_OF_MEMORY;
+		}
+
+		for (int y = ltile.y - 1; y <= ltile.y + 1; ++y)
+		{
+			for (int x = ltile.x - 1; x <= ltile.x + 1; ++x)
+			{
+				const int nneis = m_nav->getTilesAt(x, y, neis, MAX_NEIS);
+				for (int i = 0; i < nneis; ++i)
+				{
+					const dtMeshTile* nei = neis[i];
+					const dtPolyRef base = m_nav->getPolyRefBase(nei);
+					for (int j = 0; j < nei->header->offMeshConCount; ++j)
+					{
+						const dtOffMeshConnection* con = &nei->offMeshCons[j];
+						if (con->flags & DT_OFFMESH_CON_BIDIR)
+							continue;
+						const dtPoly* conPoly = &nei->polys[con->poly];
+						for (unsigned int k = conPoly->firstLink; k != DT_NULL_LINK; k = nei->links[k].next)
+						{
+							const dtLink* link = &nei->links[k];
+							if (link->edge != 1 || m_nav->decodePolyIdTile(link->ref) != it)
+								continue;
+							if (pass == 1)
+							{
+								ltile.landings[ltile.landingCount].con = base | (dtPolyRef)con->poly;
+								ltile.landings[ltile.landingCount].poly = (unsigned short)m_nav->decodePolyIdPoly(link->ref);
+								ltile.landingCount++;
+							}
+							else
+							{
+								count++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	return DT_SUCCESS;
+}
+
+// Appends the end points of an off-mesh connection which are linked to a polygon.
+static int appendConnectionEnds(const dtNavMesh* nav, const dtLandmarkTile* ltiles, dtPolyRef conRef, dtPolyRef polyRef,
+								dtLandmarkVertex* verts, int n, const int maxVerts)
+{
+	unsigned int salt, it, ip;
+	nav->decodePolyId(conRef, salt, it, ip);
+	if (!isTileKnown(ltiles[it], salt))
+		return n;
+	const dtMeshTile* tile = 0;
+	const dtPoly* poly = 0;
+	nav->getTileAndPolyByRefUnsafe(conRef, &tile, &poly);
+	for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+	{
+		const dtLink* link = &tile->links[i];
+		if (link->ref != polyRef || link->edge > 1 || n >= maxVerts)
+			continue;
+		dtLandmarkVertex& v = verts[n++];
+		v.tile = it;
+		v.index = ip * DT_VERTS_PER_POLYGON + link->edge;
+		v.point = &ltiles[it].points[v.index * 4];
+	}
+	return n;
+}
+
+int dtNavMeshLandmarks::getPolyVertices(const dtMeshTile* tile, unsigned int ip,
+										dtLandmarkVertex* verts, const int maxVerts) const
+{
+	const dtPolyRef base = m_nav->getPolyRefBase(tile);
+	const unsigned int it = m_nav->decodePolyIdTile(base);
+	const dtPoly* poly = &tile->polys[ip];
+	const float* points = m_tiles[it].points;
+	int n = 0;
+
+	if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+	{
+		for (int j = 0; j < 2; ++j)
+		{
+			dtLandmarkVertex& v = verts[n++];
+			v.tile = it;
+			v.index = ip * DT_VERTS_PER_POLYGON + j;
+			v.point = &points[v.index * 4];
+		}
+		return n;
+	}
+
+	// Walls can't be on a path, only the portal edges.
+	for (int j = 0; j < (int)poly->vertCount; ++j)
+	{
+		if (!poly->neis[j])
+			continue;
+		dtLandmarkVertex& v = verts[n++];
+		v.tile = it;
+		v.index = ip * DT_VERTS_PER_POLYGON + j;
+		v.point = &points[v.index * 4];
+	}
+
+	// Off-mesh connections starting on the polygon, or ending on it.
+	const dtPolyRef ref = base | (dtPolyRef)ip;
+	for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+	{
+		if (tile->links[i].edge == 0xff)
+			n = appendConnectionEnds(m_nav, m_tiles, tile->links[i].ref, ref, verts, n, maxVerts);
+	}
+	const dtLandmarkTile& ltile = m_tiles[it];
+	for (int i = 0; i < ltile.landingCount; ++i)
+	{
+		if (ltile.landings[i].poly == ip && m_nav->isValidPolyRef(ltile.landings[i].con))
+			n = appendConnectionEnds(m_nav, m_tiles, ltile.landings[i].con, ref, verts, n, maxVerts);
+	}
+	return n;
+}
+
+void dtNavMeshLandmarks::updateBounds(const dtMeshTile* tile)
+{
+	dtLandmarkTile& ltile = m_tiles[m_nav->decodePolyIdTile(m_nav->getTileRef(tile))];
+	const int landmarkCount = m_params.landmarkCount;
+	dtLandmarkVertex verts[DT_LANDMARK_MAX_POLY_VERTS];
+
+	for (int i = 0; i < ltile.polyCount; ++i)
+	{
+		const int n = getPolyVertices(tile, (unsigned int)i, verts, DT_LANDMARK_MAX_POLY_VERTS);
+		unsigned short* bounds = &ltile.bounds[i * landmarkCount * 2];
+		for (int k = 0; k < landmarkCount; ++k)
+		{
+			unsigned short dmin = DT_LANDMARK_UNKNOWN;
+			unsigned short dmax = 0;
+			for (int j = 0; j < n; ++j)
+			{
+				const dtLandmarkTile& vtile = m_tiles[verts[j].tile];
+				const unsigned short d = vtile.dists[k * vtile.polyCount * DT_VERTS_PER_POLYGON + verts[j].index];
+				if (d == DT_LANDMARK_UNKNOWN)
+					continue;
+				dmin = dtMin(dmin, d);
+				dmax = dtMax(dmax, d);
+			}
+			bounds[k * 2 + 0] = dmin;
+			bounds[k * 2 + 1] = dmin == DT_LANDMARK_UNKNOWN ? DT_LANDMARK_UNKNOWN : dmax;
+		}
+	}
+	ltile.dirty = false;
+}
+
+void dtNavMeshLandmarks::updateDirtyBounds()
+{
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		if (!m_tiles[i].dirty)
+			continue;
+		const dtMeshTile* tile = m_nav->getTile(i);
+		if (tile->header && isTileKnown(m_tiles[i], tile->salt))
+			updateBounds(tile);
+		m_tiles[i].dirty = false;
+	}
+}
+
+dtStatus dtNavMeshLandmarks::updateNeighbourhood(const int x, const int y)
+{
+	static const int MAX_NEIS = 32;
+	const dtMeshTile* neis[MAX_NEIS];
+	for (int ny = y - 1; ny <= y + 1; ++ny)
+	{
+		for (int nx = x - 1; nx <= x + 1; ++nx)
+		{
+			const int nneis = m_nav->getTilesAt(nx, ny, neis, MAX_NEIS);
+			for (int i = 0; i < nneis; ++i)
+			{
+				dtStatus status = updateLinks(neis[i]);
+				if (dtStatusFailed(status))
+					return status;
+				m_tiles[m_nav->decodePolyIdTile(m_nav->getTileRef(neis[i]))].dirty = true;
+			}
+		}
+	}
+	return DT_SUCCESS;
+}
+
+bool dtNavMeshLandmarks::push(const unsigned int dist, const unsigned int tile, const unsigned int index)
+{
+	if (m_heapSize == m_heapCapacity)
+	{
+		const int capacity = dtMax(m_heapCapacity * 2, 1024);
+		dtLandmarkHeapItem* heap = (dtLandmarkHeapItem*)dtAlloc(sizeof(dtLandmarkHeapItem) * capacity, DT_ALLOC_TEMP);
+		if (!heap)
+			return false;
+		if (m_heapSize)
+			memcpy(heap, m_heap, sizeof(dtLandmarkHeapItem) * m_heapSize);
+		dtFree(m_heap);
+		m_heap = heap;
+		m_heapCapacity = capacity;
+	}
+
+	int i = m_heapSize++;
+	while (i > 0)
+	{
+		const int parent = (i - 1) / 2;
+		if (m_heap[parent].dist <= dist)
+			break;
+		m_heap[i] = m_heap[parent];
+		i = parent;
+	}
+	m_heap[i].dist = dist;
+	m_heap[i].tile = tile;
+	m_heap[i].index = index;
+	return true;
+}
+
+void dtNavMeshLandmarks::pop(dtLandmarkHeapItem& top)
+{
+	top = m_heap[0];
+	const dtLandmarkHeapItem last = m_heap[--m_heapSize];
+	int i = 0;
+	for (;;)
+	{
+		int child = i * 2 + 1;
+		if (child >= m_heapSize)
+			break;
+		if (child + 1 < m_heapSize && m_heap[child + 1].dist < m_heap[child].dist)
+			child++;
+		if (last.dist <= m_heap[child].dist)
+			break;
+		m_heap[i] = m_heap[child];
+		i = child;
+	}
+	m_heap[i] = last;
+}
+
+bool dtNavMeshLandmarks::relax(const dtLandmarkVertex& vert, unsigned int dist, const int landmark)
+{
+	if (dist > DT_LANDMARK_MAX_DIST)
+		dist = DT_LANDMARK_MAX_DIST;
+	dtLandmarkTile& ltile = m_tiles[vert.tile];
+	unsigned short& d = ltile.dists[landmark * ltile.polyCount * DT_VERTS_PER_POLYGON + vert.index];
+	if (dist >= d)
+		return true;
+	d = (unsigned short)dist;
+	ltile.dirty = true;
+	return push(dist, vert.tile, vert.index);
+}
+
+// Each polygon connects all its path vertices, with the shortest distance between their
+// nodes on the xz-plane, and each portal edge is connected to the edges of the neighbour
+// polygons which link back to it, at no cost. A path entering a polygon at one vertex and
+// leaving it at another costs at least their distance, so the shortest distances of this
+// graph are never longer than the paths of the path queries.
+dtStatus dtNavMeshLandmarks::propagate(const int landmark)
+{
+	const float invScale = 1.0f / m_params.scale;
+	dtLandmarkVertex verts[DT_LANDMARK_MAX_POLY_VERTS];
+
+	while (m_heapSize > 0)
+	{
+		dtLandmarkHeapItem item;
+		pop(item);
+
+		const dtLandmarkTile& ltile = m_tiles[item.tile];
+		if (ltile.dists[landmark * ltile.polyCount * DT_VERTS_PER_POLYGON + item.index] < item.dist)
+			continue;
+		const float* point = &ltile.points[item.index * 4];
+
+		const dtMeshTile* tile = m_nav->getTile((int)item.tile);
+		const unsigned int ip = item.index / DT_VERTS_PER_POLYGON;
+		const unsigned int edge = item.index % DT_VERTS_PER_POLYGON;
+		const dtPoly* poly = &tile->polys[ip];
+		const bool isConnection = poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION;
+
+		int n = getPolyVertices(tile, ip, verts, DT_LANDMARK_MAX_POLY_VERTS);
+		for (int i = 0; i < n; ++i)
+		{
+			const unsigned int w = (unsigned int)(getVertexDistance(point, verts[i].point) * invScale);
+			if (!relax(verts[i], item.dist + w, landmark))
+				return DT_FAILURE | DT_OUT_OF_MEMORY;
+		}
+
+		const dtPolyRef ref = m_nav->getPolyRefBase(tile) | (dtPolyRef)ip;
+		for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+		{
+			const dtLink* link = &tile->links[i];
+			if (link->edge != edge)
+				continue;
+			unsigned int neiSalt, neiIt, neiIp;
+			m_nav->decodePolyId(link->ref, neiSalt, neiIt, neiIp);
+			if (!isTileKnown(m_tiles[neiIt], neiSalt))
+				continue;
+			const dtMeshTile* neiTile = 0;
+			const dtPoly* neiPoly = 0;
+			m_nav->getTileAndPolyByRefUnsafe(link->ref, &neiTile, &neiPoly);
+
+			if (isConnection)
+			{
+				// The connection end point is in the polygon it is linked to.
+				m_tiles[neiIt].dirty = true;
+				n = getPolyVertices(neiTile, neiIp, verts, DT_LANDMARK_MAX_POLY_VERTS);
+				for (int j = 0; j < n; ++j)
+				{
+					const unsigned int w = (unsigned int)(getVertexDistance(point, verts[j].point) * invScale);
+					if (!relax(verts[j], item.dist + w, landmark))
+						return DT_FAILURE | DT_OUT_OF_MEMORY;
+				}
+			}
+			else if (neiPoly->getType() != DT_POLYTYPE_OFFMESH_CONNECTION)
+			{
+				for (unsigned int j = neiPoly->firstLink; j != DT_NULL_LINK; j = neiTile->links[j].next)
+				{
+					const dtLink* neiLink = &neiTile->links[j];
+					if (neiLink->ref != ref || neiLink->edge >= neiPoly->vertCount)
+						continue;
+					dtLandmarkVertex v;
+					v.tile = neiIt;
+					v.index = neiIp * DT_VERTS_PER_POLYGON + neiLink->edge;
+					v.point = &m_tiles[neiIt].points[v.index * 4];
+					if (!relax(v, item.dist, landmark))
+						return DT_FAILURE | DT_OUT_OF_MEMORY;
+				}
+			}
+		}
+	}
+	return DT_SUCCESS;
+}
+
+dtStatus dtNavMeshLandmarks::seedLandmark(const dtMeshTile* tile, const int landmark)
+{
+	const float* pos = &m_params.positions[landmark * 3];
+	const dtMeshHeader* header = tile->header;
+	if (pos[0] < header->bmin[0] || pos[0] > header->bmax[0] ||
+		pos[2] < header->bmin[2] || pos[2] > header->bmax[2])
+	{
+		return DT_SUCCESS;
+	}
+
+	float polyVerts[DT_VERTS_PER_POLYGON * 3];
+	dtLandmarkVertex verts[DT_LANDMARK_MAX_POLY_VERTS];
+	for (int i = 0; i < header->polyCount; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+		if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+			continue;
+		float ymin = FLT_MAX, ymax = -FLT_MAX;
+		for (int j = 0; j < (int)poly->vertCount; ++j)
+		{
+			dtVcopy(&polyVerts[j * 3], &tile->verts[poly->verts[j] * 3]);
+			ymin = dtMin(ymin, polyVerts[j * 3 + 1]);
+			ymax = dtMax(ymax, polyVerts[j * 3 + 1]);
+		}
+		if (pos[1] < ymin - header->walkableClimb || pos[1] > ymax + header->walkableClimb ||
+			!dtPointInPolygon(pos, polyVerts, poly->vertCount))
+		{
+			continue;
+		}
+		const int n = getPolyVertices(tile, (unsigned int)i, verts, DT_LANDMARK_MAX_POLY_VERTS);
+		for (int j = 0; j < n; ++j)
+		{
+			if (!relax(verts[j], 0, landmark))
+				return DT_FAILURE | DT_OUT_OF_MEMORY;
+		}
+		break;
+	}
+	return DT_SUCCESS;
+}
+
+/// @par
+///
+/// The first landmark is the polygon farthest from the middle of the navigation mesh,
+/// and each next one the polygon farthest from the landmarks picked before, so
+/// the landmarks end up around the border of the part of the navigation mesh connected
+/// to its middle. The other parts get no landmark.
+///
+/// This runs a search over the whole navigation mesh for each landmark, plus one.
+///
+/// @see dtNavMeshQuery::setLandmarks
+dtStatus dtNavMeshLandmarks::build(const dtNavMesh* nav, const int landmarkCount)
+{
+	if (!nav || landmarkCount < 1 || landmarkCount > DT_MAX_LANDMARKS)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtStatus status = reset(nav);
+	if (dtStatusFailed(status))
+		return status;
+
+	// The distances are stored in units of a scale which covers paths up to
+	// 4 times the diagonal of the navigation mesh.
+	float bmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float bmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		if (!tile->header) continue;
+		dtVmin(bmin, tile->header->bmin);
+		dtVmax(bmax, tile->header->bmax);
+	}
+	m_params.landmarkCount = landmarkCount;
+	m_params.scale = 1.0f;
+	if (bmin[0] <= bmax[0])
+		m_params.scale = dtMax(dtVdist2D(bmin, bmax) * 4.0f / DT_LANDMARK_MAX_DIST, 0.001f);
+
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		if (!tile->header) continue;
+		status = allocTile(tile);
+		if (dtStatusFailed(status))
+			return status;
+	}
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		if (!tile->header) continue;
+		status = updateLinks(tile);
+		if (dtStatusFailed(status))
+			return status;
+	}
+
+	// The search from the polygon nearest the middle of the navigation mesh finds the first landmark.
+	const float mid[3] = { (bmin[0] + bmax[0]) * 0.5f, (bmin[1] + bmax[1]) * 0.5f, (bmin[2] + bmax[2]) * 0.5f };
+	dtVcopy(m_params.positions, mid);
+	float bestDist = FLT_MAX;
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		if (!tile->header) continue;
+		for (int j = 0; j < tile->header->polyCount; ++j)
+		{
+			const dtPoly* poly = &tile->polys[j];
+			if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+				continue;
+			float center[3];
+			dtCalcPolyCenter(center, poly->verts, poly->vertCount, tile->verts);
+			const float d = dtVdistSqr(center, mid);
+			if (d < bestDist)
+			{
+				bestDist = d;
+				dtVcopy(m_params.positions, center);
+			}
+		}
+	}
+
+	for (int k = -1; k < landmarkCount; ++k)
+	{
+		// The probe search from the middle uses the first landmark's distances.
+		const int landmark = dtMax(k, 0);
+		if (k >= 0)
+		{
+			// Pick the polygon whose nearest landmark is the farthest.
+			unsigned int bestScore = 0;
+			for (int i = 0; i < m_maxTiles; ++i)
+			{
+				const dtMeshTile* tile = m_nav->getTile(i);
+				const dtLandmarkTile& ltile = m_tiles[i];
+				if (!tile->header) continue;
+				const int stride = ltile.polyCount * DT_VERTS_PER_POLYGON;
+				for (int j = 0; j < ltile.polyCount; ++j)
+				{
+					const dtPoly* poly = &tile->polys[j];
+					if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+						continue;
+					unsigned int score = DT_LANDMARK_UNKNOWN;
+					for (int e = 0; e < (int)poly->vertCount && score > bestScore; ++e)
+					{
+						if (!poly->neis[e])
+							continue;
+						const int end = k == 0 ? 1 : k;
+						for (int l = 0; l < end; ++l)
+							score = dtMin(score, (unsigned int)ltile.dists[l * stride + j * DT_VERTS_PER_POLYGON + e]);
+					}
+					if (score == DT_LANDMARK_UNKNOWN || score <= bestScore)
+						continue;
+					bestScore = score;
+					dtCalcPolyCenter(&m_params.positions[k * 3], poly->verts, poly->vertCount, tile->verts);
+				}
+			}
+		}
+
+		for (int i = 0; i < m_maxTiles; ++i)
+		{
+			dtLandmarkTile& ltile = m_tiles[i];
+			if (ltile.dists)
+				memset(&ltile.dists[landmark * ltile.polyCount * DT_VERTS_PER_POLYGON], 0xff,
+					   sizeof(unsigned short) * ltile.polyCount * DT_VERTS_PER_POLYGON);
+		}
+		for (int i = 0; i < m_maxTiles; ++i)
+		{
+			const dtMeshTile* tile = m_nav->getTile(i);
+			if (!tile->header) continue;
+			status = seedLandmark(tile, landmark);
+			if (dtStatusFailed(status))
+				return status;
+		}
+		status = propagate(landmark);
+		if (dtStatusFailed(status))
+			return status;
+	}
+
+	updateDirtyBounds();
+	return DT_SUCCESS;
+}
+
+/// @par
+///
+/// The tiles' distances are then restored with restoreTileLandmarks().
+dtStatus dtNavMeshLandmarks::init(const dtNavMesh* nav, const dtNavMeshLandmarksParams* params)
+{
+	if (!nav || !params || params->landmarkCount < 1 || params->landmarkCount > DT_MAX_LANDMARKS ||
+		!(params->scale > 0.0f))
+	{
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+	dtStatus status = reset(nav);
+	if (dtStatusFailed(status))
+		return status;
+	memcpy(&m_params, params, sizeof(dtNavMeshLandmarksParams));
+	return DT_SUCCESS;
+}
+
+/// @par
+///
+/// The distances of the tile start from the neighbour tiles' and from the landmarks
+/// in the tile, and the distances they make shorter in the other tiles are updated, so
+/// this visits the tiles whose distances change. If the tile replaces another one, the
+/// distances which went through the previous tile stay as they were. They are a weaker but
+/// still valid bound.
+dtStatus dtNavMeshLandmarks::addTile(dtTileRef ref)
+{
+	if (!m_nav || !m_tiles)
+		return DT_FAILURE;
+	const dtMeshTile* tile = m_nav->getTileByRef(ref);
+	if (!tile)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtStatus status = allocTile(tile);
+	if (dtStatusFailed(status))
+		return status;
+	status = updateNeighbourhood(tile->header->x, tile->header->y);
+	if (dtStatusFailed(status))
+		return status;
+
+	static const int MAX_NEIS = 32;
+	const dtMeshTile* neis[MAX_NEIS];
+	for (int k = 0; k < m_params.landmarkCount; ++k)
+	{
+		status = seedLandmark(tile, k);
+		if (dtStatusFailed(status))
+			return status;
+
+		// Propagate the distances of the neighbour tiles into the tile.
+		for (int y = tile->header->y - 1; y <= tile->header->y + 1; ++y)
+		{
+			for (int x = tile->header->x - 1; x <= tile->header->x + 1; ++x)
+			{
+				const int nneis = m_nav->getTilesAt(x, y, neis, MAX_NEIS);
+				for (int i = 0; i < nneis; ++i)
+				{
+					if (neis[i] == tile)
+						continue;
+					const unsigned int it = m_nav->decodePolyIdTile(m_nav->getTileRef(neis[i]));
+					const dtLandmarkTile& ltile = m_tiles[it];
+					if (!isTileKnown(ltile, neis[i]->salt))
+						continue;
+					const int count = ltile.polyCount * DT_VERTS_PER_POLYGON;
+					const unsigned short* dists = &ltile.dists[k * count];
+					for (int j = 0; j < count; ++j)
+					{
+						if (dists[j] != DT_LANDMARK_UNKNOWN && !push(dists[j], it, (unsigned int)j))
+							return DT_FAILURE | DT_OUT_OF_MEMORY;
+					}
+				}
+			}
+		}
+
+		status = propagate(k);
+		if (dtStatusFailed(status))
+			return status;
+	}
+
+	updateDirtyBounds();
+	return DT_SUCCESS;
+}
+
+dtStatus dtNavMeshLandmarks::removeTile(dtTileRef ref)
+{
+	if (!m_nav || !m_tiles)
+		return DT_FAILURE;
+	const unsigned int it = m_nav->decodePolyIdTile(ref);
+	if ((int)it >= m_maxTiles || !isTileKnown(m_tiles[it], m_nav->decodePolyIdSalt(ref)))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const int x = m_tiles[it].x;
+	const int y = m_tiles[it].y;
+	freeTile(m_tiles[it]);
+
+	// Connections of the tile may have ended in its neighbours.
+	dtStatus status = updateNeighbourhood(x, y);
+	if (dtStatusFailed(status))
+		return status;
+	updateDirtyBounds();
+	return DT_SUCCESS;
+}
+
+struct dtTileLandmarksHeader
+{
+	int magic;
+	int version;
+	int polyCount;
+	int landmarkCount;
+};
+
+int dtNavMeshLandmarks::getTileLandmarksSize(const dtMeshTile* tile) const
+{
+	if (!tile || !tile->header) return 0;
+	const int headerSize = dtAlign4(sizeof(dtTileLandmarksHeader));
+	const int distSize = dtAlign4(sizeof(unsigned short) * m_params.landmarkCount * tile->header->polyCount * DT_VERTS_PER_POLYGON);
+	return headerSize + distSize;
+}
+
+/// @par
+///
+/// Only the distances of the path vertices are stored, the ranges of the polygons are
+/// recomputed when the distances are restored.
+/// @see #getTileLandmarksSize, #restoreTileLandmarks
+dtStatus dtNavMeshLandmarks::storeTileLandmarks(const dtMeshTile* tile, unsigned char* data, const int maxDataSize) const
+{
+	if (!m_nav || !tile || !tile->header)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	const dtLandmarkTile& ltile = m_tiles[m_nav->decodePolyIdTile(m_nav->getTileRef(tile))];
+	if (!isTileKnown(ltile, tile->salt))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	// Make sure there is enough space to store the distances.
+	const int sizeReq = getTileLandmarksSize(tile);
+	if (maxDataSize < sizeReq)
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+	const int distCount = m_params.landmarkCount * ltile.polyCount * DT_VERTS_PER_POLYGON;
+	dtTileLandmarksHeader* header = dtGetThenAdvanceBufferPointer<dtTileLandmarksHeader>(data, dtAlign4(sizeof(dtTileLandmarksHeader)));
+	unsigned short* dists = dtGetThenAdvanceBufferPointer<unsigned short>(data, dtAlign4(sizeof(unsigned short) * distCount));
+
+	header->magic = DT_LANDMARKS_MAGIC;
+	header->version = DT_LANDMARKS_VERSION;
+	header->polyCount = ltile.polyCount;
+	header->landmarkCount = m_params.landmarkCount;
+	memcpy(dists, ltile.dists, sizeof(unsigned short) * distCount);
+
+	return DT_SUCCESS;
+}
+
+/// @par
+///
+/// The tiles linked to the tile must be in the navigation mesh, so this is called
+/// once all the tiles are added.
+/// @see #storeTileLandmarks
+dtStatus dtNavMeshLandmarks::restoreTileLandmarks(const dtMeshTile* tile, const unsigned char* data, const int maxDataSize)
+{
+	if (!m_nav || !tile || !tile->header)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const int sizeReq = getTileLandmarksSize(tile);
+	if (maxDataSize < sizeReq)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const dtTileLandmarksHeader* header = dtGetThenAdvanceBufferPointer<const dtTileLandmarksHeader>(data, dtAlign4(sizeof(dtTileLandmarksHeader)));
+	if (header->magic != DT_LANDMARKS_MAGIC)
+		return DT_FAILURE | DT_WRONG_MAGIC;
+	if (header->version != DT_LANDMARKS_VERSION)
+		return DT_FAILURE | DT_WRONG_VERSION;
+	if (header->polyCount != tile->header->polyCount || header->landmarkCount != m_params.landmarkCount)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtStatus status = allocTile(tile);
+	if (dtStatusFailed(status))
+		return status;
+	const int distCount = m_params.landmarkCount * header->polyCount * DT_VERTS_PER_POLYGON;
+	const unsigned short* dists = dtGetThenAdvanceBufferPointer<const unsigned short>(data, dtAlign4(sizeof(unsigned short) * distCount));
+	memcpy(m_tiles[m_nav->decodePolyIdTile(m_nav->getTileRef(tile))].dists, dists, sizeof(unsigned short) * distCount);
+
+	status = updateNeighbourhood(tile->header->x, tile->header->y);
+	if (dtStatusFailed(status))
+		return status;
+	updateDirtyBounds();
+	return DT_SUCCESS;
+}
+
+const unsigned short* dtNavMeshLandmarks::getPolyBounds(dtPolyRef ref) const
+{
+	if (!m_tiles)
+		return 0;
+	unsigned int salt, it, ip;
+	m_nav->decodePolyId(ref, salt, it, ip);
+	if ((int)it >= m_maxTiles)
+		return 0;
+	const dtLandmarkTile& ltile = m_tiles[it];
+	if (!isTileKnown(ltile, salt) || (int)ip >= ltile.polyCount)
+		return 0;
+	return &ltile.bounds[ip * m_params.landmarkCount * 2];
+}
+
+/// @par
+///
+/// The distance of any point of a polygon's path vertices to a landmark is within its
+/// range, so a path between two polygons is at least as long as the gap between their
+/// ranges, for each landmark.
+float dtNavMeshLandmarks::getDistanceBound(const unsigned short* from, const unsigned short* to) const
+{
+	unsigned int gap = 0;
+	for (int i = 0; i < m_params.landmarkCount; ++i)
+	{
+		const unsigned int fromMin = from[i * 2 + 0];
+		const unsigned int toMin = to[i * 2 + 0];
+		if (fromMin == DT_LANDMARK_UNKNOWN || toMin == DT_LANDMARK_UNKNOWN)
+			continue;
+		const unsigned int fromMax = from[i * 2 + 1];
+		const unsigned int toMax = to[i * 2 + 1];
+		if (fromMin > toMax)
+			gap = dtMax(gap, fromMin - toMax);
+		else if (toMin > fromMax)
+			gap = dtMax(gap, toMin - fromMax);
+	}
+	return gap * m_params.scale;
+}
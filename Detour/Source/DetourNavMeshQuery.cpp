@@ -17,9 +17,13 @@
 //
 
 #include <float.h>
+#include <stdlib.h>
 #include <string.h>
 #include "DetourNavMeshQuery.h"
 #include "DetourNavMesh.h"
+#include "DetourNavMeshLandmarks.h"
+#include "DetourNavMeshWallField.h"
+#include "DetourPortalCache.h"
 #include "DetourNode.h"
 #include "DetourCommon.h"
 #include "DetourMath.h"
@@ -142,9 +146,13 @@ dtPolyQuery::~dtPolyQuery()
 
 dtNavMeshQuery::dtNavMeshQuery() :
 	m_nav(0),
+	m_landmarks(0),
+	m_wallField(0),
 	m_tinyNodePool(0),
 	m_nodePool(0),
-	m_openList(0)
+	m_openList(0),
+	m_reverseNodePool(0),
+	m_reverseOpenList(0)
 {
 	memset(&m_query, 0, sizeof(dtQueryData));
 }
@@ -160,6 +168,19 @@ dtNavMeshQuery::~dtNavMeshQuery()
 	dtFree(m_tinyNodePool);
 	dtFree(m_nodePool);
 	dtFree(m_openList);
+	freeReverseSearch();
+}
+
+void dtNavMeshQuery::freeReverseSearch() const
+{
+	if (m_reverseNodePool)
+		m_reverseNodePool->~dtNodePool();
+	if (m_reverseOpenList)
+		m_reverseOpenList->~dtNodeQueue();
+	dtFree(m_reverseNodePool);
+	dtFree(m_reverseOpenList);
+	m_reverseNodePool = 0;
+	m_reverseOpenList = 0;
 }
 
 /// @par 
@@ -219,6 +240,15 @@ dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes)
 	{
 		m_openList->clear();
 	}
+
+	// The search from the end polygon of bidirectional path queries allocates its nodes on
+	// its first query, it gets them again if they are now too few.
+	if (m_reverseNodePool && m_reverseNodePool->getMaxNodes() < maxNodes)
+		freeReverseSearch();
+	if (m_reverseNodePool)
+		m_reverseNodePool->clear();
+	if (m_reverseOpenList)
+		m_reverseOpenList->clear();
 	
 	return DT_SUCCESS;
 }
@@ -237,7 +267,7 @@ dtStatus dtNavMeshQuery::findRandomPoint(const dtQueryFilter* filter, float (*fr
 	for (int i = 0; i < m_nav->getMaxTiles(); i++)
 	{
 		const dtMeshTile* t = m_nav->getTile(i);
-		if (!t || !t->header) continue;
+		if (!t || !t->header || (t->flags & DT_TILE_REMOVED)) continue;
 		
 		// Choose random tile using reservoir sampling.
 		const float area = 1.0f; // Could be tile area too.
@@ -959,55 +989,48 @@ dtStatus dtNavMeshQuery::queryPolygons(const float* center, const float* halfExt
 	return DT_SUCCESS;
 }
 
-/// @par
-///
-/// If the end polygon cannot be reached through the navigation graph,
-/// the last polygon in the path will be the nearest the end polygon.
-///
-/// If the path array is to small to hold the full result, it will be filled as 
-/// far as possible from the start polygon toward the end polygon.
-///
-/// The start and end positions are used to calculate traversal costs. 
-/// (The y-values impact the result.)
-///
-dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
-								  const float* startPos, const float* endPos,
-								  const dtQueryFilter* filter,
-								  dtPolyRef* path, int* pathCount, const int maxPath) const
+// Calls the functions of a filter type without virtual dispatch, for findPathT.
+template <class Filter>
+class dtInlineQueryFilter
 {
-	dtAssert(m_nav);
-	dtAssert(m_nodePool);
-	dtAssert(m_openList);
-
-	if (!pathCount)
-		return DT_FAILURE | DT_INVALID_PARAM;
+public:
+	explicit dtInlineQueryFilter(const Filter* filter) : m_filter(filter) {}
 
-	*pathCount = 0;
-	
-	// Validate input
-	if (!m_nav->isValidPolyRef(startRef) || !m_nav->isValidPolyRef(endRef) ||
-		!startPos || !dtVisfinite(startPos) ||
-		!endPos || !dtVisfinite(endPos) ||
-		!filter || !path || maxPath <= 0)
+	bool passFilter(const dtPolyRef ref, const dtMeshTile* tile, const dtPoly* poly) const
 	{
-		return DT_FAILURE | DT_INVALID_PARAM;
+		return m_filter->Filter::passFilter(ref, tile, poly);
 	}
 
-	if (startRef == endRef)
+	float getCost(const float* pa, const float* pb,
+				  const dtPolyRef prevRef, const dtMeshTile* prevTile, const dtPoly* prevPoly,
+				  const dtPolyRef curRef, const dtMeshTile* curTile, const dtPoly* curPoly,
+				  const dtPolyRef nextRef, const dtMeshTile* nextTile, const dtPoly* nextPoly) const
 	{
-		path[0] = startRef;
-		*pathCount = 1;
-		return DT_SUCCESS;
+		return m_filter->Filter::getCost(pa, pb,
+										 prevRef, prevTile, prevPoly,
+										 curRef, curTile, curPoly,
+										 nextRef, nextTile, nextPoly);
 	}
-	
+
+private:
+	const Filter* m_filter;
+};
+
+template <class Filter>
+dtStatus dtNavMeshQuery::searchPath(dtPolyRef startRef, dtPolyRef endRef,
+									const float* startPos, const float* endPos,
+									const Filter* filter,
+									dtPolyRef* path, int* pathCount, const int maxPath) const
+{
 	m_nodePool->clear();
 	m_openList->clear();
 	
+	const unsigned short* endBounds = getLandmarkBounds(endRef);
 	dtNode* startNode = m_nodePool->getNode(startRef);
 	dtVcopy(startNode->pos, startPos);
 	startNode->pidx = 0;
 	startNode->cost = 0;
-	startNode->total = dtVdist(startPos, endPos) * H_SCALE;
+	startNode->total = getHeuristic(startRef, startPos, endPos, endBounds);
 	startNode->id = startRef;
 	startNode->flags = DT_NODE_OPEN;
 	m_openList->push(startNode);
@@ -1113,7 +1136,7 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 													  bestRef, bestTile, bestPoly,
 													  neighbourRef, neighbourTile, neighbourPoly);
 				cost = bestNode->cost + curCost;
-				heuristic = dtVdist(neighbourNode->pos, endPos)*H_SCALE;
+				heuristic = getHeuristic(neighbourRef, neighbourNode->pos, endPos, endBounds);
 			}
 
 			const float total = cost + heuristic;
@@ -1164,6 +1187,148 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 	return status;
 }
 
+/// @par
+///
+/// If the end polygon cannot be reached through the navigation graph,
+/// the last polygon in the path will be the nearest the end polygon.
+///
+/// If the path array is to small to hold the full result, it will be filled as 
+/// far as possible from the start polygon toward the end polygon.
+///
+/// The start and end positions are used to calculate traversal costs. 
+/// (The y-values impact the result.)
+///
+/// The remaining cost of a node is estimated by the straight line distance to the end
+/// position, or by the bound of the landmarks given to setLandmarks() when it is longer,
+/// which makes the query visit fewer nodes when the path has to go around walls. The
+/// landmarks are only used if they are built for the query's navigation mesh and know
+/// the tile of the end polygon.
+///
+/// With #DT_FINDPATH_BIDIRECTIONAL, a second search runs backward from the end polygon,
+/// and the query stops once no path through the open nodes of both searches can be cheaper
+/// than the cheapest path through adjacent nodes of the two searches. This usually visits
+/// fewer nodes, most when the end is hard to reach, e.g. inside a dead end or behind a
+/// bottleneck. The backward search costs the polygons with the same filter calls as the
+/// forward one, but both place a node on the edge they first reach its polygon through, so
+/// the two modes can return different paths of about the same cost. When the end cannot be
+/// reached, the partial path is the one of the forward search.
+///
+/// The backward search has a node pool of its own, of the size given to init(), which is
+/// allocated by the first bidirectional query, see getReverseNodePool(). The query stops as
+/// soon as either search has no open node left, so when the backward search runs out of
+/// nodes, the partial path ends earlier than the one of a forward only query would.
+///
+dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
+								  const float* startPos, const float* endPos,
+								  const dtQueryFilter* filter,
+								  dtPolyRef* path, int* pathCount, const int maxPath,
+								  const unsigned int options) const
+{
+	dtAssert(m_nav);
+	dtAssert(m_nodePool);
+	dtAssert(m_openList);
+
+	if (!pathCount)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	*pathCount = 0;
+	
+	// Validate input
+	if (!m_nav->isValidPolyRef(startRef) || !m_nav->isValidPolyRef(endRef) ||
+		!startPos || !dtVisfinite(startPos) ||
+		!endPos || !dtVisfinite(endPos) ||
+		!filter || !path || maxPath <= 0)
+	{
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+
+	if (startRef == endRef)
+	{
+		path[0] = startRef;
+		*pathCount = 1;
+		return DT_SUCCESS;
+	}
+
+	if (options & DT_FINDPATH_BIDIRECTIONAL)
+		return findPathBidirectional(startRef, endRef, startPos, endPos, filter, path, pathCount, maxPath);
+
+	return searchPath(startRef, endRef, startPos, endPos, filter, path, pathCount, maxPath);
+}
+
+/// @par
+///
+/// Searches the same way as findPath without options, with the same costs for the same
+/// filter functions, but calls the functions of @p Filter itself, without virtual dispatch
+/// even with #DT_VIRTUAL_QUERYFILTER, so that the compiler can inline them into the search.
+/// A filter of a class derived from @p Filter is used with the functions of @p Filter.
+///
+/// The search stays in DetourNavMeshQuery.cpp, so the function is only available for the
+/// filter types it is instantiated for at the end of that file: dtQueryFilter. Another
+/// filter type, with the passFilter and getCost functions of dtQueryFilter, is added
+/// with its own explicit instantiation there.
+///
+/// #DT_FINDPATH_BIDIRECTIONAL is not available, its search only takes a dtQueryFilter.
+///
+template <class Filter>
+dtStatus dtNavMeshQuery::findPathT(dtPolyRef startRef, dtPolyRef endRef,
+								   const float* startPos, const float* endPos,
+								   const Filter* filter,
+								   dtPolyRef* path, int* pathCount, const int maxPath) const
+{
+	dtAssert(m_nav);
+	dtAssert(m_nodePool);
+	dtAssert(m_openList);
+
+	if (!pathCount)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	*pathCount = 0;
+	
+	// Validate input
+	if (!m_nav->isValidPolyRef(startRef) || !m_nav->isValidPolyRef(endRef) ||
+		!startPos || !dtVisfinite(startPos) ||
+		!endPos || !dtVisfinite(endPos) ||
+		!filter || !path || maxPath <= 0)
+	{
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+
+	if (startRef == endRef)
+	{
+		path[0] = startRef;
+		*pathCount = 1;
+		return DT_SUCCESS;
+	}
+
+	const dtInlineQueryFilter<Filter> inlineFilter(filter);
+	return searchPath(startRef, endRef, startPos, endPos, &inlineFilter, path, pathCount, maxPath);
+}
+
+template dtStatus dtNavMeshQuery::findPathT<dtQueryFilter>(dtPolyRef startRef, dtPolyRef endRef,
+														   const float* startPos, const float* endPos,
+														   const dtQueryFilter* filter,
+														   dtPolyRef* path, int* pathCount, const int maxPath) const;
+
+const unsigned short* dtNavMeshQuery::getLandmarkBounds(dtPolyRef endRef) const
+{
+	// The landmarks of another navigation mesh would not give a valid bound.
+	if (!m_landmarks || m_landmarks->getNavMesh() != m_nav)
+		return 0;
+	return m_landmarks->getPolyBounds(endRef);
+}
+
+float dtNavMeshQuery::getHeuristic(dtPolyRef ref, const float* pos, const float* endPos, const unsigned short* endBounds) const
+{
+	float dist = dtVdist(pos, endPos);
+	if (endBounds)
+	{
+		const unsigned short* bounds = m_landmarks->getPolyBounds(ref);
+		if (bounds)
+			dist = dtMax(dist, m_landmarks->getDistanceBound(bounds, endBounds));
+	}
+	return dist * H_SCALE;
+}
+
 dtStatus dtNavMeshQuery::getPathToNode(dtNode* endNode, dtPolyRef* path, int* pathCount, int maxPath) const
 {
 	// Find the length of the entire path.
@@ -1205,6 +1370,436 @@ dtStatus dtNavMeshQuery::getPathToNode(dtNode* endNode, dtPolyRef* path, int* pa
 }
 
 
+// Potential of the forward search of a bidirectional path query, the reverse search uses its
+// opposite. Half the difference of the distances to the end and the start, it never drops by
+// more than the cost of a move, in both directions, as long as the costs are at least the distance.
+static float getBidirectionalPotential(const float* pos, const float* startPos, const float* endPos)
+{
+	return 0.5f * H_SCALE * (dtVdist(pos, endPos) - dtVdist(pos, startPos));
+}
+
+// State of a bidirectional path query.
+struct dtBidirectionalSearch
+{
+	const float* startPos;
+	const float* endPos;
+	const dtQueryFilter* filter;
+
+	// Cheapest path found so far, through a node of each search.
+	float meetCost;
+	dtNode* meetForward;
+	dtNode* meetReverse;
+
+	// Nearest node to the end of the forward search.
+	dtNode* lastBestNode;
+	float lastBestNodeCost;
+
+	bool outOfNodes;
+
+	// Tiles around the tile last expanded by the reverse search which have one way off-mesh connections.
+	const dtMeshTile* conTile;
+	const dtMeshTile* conTiles[32];
+	int nconTiles;
+};
+
+// Returns true if the polygon has a link to the given polygon.
+static bool hasLinkTo(const dtMeshTile* tile, const dtPoly* poly, const dtPolyRef ref)
+{
+	for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+	{
+		if (tile->links[i].ref == ref)
+			return true;
+	}
+	return false;
+}
+
+dtStatus dtNavMeshQuery::findPathBidirectional(dtPolyRef startRef, dtPolyRef endRef,
+											   const float* startPos, const float* endPos,
+											   const dtQueryFilter* filter,
+											   dtPolyRef* path, int* pathCount, const int maxPath) const
+{
+	if (!m_reverseNodePool || !m_reverseOpenList)
+	{
+		const int maxNodes = m_nodePool->getMaxNodes();
+		freeReverseSearch();
+		m_reverseNodePool = new (dtAlloc(sizeof(dtNodePool), DT_ALLOC_PERM)) dtNodePool(maxNodes, dtNextPow2(maxNodes/4));
+		m_reverseOpenList = new (dtAlloc(sizeof(dtNodeQueue), DT_ALLOC_PERM)) dtNodeQueue(maxNodes);
+		if (!m_reverseNodePool || !m_reverseOpenList)
+		{
+			freeReverseSearch();
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+		}
+	}
+
+	m_nodePool->clear();
+	m_openList->clear();
+	m_reverseNodePool->clear();
+	m_reverseOpenList->clear();
+
+	dtNode* startNode = m_nodePool->getNode(startRef);
+	dtVcopy(startNode->pos, startPos);
+	startNode->pidx = 0;
+	startNode->cost = 0;
+	startNode->total = getBidirectionalPotential(startPos, startPos, endPos);
+	startNode->id = startRef;
+	startNode->flags = DT_NODE_OPEN;
+	m_openList->push(startNode);
+
+	// The reverse search costs its nodes up to the end position, its parents lead to the end polygon.
+	dtNode* endNode = m_reverseNodePool->getNode(endRef);
+	dtVcopy(endNode->pos, endPos);
+	endNode->pidx = 0;
+	endNode->cost = 0;
+	endNode->total = -getBidirectionalPotential(endPos, startPos, endPos);
+	endNode->id = endRef;
+	endNode->flags = DT_NODE_OPEN;
+	m_reverseOpenList->push(endNode);
+
+	dtBidirectionalSearch search;
+	search.startPos = startPos;
+	search.endPos = endPos;
+	search.filter = filter;
+	search.meetCost = FLT_MAX;
+	search.meetForward = 0;
+	search.meetReverse = 0;
+	search.lastBestNode = startNode;
+	search.lastBestNodeCost = dtVdist(startPos, endPos) * H_SCALE;
+	search.outOfNodes = false;
+	search.conTile = 0;
+	search.nconTiles = 0;
+
+	while (!m_openList->empty() && !m_reverseOpenList->empty())
+	{
+		// The searches use opposite potentials, which makes them a bidirectional Dijkstra
+		// search over the same reduced costs. A path through open nodes of both searches
+		// then costs at least the sum of their totals.
+		if (m_openList->top()->total + m_reverseOpenList->top()->total >= search.meetCost)
+			break;
+
+		// Expand the search which has visited less nodes.
+		const bool reverse = m_reverseNodePool->getNodeCount() < m_nodePool->getNodeCount();
+		dtNodeQueue* openList = reverse ? m_reverseOpenList : m_openList;
+
+		// Remove node from open list and put it in closed list.
+		dtNode* bestNode = openList->pop();
+		bestNode->flags &= ~DT_NODE_OPEN;
+		bestNode->flags |= DT_NODE_CLOSED;
+
+		expandBidirectionalNode(bestNode, reverse, search);
+	}
+
+	dtStatus status;
+	if (search.meetForward)
+	{
+		status = getPathThroughNodes(search.meetForward, search.meetReverse, path, pathCount, maxPath);
+	}
+	else
+	{
+		status = getPathToNode(search.lastBestNode, path, pathCount, maxPath);
+		status |= DT_PARTIAL_RESULT;
+	}
+
+	if (search.outOfNodes)
+		status |= DT_OUT_OF_NODES;
+
+	return status;
+}
+
+void dtNavMeshQuery::expandBidirectionalNode(dtNode* bestNode, const bool reverse, dtBidirectionalSearch& search) const
+{
+	const dtQueryFilter* filter = search.filter;
+	dtNodePool* nodePool = reverse ? m_reverseNodePool : m_nodePool;
+	dtNodePool* otherNodePool = reverse ? m_nodePool : m_reverseNodePool;
+	dtNodeQueue* openList = reverse ? m_reverseOpenList : m_openList;
+
+	// Get current poly and tile.
+	// The API input has been checked already, skip checking internal data.
+	const dtPolyRef bestRef = bestNode->id;
+	const dtMeshTile* bestTile = 0;
+	const dtPoly* bestPoly = 0;
+	m_nav->getTileAndPolyByRefUnsafe(bestRef, &bestTile, &bestPoly);
+
+	// Get parent poly and tile, the next polygon toward the end for the reverse search.
+	dtPolyRef parentRef = 0;
+	const dtMeshTile* parentTile = 0;
+	const dtPoly* parentPoly = 0;
+	if (bestNode->pidx)
+		parentRef = nodePool->getNodeAtIdx(bestNode->pidx)->id;
+	if (parentRef)
+		m_nav->getTileAndPolyByRefUnsafe(parentRef, &parentTile, &parentPoly);
+
+	// The reverse search follows the links which have a link back. The links of one way off-mesh
+	// connections only go from the connection to its end polygon, so the connections landing on
+	// the polygon are looked up in the tiles they can be in, which are the neighbours of its tile.
+	if (reverse && bestTile != search.conTile)
+	{
+		static const int MAX_NEIS = 32;
+		const dtMeshTile* neis[MAX_NEIS];
+		int nneis = 0;
+		for (int y = -1; y <= 1; ++y)
+		{
+			for (int x = -1; x <= 1; ++x)
+				nneis += m_nav->getTilesAt(bestTile->header->x + x, bestTile->header->y + y, neis + nneis, MAX_NEIS - nneis);
+		}
+		search.conTile = bestTile;
+		search.nconTiles = 0;
+		for (int i = 0; i < nneis; ++i)
+		{
+			for (int j = 0; j < neis[i]->header->offMeshConCount; ++j)
+			{
+				if (!(neis[i]->offMeshCons[j].flags & DT_OFFMESH_CON_BIDIR))
+				{
+					search.conTiles[search.nconTiles++] = neis[i];
+					break;
+				}
+			}
+		}
+	}
+	const int nneis = reverse ? search.nconTiles : 0;
+
+	unsigned int linkIdx = bestPoly->firstLink;
+	int neiIdx = 0;
+	int conIdx = 0;
+	for (;;)
+	{
+		dtPolyRef neighbourRef = 0;
+		unsigned char crossSide = 0;
+		if (linkIdx != DT_NULL_LINK)
+		{
+			const dtLink& link = bestTile->links[linkIdx];
+			linkIdx = link.next;
+			neighbourRef = link.ref;
+			// deal explicitly with crossing tile boundaries
+			if (link.side != 0xff)
+				crossSide = link.side >> 1;
+		}
+		else if (neiIdx < nneis)
+		{
+			const dtMeshTile* tile = search.conTiles[neiIdx];
+			if (conIdx >= tile->header->offMeshConCount)
+			{
+				neiIdx++;
+				conIdx = 0;
+				continue;
+			}
+			const dtOffMeshConnection& con = tile->offMeshCons[conIdx++];
+			if (con.flags & DT_OFFMESH_CON_BIDIR)
+				continue;
+			const dtPoly* conPoly = &tile->polys[con.poly];
+			if (!hasLinkTo(tile, conPoly, bestRef))
+				continue;
+			neighbourRef = m_nav->getPolyRefBase(tile) | (dtPolyRef)con.poly;
+		}
+		else
+		{
+			break;
+		}
+
+		// Skip invalid ids and do not expand back to where we came from.
+		if (!neighbourRef || neighbourRef == parentRef)
+			continue;
+
+		// Get neighbour poly and tile.
+		// The API input has been checked already, skip checking internal data.
+		const dtMeshTile* neighbourTile = 0;
+		const dtPoly* neighbourPoly = 0;
+		m_nav->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
+
+		if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
+			continue;
+
+		// The reverse search moves from the polygon to the ones that link to it.
+		if (reverse && !hasLinkTo(neighbourTile, neighbourPoly, bestRef))
+			continue;
+
+		// Check the paths through the nodes of the other search at the neighbour.
+		dtNode* otherNodes[DT_MAX_STATES_PER_NODE];
+		const int notherNodes = (int)otherNodePool->findNodes(neighbourRef, otherNodes, DT_MAX_STATES_PER_NODE);
+		for (int j = 0; j < notherNodes; ++j)
+		{
+			dtNode* forwardNode = reverse ? otherNodes[j] : bestNode;
+			dtNode* reverseNode = reverse ? bestNode : otherNodes[j];
+			const float cost = getMeetingCost(forwardNode, reverseNode, filter);
+			if (cost < search.meetCost)
+			{
+				search.meetCost = cost;
+				search.meetForward = forwardNode;
+				search.meetReverse = reverseNode;
+			}
+		}
+
+		// get the node
+		dtNode* neighbourNode = nodePool->getNode(neighbourRef, crossSide);
+		if (!neighbourNode)
+		{
+			search.outOfNodes = true;
+			continue;
+		}
+
+		// If the node is visited the first time, calculate node position.
+		// The position is on the edge the path crosses, which is the same for both searches.
+		if (neighbourNode->flags == 0)
+		{
+			if (reverse)
+			{
+				getEdgeMidPoint(neighbourRef, neighbourPoly, neighbourTile,
+								bestRef, bestPoly, bestTile,
+								neighbourNode->pos);
+			}
+			else
+			{
+				getEdgeMidPoint(bestRef, bestPoly, bestTile,
+								neighbourRef, neighbourPoly, neighbourTile,
+								neighbourNode->pos);
+			}
+		}
+
+		// Cost of crossing the current polygon, from the neighbour for the reverse search.
+		float curCost;
+		if (reverse)
+		{
+			curCost = filter->getCost(neighbourNode->pos, bestNode->pos,
+									  neighbourRef, neighbourTile, neighbourPoly,
+									  bestRef, bestTile, bestPoly,
+									  parentRef, parentTile, parentPoly);
+		}
+		else
+		{
+			curCost = filter->getCost(bestNode->pos, neighbourNode->pos,
+									  parentRef, parentTile, parentPoly,
+									  bestRef, bestTile, bestPoly,
+									  neighbourRef, neighbourTile, neighbourPoly);
+		}
+		const float cost = bestNode->cost + curCost;
+		const float potential = getBidirectionalPotential(neighbourNode->pos, search.startPos, search.endPos);
+		const float total = reverse ? cost - potential : cost + potential;
+
+		// The node is already in open list and the new result is worse, skip.
+		if ((neighbourNode->flags & DT_NODE_OPEN) && total >= neighbourNode->total)
+			continue;
+		// The node is already visited and process, and the new result is worse, skip.
+		if ((neighbourNode->flags & DT_NODE_CLOSED) && total >= neighbourNode->total)
+			continue;
+
+		// Add or update the node.
+		neighbourNode->pidx = nodePool->getNodeIdx(bestNode);
+		neighbourNode->id = neighbourRef;
+		neighbourNode->flags = (neighbourNode->flags & ~DT_NODE_CLOSED);
+		neighbourNode->cost = cost;
+		neighbourNode->total = total;
+
+		if (neighbourNode->flags & DT_NODE_OPEN)
+		{
+			// Already in open, update node location.
+			openList->modify(neighbourNode);
+		}
+		else
+		{
+			// Put the node in open list.
+			neighbourNode->flags |= DT_NODE_OPEN;
+			openList->push(neighbourNode);
+		}
+
+		// Update nearest node to target so far.
+		const float heuristic = reverse ? FLT_MAX : dtVdist(neighbourNode->pos, search.endPos)*H_SCALE;
+		if (heuristic < search.lastBestNodeCost)
+		{
+			search.lastBestNodeCost = heuristic;
+			search.lastBestNode = neighbourNode;
+		}
+	}
+}
+
+float dtNavMeshQuery::getMeetingCost(const dtNode* forwardNode, const dtNode* reverseNode,
+									 const dtQueryFilter* filter) const
+{
+	const dtNode* parentNode = m_nodePool->getNodeAtIdx(forwardNode->pidx);
+	const dtNode* nextNode = m_reverseNodePool->getNodeAtIdx(reverseNode->pidx);
+
+	const dtPolyRef parentRef = parentNode ? parentNode->id : 0;
+	const dtPolyRef forwardRef = forwardNode->id;
+	const dtPolyRef reverseRef = reverseNode->id;
+	const dtPolyRef nextRef = nextNode ? nextNode->id : 0;
+
+	const dtMeshTile* parentTile = 0;
+	const dtPoly* parentPoly = 0;
+	const dtMeshTile* forwardTile = 0;
+	const dtPoly* forwardPoly = 0;
+	const dtMeshTile* reverseTile = 0;
+	const dtPoly* reversePoly = 0;
+	const dtMeshTile* nextTile = 0;
+	const dtPoly* nextPoly = 0;
+	if (parentRef)
+		m_nav->getTileAndPolyByRefUnsafe(parentRef, &parentTile, &parentPoly);
+	m_nav->getTileAndPolyByRefUnsafe(forwardRef, &forwardTile, &forwardPoly);
+	m_nav->getTileAndPolyByRefUnsafe(reverseRef, &reverseTile, &reversePoly);
+	if (nextRef)
+		m_nav->getTileAndPolyByRefUnsafe(nextRef, &nextTile, &nextPoly);
+
+	// The path crosses from the forward polygon to the reverse one at their edge.
+	float mid[3];
+	if (dtStatusFailed(getEdgeMidPoint(forwardRef, forwardPoly, forwardTile,
+									   reverseRef, reversePoly, reverseTile, mid)))
+		return FLT_MAX;
+
+	const float forwardCost = filter->getCost(forwardNode->pos, mid,
+											  parentRef, parentTile, parentPoly,
+											  forwardRef, forwardTile, forwardPoly,
+											  reverseRef, reverseTile, reversePoly);
+	const float reverseCost = filter->getCost(mid, reverseNode->pos,
+											  forwardRef, forwardTile, forwardPoly,
+											  reverseRef, reverseTile, reversePoly,
+											  nextRef, nextTile, nextPoly);
+	return forwardNode->cost + forwardCost + reverseCost + reverseNode->cost;
+}
+
+dtStatus dtNavMeshQuery::getPathThroughNodes(dtNode* forwardNode, dtNode* reverseNode,
+											 dtPolyRef* path, int* pathCount, int maxPath) const
+{
+	// Find the length of the path to the forward node, and the path from the reverse node.
+	int forwardLength = 0;
+	for (dtNode* curNode = forwardNode; curNode; curNode = m_nodePool->getNodeAtIdx(curNode->pidx))
+		forwardLength++;
+	int reverseLength = 0;
+	for (dtNode* curNode = reverseNode; curNode; curNode = m_reverseNodePool->getNodeAtIdx(curNode->pidx))
+		reverseLength++;
+
+	// If the path cannot be fully stored, it is filled from the start.
+	dtNode* curNode = forwardNode;
+	int writeCount;
+	for (writeCount = forwardLength; writeCount > maxPath; writeCount--)
+	{
+		dtAssert(curNode);
+
+		curNode = m_nodePool->getNodeAtIdx(curNode->pidx);
+	}
+
+	// Write the path to the forward node
+	for (int i = writeCount - 1; i >= 0; i--)
+	{
+		dtAssert(curNode);
+
+		path[i] = curNode->id;
+		curNode = m_nodePool->getNodeAtIdx(curNode->pidx);
+	}
+
+	// Write the path from the reverse node, its parents lead to the end.
+	curNode = reverseNode;
+	for (int i = forwardLength; i < maxPath && curNode; i++)
+	{
+		path[i] = curNode->id;
+		curNode = m_reverseNodePool->getNodeAtIdx(curNode->pidx);
+	}
+
+	const int length = forwardLength + reverseLength;
+	*pathCount = dtMin(length, maxPath);
+
+	if (length > maxPath)
+		return DT_SUCCESS | DT_BUFFER_TOO_SMALL;
+
+	return DT_SUCCESS;
+}
+
 /// @par
 ///
 /// @warning Calling any non-slice methods before calling finalizeSlicedFindPath() 
@@ -1265,7 +1860,7 @@ dtStatus dtNavMeshQuery::initSlicedFindPath(dtPolyRef startRef, dtPolyRef endRef
 	dtVcopy(startNode->pos, startPos);
 	startNode->pidx = 0;
 	startNode->cost = 0;
-	startNode->total = dtVdist(startPos, endPos) * H_SCALE;
+	startNode->total = getHeuristic(startRef, startPos, endPos, getLandmarkBounds(endRef));
 	startNode->id = startRef;
 	startNode->flags = DT_NODE_OPEN;
 	m_openList->push(startNode);
@@ -1291,6 +1886,9 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 
 	dtRaycastHit rayHit;
 	rayHit.maxPath = 0;
+	
+	// The landmarks' tiles may have changed since the last update.
+	const unsigned short* endBounds = getLandmarkBounds(m_query.endRef);
 		
 	int iter = 0;
 	while (iter < maxIter && !m_openList->empty())
@@ -1439,7 +2037,7 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 			}
 			else
 			{
-				heuristic = dtVdist(neighbourNode->pos, m_query.endPos)*H_SCALE;
+				heuristic = getHeuristic(neighbourRef, neighbourNode->pos, m_query.endPos, endBounds);
 			}
 			
 			const float total = cost + heuristic;
@@ -1723,7 +2321,86 @@ dtStatus dtNavMeshQuery::appendVertex(const float* pos, const unsigned char flag
 	return DT_IN_PROGRESS;
 }
 
-dtStatus dtNavMeshQuery::appendPortals(const int startIdx, const int endIdx, const float* endPos, const dtPolyRef* path,
+void dtNavMeshQuery::updatePortalCache(dtPortalCache* portals, const dtPolyRef* path, const int pathSize) const
+{
+	if (portals->m_nav != m_nav)
+	{
+		portals->clear();
+		portals->m_nav = m_nav;
+	}
+
+	// The corridor drops polygons from the start of its path as the agent moves,
+	// find the start of the path in the cached one.
+	int offset = 0;
+	while (offset < portals->m_portalCount && portals->m_path[offset] != path[0])
+		offset++;
+
+	// Keep the portals between the polygons the paths have in common.
+	int kept = 0;
+	if (offset < portals->m_portalCount && m_nav->isValidPolyRef(path[0]))
+	{
+		const int n = dtMin(pathSize-1, portals->m_portalCount - offset);
+		while (kept < n && portals->m_path[offset+kept+1] == path[kept+1] && m_nav->isValidPolyRef(path[kept+1]))
+			kept++;
+	}
+	if (kept > 0 && offset > 0)
+	{
+		memmove(portals->m_types, portals->m_types + offset, sizeof(unsigned char)*kept);
+		memmove(portals->m_areas, portals->m_areas + offset, sizeof(unsigned char)*(kept+1));
+		memmove(portals->m_left, portals->m_left + offset*3, sizeof(float)*3*kept);
+		memmove(portals->m_right, portals->m_right + offset*3, sizeof(float)*3*kept);
+	}
+	portals->m_portalCount = kept;
+
+	portals->m_pathSize = dtMin(pathSize, portals->m_maxPathSize);
+	memcpy(portals->m_path, path, sizeof(dtPolyRef)*portals->m_pathSize);
+}
+
+dtStatus dtNavMeshQuery::getPathPortal(dtPortalCache* portals, const dtPolyRef* path, const int i,
+									   float* left, float* right, unsigned char& toType,
+									   unsigned char& fromArea, unsigned char& toArea) const
+{
+	if (portals && i+1 < portals->m_pathSize)
+	{
+		// Extract the portals up to this one, the funnel moves along the path.
+		while (portals->m_portalCount <= i)
+		{
+			const int j = portals->m_portalCount;
+			dtStatus status = getPathPortal(0, portals->m_path, j, &portals->m_left[j*3], &portals->m_right[j*3],
+											portals->m_types[j], portals->m_areas[j], portals->m_areas[j+1]);
+			if (dtStatusFailed(status))
+				return status;
+			portals->m_portalCount++;
+			portals->m_extractCount++;
+		}
+		dtVcopy(left, &portals->m_left[i*3]);
+		dtVcopy(right, &portals->m_right[i*3]);
+		toType = portals->m_types[i];
+		fromArea = portals->m_areas[i];
+		toArea = portals->m_areas[i+1];
+		return DT_SUCCESS;
+	}
+
+	const dtMeshTile* fromTile = 0;
+	const dtPoly* fromPoly = 0;
+	if (dtStatusFailed(m_nav->getTileAndPolyByRef(path[i], &fromTile, &fromPoly)))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const dtMeshTile* toTile = 0;
+	const dtPoly* toPoly = 0;
+	if (dtStatusFailed(m_nav->getTileAndPolyByRef(path[i+1], &toTile, &toPoly)))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	if (dtStatusFailed(getPortalPoints(path[i], fromPoly, fromTile, path[i+1], toPoly, toTile, left, right)))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	toType = toPoly->getType();
+	fromArea = fromPoly->getArea();
+	toArea = toPoly->getArea();
+	return DT_SUCCESS;
+}
+
+dtStatus dtNavMeshQuery::appendPortals(dtPortalCache* portals, const int startIdx, const int endIdx, const float* endPos, const dtPolyRef* path,
 									  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
 									  int* straightPathCount, const int maxStraightPath, const int options) const
 {
@@ -1733,26 +2410,15 @@ dtStatus dtNavMeshQuery::appendPortals(const int startIdx, const int endIdx, con
 	for (int i = startIdx; i < endIdx; i++)
 	{
 		// Calculate portal
-		const dtPolyRef from = path[i];
-		const dtMeshTile* fromTile = 0;
-		const dtPoly* fromPoly = 0;
-		if (dtStatusFailed(m_nav->getTileAndPolyByRef(from, &fromTile, &fromPoly)))
-			return DT_FAILURE | DT_INVALID_PARAM;
-		
-		const dtPolyRef to = path[i+1];
-		const dtMeshTile* toTile = 0;
-		const dtPoly* toPoly = 0;
-		if (dtStatusFailed(m_nav->getTileAndPolyByRef(to, &toTile, &toPoly)))
-			return DT_FAILURE | DT_INVALID_PARAM;
-		
 		float left[3], right[3];
-		if (dtStatusFailed(getPortalPoints(from, fromPoly, fromTile, to, toPoly, toTile, left, right)))
+		unsigned char toType, fromArea, toArea;
+		if (dtStatusFailed(getPathPortal(portals, path, i, left, right, toType, fromArea, toArea)))
 			break;
 	
-		if (options & DT_STRAIGHTPATH_AREA_CROSSINGS)
+	if (options & DT_STRAIGHTPATH_AREA_CROSSINGS)
 		{
 			// Skip intersection if only area crossings are requested.
-			if (fromPoly->getArea() == toPoly->getArea())
+			if (fromArea == toArea)
 				continue;
 		}
 		
@@ -1794,6 +2460,22 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 										  const dtPolyRef* path, const int pathSize,
 										  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
 										  int* straightPathCount, const int maxStraightPath, const int options) const
+{
+	return findStraightPath(startPos, endPos, path, pathSize, 0,
+							straightPath, straightPathFlags, straightPathRefs,
+							straightPathCount, maxStraightPath, options);
+}
+
+/// @par
+///
+/// Gives the same result as findStraightPath() without the portal cache. The
+/// portals of the path are read from the cache, which is first updated to the
+/// path, see dtPortalCache.
+///
+dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* endPos,
+										  const dtPolyRef* path, const int pathSize, dtPortalCache* portals,
+										  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
+										  int* straightPathCount, const int maxStraightPath, const int options) const
 {
 	dtAssert(m_nav);
 
@@ -1810,6 +2492,9 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 		return DT_FAILURE | DT_INVALID_PARAM;
 	}
 	
+	if (portals)
+		updatePortalCache(portals, path, pathSize);
+
 	dtStatus stat = 0;
 	
 	// TODO: Should this be callers responsibility?
@@ -1851,10 +2536,10 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 			
 			if (i+1 < pathSize)
 			{
-				unsigned char fromType; // fromType is ignored.
+				unsigned char fromArea, toArea; // The areas are ignored.
 
 				// Next portal.
-				if (dtStatusFailed(getPortalPoints(path[i], path[i+1], left, right, fromType, toType)))
+				if (dtStatusFailed(getPathPortal(portals, path, i, left, right, toType, fromArea, toArea)))
 				{
 					// Failed to get portal points, in practice this means that path[i+1] is invalid polygon.
 					// Clamp the end point to path[i], and return the path so far.
@@ -1869,7 +2554,7 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 					if (options & (DT_STRAIGHTPATH_AREA_CROSSINGS | DT_STRAIGHTPATH_ALL_CROSSINGS))
 					{
 						// Ignore status return value as we're just about to return anyway.
-						appendPortals(apexIndex, i, closestEndPos, path,
+						appendPortals(portals, apexIndex, i, closestEndPos, path,
 											 straightPath, straightPathFlags, straightPathRefs,
 											 straightPathCount, maxStraightPath, options);
 					}
@@ -1914,7 +2599,7 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 					// Append portals along the current straight path segment.
 					if (options & (DT_STRAIGHTPATH_AREA_CROSSINGS | DT_STRAIGHTPATH_ALL_CROSSINGS))
 					{
-						stat = appendPortals(apexIndex, leftIndex, portalLeft, path,
+						stat = appendPortals(portals, apexIndex, leftIndex, portalLeft, path,
 											 straightPath, straightPathFlags, straightPathRefs,
 											 straightPathCount, maxStraightPath, options);
 						if (stat != DT_IN_PROGRESS)
@@ -1965,7 +2650,7 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 					// Append portals along the current straight path segment.
 					if (options & (DT_STRAIGHTPATH_AREA_CROSSINGS | DT_STRAIGHTPATH_ALL_CROSSINGS))
 					{
-						stat = appendPortals(apexIndex, rightIndex, portalRight, path,
+						stat = appendPortals(portals, apexIndex, rightIndex, portalRight, path,
 											 straightPath, straightPathFlags, straightPathRefs,
 											 straightPathCount, maxStraightPath, options);
 						if (stat != DT_IN_PROGRESS)
@@ -2005,7 +2690,7 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 		// Append portals along the current straight path segment.
 		if (options & (DT_STRAIGHTPATH_AREA_CROSSINGS | DT_STRAIGHTPATH_ALL_CROSSINGS))
 		{
-			stat = appendPortals(apexIndex, pathSize-1, closestEndPos, path,
+			stat = appendPortals(portals, apexIndex, pathSize-1, closestEndPos, path,
 								 straightPath, straightPathFlags, straightPathRefs,
 								 straightPathCount, maxStraightPath, options);
 			if (stat != DT_IN_PROGRESS)
@@ -2021,6 +2706,152 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 	return DT_SUCCESS | ((*straightPathCount >= maxStraightPath) ? DT_BUFFER_TOO_SMALL : 0);
 }
 
+// Sort key of a query of a path batch.
+struct dtPathBatchItem
+{
+	const dtQueryFilter* filter;
+	unsigned int startTile;
+	dtPolyRef startRef;
+	dtPolyRef endRef;
+	int index;
+};
+
+static int comparePathBatchItems(const void* va, const void* vb)
+{
+	const dtPathBatchItem* a = (const dtPathBatchItem*)va;
+	const dtPathBatchItem* b = (const dtPathBatchItem*)vb;
+	if (a->filter != b->filter)
+		return a->filter < b->filter ? -1 : 1;
+	if (a->startTile != b->startTile)
+		return a->startTile < b->startTile ? -1 : 1;
+	if (a->startRef != b->startRef)
+		return a->startRef < b->startRef ? -1 : 1;
+	if (a->endRef != b->endRef)
+		return a->endRef < b->endRef ? -1 : 1;
+	return a->index - b->index;
+}
+
+static bool samePathRequest(const dtPathRequest& a, const dtPathRequest& b)
+{
+	return a.startRef == b.startRef && a.endRef == b.endRef && a.filter == b.filter &&
+		a.startPos[0] == b.startPos[0] && a.startPos[1] == b.startPos[1] && a.startPos[2] == b.startPos[2] &&
+		a.endPos[0] == b.endPos[0] && a.endPos[1] == b.endPos[1] && a.endPos[2] == b.endPos[2];
+}
+
+/// @par
+///
+/// Each query gives the same result as calling findPath(), followed by findStraightPath()
+/// on the polygon path when @p straightPath is given. dtPathResult::straightPathStatus is zero
+/// when the straight path is not searched.
+///
+/// The queries are run grouped by filter and by the tile of their start polygon, so that
+/// consecutive searches reuse the nodes and tiles left in cache by the one before. A query
+/// identical to the query run before it is not searched again, its result points to the same
+/// part of the path arrays.
+///
+/// The paths are packed one after the other in the order the queries are run. Each query may
+/// use all the space left in the arrays, so they should be sized for the sum of the expected
+/// paths. Once they are full, the remaining queries fail with #DT_BUFFER_TOO_SMALL, which is
+/// also set in the returned status.
+///
+/// The node pool is shared by the queries, as it is by the calls to findPath().
+///
+dtStatus dtNavMeshQuery::findPathBatch(const dtPathRequest* requests, const int requestCount, dtPathResult* results,
+									   dtPolyRef* path, const int maxPath,
+									   float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
+									   const int maxStraightPath, const int options) const
+{
+	dtAssert(m_nav);
+
+	if (!requests || requestCount < 0 || !results ||
+		!path || maxPath <= 0 ||
+		(straightPath && maxStraightPath <= 0))
+	{
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+
+	if (requestCount == 0)
+		return DT_SUCCESS;
+
+	dtPathBatchItem* items = (dtPathBatchItem*)dtAlloc(sizeof(dtPathBatchItem)*requestCount, DT_ALLOC_TEMP);
+	if (!items)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	for (int i = 0; i < requestCount; ++i)
+	{
+		dtPathBatchItem& item = items[i];
+		item.filter = requests[i].filter;
+		item.startTile = m_nav->decodePolyIdTile(requests[i].startRef);
+		item.startRef = requests[i].startRef;
+		item.endRef = requests[i].endRef;
+		item.index = i;
+	}
+	qsort(items, requestCount, sizeof(dtPathBatchItem), comparePathBatchItems);
+
+	dtStatus status = DT_SUCCESS;
+	int pathUsed = 0;
+	int straightPathUsed = 0;
+	const dtPathRequest* prevRequest = 0;
+	const dtPathResult* prevResult = 0;
+
+	for (int i = 0; i < requestCount; ++i)
+	{
+		const dtPathRequest& request = requests[items[i].index];
+		dtPathResult& result = results[items[i].index];
+
+		if (prevRequest && samePathRequest(*prevRequest, request))
+		{
+			result = *prevResult;
+			continue;
+		}
+		prevRequest = &request;
+		prevResult = &result;
+
+		result.pathOffset = pathUsed;
+		result.pathCount = 0;
+		result.straightPathStatus = 0;
+		result.straightPathOffset = straightPathUsed;
+		result.straightPathCount = 0;
+
+		if (pathUsed < maxPath)
+		{
+			result.pathStatus = findPath(request.startRef, request.endRef, request.startPos, request.endPos,
+										 request.filter, path + pathUsed, &result.pathCount, maxPath - pathUsed);
+		}
+		else
+		{
+			result.pathStatus = DT_FAILURE | DT_BUFFER_TOO_SMALL;
+		}
+		pathUsed += result.pathCount;
+
+		if (straightPath && dtStatusSucceed(result.pathStatus))
+		{
+			if (straightPathUsed < maxStraightPath)
+			{
+				result.straightPathStatus = findStraightPath(request.startPos, request.endPos,
+															 path + result.pathOffset, result.pathCount,
+															 straightPath + straightPathUsed*3,
+															 straightPathFlags ? straightPathFlags + straightPathUsed : 0,
+															 straightPathRefs ? straightPathRefs + straightPathUsed : 0,
+															 &result.straightPathCount, maxStraightPath - straightPathUsed,
+															 options);
+			}
+			else
+			{
+				result.straightPathStatus = DT_FAILURE | DT_BUFFER_TOO_SMALL;
+			}
+			straightPathUsed += result.straightPathCount;
+		}
+
+		if ((result.pathStatus | result.straightPathStatus) & DT_BUFFER_TOO_SMALL)
+			status |= DT_BUFFER_TOO_SMALL;
+	}
+
+	dtFree(items);
+
+	return status;
+}
+
 /// @par
 ///
 /// This method is optimized for small delta movement and a small number of 
@@ -2466,6 +3297,109 @@ dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, cons
 dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, const float* endPos,
 								 const dtQueryFilter* filter, const unsigned int options,
 								 dtRaycastHit* hit, dtPolyRef prevRef) const
+{
+	return raycastPolys(startRef, startPos, endPos, filter, options, hit, prevRef, 0);
+}
+
+// The vertices and edges of a polygon, as the raycast tests them.
+struct dtRaycastPoly
+{
+	dtPolyRef ref;
+	const dtMeshTile* tile;
+	const dtPoly* poly;
+	int nv;
+	float vx[DT_VERTS_PER_POLYGON];		// Vertices.
+	float vy[DT_VERTS_PER_POLYGON];
+	float vz[DT_VERTS_PER_POLYGON];
+	float ex[DT_VERTS_PER_POLYGON];		// Edge j, from vertex j to the next one.
+	float ez[DT_VERTS_PER_POLYGON];
+};
+
+// The number of polygons cached by a raycast batch. Must be a power of two.
+static const int DT_RAYCAST_POLY_CACHE_SIZE = 256;
+
+static void initRaycastPoly(dtRaycastPoly& rp, dtPolyRef ref, const dtMeshTile* tile, const dtPoly* poly)
+{
+	rp.ref = ref;
+	rp.tile = tile;
+	rp.poly = poly;
+	rp.nv = (int)poly->vertCount;
+	for (int j = 0; j < rp.nv; ++j)
+	{
+		const float* v = &tile->verts[poly->verts[j]*3];
+		rp.vx[j] = v[0];
+		rp.vy[j] = v[1];
+		rp.vz[j] = v[2];
+	}
+	for (int j = 0; j < rp.nv; ++j)
+	{
+		const int i = j+1 < rp.nv ? j+1 : 0;
+		rp.ex[j] = rp.vx[i] - rp.vx[j];
+		rp.ez[j] = rp.vz[i] - rp.vz[j];
+	}
+}
+
+// Same as dtIntersectSegmentPoly2D, over the edges of a raycast polygon.
+static bool intersectSegmentRaycastPoly(const float* p0, const float* p1, const dtRaycastPoly& rp,
+										float& tmin, float& tmax, int& segMin, int& segMax)
+{
+	static const float EPS = 0.000001f;
+
+	tmin = 0;
+	tmax = 1;
+	segMin = -1;
+	segMax = -1;
+
+	const float dirx = p1[0] - p0[0];
+	const float dirz = p1[2] - p0[2];
+	const int nv = rp.nv;
+
+	// The terms of each edge don't depend on the others, the compiler may compute several at once.
+	float n[DT_VERTS_PER_POLYGON], d[DT_VERTS_PER_POLYGON];
+	for (int j = 0; j < nv; ++j)
+	{
+		n[j] = rp.ez[j]*(p0[0] - rp.vx[j]) - rp.ex[j]*(p0[2] - rp.vz[j]);
+		d[j] = dirz*rp.ex[j] - dirx*rp.ez[j];
+	}
+
+	// Clip in the order of dtIntersectSegmentPoly2D, starting with the edge of the last vertex.
+	// As tmin only grows and tmax only shrinks, the segment misses the polygon if they cross at the end.
+	for (int i = 0, j = nv-1; i < nv; j = i++)
+	{
+		if (fabsf(d[j]) < EPS)
+		{
+			// S is nearly parallel to this edge
+			if (n[j] < 0)
+				return false;
+			continue;
+		}
+		const float t = n[j] / d[j];
+		if (d[j] < 0)
+		{
+			// segment S is entering across this edge
+			if (t > tmin)
+			{
+				tmin = t;
+				segMin = j;
+			}
+		}
+		else
+		{
+			// segment S is leaving across this edge
+			if (t < tmax)
+			{
+				tmax = t;
+				segMax = j;
+			}
+		}
+	}
+
+	return tmin <= tmax;
+}
+
+dtStatus dtNavMeshQuery::raycastPolys(dtPolyRef startRef, const float* startPos, const float* endPos,
+									  const dtQueryFilter* filter, const unsigned int options,
+									  dtRaycastHit* hit, dtPolyRef prevRef, dtRaycastPoly* polyCache) const
 {
 	dtAssert(m_nav);
 
@@ -2487,7 +3421,7 @@ dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, cons
 	}
 	
 	float dir[3], curPos[3], lastPos[3];
-	float verts[DT_VERTS_PER_POLYGON*3+3];	
+	dtRaycastPoly localPoly;
 	int n = 0;
 
 	dtVcopy(curPos, startPos);
@@ -2514,17 +3448,24 @@ dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, cons
 	{
 		// Cast ray against current polygon.
 		
-		// Collect vertices.
-		int nv = 0;
-		for (int i = 0; i < (int)poly->vertCount; ++i)
+		// Collect vertices, or find them in the cache.
+		dtRaycastPoly* rp = &localPoly;
+		if (polyCache)
 		{
-			dtVcopy(&verts[nv*3], &tile->verts[poly->verts[i]*3]);
-			nv++;
+			const unsigned int slot = m_nav->decodePolyIdTile(curRef)*31 + m_nav->decodePolyIdPoly(curRef);
+			rp = &polyCache[slot & (DT_RAYCAST_POLY_CACHE_SIZE-1)];
+			if (rp->ref != curRef)
+				initRaycastPoly(*rp, curRef, tile, poly);
 		}
+		else
+		{
+			initRaycastPoly(*rp, curRef, tile, poly);
+		}
+		const int nv = rp->nv;
 		
 		float tmin, tmax;
 		int segMin, segMax;
-		if (!dtIntersectSegmentPoly2D(startPos, endPos, verts, nv, tmin, tmax, segMin, segMax))
+		if (!intersectSegmentRaycastPoly(startPos, endPos, *rp, tmin, tmax, segMin, segMax))
 		{
 			// Could not hit the polygon, keep the old t and report hit.
 			hit->pathCount = n;
@@ -2643,8 +3584,9 @@ dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, cons
 			// and correct the height (since the raycast moves in 2d)
 			dtVcopy(lastPos, curPos);
 			dtVmad(curPos, startPos, dir, hit->t);
-			float* e1 = &verts[segMax*3];
-			float* e2 = &verts[((segMax+1)%nv)*3];
+			const int b = (segMax+1)%nv;
+			const float e1[3] = { rp->vx[segMax], rp->vy[segMax], rp->vz[segMax] };
+			const float e2[3] = { rp->vx[b], rp->vy[b], rp->vz[b] };
 			float eDir[3], diff[3];
 			dtVsub(eDir, e2, e1);
 			dtVsub(diff, curPos, e1);
@@ -2659,12 +3601,8 @@ dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, cons
 			// No neighbour, we hit a wall.
 			
 			// Calculate hit normal.
-			const int a = segMax;
-			const int b = segMax+1 < nv ? segMax+1 : 0;
-			const float* va = &verts[a*3];
-			const float* vb = &verts[b*3];
-			const float dx = vb[0] - va[0];
-			const float dz = vb[2] - va[2];
+			const float dx = rp->ex[segMax];
+			const float dz = rp->ez[segMax];
 			hit->hitNormal[0] = dz;
 			hit->hitNormal[1] = 0;
 			hit->hitNormal[2] = -dx;
@@ -2694,6 +3632,52 @@ dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, cons
 	return status;
 }
 
+/// @par
+///
+/// Each ray gives the same result as calling raycast().
+///
+/// The polygons crossed by the rays are kept, with the edges the rays are tested against,
+/// in a cache shared by the rays of the batch, so that the rays leaving the same area, e.g.
+/// the line of sight checks of an agent, don't collect them again. The rays are cast in the
+/// order of @p requests, which should keep the rays of the same area together.
+///
+/// The returned status has #DT_BUFFER_TOO_SMALL set when the path of any of the rays did
+/// not fit in its hit. The failure of a ray is only returned in its status.
+///
+dtStatus dtNavMeshQuery::raycastBatch(const dtRaycastRequest* requests, const int requestCount, const unsigned int options,
+									  dtRaycastHit* hits, dtStatus* statuses) const
+{
+	dtAssert(m_nav);
+
+	if (!requests || requestCount < 0 || !hits)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	if (requestCount == 0)
+		return DT_SUCCESS;
+
+	dtRaycastPoly* polyCache = (dtRaycastPoly*)dtAlloc(sizeof(dtRaycastPoly)*DT_RAYCAST_POLY_CACHE_SIZE, DT_ALLOC_TEMP);
+	if (!polyCache)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	for (int i = 0; i < DT_RAYCAST_POLY_CACHE_SIZE; ++i)
+		polyCache[i].ref = 0;
+
+	dtStatus status = DT_SUCCESS;
+	for (int i = 0; i < requestCount; ++i)
+	{
+		const dtRaycastRequest& request = requests[i];
+		const dtStatus rayStatus = raycastPolys(request.startRef, request.startPos, request.endPos, request.filter,
+												options, &hits[i], request.prevRef, polyCache);
+		if (statuses)
+			statuses[i] = rayStatus;
+		if (rayStatus & DT_BUFFER_TOO_SMALL)
+			status |= DT_BUFFER_TOO_SMALL;
+	}
+
+	dtFree(polyCache);
+
+	return status;
+}
+
 /// @par
 ///
 /// At least one result array must be provided.
@@ -3473,6 +4457,11 @@ dtStatus dtNavMeshQuery::getPolyWallSegments(dtPolyRef ref, const dtQueryFilter*
 ///
 /// The normal will become unpredicable if @p hitDist is a very small number.
 ///
+/// Given a wall field with setWallField(), the search first covers the distance
+/// to the wall the field knows for the cell of @p centerPos, and only covers
+/// @p maxRadius when no wall is found within it. The results are the same as
+/// without the field. See dtNavMeshWallField.
+///
 dtStatus dtNavMeshQuery::findDistanceToWall(dtPolyRef startRef, const float* centerPos, const float maxRadius,
 											const dtQueryFilter* filter,
 											float* hitDist, float* hitPos, float* hitNormal) const
@@ -3490,6 +4479,33 @@ dtStatus dtNavMeshQuery::findDistanceToWall(dtPolyRef startRef, const float* cen
 		return DT_FAILURE | DT_INVALID_PARAM;
 	}
 	
+	bool found = false;
+	if (m_wallField && m_wallField->getNavMesh() == m_nav && m_wallField->matchesFilter(filter))
+	{
+		// Any wall found within the radius is the nearest one the whole search would find,
+		// the radius only needs a little slack to cover the wall of the field itself.
+		float wallDist;
+		if (m_wallField->getWallDistance(startRef, centerPos, &wallDist))
+		{
+			const float radius = wallDist*1.001f + 0.001f;
+			if (radius < maxRadius)
+			{
+				dtStatus status = searchDistanceToWall(startRef, centerPos, radius, filter, hitDist, hitPos, hitNormal, &found);
+				if (found)
+					return status;
+			}
+		}
+	}
+	
+	return searchDistanceToWall(startRef, centerPos, maxRadius, filter, hitDist, hitPos, hitNormal, &found);
+}
+
+dtStatus dtNavMeshQuery::searchDistanceToWall(dtPolyRef startRef, const float* centerPos, const float maxRadius,
+											  const dtQueryFilter* filter,
+											  float* hitDist, float* hitPos, float* hitNormal, bool* found) const
+{
+	*found = false;
+	
 	m_nodePool->clear();
 	m_openList->clear();
 	
@@ -3575,6 +4591,7 @@ dtStatus dtNavMeshQuery::findDistanceToWall(dtPolyRef startRef, const float* cen
 			
 			// Hit wall, update radius.
 			radiusSqr = distSqr;
+			*found = true;
 			// Calculate hit pos.
 			hitPos[0] = vj[0] + (vi[0] - vj[0])*tseg;
 			hitPos[1] = vj[1] + (vi[1] - vj[1])*tseg;
@@ -0,0 +1,291 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <float.h>
+#include <string.h>
+#include "DetourNavMeshWallField.h"
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourCommon.h"
+#include "DetourMath.h"
+#include "DetourAlloc.h"
+#include <new>
+
+// Cell without any wall in its tile.
+static const unsigned short DT_WALLFIELD_NONE = 0xffff;
+
+// The maximum number of walls of a tile.
+static const int DT_WALLFIELD_MAX_WALLS = 0xfffe;
+
+struct dtWallFieldTile
+{
+	unsigned int salt;				// Salt of the tile the walls belong to.
+	int x, y;						// Location of the tile, which stays known after it is removed.
+	float bmin[3];					// Minimum bounds of the cells.
+	int width, height;				// Number of cells along x and z.
+	unsigned short* cells;			// Nearest wall of each cell. [width * height]
+	float* walls;					// Wall edges. [(ax, ay, az, bx, by, bz) * wallCount]
+	int wallCount;
+};
+
+dtNavMeshWallField* dtAllocNavMeshWallField()
+{
+	void* mem = dtAlloc(sizeof(dtNavMeshWallField), DT_ALLOC_PERM);
+	if (!mem) return 0;
+	return new(mem) dtNavMeshWallField;
+}
+
+void dtFreeNavMeshWallField(dtNavMeshWallField* field)
+{
+	if (!field) return;
+	field->~dtNavMeshWallField();
+	dtFree(field);
+}
+
+dtNavMeshWallField::dtNavMeshWallField() :
+	m_nav(0),
+	m_tiles(0),
+	m_maxTiles(0)
+{
+	memset(&m_params, 0, sizeof(m_params));
+}
+
+dtNavMeshWallField::~dtNavMeshWallField()
+{
+	for (int i = 0; i < m_maxTiles; ++i)
+		freeTile(m_tiles[i]);
+	dtFree(m_tiles);
+}
+
+void dtNavMeshWallField::freeTile(dtWallFieldTile& wtile)
+{
+	dtFree(wtile.cells);
+	dtFree(wtile.walls);
+	memset(&wtile, 0, sizeof(dtWallFieldTile));
+}
+
+inline bool passFieldFlags(const dtPoly* poly, const dtNavMeshWallFieldParams& params)
+{
+	return (poly->flags & params.includeFlags) != 0 && (poly->flags & params.excludeFlags) == 0;
+}
+
+dtStatus dtNavMeshWallField::buildTile(const dtMeshTile* tile)
+{
+	const dtTileRef ref = m_nav->getTileRef(tile);
+	dtWallFieldTile& wtile = m_tiles[m_nav->decodePolyIdTile(ref)];
+	freeTile(wtile);
+	wtile.salt = m_nav->decodePolyIdSalt(ref);
+	wtile.x = tile->header->x;
+	wtile.y = tile->header->y;
+
+	// Same walls as dtNavMeshQuery::findDistanceToWall, for the polygons passing the flags.
+	const int maxWalls = dtMin(tile->header->polyCount * DT_VERTS_PER_POLYGON, DT_WALLFIELD_MAX_WALLS);
+	if (maxWalls > 0)
+	{
+		wtile.walls = (float*)dtAlloc(sizeof(float) * 6 * maxWalls, DT_ALLOC_PERM);
+		if (!wtile.walls)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+	for (int ip = 0; ip < tile->header->polyCount; ++ip)
+	{
+		const dtPoly* poly = &tile->polys[ip];
+		if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION || !passFieldFlags(poly, m_params))
+			continue;
+		for (int i = 0, j = (int)poly->vertCount-1; i < (int)poly->vertCount; j = i++)
+		{
+			bool solid = true;
+			if (poly->neis[j] & DT_EXT_LINK)
+			{
+				for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+				{
+					const dtLink* link = &tile->links[k];
+					if (link->edge == j)
+					{
+						if (link->ref != 0)
+						{
+							const dtMeshTile* neiTile = 0;
+							const dtPoly* neiPoly = 0;
+							m_nav->getTileAndPolyByRefUnsafe(link->ref, &neiTile, &neiPoly);
+							solid = !passFieldFlags(neiPoly, m_params);
+						}
+						break;
+					}
+				}
+			}
+			else if (poly->neis[j])
+			{
+				solid = !passFieldFlags(&tile->polys[poly->neis[j]-1], m_params);
+			}
+			if (!solid || wtile.wallCount >= maxWalls)
+				continue;
+			dtVcopy(&wtile.walls[wtile.wallCount*6], &tile->verts[poly->verts[j]*3]);
+			dtVcopy(&wtile.walls[wtile.wallCount*6+3], &tile->verts[poly->verts[i]*3]);
+			wtile.wallCount++;
+		}
+	}
+
+	const float cs = m_params.cellSize;
+	dtVcopy(wtile.bmin, tile->header->bmin);
+	wtile.width = dtMax(1, (int)ceilf((tile->header->bmax[0] - tile->header->bmin[0]) / cs));
+	wtile.height = dtMax(1, (int)ceilf((tile->header->bmax[2] - tile->header->bmin[2]) / cs));
+	const int cellCount = wtile.width * wtile.height;
+	wtile.cells = (unsigned short*)dtAlloc(sizeof(unsigned short) * cellCount, DT_ALLOC_PERM);
+	if (!wtile.cells)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	for (int z = 0; z < wtile.height; ++z)
+	{
+		for (int x = 0; x < wtile.width; ++x)
+		{
+			const float center[3] = { wtile.bmin[0] + (x + 0.5f) * cs, 0.0f, wtile.bmin[2] + (z + 0.5f) * cs };
+			unsigned short nearest = DT_WALLFIELD_NONE;
+			float nearestDistSqr = FLT_MAX;
+			for (int i = 0; i < wtile.wallCount; ++i)
+			{
+				float t;
+				const float distSqr = dtDistancePtSegSqr2D(center, &wtile.walls[i*6], &wtile.walls[i*6+3], t);
+				if (distSqr < nearestDistSqr)
+				{
+					nearestDistSqr = distSqr;
+					nearest = (unsigned short)i;
+				}
+			}
+			wtile.cells[x + z * wtile.width] = nearest;
+		}
+	}
+
+	return DT_SUCCESS;
+}
+
+dtStatus dtNavMeshWallField::buildNeighbours(const int x, const int y)
+{
+	static const int MAX_NEIS = 32;
+	const dtMeshTile* neis[MAX_NEIS];
+	for (int ny = y - 1; ny <= y + 1; ++ny)
+	{
+		for (int nx = x - 1; nx <= x + 1; ++nx)
+		{
+			const int nneis = m_nav->getTilesAt(nx, ny, neis, MAX_NEIS);
+			for (int i = 0; i < nneis; ++i)
+			{
+				dtStatus status = buildTile(neis[i]);
+				if (dtStatusFailed(status))
+					return status;
+			}
+		}
+	}
+	return DT_SUCCESS;
+}
+
+dtStatus dtNavMeshWallField::build(const dtNavMesh* nav, const dtNavMeshWallFieldParams* params)
+{
+	if (!nav || !params || !(params->cellSize > 0.0f) || !dtMathIsfinite(params->cellSize))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	for (int i = 0; i < m_maxTiles; ++i)
+		freeTile(m_tiles[i]);
+	dtFree(m_tiles);
+	m_tiles = 0;
+	m_maxTiles = 0;
+	m_nav = 0;
+
+	const int maxTiles = nav->getMaxTiles();
+	m_tiles = (dtWallFieldTile*)dtAlloc(sizeof(dtWallFieldTile) * dtMax(maxTiles, 1), DT_ALLOC_PERM);
+	if (!m_tiles)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	memset(m_tiles, 0, sizeof(dtWallFieldTile) * dtMax(maxTiles, 1));
+	m_maxTiles = maxTiles;
+	m_nav = nav;
+	m_params = *params;
+
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		if (!tile->header) continue;
+		dtStatus status = buildTile(tile);
+		if (dtStatusFailed(status))
+			return status;
+	}
+	return DT_SUCCESS;
+}
+
+dtStatus dtNavMeshWallField::addTile(dtTileRef ref)
+{
+	if (!m_nav || !m_tiles)
+		return DT_FAILURE;
+	const dtMeshTile* tile = m_nav->getTileByRef(ref);
+	if (!tile)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	// The walls of the neighbours on the tile border are now connected to the tile.
+	return buildNeighbours(tile->header->x, tile->header->y);
+}
+
+dtStatus dtNavMeshWallField::removeTile(dtTileRef ref)
+{
+	if (!m_nav || !m_tiles)
+		return DT_FAILURE;
+	const unsigned int it = m_nav->decodePolyIdTile(ref);
+	if ((int)it >= m_maxTiles || !m_tiles[it].cells || m_tiles[it].salt != m_nav->decodePolyIdSalt(ref))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const int x = m_tiles[it].x;
+	const int y = m_tiles[it].y;
+	freeTile(m_tiles[it]);
+	return buildNeighbours(x, y);
+}
+
+bool dtNavMeshWallField::matchesFilter(const dtQueryFilter* filter) const
+{
+	return filter->getIncludeFlags() == m_params.includeFlags && filter->getExcludeFlags() == m_params.excludeFlags;
+}
+
+bool dtNavMeshWallField::getWallDistance(dtPolyRef ref, const float* pos, float* dist) const
+{
+	const unsigned int it = m_nav->decodePolyIdTile(ref);
+	if ((int)it >= m_maxTiles)
+		return false;
+	const dtWallFieldTile& wtile = m_tiles[it];
+	if (!wtile.cells || wtile.salt != m_nav->decodePolyIdSalt(ref))
+		return false;
+
+	const float ics = 1.0f / m_params.cellSize;
+	const int x = dtClamp((int)floorf((pos[0] - wtile.bmin[0]) * ics), 0, wtile.width - 1);
+	const int z = dtClamp((int)floorf((pos[2] - wtile.bmin[2]) * ics), 0, wtile.height - 1);
+	const unsigned short wall = wtile.cells[x + z * wtile.width];
+	if (wall == DT_WALLFIELD_NONE)
+		return false;
+
+	float t;
+	*dist = dtMathSqrtf(dtDistancePtSegSqr2D(pos, &wtile.walls[wall*6], &wtile.walls[wall*6+3], t));
+	return true;
+}
+
+int dtNavMeshWallField::getMemoryUsed() const
+{
+	int size = (int)sizeof(dtWallFieldTile) * m_maxTiles;
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtWallFieldTile& wtile = m_tiles[i];
+		if (!wtile.cells)
+			continue;
+		size += (int)sizeof(unsigned short) * wtile.width * wtile.height;
+		size += (int)sizeof(float) * 6 * wtile.wallCount;
+	}
+	return size;
+}
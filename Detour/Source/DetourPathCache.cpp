@@ -0,0 +1,303 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <string.h>
+#include "DetourPathCache.h"
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourCommon.h"
+#include "DetourAlloc.h"
+#include "DetourAssert.h"
+#include <new>
+
+static const unsigned short DT_PATHCACHE_NULL = 0xffff;
+
+struct dtPathCacheEntry
+{
+	dtPolyRef startRef;
+	dtPolyRef endRef;
+	unsigned int signature;
+	int pathCount;
+	unsigned short next;		// Next entry in the hash bucket, or in the free list.
+	unsigned short lruPrev;
+	unsigned short lruNext;
+};
+
+dtPathCache* dtAllocPathCache()
+{
+	void* mem = dtAlloc(sizeof(dtPathCache), DT_ALLOC_PERM);
+	if (!mem) return 0;
+	return new(mem) dtPathCache;
+}
+
+void dtFreePathCache(dtPathCache* cache)
+{
+	if (!cache) return;
+	cache->~dtPathCache();
+	dtFree(cache);
+}
+
+static inline unsigned int hashKey(dtPolyRef startRef, dtPolyRef endRef, unsigned int signature)
+{
+	// FNV-1a over the bytes of the key.
+	unsigned int h = 2166136261u;
+	const dtPolyRef refs[2] = { startRef, endRef };
+	const unsigned char* bytes = (const unsigned char*)refs;
+	for (int i = 0; i < (int)sizeof(refs); ++i)
+		h = (h ^ bytes[i]) * 16777619u;
+	bytes = (const unsigned char*)&signature;
+	for (int i = 0; i < (int)sizeof(signature); ++i)
+		h = (h ^ bytes[i]) * 16777619u;
+	return h;
+}
+
+dtPathCache::dtPathCache() :
+	m_nav(0),
+	m_entries(0),
+	m_paths(0),
+	m_buckets(0),
+	m_maxPaths(0),
+	m_maxPathSize(0),
+	m_hashSize(0),
+	m_pathCount(0),
+	m_free(DT_PATHCACHE_NULL),
+	m_lruHead(DT_PATHCACHE_NULL),
+	m_lruTail(DT_PATHCACHE_NULL),
+	m_timer(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+dtPathCache::~dtPathCache()
+{
+	dtFree(m_entries);
+	dtFree(m_paths);
+	dtFree(m_buckets);
+}
+
+dtStatus dtPathCache::init(const dtNavMesh* nav, const int maxPaths, const int maxPathSize)
+{
+	if (!nav || maxPaths <= 0 || maxPaths >= (int)DT_PATHCACHE_NULL || maxPathSize <= 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtFree(m_entries);
+	dtFree(m_paths);
+	dtFree(m_buckets);
+	m_entries = 0;
+	m_paths = 0;
+	m_buckets = 0;
+	m_maxPaths = 0;
+	m_maxPathSize = 0;
+
+	const int hashSize = (int)dtNextPow2((unsigned int)maxPaths);
+	m_entries = (dtPathCacheEntry*)dtAlloc(sizeof(dtPathCacheEntry) * maxPaths, DT_ALLOC_PERM);
+	m_paths = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef) * maxPaths * maxPathSize, DT_ALLOC_PERM);
+	m_buckets = (unsigned short*)dtAlloc(sizeof(unsigned short) * hashSize, DT_ALLOC_PERM);
+	if (!m_entries || !m_paths || !m_buckets)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	m_nav = nav;
+	m_maxPaths = maxPaths;
+	m_maxPathSize = maxPathSize;
+	m_hashSize = hashSize;
+	clear();
+	resetStats();
+	return DT_SUCCESS;
+}
+
+void dtPathCache::clear()
+{
+	if (!m_entries)
+		return;
+	memset(m_buckets, 0xff, sizeof(unsigned short) * m_hashSize);
+	for (int i = 0; i < m_maxPaths; ++i)
+		m_entries[i].next = (unsigned short)(i + 1 < m_maxPaths ? i + 1 : DT_PATHCACHE_NULL);
+	m_free = 0;
+	m_lruHead = DT_PATHCACHE_NULL;
+	m_lruTail = DT_PATHCACHE_NULL;
+	m_pathCount = 0;
+}
+
+void dtPathCache::resetStats()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+unsigned int dtPathCache::getFilterSignature(const dtQueryFilter* filter)
+{
+	unsigned int h = 2166136261u;
+	const unsigned int flags = (unsigned int)filter->getIncludeFlags() | ((unsigned int)filter->getExcludeFlags() << 16);
+	h = (h ^ flags) * 16777619u;
+	for (int i = 0; i < DT_MAX_AREAS; ++i)
+	{
+		const float cost = filter->getAreaCost(i);
+		unsigned int bits;
+		memcpy(&bits, &cost, sizeof(bits));
+		h = (h ^ bits) * 16777619u;
+	}
+	return h;
+}
+
+int dtPathCache::findEntry(dtPolyRef startRef, dtPolyRef endRef, unsigned int signature) const
+{
+	const unsigned int bucket = hashKey(startRef, endRef, signature) & (m_hashSize - 1);
+	for (unsigned short i = m_buckets[bucket]; i != DT_PATHCACHE_NULL; i = m_entries[i].next)
+	{
+		const dtPathCacheEntry& e = m_entries[i];
+		if (e.startRef == startRef && e.endRef == endRef && e.signature == signature)
+			return i;
+	}
+	return -1;
+}
+
+bool dtPathCache::isEntryValid(const int idx) const
+{
+	const dtPolyRef* path = &m_paths[idx * m_maxPathSize];
+	const int pathCount = m_entries[idx].pathCount;
+	for (int i = 0; i < pathCount; ++i)
+	{
+		if (!m_nav->isValidPolyRef(path[i]))
+			return false;
+	}
+	return true;
+}
+
+void dtPathCache::unlinkLru(const int idx)
+{
+	dtPathCacheEntry& e = m_entries[idx];
+	if (e.lruPrev != DT_PATHCACHE_NULL)
+		m_entries[e.lruPrev].lruNext = e.lruNext;
+	else
+		m_lruHead = e.lruNext;
+	if (e.lruNext != DT_PATHCACHE_NULL)
+		m_entries[e.lruNext].lruPrev = e.lruPrev;
+	else
+		m_lruTail = e.lruPrev;
+}
+
+void dtPathCache::linkLru(const int idx)
+{
+	dtPathCacheEntry& e = m_entries[idx];
+	e.lruPrev = DT_PATHCACHE_NULL;
+	e.lruNext = m_lruHead;
+	if (m_lruHead != DT_PATHCACHE_NULL)
+		m_entries[m_lruHead].lruPrev = (unsigned short)idx;
+	else
+		m_lruTail = (unsigned short)idx;
+	m_lruHead = (unsigned short)idx;
+}
+
+void dtPathCache::touchEntry(const int idx)
+{
+	if (m_lruHead == idx)
+		return;
+	unlinkLru(idx);
+	linkLru(idx);
+}
+
+void dtPathCache::removeEntry(const int idx)
+{
+	dtPathCacheEntry& e = m_entries[idx];
+	const unsigned int bucket = hashKey(e.startRef, e.endRef, e.signature) & (m_hashSize - 1);
+	unsigned short* link = &m_buckets[bucket];
+	while (*link != idx)
+		link = &m_entries[*link].next;
+	*link = e.next;
+
+	unlinkLru(idx);
+	e.next = m_free;
+	m_free = (unsigned short)idx;
+	m_pathCount--;
+}
+
+void dtPathCache::addEntry(dtPolyRef startRef, dtPolyRef endRef, unsigned int signature,
+						   const dtPolyRef* path, const int pathCount)
+{
+	if (m_free == DT_PATHCACHE_NULL)
+	{
+		removeEntry(m_lruTail);
+		m_stats.evictions++;
+	}
+
+	const int idx = m_free;
+	dtPathCacheEntry& e = m_entries[idx];
+	m_free = e.next;
+
+	e.startRef = startRef;
+	e.endRef = endRef;
+	e.signature = signature;
+	e.pathCount = pathCount;
+	memcpy(&m_paths[idx * m_maxPathSize], path, sizeof(dtPolyRef) * pathCount);
+
+	const unsigned int bucket = hashKey(startRef, endRef, signature) & (m_hashSize - 1);
+	e.next = m_buckets[bucket];
+	m_buckets[bucket] = (unsigned short)idx;
+	linkLru(idx);
+	m_pathCount++;
+	m_stats.stores++;
+}
+
+dtStatus dtPathCache::findPath(const dtNavMeshQuery* query, dtPolyRef startRef, dtPolyRef endRef,
+							   const float* startPos, const float* endPos, const dtQueryFilter* filter,
+							   dtPolyRef* path, int* pathCount, const int maxPath)
+{
+	dtAssert(query);
+
+	if (!m_entries || !filter || !pathCount || !path || maxPath <= 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	// Paths of another navigation mesh can't be shared.
+	if (query->getAttachedNavMesh() != m_nav)
+		return query->findPath(startRef, endRef, startPos, endPos, filter, path, pathCount, maxPath);
+
+	const double begin = m_timer ? m_timer() : 0.0;
+	const unsigned int signature = getFilterSignature(filter);
+
+	int idx = findEntry(startRef, endRef, signature);
+	if (idx != -1 && !isEntryValid(idx))
+	{
+		removeEntry(idx);
+		m_stats.stale++;
+		idx = -1;
+	}
+
+	if (idx != -1)
+	{
+		// Same as findPath, fill the path as far as possible from the start.
+		const dtPathCacheEntry& e = m_entries[idx];
+		const int n = dtMin(e.pathCount, maxPath);
+		memcpy(path, &m_paths[idx * m_maxPathSize], sizeof(dtPolyRef) * n);
+		*pathCount = n;
+		touchEntry(idx);
+		m_stats.hits++;
+		if (m_timer)
+			m_stats.hitTime += m_timer() - begin;
+		return n < e.pathCount ? (DT_SUCCESS | DT_BUFFER_TOO_SMALL) : DT_SUCCESS;
+	}
+
+	const dtStatus status = query->findPath(startRef, endRef, startPos, endPos, filter, path, pathCount, maxPath);
+	m_stats.misses++;
+
+	// Only cache complete paths.
+	if (status == DT_SUCCESS && startRef != endRef && *pathCount <= m_maxPathSize && path[*pathCount - 1] == endRef)
+		addEntry(startRef, endRef, signature, path, *pathCount);
+
+	if (m_timer)
+		m_stats.missTime += m_timer() - begin;
+	return status;
+}
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include "DetourPortalCache.h"
+#include "DetourAlloc.h"
+#include <new>
+
+dtPortalCache* dtAllocPortalCache()
+{
+	void* mem = dtAlloc(sizeof(dtPortalCache), DT_ALLOC_PERM);
+	if (!mem) return 0;
+	return new(mem) dtPortalCache;
+}
+
+void dtFreePortalCache(dtPortalCache* cache)
+{
+	if (!cache) return;
+	cache->~dtPortalCache();
+	dtFree(cache);
+}
+
+dtPortalCache::dtPortalCache() :
+	m_nav(0),
+	m_path(0),
+	m_types(0),
+	m_areas(0),
+	m_left(0),
+	m_right(0),
+	m_maxPathSize(0),
+	m_pathSize(0),
+	m_portalCount(0),
+	m_extractCount(0)
+{
+}
+
+dtPortalCache::~dtPortalCache()
+{
+	dtFree(m_path);
+	dtFree(m_types);
+	dtFree(m_areas);
+	dtFree(m_left);
+	dtFree(m_right);
+}
+
+dtStatus dtPortalCache::init(const int maxPathSize)
+{
+	if (maxPathSize <= 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtFree(m_path);
+	dtFree(m_types);
+	dtFree(m_areas);
+	dtFree(m_left);
+	dtFree(m_right);
+	m_maxPathSize = 0;
+	clear();
+
+	m_path = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef) * maxPathSize, DT_ALLOC_PERM);
+	m_types = (unsigned char*)dtAlloc(sizeof(unsigned char) * maxPathSize, DT_ALLOC_PERM);
+	m_areas = (unsigned char*)dtAlloc(sizeof(unsigned char) * maxPathSize, DT_ALLOC_PERM);
+	m_left = (float*)dtAlloc(sizeof(float) * 3 * maxPathSize, DT_ALLOC_PERM);
+	m_right = (float*)dtAlloc(sizeof(float) * 3 * maxPathSize, DT_ALLOC_PERM);
+	if (!m_path || !m_types || !m_areas || !m_left || !m_right)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	m_maxPathSize = maxPathSize;
+	m_extractCount = 0;
+	return DT_SUCCESS;
+}
+
+void dtPortalCache::clear()
+{
+	m_nav = 0;
+	m_pathSize = 0;
+	m_portalCount = 0;
+}
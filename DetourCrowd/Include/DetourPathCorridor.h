@@ -20,6 +20,7 @@
 #define DETOUTPATHCORRIDOR_H
 
 #include "DetourNavMeshQuery.h"
+#include "DetourPortalCache.h"
 
 /// Represents a dynamic polygon corridor used to plan agent movement.
 /// @ingroup crowd, detour
@@ -31,6 +32,8 @@ class dtPathCorridor
 	dtPolyRef* m_path;
 	int m_npath;
 	int m_maxPath;
+
+	dtPortalCache m_portals;	///< The portals of the path, kept for findCorners.
 	
 public:
 	dtPathCorridor();
@@ -218,6 +218,8 @@ bool dtPathCorridor::init(const int maxPath)
 	m_path = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*maxPath, DT_ALLOC_PERM);
 	if (!m_path)
 		return false;
+	if (dtStatusFailed(m_portals.init(maxPath)))
+		return false;
 	m_npath = 0;
 	m_maxPath = maxPath;
 	return true;
@@ -247,6 +249,8 @@ For example: If the buffers are sized to hold 10 corners, the function will neve
 So if 10 corners are needed, the buffers should be sized for 11 corners.
 
 If the target is within range, it will be the last corner and have a polygon reference id of zero.
+
+The portals of the corridor are kept from one call to the next, see #dtPortalCache.
 */
 int dtPathCorridor::findCorners(float* cornerVerts, unsigned char* cornerFlags,
 							  dtPolyRef* cornerPolys, const int maxCorners,
@@ -258,7 +262,7 @@ int dtPathCorridor::findCorners(float* cornerVerts, unsigned char* cornerFlags,
 	static const float MIN_TARGET_DIST = 0.01f;
 	
 	int ncorners = 0;
-	navquery->findStraightPath(m_pos, m_target, m_path, m_npath,
+	navquery->findStraightPath(m_pos, m_target, m_path, m_npath, &m_portals,
 							   cornerVerts, cornerFlags, cornerPolys, &ncorners, maxCorners);
 	
 	// Prune points in the beginning of the path which are too close.
@@ -19,6 +19,8 @@
 #ifndef RECAST_H
 #define RECAST_H
 
+#include "RecastAlloc.h"
+
 /// The value of PI used by Recast.
 static const float RC_PI = 3.14159265f;
 
@@ -78,15 +80,17 @@ enum rcTimerLabel
 	RC_TIMER_BUILD_DISTANCEFIELD_DIST,
 	/// The time to blur the distance field. (See: #rcBuildDistanceField)
 	RC_TIMER_BUILD_DISTANCEFIELD_BLUR,
-	/// The total time to build the regions. (See: #rcBuildRegions, #rcBuildRegionsMonotone)
+	/// The total time to build the regions. (See: #rcBuildRegions, #rcBuildRegionsMonotone, #rcBuildRegionsParallel)
 	RC_TIMER_BUILD_REGIONS,
-	/// The total time to apply the watershed algorithm. (See: #rcBuildRegions)
+	/// The total time to apply the watershed algorithm. (See: #rcBuildRegions, #rcBuildRegionsParallel)
 	RC_TIMER_BUILD_REGIONS_WATERSHED,
-	/// The time to expand regions while applying the watershed algorithm. (See: #rcBuildRegions)
+	/// The time to expand regions while applying the watershed algorithm. (See: #rcBuildRegions, #rcBuildRegionsParallel)
 	RC_TIMER_BUILD_REGIONS_EXPAND,
-	/// The time to flood regions while applying the watershed algorithm. (See: #rcBuildRegions)
+	/// The time to flood regions while applying the watershed algorithm. (See: #rcBuildRegions, #rcBuildRegionsParallel)
 	RC_TIMER_BUILD_REGIONS_FLOOD,
-	/// The time to filter out small regions. (See: #rcBuildRegions, #rcBuildRegionsMonotone)
+	/// The time to join the regions cut by the partition seams. (See: #rcBuildRegionsParallel)
+	RC_TIMER_BUILD_REGIONS_STITCH,
+	/// The time to filter out small regions. (See: #rcBuildRegions, #rcBuildRegionsMonotone, #rcBuildRegionsParallel)
 	RC_TIMER_BUILD_REGIONS_FILTER,
 	/// The time to build heightfield layers. (See: #rcBuildHeightfieldLayers)
 	RC_TIMER_BUILD_LAYERS, 
@@ -98,6 +102,35 @@ enum rcTimerLabel
 	RC_MAX_TIMERS
 };
 
+/// Memory allocation counters of a build stage or of an allocation hint.
+/// @see rcContext::getAllocStats
+struct rcAllocCounters
+{
+	/// The number of bytes allocated and not freed yet.
+	size_t liveBytes;
+
+	/// For an allocation hint, the highest value #liveBytes reached.
+	/// For a build stage, the highest total of live bytes, whichever stage allocated them, while the stage was running.
+	size_t peakBytes;
+
+	/// The number of allocations.
+	int allocCount;
+};
+
+class rcAllocStats;
+
+/// A set of independent work items that a Recast build step may execute concurrently.
+/// @see rcContext::runTasks
+class rcTaskSet
+{
+public:
+	virtual ~rcTaskSet() {}
+
+	/// Executes a single work item.
+	///  @param[in]		taskIndex	The index of the work item. [Limits: 0 <= value < task count]
+	virtual void runTask(const int taskIndex) = 0;
+};
+
 /// Provides an interface for optional logging and performance tracking of the Recast 
 /// build process.
 /// 
@@ -109,6 +142,16 @@ enum rcTimerLabel
 ///
 /// If no logging or timers are required, just pass an instance of this 
 /// class through the Recast build process.
+///
+/// Build steps that split their work into independent tasks hand them to 
+/// #runTasks, which runs them serially unless #doRunTasks is overridden to 
+/// dispatch them to worker threads.  Tasks never call back into the context, 
+/// but they do allocate through #rcAlloc, so a custom allocator must be 
+/// thread-safe if tasks run concurrently.
+///
+/// The context can also account for the memory allocated through #rcAlloc, 
+/// see #enableAllocStats.  Allocations are charged to the innermost running 
+/// timer, so the statistics are only as fine grained as the timers.
 /// 
 /// @ingroup recast
 class rcContext
@@ -116,8 +159,17 @@ class rcContext
 public:
 	/// Constructor.
 	///  @param[in]		state	TRUE if the logging and performance timers should be enabled.  [Default: true]
-	inline rcContext(bool state = true) : m_logEnabled(state), m_timerEnabled(state) {}
-	virtual ~rcContext() {}
+	inline rcContext(bool state = true) : m_logEnabled(state), m_timerEnabled(state), m_allocStatsEnabled(false), m_allocStats(0) {}
+
+	/// Copy constructor.  The copy has the same logging and timer states, but its allocation 
+	/// statistics start out disabled and empty.
+	inline rcContext(const rcContext& other) : m_logEnabled(other.m_logEnabled), m_timerEnabled(other.m_timerEnabled), m_allocStatsEnabled(false), m_allocStats(0) {}
+
+	/// Destructor.  Must run on the thread that enabled the allocation statistics, if they are enabled.
+	virtual ~rcContext();
+
+	/// Copy assignment.  Copies the logging and timer states, keeping the allocation statistics of this context.
+	inline rcContext& operator=(const rcContext& other) { m_logEnabled = other.m_logEnabled; m_timerEnabled = other.m_timerEnabled; return *this; }
 
 	/// Enables or disables logging.
 	///  @param[in]		state	TRUE if logging should be enabled.
@@ -147,17 +199,50 @@ public:
 
 	/// Starts the specified performance timer.
 	/// @param	label	The category of the timer.
-	inline void startTimer(const rcTimerLabel label) { if (m_timerEnabled) doStartTimer(label); }
+	inline void startTimer(const rcTimerLabel label) { if (m_allocStatsEnabled) pushAllocStage(label); if (m_timerEnabled) doStartTimer(label); }
 
 	/// Stops the specified performance timer.
 	/// @param	label	The category of the timer.
-	inline void stopTimer(const rcTimerLabel label) { if (m_timerEnabled) doStopTimer(label); }
+	inline void stopTimer(const rcTimerLabel label) { if (m_allocStatsEnabled) popAllocStage(label); if (m_timerEnabled) doStopTimer(label); }
 
 	/// Returns the total accumulated time of the specified performance timer.
 	/// @param	label	The category of the timer.
 	/// @return The accumulated time of the timer, or -1 if timers are disabled or the timer has never been started.
 	inline int getAccumulatedTime(const rcTimerLabel label) const { return m_timerEnabled ? doGetAccumulatedTime(label) : -1; }
 
+	/// Executes every work item of a task set and returns once all of them have completed.
+	///  @param[in]		tasks		The work items to execute.
+	///  @param[in]		taskCount	The number of work items.
+	inline void runTasks(rcTaskSet& tasks, const int taskCount) { doRunTasks(tasks, taskCount); }
+
+	/// Enables or disables the allocation statistics.
+	/// 
+	/// While enabled, the context tracks the memory allocated through #rcAlloc on the thread that 
+	/// enabled it, which must be the thread running the build.  Allocations made by tasks running 
+	/// on other threads are not accounted for.
+	///
+	/// Several contexts may enable statistics on the same thread; allocations are charged to the 
+	/// one enabled last.  They can be disabled in any order.  Statistics must be disabled, or the 
+	/// context destroyed, on the thread that enabled them.
+	///  @param[in]		state	TRUE if allocations should be tracked.
+	/// @returns False if the statistics could not be allocated, or could not be disabled because 
+	/// they were enabled on another thread or a custom #rcAllocTracker was bound on top of them.
+	bool enableAllocStats(bool state);
+
+	/// Clears all allocation statistics.  Blocks allocated before the reset are forgotten.
+	void resetAllocStats();
+
+	/// Returns the allocation counters of a build stage.
+	/// @param[in]		label	The timer of the stage.
+	/// @return The allocations made while @p label was the innermost running timer, all zero if 
+	/// allocation statistics have never been enabled.
+	rcAllocCounters getAllocStats(const rcTimerLabel label) const;
+
+	/// Returns the allocation counters of an allocation hint.
+	/// @param[in]		hint	The allocation hint.
+	/// @return The allocations made with @p hint, all zero if allocation statistics have never been enabled.
+	rcAllocCounters getAllocStats(const rcAllocHint hint) const;
+
 protected:
 	/// Clears all log entries.
 	virtual void doResetLog();
@@ -183,12 +268,28 @@ protected:
 	/// @param[in]		label	The category of the timer.
 	/// @return The accumulated time of the timer, or -1 if timers are disabled or the timer has never been started.
 	virtual int doGetAccumulatedTime(const rcTimerLabel label) const { rcIgnoreUnused(label); return -1; }
+
+	/// Executes every work item of a task set.
+	/// The default implementation runs the items serially on the calling thread.
+	///  @param[in]		tasks		The work items to execute.
+	///  @param[in]		taskCount	The number of work items.
+	virtual void doRunTasks(rcTaskSet& tasks, const int taskCount) { for (int i = 0; i < taskCount; ++i) tasks.runTask(i); }
 	
 	/// True if logging is enabled.
 	bool m_logEnabled;
 
 	/// True if the performance timers are enabled.
 	bool m_timerEnabled;
+
+private:
+	void pushAllocStage(const rcTimerLabel label);
+	void popAllocStage(const rcTimerLabel label);
+
+	/// True if allocations are tracked.
+	bool m_allocStatsEnabled;
+
+	/// The allocation statistics, allocated the first time they are enabled.
+	rcAllocStats* m_allocStats;
 };
 
 /// A helper to first start a timer and then stop it when this helper goes out of scope.
@@ -1201,6 +1302,23 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf);
 /// @returns True if the operation completed successfully.
 bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf, int borderSize, int minRegionArea, int mergeRegionArea);
 
+/// Builds region data for the heightfield using watershed partitioning, flooding 
+/// square partitions of the heightfield as independent tasks.
+/// @ingroup recast
+/// @param[in,out]	ctx				The build context to use during the operation. Partitions are
+/// 								flooded through rcContext::runTasks.
+/// @param[in,out]	chf				A populated compact heightfield.
+/// @param[in]		borderSize		The size of the non-navigable border around the heightfield.
+/// 								[Limit: >=0] [Units: vx]
+/// @param[in]		minRegionArea	The minimum number of cells allowed to form isolated island areas.
+/// 								[Limit: >=0] [Units: vx].
+/// @param[in]		mergeRegionArea	Any regions with a span count smaller than this value will, if possible,
+/// 								be merged with larger regions. [Limit: >=0] [Units: vx] 
+/// @param[in]		partitionSize	The width and height of each flooded partition. [Limit: > 0] [Units: vx]
+/// @returns True if the operation completed successfully.
+bool rcBuildRegionsParallel(rcContext* ctx, rcCompactHeightfield& chf, int borderSize, int minRegionArea,
+							int mergeRegionArea, int partitionSize);
+
 /// Builds region data for the heightfield by partitioning the heightfield in non-overlapping layers.
 /// @ingroup recast
 /// @param[in,out]	ctx				The build context to use during the operation.
@@ -1295,6 +1413,23 @@ bool rcBuildHeightfieldLayers(rcContext* ctx, const rcCompactHeightfield& chf,
 							  int borderSize, int walkableHeight,
 							  rcHeightfieldLayerSet& lset);
 
+/// Builds the layer sets of several compact heightfields, such as the tiles of a tile cache.
+/// @ingroup recast
+/// @param[in,out]	ctx				The build context to use during the operation.
+/// @param[in]		count			The number of heightfields. [Limit: >= 0]
+/// @param[in]		chfs			Fully built compact heightfields. [Size: @p count]
+/// @param[in]		borderSize		The size of the non-navigable border around the heightfields. [Limit: >=0] 
+///  								[Units: vx]
+/// @param[in]		walkableHeight	Minimum floor to 'ceiling' height that will still allow the floor area 
+///  								to be considered walkable. [Limit: >= 3] [Units: vx]
+/// @param[out]		lsets			The resulting layer sets, one for each heightfield. (Must be pre-allocated.)
+///  								[Size: @p count]
+/// @param[out]		built			Whether the layers of each heightfield were built. [opt] [Size: @p count]
+/// @returns True if the layers of all the heightfields were built successfully.
+bool rcBuildHeightfieldLayersBatch(rcContext* ctx, const int count, const rcCompactHeightfield* const* chfs,
+								   const int borderSize, const int walkableHeight,
+								   rcHeightfieldLayerSet* const* lsets, bool* built = 0);
+
 /// Builds a contour set from the region outlines in the provided compact heightfield.
 /// @ingroup recast
 /// @param[in,out]	ctx			The build context to use during the operation.
@@ -64,6 +64,137 @@ void* rcAlloc(size_t size, rcAllocHint hint);
 /// @see rcAlloc, rcAllocSetCustom
 void rcFree(void* ptr);
 
+/// Observes the memory allocated and freed through #rcAlloc and #rcFree on a thread.
+/// The tracker is unbound while its functions run, so it may allocate through #rcAlloc itself.
+/// @see rcAllocSetThreadTracker
+class rcAllocTracker
+{
+public:
+	virtual ~rcAllocTracker() {}
+
+	/// Called after a memory block was allocated.
+	///  @param[in]		ptr		The allocated memory block.
+	///  @param[in]		size	The requested size of the block, in bytes.
+	///  @param[in]		hint	The hint the block was allocated with.
+	virtual void trackAlloc(void* ptr, size_t size, rcAllocHint hint) = 0;
+
+	/// Called before a memory block is freed, including blocks that were allocated before 
+	/// the tracker was bound or on other threads.
+	///  @param[in]		ptr		The memory block about to be freed.
+	virtual void trackFree(void* ptr) = 0;
+};
+
+/// Binds an allocation tracker to the calling thread. Allocations made by other threads are not tracked.
+///  @param[in]		tracker		The tracker to bind, or null to track nothing.
+/// @return The tracker previously bound to the calling thread.
+/// @see rcAllocTracker
+rcAllocTracker* rcAllocSetThreadTracker(rcAllocTracker* tracker);
+
+/// A linear allocator for temporary memory.
+///
+/// The arena allocates from a single block by bumping an offset. Freeing the most recent
+/// allocation rewinds the offset, and so does freeing the allocations below it once the most
+/// recent one is gone, so the last-in first-out pattern of Recast's temporary buffers reuses
+/// the same memory over and over. #reset releases everything at once.
+///
+/// While an arena is bound to a thread by #rcScopedTempArena, every #RC_ALLOC_TEMP allocation 
+/// made by #rcAlloc on that thread comes from it. Allocations that do not fit fall back to the 
+/// custom allocation functions.
+///
+/// An arena must only be used by one thread at a time.
+/// @see rcScopedTempArena
+class rcTempArena
+{
+public:
+	rcTempArena();
+	~rcTempArena();
+
+	/// Allocates the arena's memory block from the custom allocation functions. 
+	/// Any previous block is released.
+	///  @param[in]		capacity	The size of the block, in bytes.
+	/// @returns True if the block was allocated.
+	bool init(size_t capacity);
+
+	/// Allocates memory from the arena.
+	///  @param[in]		size	The size, in bytes of memory, to allocate.
+	/// @return A pointer aligned to 16 bytes, or null if the arena has no room left.
+	void* alloc(size_t size);
+
+	/// Releases memory allocated by #alloc.
+	///  @param[in]		ptr		A pointer previously returned by #alloc.
+	void free(void* ptr);
+
+	/// Releases every allocation made from the arena. The peak usage is kept.
+	void reset();
+
+	/// @returns True if @p ptr was allocated from this arena.
+	bool owns(const void* ptr) const { return m_data != 0 && (const unsigned char*)ptr >= m_data && (const unsigned char*)ptr < m_data + m_capacity; }
+
+	/// @returns The size of the arena's memory block, in bytes.
+	size_t getCapacity() const { return m_capacity; }
+
+	/// @returns The number of bytes currently in use, including allocation headers.
+	size_t getUsed() const { return m_top; }
+
+	/// @returns The highest number of bytes in use since the arena was initialized or #resetStats was called.
+	size_t getPeakUsed() const { return m_peak; }
+
+	/// @returns The number of allocations that did not fit into the arena since it was initialized or #resetStats was called.
+	int getOverflowCount() const { return m_overflowCount; }
+
+	/// Restarts the peak usage from the current usage and clears the overflow count, e.g. to 
+	/// measure a single build stage.
+	void resetStats() { m_peak = m_top; m_overflowCount = 0; }
+
+private:
+	friend class rcScopedTempArena;
+	friend void rcFree(void* ptr);
+
+	unsigned char* m_data;
+	size_t m_capacity;
+	size_t m_top;
+	size_t m_peak;
+	size_t m_lastBlock;
+	int m_overflowCount;
+	rcTempArena* m_outer;	///< The arena bound to the thread before this one, while bound.
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	rcTempArena(const rcTempArena&);
+	rcTempArena& operator=(const rcTempArena&);
+};
+
+/// Binds a temporary memory arena to the calling thread for the lifetime of the object,
+/// typically for the duration of a single tile build.
+///
+/// Scopes can be nested; the innermost arena serves the allocations. When the scope ends, the 
+/// previous arena is bound again and the arena is reset, so no temporary memory allocated 
+/// during the scope may outlive it or be freed by another thread.
+///
+/// @code
+/// static rcTempArena arena; // One per worker thread.
+/// arena.init(64*1024*1024);
+/// {
+/// 	rcScopedTempArena scope(arena);
+/// 	rcBuildRegions(ctx, chf, borderSize, minRegionArea, mergeRegionArea);
+/// 	...
+/// }
+/// printf("Peak temp memory %d kB\n", (int)(arena.getPeakUsed() / 1024));
+/// @endcode
+/// @see rcTempArena
+class rcScopedTempArena
+{
+public:
+	explicit rcScopedTempArena(rcTempArena& arena);
+	~rcScopedTempArena();
+
+private:
+	rcTempArena& m_arena;
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	rcScopedTempArena(const rcScopedTempArena&);
+	rcScopedTempArena& operator=(const rcScopedTempArena&);
+};
+
 /// An implementation of operator new usable for placement new. The default one is part of STL (which we don't use).
 /// rcNewTag is a dummy type used to differentiate our operator from the STL one, in case users import both Recast
 /// and STL.
@@ -83,6 +83,333 @@ void rcContext::doResetLog()
 	// Defined out of line to fix the weak v-tables warning
 }
 
+/// Tracks the allocations of a build for rcContext.
+/// Live blocks are kept in an open addressing hash table so that the size and stage of a block
+/// are known when it is freed.
+class rcAllocStats : public rcAllocTracker
+{
+public:
+	rcAllocStats() : m_previous(NULL), m_outer(NULL), m_blocks(NULL), m_capacity(0), m_count(0), m_stageCount(0), m_liveBytes(0)
+	{
+		reset();
+	}
+
+	virtual ~rcAllocStats()
+	{
+		rcFree(m_blocks);
+	}
+
+	void reset()
+	{
+		memset(m_hints, 0, sizeof(m_hints));
+		memset(m_stages, 0, sizeof(m_stages));
+		m_liveBytes = 0;
+		m_count = 0;
+		for (int i = 0; i < m_capacity; ++i)
+			m_blocks[i].ptr = NULL;
+	}
+
+	void pushStage(const rcTimerLabel label)
+	{
+		if (m_stageCount < MAX_STAGE_DEPTH)
+			m_stageStack[m_stageCount] = label;
+		m_stageCount++;
+		updatePeaks();
+	}
+
+	void popStage(const rcTimerLabel label)
+	{
+		// Timers are not always stopped in the reverse order they were started.
+		for (int i = rcMin(m_stageCount, (int)MAX_STAGE_DEPTH) - 1; i >= 0; --i)
+		{
+			if (m_stageStack[i] == label)
+			{
+				for (int j = i; j < rcMin(m_stageCount, (int)MAX_STAGE_DEPTH) - 1; ++j)
+					m_stageStack[j] = m_stageStack[j+1];
+				m_stageCount--;
+				return;
+			}
+		}
+		if (m_stageCount > MAX_STAGE_DEPTH)
+			m_stageCount--;
+	}
+
+	virtual void trackAlloc(void* ptr, size_t size, rcAllocHint hint)
+	{
+		if (m_count*2 >= m_capacity && !grow())
+			return;
+
+		const int stage = m_stageCount > 0 ? m_stageStack[rcMin(m_stageCount, (int)MAX_STAGE_DEPTH) - 1] : -1;
+		Block* block = findSlot(ptr);
+		block->ptr = ptr;
+		block->size = size;
+		block->hint = (int)hint;
+		block->stage = stage;
+		m_count++;
+
+		rcAllocCounters& hintCounters = m_hints[hint];
+		hintCounters.liveBytes += size;
+		hintCounters.peakBytes = rcMax(hintCounters.peakBytes, hintCounters.liveBytes);
+		hintCounters.allocCount++;
+		if (stage >= 0)
+		{
+			m_stages[stage].liveBytes += size;
+			m_stages[stage].allocCount++;
+		}
+		m_liveBytes += size;
+		updatePeaks();
+	}
+
+	virtual void trackFree(void* ptr)
+	{
+		if (m_capacity == 0)
+			return;
+		Block* block = findSlot(ptr);
+		if (block->ptr == NULL)
+			return;
+
+		m_hints[block->hint].liveBytes -= block->size;
+		if (block->stage >= 0)
+			m_stages[block->stage].liveBytes -= block->size;
+		m_liveBytes -= block->size;
+		removeSlot(block);
+	}
+
+	const rcAllocCounters& getStage(const rcTimerLabel label) const { return m_stages[label]; }
+	const rcAllocCounters& getHint(const rcAllocHint hint) const { return m_hints[hint]; }
+
+	/// The tracker that was bound to the thread before this one.
+	rcAllocTracker* m_previous;
+
+	/// The statistics that were bound to the thread before this one.
+	rcAllocStats* m_outer;
+
+private:
+	static const int MAX_STAGE_DEPTH = 16;
+
+	struct Block
+	{
+		void* ptr;
+		size_t size;
+		int hint;
+		int stage;
+	};
+
+	static unsigned int hashPointer(const void* ptr)
+	{
+		const size_t p = (size_t)ptr >> 4;
+		return (unsigned int)(p ^ (p >> 16)) * 0x9e3779b1u;
+	}
+
+	Block* findSlot(const void* ptr)
+	{
+		const int mask = m_capacity - 1;
+		int i = (int)(hashPointer(ptr) & mask);
+		while (m_blocks[i].ptr != NULL && m_blocks[i].ptr != ptr)
+			i = (i + 1) & mask;
+		return &m_blocks[i];
+	}
+
+	void removeSlot(Block* block)
+	{
+		// Shift the following entries back so that no lookup stops early at the freed slot.
+		const int mask = m_capacity - 1;
+		int i = (int)(block - m_blocks);
+		int j = i;
+		for (;;)
+		{
+			j = (j + 1) & mask;
+			if (m_blocks[j].ptr == NULL)
+				break;
+			const int k = (int)(hashPointer(m_blocks[j].ptr) & mask);
+			// Move the entry unless its home slot lies cyclically within (i, j].
+			if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+				continue;
+			m_blocks[i] = m_blocks[j];
+			i = j;
+		}
+		m_blocks[i].ptr = NULL;
+		m_count--;
+	}
+
+	bool grow()
+	{
+		const int capacity = m_capacity ? m_capacity*2 : 1024;
+		Block* blocks = (Block*)rcAlloc(sizeof(Block)*capacity, RC_ALLOC_PERM);
+		if (!blocks)
+			return false;
+		memset(blocks, 0, sizeof(Block)*capacity);
+
+		Block* oldBlocks = m_blocks;
+		const int oldCapacity = m_capacity;
+		m_blocks = blocks;
+		m_capacity = capacity;
+		for (int i = 0; i < oldCapacity; ++i)
+		{
+			if (oldBlocks[i].ptr != NULL)
+				*findSlot(oldBlocks[i].ptr) = oldBlocks[i];
+		}
+		rcFree(oldBlocks);
+		return true;
+	}
+
+	void updatePeaks()
+	{
+		for (int i = 0, n = rcMin(m_stageCount, (int)MAX_STAGE_DEPTH); i < n; ++i)
+		{
+			rcAllocCounters& counters = m_stages[m_stageStack[i]];
+			counters.peakBytes = rcMax(counters.peakBytes, m_liveBytes);
+		}
+	}
+
+	rcAllocCounters m_hints[RC_ALLOC_TEMP+1];
+	rcAllocCounters m_stages[RC_MAX_TIMERS];
+	Block* m_blocks;
+	int m_capacity;
+	int m_count;
+	rcTimerLabel m_stageStack[MAX_STAGE_DEPTH];
+	int m_stageCount;
+	size_t m_liveBytes;
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	rcAllocStats(const rcAllocStats&);
+	rcAllocStats& operator=(const rcAllocStats&);
+};
+
+// Thread local storage without relying on C++11.
+#if !defined(RC_THREAD_LOCAL)
+#	if defined(_MSC_VER)
+#		define RC_THREAD_LOCAL __declspec(thread)
+#	else
+#		define RC_THREAD_LOCAL __thread
+#	endif
+#endif
+
+// The innermost allocation statistics bound to the calling thread.
+static RC_THREAD_LOCAL rcAllocStats* sThreadStats = NULL;
+
+// Unbinds allocation statistics from the calling thread.  Contexts may disable their statistics
+// in any order, so the statistics are unlinked from the middle of the tracker chain if needed.
+// Fails if the statistics were bound on another thread, or if a tracker other than allocation
+// statistics was bound on top of them.
+static bool unbindAllocStats(rcAllocStats* stats)
+{
+	rcAllocStats** link = &sThreadStats;
+	while (*link != NULL && *link != stats)
+	{
+		link = &(*link)->m_outer;
+	}
+	if (*link == NULL)
+	{
+		return false;
+	}
+
+	rcAllocTracker* current = rcAllocSetThreadTracker(NULL);
+	rcAllocSetThreadTracker(current);
+	if (current == stats)
+	{
+		rcAllocSetThreadTracker(stats->m_previous);
+	}
+	else
+	{
+		rcAllocStats* above = sThreadStats;
+		while (above != NULL && above->m_previous != stats)
+		{
+			above = above->m_outer;
+		}
+		if (above == NULL)
+		{
+			return false;
+		}
+		above->m_previous = stats->m_previous;
+	}
+
+	*link = stats->m_outer;
+	stats->m_outer = NULL;
+	stats->m_previous = NULL;
+	return true;
+}
+
+rcContext::~rcContext()
+{
+	if (enableAllocStats(false))
+	{
+		rcDelete(m_allocStats);
+	}
+	else
+	{
+		// The statistics are still bound, most likely to another thread.  Leak them rather than
+		// leave a dangling tracker behind.
+		rcAssert(false);
+	}
+}
+
+bool rcContext::enableAllocStats(bool state)
+{
+	if (state == m_allocStatsEnabled)
+	{
+		return true;
+	}
+	if (state)
+	{
+		if (!m_allocStats)
+		{
+			m_allocStats = rcNew<rcAllocStats>(RC_ALLOC_PERM);
+			if (!m_allocStats)
+			{
+				return false;
+			}
+		}
+		m_allocStats->m_previous = rcAllocSetThreadTracker(m_allocStats);
+		m_allocStats->m_outer = sThreadStats;
+		sThreadStats = m_allocStats;
+	}
+	else if (!unbindAllocStats(m_allocStats))
+	{
+		return false;
+	}
+	m_allocStatsEnabled = state;
+	return true;
+}
+
+void rcContext::resetAllocStats()
+{
+	if (m_allocStats)
+	{
+		m_allocStats->reset();
+	}
+}
+
+rcAllocCounters rcContext::getAllocStats(const rcTimerLabel label) const
+{
+	if (!m_allocStats)
+	{
+		rcAllocCounters empty = { 0, 0, 0 };
+		return empty;
+	}
+	return m_allocStats->getStage(label);
+}
+
+rcAllocCounters rcContext::getAllocStats(const rcAllocHint hint) const
+{
+	if (!m_allocStats)
+	{
+		rcAllocCounters empty = { 0, 0, 0 };
+		return empty;
+	}
+	return m_allocStats->getHint(hint);
+}
+
+void rcContext::pushAllocStage(const rcTimerLabel label)
+{
+	m_allocStats->pushStage(label);
+}
+
+void rcContext::popAllocStage(const rcTimerLabel label)
+{
+	m_allocStats->popStage(label);
+}
+
 rcHeightfield* rcAllocHeightfield()
 {
 	return rcNew<rcHeightfield>(RC_ALLOC_PERM);
@@ -540,3 +867,4 @@ bool rcBuildCompactHeightfield(rcContext* context, const int walkableHeight, con
 
 	return true;
 }
+
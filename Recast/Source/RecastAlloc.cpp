@@ -31,21 +31,182 @@ static void rcFreeDefault(void *ptr)
 static rcAllocFunc* sRecastAllocFunc = rcAllocDefault;
 static rcFreeFunc* sRecastFreeFunc = rcFreeDefault;
 
+// Thread local storage without relying on C++11.
+#if defined(_MSC_VER)
+#	define RC_THREAD_LOCAL __declspec(thread)
+#else
+#	define RC_THREAD_LOCAL __thread
+#endif
+
+// The innermost arena bound to the calling thread.
+static RC_THREAD_LOCAL rcTempArena* sThreadArena = NULL;
+
+// The allocation tracker bound to the calling thread.
+static RC_THREAD_LOCAL rcAllocTracker* sThreadTracker = NULL;
+
 void rcAllocSetCustom(rcAllocFunc* allocFunc, rcFreeFunc* freeFunc)
 {
 	sRecastAllocFunc = allocFunc ? allocFunc : rcAllocDefault;
 	sRecastFreeFunc = freeFunc ? freeFunc : rcFreeDefault;
 }
 
+rcAllocTracker* rcAllocSetThreadTracker(rcAllocTracker* tracker)
+{
+	rcAllocTracker* previous = sThreadTracker;
+	sThreadTracker = tracker;
+	return previous;
+}
+
 void* rcAlloc(size_t size, rcAllocHint hint)
 {
-	return sRecastAllocFunc(size, hint);
+	void* ptr = NULL;
+	if (hint == RC_ALLOC_TEMP && sThreadArena)
+	{
+		ptr = sThreadArena->alloc(size);
+	}
+	if (ptr == NULL)
+	{
+		ptr = sRecastAllocFunc(size, hint);
+	}
+	if (rcUnlikely(sThreadTracker != NULL) && ptr != NULL)
+	{
+		rcAllocTracker* tracker = sThreadTracker;
+		sThreadTracker = NULL;
+		tracker->trackAlloc(ptr, size, hint);
+		sThreadTracker = tracker;
+	}
+	return ptr;
 }
 
 void rcFree(void* ptr)
 {
-	if (ptr != NULL)
+	if (ptr == NULL)
+	{
+		return;
+	}
+	if (rcUnlikely(sThreadTracker != NULL))
 	{
-		sRecastFreeFunc(ptr);
+		rcAllocTracker* tracker = sThreadTracker;
+		sThreadTracker = NULL;
+		tracker->trackFree(ptr);
+		sThreadTracker = tracker;
 	}
+	for (rcTempArena* arena = sThreadArena; arena; arena = arena->m_outer)
+	{
+		if (arena->owns(ptr))
+		{
+			arena->free(ptr);
+			return;
+		}
+	}
+	sRecastFreeFunc(ptr);
+}
+
+namespace
+{
+// Precedes every allocation made from an arena.
+struct rcArenaBlockHeader
+{
+	size_t prev;	// Offset of the previous block's header.
+	size_t freed;	// Non-zero once the block has been freed.
+};
+
+const size_t RC_ARENA_ALIGN = 16;
+const size_t RC_ARENA_HEADER_SIZE = (sizeof(rcArenaBlockHeader) + RC_ARENA_ALIGN-1) & ~(RC_ARENA_ALIGN-1);
+const size_t RC_ARENA_NO_BLOCK = ~(size_t)0;
+}
+
+rcTempArena::rcTempArena() :
+	m_data(NULL),
+	m_capacity(0),
+	m_top(0),
+	m_peak(0),
+	m_lastBlock(RC_ARENA_NO_BLOCK),
+	m_overflowCount(0),
+	m_outer(NULL)
+{
+}
+
+rcTempArena::~rcTempArena()
+{
+	rcAssert(!m_outer && sThreadArena != this);
+	if (m_data)
+		sRecastFreeFunc(m_data);
+}
+
+bool rcTempArena::init(size_t capacity)
+{
+	rcAssert(!m_outer && sThreadArena != this);
+	if (m_data)
+		sRecastFreeFunc(m_data);
+	m_data = NULL;
+	m_capacity = 0;
+	m_peak = 0;
+	m_overflowCount = 0;
+	reset();
+
+	// Allocated from the custom allocator so that the block is aligned like any other allocation.
+	m_data = (unsigned char*)sRecastAllocFunc(capacity, RC_ALLOC_PERM);
+	if (!m_data)
+		return false;
+	m_capacity = capacity;
+	return true;
+}
+
+void* rcTempArena::alloc(size_t size)
+{
+	const size_t alignedSize = (size + RC_ARENA_ALIGN-1) & ~(RC_ARENA_ALIGN-1);
+	if (alignedSize < size || m_capacity - m_top < RC_ARENA_HEADER_SIZE || m_capacity - m_top - RC_ARENA_HEADER_SIZE < alignedSize)
+	{
+		m_overflowCount++;
+		return NULL;
+	}
+
+	rcArenaBlockHeader* header = (rcArenaBlockHeader*)(m_data + m_top);
+	header->prev = m_lastBlock;
+	header->freed = 0;
+	m_lastBlock = m_top;
+	m_top += RC_ARENA_HEADER_SIZE + alignedSize;
+	if (m_top > m_peak)
+		m_peak = m_top;
+
+	return m_data + m_lastBlock + RC_ARENA_HEADER_SIZE;
+}
+
+void rcTempArena::free(void* ptr)
+{
+	rcAssert(owns(ptr));
+	rcArenaBlockHeader* header = (rcArenaBlockHeader*)((unsigned char*)ptr - RC_ARENA_HEADER_SIZE);
+	header->freed = 1;
+
+	// Rewind past every freed block at the top of the arena.
+	while (m_lastBlock != RC_ARENA_NO_BLOCK)
+	{
+		const rcArenaBlockHeader* last = (const rcArenaBlockHeader*)(m_data + m_lastBlock);
+		if (!last->freed)
+			break;
+		m_top = m_lastBlock;
+		m_lastBlock = last->prev;
+	}
+}
+
+void rcTempArena::reset()
+{
+	m_top = 0;
+	m_lastBlock = RC_ARENA_NO_BLOCK;
+}
+
+rcScopedTempArena::rcScopedTempArena(rcTempArena& arena) : m_arena(arena)
+{
+	rcAssert(!arena.m_outer && sThreadArena != &arena);
+	arena.m_outer = sThreadArena;
+	sThreadArena = &arena;
+}
+
+rcScopedTempArena::~rcScopedTempArena()
+{
+	rcAssert(sThreadArena == &m_arena);
+	sThreadArena = m_arena.m_outer;
+	m_arena.m_outer = NULL;
+	m_arena.reset();
 }
@@ -22,26 +22,230 @@
 
 #include <string.h> // for memcpy and memset
 
-/// Sorts the given data in-place using insertion sort.
-///
-/// @param	data		The data to sort
-/// @param	dataLength	The number of elements in @p data
-static void insertSort(unsigned char* data, const int dataLength)
+/// Sorts two values in-place.
+static inline void sortPair(unsigned char& a, unsigned char& b)
+{
+	const unsigned char minValue = rcMin(a, b);
+	b = rcMax(a, b);
+	a = minValue;
+}
+
+/// Finds the median of 9 values using a sorting network, which compiles to branchless min/max operations.
+/// 
+/// @param	values	The values. Their order is scrambled.
+/// @return The median value.
+static unsigned char medianOf9(unsigned char* values)
+{
+	sortPair(values[1], values[2]); sortPair(values[4], values[5]); sortPair(values[7], values[8]);
+	sortPair(values[0], values[1]); sortPair(values[3], values[4]); sortPair(values[6], values[7]);
+	sortPair(values[1], values[2]); sortPair(values[4], values[5]); sortPair(values[7], values[8]);
+	sortPair(values[0], values[3]); sortPair(values[5], values[8]); sortPair(values[4], values[7]);
+	sortPair(values[3], values[6]); sortPair(values[1], values[4]); sortPair(values[2], values[5]);
+	sortPair(values[4], values[7]); sortPair(values[4], values[2]); sortPair(values[6], values[4]);
+	sortPair(values[4], values[2]);
+	return values[4];
+}
+
+namespace
 {
-	for (int valueIndex = 1; valueIndex < dataLength; valueIndex++)
+/// The number of heightfield rows handled by each task of the area filters.
+const int AREA_FILTER_ROWS_PER_TASK = 32;
+
+/// Returns the number of row tasks needed to cover the heightfield.
+int getRowTaskCount(const rcCompactHeightfield& compactHeightfield)
+{
+	return (compactHeightfield.height + AREA_FILTER_ROWS_PER_TASK - 1) / AREA_FILTER_ROWS_PER_TASK;
+}
+
+/// Marks the spans on the boundary of the walkable area with a distance of zero.
+class MarkBoundaryTasks : public rcTaskSet
+{
+public:
+	MarkBoundaryTasks(const rcCompactHeightfield& compactHeightfield, unsigned char* distanceToBoundary)
+		: m_chf(compactHeightfield), m_distanceToBoundary(distanceToBoundary) {}
+
+	virtual void runTask(const int taskIndex)
 	{
-		const unsigned char value = data[valueIndex];
-		int insertionIndex;
-		for (insertionIndex = valueIndex - 1; insertionIndex >= 0 && data[insertionIndex] > value; insertionIndex--)
+		const rcCompactHeightfield& compactHeightfield = m_chf;
+		unsigned char* distanceToBoundary = m_distanceToBoundary;
+		const int xSize = compactHeightfield.width;
+		const int zStride = xSize; // For readability
+		const int minZ = taskIndex * AREA_FILTER_ROWS_PER_TASK;
+		const int maxZ = rcMin(minZ + AREA_FILTER_ROWS_PER_TASK, compactHeightfield.height);
+
+		for (int z = minZ; z < maxZ; ++z)
 		{
-			// Shift over values
-			data[insertionIndex + 1] = data[insertionIndex];
+			for (int x = 0; x < xSize; ++x)
+			{
+				const rcCompactCell& cell = compactHeightfield.cells[x + z * zStride];
+				for (int spanIndex = (int)cell.index, maxSpanIndex = (int)(cell.index + cell.count); spanIndex < maxSpanIndex; ++spanIndex)
+				{
+					if (compactHeightfield.areas[spanIndex] == RC_NULL_AREA)
+					{
+						distanceToBoundary[spanIndex] = 0;
+						continue;
+					}
+					const rcCompactSpan& span = compactHeightfield.spans[spanIndex];
+
+					// Check that there is a non-null adjacent span in each of the 4 cardinal directions.
+					int neighborCount = 0;
+					for (int direction = 0; direction < 4; ++direction)
+					{
+						const int neighborConnection = rcGetCon(span, direction);
+						if (neighborConnection == RC_NOT_CONNECTED)
+						{
+							break;
+						}
+						
+						const int neighborX = x + rcGetDirOffsetX(direction);
+						const int neighborZ = z + rcGetDirOffsetY(direction);
+						const int neighborSpanIndex = (int)compactHeightfield.cells[neighborX + neighborZ * zStride].index + neighborConnection;
+						
+						if (compactHeightfield.areas[neighborSpanIndex] == RC_NULL_AREA)
+						{
+							break;
+						}
+						neighborCount++;
+					}
+					
+					// At least one missing neighbour, so this is a boundary cell.
+					if (neighborCount != 4)
+					{
+						distanceToBoundary[spanIndex] = 0;
+					}
+				}
+			}
 		}
-		
-		// Insert the value in sorted order.
-		data[insertionIndex + 1] = value;
 	}
-}
+
+private:
+	const rcCompactHeightfield& m_chf;
+	unsigned char* m_distanceToBoundary;
+
+	// Explicitly-disabled copy assignment operator.
+	MarkBoundaryTasks& operator=(const MarkBoundaryTasks&);
+};
+
+/// Removes the spans that are closer to the boundary than the erosion radius from the walkable area.
+class ErodeSpansTasks : public rcTaskSet
+{
+public:
+	ErodeSpansTasks(rcCompactHeightfield& compactHeightfield, const unsigned char* distanceToBoundary, unsigned char minBoundaryDistance)
+		: m_chf(compactHeightfield), m_distanceToBoundary(distanceToBoundary), m_minBoundaryDistance(minBoundaryDistance) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		const int xSize = m_chf.width;
+		const int zStride = xSize; // For readability
+		const int minZ = taskIndex * AREA_FILTER_ROWS_PER_TASK;
+		const int maxZ = rcMin(minZ + AREA_FILTER_ROWS_PER_TASK, m_chf.height);
+
+		// Empty cells have no span range of their own, so each cell gives its spans.
+		for (int z = minZ; z < maxZ; ++z)
+		{
+			for (int x = 0; x < xSize; ++x)
+			{
+				const rcCompactCell& cell = m_chf.cells[x + z * zStride];
+				for (int spanIndex = (int)cell.index, maxSpanIndex = (int)(cell.index + cell.count); spanIndex < maxSpanIndex; ++spanIndex)
+				{
+					if (m_distanceToBoundary[spanIndex] < m_minBoundaryDistance)
+					{
+						m_chf.areas[spanIndex] = RC_NULL_AREA;
+					}
+				}
+			}
+		}
+	}
+
+private:
+	rcCompactHeightfield& m_chf;
+	const unsigned char* m_distanceToBoundary;
+	const unsigned char m_minBoundaryDistance;
+
+	// Explicitly-disabled copy assignment operator.
+	ErodeSpansTasks& operator=(const ErodeSpansTasks&);
+};
+
+/// Writes the median area of each span and its 8 neighbours to a separate array.
+class MedianFilterTasks : public rcTaskSet
+{
+public:
+	MedianFilterTasks(const rcCompactHeightfield& compactHeightfield, unsigned char* areas)
+		: m_chf(compactHeightfield), m_areas(areas) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		const rcCompactHeightfield& compactHeightfield = m_chf;
+		unsigned char* areas = m_areas;
+		const int xSize = compactHeightfield.width;
+		const int zStride = xSize; // For readability
+		const int minZ = taskIndex * AREA_FILTER_ROWS_PER_TASK;
+		const int maxZ = rcMin(minZ + AREA_FILTER_ROWS_PER_TASK, compactHeightfield.height);
+
+		for (int z = minZ; z < maxZ; ++z)
+		{
+			for (int x = 0; x < xSize; ++x)
+			{
+				const rcCompactCell& cell = compactHeightfield.cells[x + z * zStride];
+				const int maxSpanIndex = (int)(cell.index + cell.count);
+				for (int spanIndex = (int)cell.index; spanIndex < maxSpanIndex; ++spanIndex)
+				{
+					const rcCompactSpan& span = compactHeightfield.spans[spanIndex];
+					if (compactHeightfield.areas[spanIndex] == RC_NULL_AREA)
+					{
+						areas[spanIndex] = compactHeightfield.areas[spanIndex];
+						continue;
+					}
+
+					unsigned char neighborAreas[9];
+					for (int neighborIndex = 0; neighborIndex < 9; ++neighborIndex)
+					{
+						neighborAreas[neighborIndex] = compactHeightfield.areas[spanIndex];
+					}
+
+					for (int dir = 0; dir < 4; ++dir)
+					{
+						if (rcGetCon(span, dir) == RC_NOT_CONNECTED)
+						{
+							continue;
+						}
+						
+						const int aX = x + rcGetDirOffsetX(dir);
+						const int aZ = z + rcGetDirOffsetY(dir);
+						const int aIndex = (int)compactHeightfield.cells[aX + aZ * zStride].index + rcGetCon(span, dir);
+						if (compactHeightfield.areas[aIndex] != RC_NULL_AREA)
+						{
+							neighborAreas[dir * 2 + 0] = compactHeightfield.areas[aIndex];
+						}
+
+						const rcCompactSpan& aSpan = compactHeightfield.spans[aIndex];
+						const int dir2 = (dir + 1) & 0x3;
+						const int neighborConnection2 = rcGetCon(aSpan, dir2);
+						if (neighborConnection2 != RC_NOT_CONNECTED)
+						{
+							const int bX = aX + rcGetDirOffsetX(dir2);
+							const int bZ = aZ + rcGetDirOffsetY(dir2);
+							const int bIndex = (int)compactHeightfield.cells[bX + bZ * zStride].index + neighborConnection2;
+							if (compactHeightfield.areas[bIndex] != RC_NULL_AREA)
+							{
+								neighborAreas[dir * 2 + 1] = compactHeightfield.areas[bIndex];
+							}
+						}
+					}
+					areas[spanIndex] = medianOf9(neighborAreas);
+				}
+			}
+		}
+	}
+
+private:
+	const rcCompactHeightfield& m_chf;
+	unsigned char* m_areas;
+
+	// Explicitly-disabled copy assignment operator.
+	MedianFilterTasks& operator=(const MedianFilterTasks&);
+};
+}  // namespace
 
 // TODO (graham): This is duplicated in the ConvexVolumeTool in RecastDemo
 /// Checks if a point is contained within a polygon
@@ -92,49 +296,8 @@ bool rcErodeWalkableArea(rcContext* context, const int erosionRadius, rcCompactH
 	memset(distanceToBoundary, 0xff, sizeof(unsigned char) * compactHeightfield.spanCount);
 	
 	// Mark boundary cells.
-	for (int z = 0; z < zSize; ++z)
-	{
-		for (int x = 0; x < xSize; ++x)
-		{
-			const rcCompactCell& cell = compactHeightfield.cells[x + z * zStride];
-			for (int spanIndex = (int)cell.index, maxSpanIndex = (int)(cell.index + cell.count); spanIndex < maxSpanIndex; ++spanIndex)
-			{
-				if (compactHeightfield.areas[spanIndex] == RC_NULL_AREA)
-				{
-					distanceToBoundary[spanIndex] = 0;
-					continue;
-				}
-				const rcCompactSpan& span = compactHeightfield.spans[spanIndex];
-
-				// Check that there is a non-null adjacent span in each of the 4 cardinal directions.
-				int neighborCount = 0;
-				for (int direction = 0; direction < 4; ++direction)
-				{
-					const int neighborConnection = rcGetCon(span, direction);
-					if (neighborConnection == RC_NOT_CONNECTED)
-					{
-						break;
-					}
-					
-					const int neighborX = x + rcGetDirOffsetX(direction);
-					const int neighborZ = z + rcGetDirOffsetY(direction);
-					const int neighborSpanIndex = (int)compactHeightfield.cells[neighborX + neighborZ * zStride].index + neighborConnection;
-					
-					if (compactHeightfield.areas[neighborSpanIndex] == RC_NULL_AREA)
-					{
-						break;
-					}
-					neighborCount++;
-				}
-				
-				// At least one missing neighbour, so this is a boundary cell.
-				if (neighborCount != 4)
-				{
-					distanceToBoundary[spanIndex] = 0;
-				}
-			}
-		}
-	}
+	MarkBoundaryTasks markBoundaryTasks(compactHeightfield, distanceToBoundary);
+	context->runTasks(markBoundaryTasks, getRowTaskCount(compactHeightfield));
 	
 	unsigned char newDistance;
 	
@@ -273,13 +436,8 @@ bool rcErodeWalkableArea(rcContext* context, const int erosionRadius, rcCompactH
 	}
 
 	const unsigned char minBoundaryDistance = (unsigned char)(erosionRadius * 2);
-	for (int spanIndex = 0; spanIndex < compactHeightfield.spanCount; ++spanIndex)
-	{
-		if (distanceToBoundary[spanIndex] < minBoundaryDistance)
-		{
-			compactHeightfield.areas[spanIndex] = RC_NULL_AREA;
-		}
-	}
+	ErodeSpansTasks erodeSpansTasks(compactHeightfield, distanceToBoundary, minBoundaryDistance);
+	context->runTasks(erodeSpansTasks, getRowTaskCount(compactHeightfield));
 
 	rcFree(distanceToBoundary);
 	
@@ -289,10 +447,6 @@ bool rcErodeWalkableArea(rcContext* context, const int erosionRadius, rcCompactH
 bool rcMedianFilterWalkableArea(rcContext* context, rcCompactHeightfield& compactHeightfield)
 {
 	rcAssert(context);
-	
-	const int xSize = compactHeightfield.width;
-	const int zSize = compactHeightfield.height;
-	const int zStride = xSize; // For readability
 
 	rcScopedTimer timer(context, RC_TIMER_MEDIAN_AREA);
 
@@ -305,61 +459,8 @@ bool rcMedianFilterWalkableArea(rcContext* context, rcCompactHeightfield& compac
 	}
 	memset(areas, 0xff, sizeof(unsigned char) * compactHeightfield.spanCount);
 
-	for (int z = 0; z < zSize; ++z)
-	{
-		for (int x = 0; x < xSize; ++x)
-		{
-			const rcCompactCell& cell = compactHeightfield.cells[x + z * zStride];
-			const int maxSpanIndex = (int)(cell.index + cell.count);
-			for (int spanIndex = (int)cell.index; spanIndex < maxSpanIndex; ++spanIndex)
-			{
-				const rcCompactSpan& span = compactHeightfield.spans[spanIndex];
-				if (compactHeightfield.areas[spanIndex] == RC_NULL_AREA)
-				{
-					areas[spanIndex] = compactHeightfield.areas[spanIndex];
-					continue;
-				}
-
-				unsigned char neighborAreas[9];
-				for (int neighborIndex = 0; neighborIndex < 9; ++neighborIndex)
-				{
-					neighborAreas[neighborIndex] = compactHeightfield.areas[spanIndex];
-				}
-
-				for (int dir = 0; dir < 4; ++dir)
-				{
-					if (rcGetCon(span, dir) == RC_NOT_CONNECTED)
-					{
-						continue;
-					}
-					
-					const int aX = x + rcGetDirOffsetX(dir);
-					const int aZ = z + rcGetDirOffsetY(dir);
-					const int aIndex = (int)compactHeightfield.cells[aX + aZ * zStride].index + rcGetCon(span, dir);
-					if (compactHeightfield.areas[aIndex] != RC_NULL_AREA)
-					{
-						neighborAreas[dir * 2 + 0] = compactHeightfield.areas[aIndex];
-					}
-
-					const rcCompactSpan& aSpan = compactHeightfield.spans[aIndex];
-					const int dir2 = (dir + 1) & 0x3;
-					const int neighborConnection2 = rcGetCon(aSpan, dir2);
-					if (neighborConnection2 != RC_NOT_CONNECTED)
-					{
-						const int bX = aX + rcGetDirOffsetX(dir2);
-						const int bZ = aZ + rcGetDirOffsetY(dir2);
-						const int bIndex = (int)compactHeightfield.cells[bX + bZ * zStride].index + neighborConnection2;
-						if (compactHeightfield.areas[bIndex] != RC_NULL_AREA)
-						{
-							neighborAreas[dir * 2 + 1] = compactHeightfield.areas[bIndex];
-						}
-					}
-				}
-				insertSort(neighborAreas, 9);
-				areas[spanIndex] = neighborAreas[4];
-			}
-		}
-	}
+	MedianFilterTasks medianFilterTasks(compactHeightfield, areas);
+	context->runTasks(medianFilterTasks, getRowTaskCount(compactHeightfield));
 
 	memcpy(compactHeightfield.areas, areas, sizeof(unsigned char) * compactHeightfield.spanCount);
 
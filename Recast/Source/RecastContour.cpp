@@ -798,6 +798,208 @@ static void mergeRegionHoles(rcContext* ctx, rcContourRegion& region)
 }
 
 
+namespace
+{
+/// The number of heightfield rows handled by each boundary marking task.
+const int CONTOUR_ROWS_PER_TASK = 32;
+/// The number of regions traced by each trace task.
+const int CONTOUR_REGIONS_PER_TASK = 16;
+/// The number of raw contours simplified by each simplify task.
+const int CONTOURS_PER_TASK = 32;
+
+/// Marks the span edges that do not connect to a span of the same region.
+class MarkContourEdgesTasks : public rcTaskSet
+{
+public:
+	MarkContourEdgesTasks(const rcCompactHeightfield& chf, unsigned char* flags)
+		: m_chf(chf), m_flags(flags) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		const rcCompactHeightfield& chf = m_chf;
+		unsigned char* flags = m_flags;
+		const int w = chf.width;
+		const int y0 = taskIndex * CONTOUR_ROWS_PER_TASK;
+		const int y1 = rcMin(y0 + CONTOUR_ROWS_PER_TASK, chf.height);
+
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int x = 0; x < w; ++x)
+			{
+				const rcCompactCell& c = chf.cells[x+y*w];
+				for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+				{
+					unsigned char res = 0;
+					const rcCompactSpan& s = chf.spans[i];
+					if (!chf.spans[i].reg || (chf.spans[i].reg & RC_BORDER_REG))
+					{
+						flags[i] = 0;
+						continue;
+					}
+					for (int dir = 0; dir < 4; ++dir)
+					{
+						unsigned short r = 0;
+						if (rcGetCon(s, dir) != RC_NOT_CONNECTED)
+						{
+							const int ax = x + rcGetDirOffsetX(dir);
+							const int ay = y + rcGetDirOffsetY(dir);
+							const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
+							r = chf.spans[ai].reg;
+						}
+						if (r == chf.spans[i].reg)
+							res |= (1 << dir);
+					}
+					flags[i] = res ^ 0xf; // Inverse, mark non connected edges.
+					// Spans without any same-region neighbours do not start a contour.
+					if (flags[i] == 0xf)
+						flags[i] = 0;
+				}
+			}
+		}
+	}
+
+private:
+	const rcCompactHeightfield& m_chf;
+	unsigned char* m_flags;
+
+	// Explicitly-disabled copy assignment operator.
+	MarkContourEdgesTasks& operator=(const MarkContourEdgesTasks&);
+};
+
+/// A contour stored in one of the per-task vertex buffers.
+struct rcContourSlice
+{
+	int task;		///< The task whose buffer holds the vertices, or -1 if there is no contour.
+	int offset;		///< The index of the first vertex value in the buffer.
+	int nverts;		///< The number of vertices.
+};
+
+/// Contour start spans in the order rcBuildContours scans the heightfield, bucketed by region.
+struct rcContourStarts
+{
+	int* spans;			///< The span of each start. [Size: nstarts]
+	int* cells;			///< The cell of each start. [Size: nstarts]
+	int* byRegion;		///< The starts sorted by region, in scan order within a region. [Size: nstarts]
+	int* regionFirst;	///< The first entry of each region in #byRegion. [Size: nregions+1]
+	int nregions;
+};
+
+/// Walks the contours of a range of regions.
+/// Walking a contour only clears the edge flags of spans in its own region, so regions are
+/// independent, and visiting the starts of a region in scan order finds the same contours
+/// as a single scan over the whole heightfield.
+class TraceContoursTasks : public rcTaskSet
+{
+public:
+	TraceContoursTasks(const rcCompactHeightfield& chf, unsigned char* flags, const rcContourStarts& starts,
+					   rcTempVector<int>* verts, rcContourSlice* raw)
+		: m_chf(chf), m_flags(flags), m_starts(starts), m_verts(verts), m_raw(raw) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		const int r0 = taskIndex * CONTOUR_REGIONS_PER_TASK;
+		const int r1 = rcMin(r0 + CONTOUR_REGIONS_PER_TASK, m_starts.nregions);
+		rcTempVector<int>& verts = m_verts[taskIndex];
+
+		for (int j = m_starts.regionFirst[r0], nj = m_starts.regionFirst[r1]; j < nj; ++j)
+		{
+			const int k = m_starts.byRegion[j];
+			const int i = m_starts.spans[k];
+			rcContourSlice& slice = m_raw[k];
+			if (m_flags[i] == 0)
+			{
+				// Already visited by an earlier contour of the region.
+				slice.task = -1;
+				continue;
+			}
+			const int offset = static_cast<int>(verts.size());
+			walkContour(m_starts.cells[k] % m_chf.width, m_starts.cells[k] / m_chf.width, i, m_chf, m_flags, verts);
+			slice.task = taskIndex;
+			slice.offset = offset;
+			slice.nverts = (static_cast<int>(verts.size()) - offset) / 4;
+		}
+	}
+
+private:
+	const rcCompactHeightfield& m_chf;
+	unsigned char* m_flags;
+	const rcContourStarts& m_starts;
+	rcTempVector<int>* m_verts;
+	rcContourSlice* m_raw;
+
+	// Explicitly-disabled copy assignment operator.
+	TraceContoursTasks& operator=(const TraceContoursTasks&);
+};
+
+/// Simplifies a range of the raw contours.
+class SimplifyContoursTasks : public rcTaskSet
+{
+public:
+	SimplifyContoursTasks(const rcTempVector<int>* rawVerts, const rcContourSlice* raw, const int* contours, const int ncontours,
+						  rcTempVector<int>* verts, rcContourSlice* simplified,
+						  const float maxError, const int maxEdgeLen, const int buildFlags)
+		: m_rawVerts(rawVerts), m_raw(raw), m_contours(contours), m_ncontours(ncontours),
+		  m_verts(verts), m_simplified(simplified),
+		  m_maxError(maxError), m_maxEdgeLen(maxEdgeLen), m_buildFlags(buildFlags) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		const int c0 = taskIndex * CONTOURS_PER_TASK;
+		const int c1 = rcMin(c0 + CONTOURS_PER_TASK, m_ncontours);
+		rcTempVector<int>& out = m_verts[taskIndex];
+		rcTempVector<int> points;
+		rcTempVector<int> simplified;
+
+		for (int c = c0; c < c1; ++c)
+		{
+			const rcContourSlice& raw = m_raw[m_contours[c]];
+			const int* src = m_rawVerts[raw.task].data() + raw.offset;
+			points.assign(src, src + raw.nverts*4);
+			simplified.clear();
+			simplifyContour(points, simplified, m_maxError, m_maxEdgeLen, m_buildFlags);
+			removeDegenerateSegments(simplified);
+
+			rcContourSlice& slice = m_simplified[c];
+			slice.task = taskIndex;
+			slice.offset = static_cast<int>(out.size());
+			slice.nverts = static_cast<int>(simplified.size()) / 4;
+			for (int j = 0; j < static_cast<int>(simplified.size()); ++j)
+				out.push_back(simplified[j]);
+		}
+	}
+
+private:
+	const rcTempVector<int>* m_rawVerts;
+	const rcContourSlice* m_raw;
+	const int* m_contours;
+	const int m_ncontours;
+	rcTempVector<int>* m_verts;
+	rcContourSlice* m_simplified;
+	const float m_maxError;
+	const int m_maxEdgeLen;
+	const int m_buildFlags;
+
+	// Explicitly-disabled copy assignment operator.
+	SimplifyContoursTasks& operator=(const SimplifyContoursTasks&);
+};
+
+/// Copies contour vertices, removing the offset of the heightfield border.
+void copyContourVerts(int* dst, const int* src, const int nverts, const int borderSize)
+{
+	memcpy(dst, src, sizeof(int)*nverts*4);
+	if (borderSize > 0)
+	{
+		// If the heightfield was build with bordersize, remove the offset.
+		for (int j = 0; j < nverts; ++j)
+		{
+			int* v = &dst[j*4];
+			v[0] -= borderSize;
+			v[2] -= borderSize;
+		}
+	}
+}
+}  // namespace
+
 /// @par
 ///
 /// The raw contours will match the region outlines exactly. The @p maxError and @p maxEdgeLen
@@ -808,9 +1010,13 @@ static void mergeRegionHoles(rcContext* ctx, rcContourRegion& region)
 ///
 /// Setting @p maxEdgeLength to zero will disabled the edge length feature.
 ///
+/// The contours of different regions are traced, and then simplified, by task sets run through
+/// rcContext::runTasks. They are stored in the order their first span is found in the heightfield,
+/// so the result does not depend on how the tasks are scheduled.
+///
 /// See the #rcConfig documentation for more information on the configuration parameters.
 ///
-/// @see rcAllocContourSet, rcCompactHeightfield, rcContourSet, rcConfig
+/// @see rcAllocContourSet, rcCompactHeightfield, rcContourSet, rcContext::runTasks, rcConfig
 bool rcBuildContours(rcContext* ctx, const rcCompactHeightfield& chf,
 					 const float maxError, const int maxEdgeLen,
 					 rcContourSet& cset, const int buildFlags)
@@ -841,12 +1047,6 @@ bool rcBuildContours(rcContext* ctx, const rcCompactHeightfield& chf,
 	cset.borderSize = chf.borderSize;
 	cset.maxError = maxError;
 	
-	int maxContours = rcMax((int)chf.maxRegions, 8);
-	cset.conts = (rcContour*)rcAlloc(sizeof(rcContour)*maxContours, RC_ALLOC_PERM);
-	if (!cset.conts)
-		return false;
-	cset.nconts = 0;
-	
 	rcScopedDelete<unsigned char> flags((unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP));
 	if (!flags)
 	{
@@ -857,6 +1057,36 @@ bool rcBuildContours(rcContext* ctx, const rcCompactHeightfield& chf,
 	ctx->startTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
 	
 	// Mark boundaries.
+	MarkContourEdgesTasks markTasks(chf, flags);
+	ctx->runTasks(markTasks, (h + CONTOUR_ROWS_PER_TASK - 1) / CONTOUR_ROWS_PER_TASK);
+	
+	// Collect the spans that start a contour in scan order and bucket them by region.
+	// The contours are stored in the order of their start spans, which keeps the
+	// result independent of how the regions are split between tasks.
+	rcContourStarts starts;
+	starts.nregions = chf.maxRegions+1;
+	int nstarts = 0;
+	for (int i = 0; i < chf.spanCount; ++i)
+	{
+		if (flags[i])
+			nstarts++;
+	}
+	rcTempVector<int> startSpans(nstarts);
+	rcTempVector<int> startCells(nstarts);
+	rcTempVector<int> startsByRegion(nstarts);
+	rcTempVector<int> regionFirst(starts.nregions+1, 0);
+	if (nstarts > 0 && (startSpans.size() != nstarts || startCells.size() != nstarts || startsByRegion.size() != nstarts))
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'starts' (%d).", nstarts);
+		return false;
+	}
+	if (regionFirst.size() != starts.nregions+1)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'regionFirst' (%d).", starts.nregions+1);
+		return false;
+	}
+	
+	int k = 0;
 	for (int y = 0; y < h; ++y)
 	{
 		for (int x = 0; x < w; ++x)
@@ -864,135 +1094,100 @@ bool rcBuildContours(rcContext* ctx, const rcCompactHeightfield& chf,
 			const rcCompactCell& c = chf.cells[x+y*w];
 			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 			{
-				unsigned char res = 0;
-				const rcCompactSpan& s = chf.spans[i];
-				if (!chf.spans[i].reg || (chf.spans[i].reg & RC_BORDER_REG))
-				{
-					flags[i] = 0;
+				if (!flags[i])
 					continue;
-				}
-				for (int dir = 0; dir < 4; ++dir)
-				{
-					unsigned short r = 0;
-					if (rcGetCon(s, dir) != RC_NOT_CONNECTED)
-					{
-						const int ax = x + rcGetDirOffsetX(dir);
-						const int ay = y + rcGetDirOffsetY(dir);
-						const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
-						r = chf.spans[ai].reg;
-					}
-					if (r == chf.spans[i].reg)
-						res |= (1 << dir);
-				}
-				flags[i] = res ^ 0xf; // Inverse, mark non connected edges.
+				startSpans[k] = i;
+				startCells[k] = x+y*w;
+				regionFirst[chf.spans[i].reg+1]++;
+				k++;
 			}
 		}
 	}
+	for (int r = 0; r < starts.nregions; ++r)
+		regionFirst[r+1] += regionFirst[r];
+	{
+		rcTempVector<int> next(regionFirst.data(), regionFirst.data() + starts.nregions);
+		for (int j = 0; j < nstarts; ++j)
+			startsByRegion[next[chf.spans[startSpans[j]].reg]++] = j;
+	}
+	starts.spans = startSpans.data();
+	starts.cells = startCells.data();
+	starts.byRegion = startsByRegion.data();
+	starts.regionFirst = regionFirst.data();
+	
+	// Walk the contours of each region.
+	const int ntraceTasks = (starts.nregions + CONTOUR_REGIONS_PER_TASK - 1) / CONTOUR_REGIONS_PER_TASK;
+	rcTempVector<rcTempVector<int> > rawVerts(ntraceTasks);
+	rcTempVector<rcContourSlice> raw(nstarts);
+	TraceContoursTasks traceTasks(chf, flags, starts, rawVerts.data(), raw.data());
+	ctx->runTasks(traceTasks, ntraceTasks);
 	
 	ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
 	
-	rcTempVector<int> verts(256);
-	rcTempVector<int> simplified(64);
+	rcTempVector<int> traced;
+	for (int j = 0; j < nstarts; ++j)
+	{
+		if (raw[j].task >= 0)
+			traced.push_back(j);
+	}
+	const int ntraced = static_cast<int>(traced.size());
+	
+	ctx->startTimer(RC_TIMER_BUILD_CONTOURS_SIMPLIFY);
 	
-	for (int y = 0; y < h; ++y)
+	const int nsimplifyTasks = (ntraced + CONTOURS_PER_TASK - 1) / CONTOURS_PER_TASK;
+	rcTempVector<rcTempVector<int> > simplifiedVerts(nsimplifyTasks);
+	rcTempVector<rcContourSlice> simplified(ntraced);
+	SimplifyContoursTasks simplifyTasks(rawVerts.data(), raw.data(), traced.data(), ntraced,
+										simplifiedVerts.data(), simplified.data(), maxError, maxEdgeLen, buildFlags);
+	ctx->runTasks(simplifyTasks, nsimplifyTasks);
+	
+	ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_SIMPLIFY);
+	
+	// Create contours.
+	int nconts = 0;
+	for (int j = 0; j < ntraced; ++j)
 	{
-		for (int x = 0; x < w; ++x)
+		if (simplified[j].nverts >= 3)
+			nconts++;
+	}
+	
+	const int maxContours = rcMax(nconts, rcMax((int)chf.maxRegions, 8));
+	cset.conts = (rcContour*)rcAlloc(sizeof(rcContour)*maxContours, RC_ALLOC_PERM);
+	if (!cset.conts)
+		return false;
+	cset.nconts = 0;
+	
+	for (int j = 0; j < ntraced; ++j)
+	{
+		const rcContourSlice& simp = simplified[j];
+		if (simp.nverts < 3)
+			continue;
+		const rcContourSlice& rawSlice = raw[traced[j]];
+		const int i = startSpans[traced[j]];
+		
+		rcContour* cont = &cset.conts[cset.nconts++];
+		cont->rverts = 0;
+		
+		cont->nverts = simp.nverts;
+		cont->verts = (int*)rcAlloc(sizeof(int)*cont->nverts*4, RC_ALLOC_PERM);
+		if (!cont->verts)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
-			{
-				if (flags[i] == 0 || flags[i] == 0xf)
-				{
-					flags[i] = 0;
-					continue;
-				}
-				const unsigned short reg = chf.spans[i].reg;
-				if (!reg || (reg & RC_BORDER_REG))
-					continue;
-				const unsigned char area = chf.areas[i];
-				
-				verts.clear();
-				simplified.clear();
-				
-				ctx->startTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
-				walkContour(x, y, i, chf, flags, verts);
-				ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
-				
-				ctx->startTimer(RC_TIMER_BUILD_CONTOURS_SIMPLIFY);
-				simplifyContour(verts, simplified, maxError, maxEdgeLen, buildFlags);
-				removeDegenerateSegments(simplified);
-				ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_SIMPLIFY);
-				
-				
-				// Store region->contour remap info.
-				// Create contour.
-				if (simplified.size()/4 >= 3)
-				{
-					if (cset.nconts >= maxContours)
-					{
-						// Allocate more contours.
-						// This happens when a region has holes.
-						const int oldMax = maxContours;
-						maxContours *= 2;
-						rcContour* newConts = (rcContour*)rcAlloc(sizeof(rcContour)*maxContours, RC_ALLOC_PERM);
-						for (int j = 0; j < cset.nconts; ++j)
-						{
-							newConts[j] = cset.conts[j];
-							// Reset source pointers to prevent data deletion.
-							cset.conts[j].verts = 0;
-							cset.conts[j].rverts = 0;
-						}
-						rcFree(cset.conts);
-						cset.conts = newConts;
-						
-						ctx->log(RC_LOG_WARNING, "rcBuildContours: Expanding max contours from %d to %d.", oldMax, maxContours);
-					}
-					
-					rcContour* cont = &cset.conts[cset.nconts++];
-					
-					cont->nverts = static_cast<int>(simplified.size()) / 4;
-					cont->verts = (int*)rcAlloc(sizeof(int)*cont->nverts*4, RC_ALLOC_PERM);
-					if (!cont->verts)
-					{
-						ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'verts' (%d).", cont->nverts);
-						return false;
-					}
-					memcpy(cont->verts, &simplified[0], sizeof(int)*cont->nverts*4);
-					if (borderSize > 0)
-					{
-						// If the heightfield was build with bordersize, remove the offset.
-						for (int j = 0; j < cont->nverts; ++j)
-						{
-							int* v = &cont->verts[j*4];
-							v[0] -= borderSize;
-							v[2] -= borderSize;
-						}
-					}
-					
-					cont->nrverts = static_cast<int>(verts.size()) / 4;
-					cont->rverts = static_cast<int*>(rcAlloc(sizeof(int) * cont->nrverts * 4, RC_ALLOC_PERM));
-					if (!cont->rverts)
-					{
-						ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'rverts' (%d).", cont->nrverts);
-						return false;
-					}
-					memcpy(cont->rverts, &verts[0], sizeof(int)*cont->nrverts*4);
-					if (borderSize > 0)
-					{
-						// If the heightfield was build with bordersize, remove the offset.
-						for (int j = 0; j < cont->nrverts; ++j)
-						{
-							int* v = &cont->rverts[j*4];
-							v[0] -= borderSize;
-							v[2] -= borderSize;
-						}
-					}
-					
-					cont->reg = reg;
-					cont->area = area;
-				}
-			}
+			ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'verts' (%d).", cont->nverts);
+			return false;
+		}
+		copyContourVerts(cont->verts, simplifiedVerts[simp.task].data() + simp.offset, cont->nverts, borderSize);
+		
+		cont->nrverts = rawSlice.nverts;
+		cont->rverts = static_cast<int*>(rcAlloc(sizeof(int) * cont->nrverts * 4, RC_ALLOC_PERM));
+		if (!cont->rverts)
+		{
+			ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'rverts' (%d).", cont->nrverts);
+			return false;
 		}
+		copyContourVerts(cont->rverts, rawVerts[rawSlice.task].data() + rawSlice.offset, cont->nrverts, borderSize);
+		
+		cont->reg = chf.spans[i].reg;
+		cont->area = chf.areas[i];
 	}
 	
 	// Merge holes if needed.
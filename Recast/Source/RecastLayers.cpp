@@ -24,6 +24,7 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastTaskLog.h"
 
 
 // Must be 255 or smaller (not 256) because layer IDs are stored as
@@ -654,3 +655,99 @@ bool rcBuildHeightfieldLayers(rcContext* ctx, const rcCompactHeightfield& chf,
 	
 	return true;
 }
+
+namespace
+{
+/// The outcome of building the layer set of one heightfield of a batch.
+struct LayersTaskResult
+{
+	LayersTaskResult() : failed(false) {}
+	rcTempVector<char> messages;
+	bool failed;
+};
+
+/// Builds the layer sets of a batch of compact heightfields, one heightfield per task.
+class BuildHeightfieldLayersTasks : public rcTaskSet
+{
+public:
+	BuildHeightfieldLayersTasks(const rcCompactHeightfield* const* chfs, const int borderSize, const int walkableHeight,
+								rcHeightfieldLayerSet* const* lsets, LayersTaskResult* results)
+		: m_chfs(chfs), m_borderSize(borderSize), m_walkableHeight(walkableHeight), m_lsets(lsets), m_results(results) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		LayersTaskResult& result = m_results[taskIndex];
+		rcTaskLogContext ctx(result.messages);
+		rcHeightfieldLayerSet& lset = *m_lsets[taskIndex];
+		if (rcBuildHeightfieldLayers(&ctx, *m_chfs[taskIndex], m_borderSize, m_walkableHeight, lset))
+			return;
+
+		// Free the layers built before the failure.
+		result.failed = true;
+		for (int i = 0; lset.layers && i < lset.nlayers; ++i)
+		{
+			rcFree(lset.layers[i].heights);
+			rcFree(lset.layers[i].areas);
+			rcFree(lset.layers[i].cons);
+		}
+		rcFree(lset.layers);
+		lset.layers = 0;
+		lset.nlayers = 0;
+	}
+
+private:
+	const rcCompactHeightfield* const* m_chfs;
+	const int m_borderSize;
+	const int m_walkableHeight;
+	rcHeightfieldLayerSet* const* m_lsets;
+	LayersTaskResult* m_results;
+
+	// Explicitly-disabled copy assignment operator.
+	BuildHeightfieldLayersTasks& operator=(const BuildHeightfieldLayersTasks&);
+};
+}  // namespace
+
+/// @par
+///
+/// Each compact heightfield is handled by a task run through rcContext::runTasks, so the
+/// layer sets of the tiles of a tile cache can be built concurrently. The layer sets are the
+/// same as the ones built by #rcBuildHeightfieldLayers.
+///
+/// The messages of the tasks are logged to the build context in heightfield order once the
+/// tasks have completed. The layer set of a heightfield whose layers could not be built is
+/// left empty. The layer sets of the other heightfields are valid even if the function
+/// returns false, @p built tells which ones they are.
+///
+/// @see rcBuildHeightfieldLayers, rcContext::runTasks
+bool rcBuildHeightfieldLayersBatch(rcContext* ctx, const int count, const rcCompactHeightfield* const* chfs,
+								   const int borderSize, const int walkableHeight,
+								   rcHeightfieldLayerSet* const* lsets, bool* built)
+{
+	rcAssert(ctx);
+
+	rcTempVector<LayersTaskResult> results(count);
+	if (results.size() != count)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildHeightfieldLayersBatch: Out of memory 'results' (%d).", count);
+		for (int i = 0; built && i < count; ++i)
+			built[i] = false;
+		return false;
+	}
+
+	{
+		rcScopedTimer timer(ctx, RC_TIMER_BUILD_LAYERS);
+		BuildHeightfieldLayersTasks tasks(chfs, borderSize, walkableHeight, lsets, results.data());
+		ctx->runTasks(tasks, count);
+	}
+
+	bool success = true;
+	for (int i = 0; i < count; ++i)
+	{
+		rcTaskLogContext::replay(ctx, results[i].messages);
+		if (built)
+			built[i] = !results[i].failed;
+		if (results[i].failed)
+			success = false;
+	}
+	return success;
+}
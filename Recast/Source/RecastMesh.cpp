@@ -122,42 +122,140 @@ static bool buildMeshAdjacency(unsigned short* polys, const int npolys,
 }
 
 
-static const int VERTEX_BUCKET_COUNT = (1<<12);
-
-inline int computeVertexHash(int x, int y, int z)
+namespace
 {
-	const unsigned int h1 = 0x8da6b343; // Large multiplicative constants;
-	const unsigned int h2 = 0xd8163841; // here arbitrarily chosen primes
-	const unsigned int h3 = 0xcb1ab31f;
-	unsigned int n = h1 * x + h2 * y + h3 * z;
-	return (int)(n & (VERTEX_BUCKET_COUNT-1));
-}
-
-static unsigned short addVertex(unsigned short x, unsigned short y, unsigned short z,
-								unsigned short* verts, int* firstVert, int* nextVert, int& nv)
+/// An open addressing hash of the mesh vertices by their xz-position, used to weld vertices.
+/// Vertices with the same xz-position whose heights are within 2 units are welded.
+///
+/// The table uses linear probing over a separate array of packed xz-keys, so most probes only
+/// touch the key array, and grows when it becomes half full.
+class VertexHash
 {
-	int bucket = computeVertexHash(x, 0, z);
-	int i = firstVert[bucket];
-	
-	while (i != -1)
+public:
+	VertexHash() : m_keys(0), m_indices(0), m_capacity(0), m_count(0), m_lookups(0), m_probes(0) {}
+	~VertexHash()
 	{
-		const unsigned short* v = &verts[i*3];
-		if (v[0] == x && (rcAbs(v[1] - y) <= 2) && v[2] == z)
-			return (unsigned short)i;
-		i = nextVert[i]; // next
+		rcFree(m_keys);
+		rcFree(m_indices);
+	}
+
+	/// Allocates a table that holds @p maxVerts vertices without growing.
+	bool init(const int maxVerts)
+	{
+		int capacity = 16;
+		while (capacity < maxVerts*2)
+			capacity *= 2;
+		return rehash(capacity);
+	}
+
+	/// Returns the index of the vertex welded with (@p x, @p y, @p z), adding the vertex to @p verts
+	/// if there is none. Returns -1 if out of memory.
+	int addVertex(unsigned short x, unsigned short y, unsigned short z, unsigned short* verts, int& nv)
+	{
+		const unsigned int key = packKey(x, z);
+		const unsigned int mask = (unsigned int)m_capacity-1;
+		unsigned int slot = hashKey(key) & mask;
+		
+		// Prefer the most recently added vertex, which the probe finds last.
+		int found = -1;
+		m_lookups++;
+		for (;;)
+		{
+			m_probes++;
+			const int i = m_indices[slot];
+			if (i == -1)
+				break;
+			if (m_keys[slot] == key && rcAbs((int)verts[i*3+1] - (int)y) <= 2)
+				found = i;
+			slot = (slot+1) & mask;
+		}
+		if (found != -1)
+			return found;
+		
+		if ((m_count+1)*2 > m_capacity)
+		{
+			if (!rehash(m_capacity*2))
+				return -1;
+			return addVertex(x, y, z, verts, nv);
+		}
+		
+		// Could not find, create new.
+		const int i = nv; nv++;
+		unsigned short* v = &verts[i*3];
+		v[0] = x;
+		v[1] = y;
+		v[2] = z;
+		m_keys[slot] = key;
+		m_indices[slot] = i;
+		m_count++;
+		
+		return i;
+	}
+
+	/// The fraction of the table slots in use.
+	float getLoadFactor() const { return m_capacity > 0 ? (float)m_count / (float)m_capacity : 0.0f; }
+	/// The average number of slots visited by a lookup.
+	float getAverageProbeLength() const { return m_lookups > 0 ? (float)m_probes / (float)m_lookups : 0.0f; }
+	int getCapacity() const { return m_capacity; }
+
+private:
+	static unsigned int packKey(unsigned short x, unsigned short z)
+	{
+		return (unsigned int)x | ((unsigned int)z << 16);
+	}
+
+	static unsigned int hashKey(unsigned int key)
+	{
+		const unsigned int h1 = 0x8da6b343; // Large multiplicative constants;
+		const unsigned int h3 = 0xcb1ab31f; // here arbitrarily chosen primes
+		unsigned int n = h1 * (key & 0xffff) + h3 * (key >> 16);
+		return n ^ (n >> 16);
+	}
+
+	bool rehash(const int capacity)
+	{
+		unsigned int* keys = (unsigned int*)rcAlloc(sizeof(unsigned int)*capacity, RC_ALLOC_TEMP);
+		int* indices = (int*)rcAlloc(sizeof(int)*capacity, RC_ALLOC_TEMP);
+		if (!keys || !indices)
+		{
+			rcFree(keys);
+			rcFree(indices);
+			return false;
+		}
+		memset(indices, 0xff, sizeof(int)*capacity);
+		
+		const unsigned int mask = (unsigned int)capacity-1;
+		for (int i = 0; i < m_capacity; ++i)
+		{
+			if (m_indices[i] == -1)
+				continue;
+			unsigned int slot = hashKey(m_keys[i]) & mask;
+			while (indices[slot] != -1)
+				slot = (slot+1) & mask;
+			keys[slot] = m_keys[i];
+			indices[slot] = m_indices[i];
+		}
+		
+		rcFree(m_keys);
+		rcFree(m_indices);
+		m_keys = keys;
+		m_indices = indices;
+		m_capacity = capacity;
+		return true;
 	}
-	
-	// Could not find, create new.
-	i = nv; nv++;
-	unsigned short* v = &verts[i*3];
-	v[0] = x;
-	v[1] = y;
-	v[2] = z;
-	nextVert[i] = firstVert[bucket];
-	firstVert[bucket] = i;
-	
-	return (unsigned short)i;
-}
+
+	unsigned int* m_keys;	///< The packed xz-position of the vertex in each slot.
+	int* m_indices;			///< The vertex in each slot, or -1 if the slot is empty.
+	int m_capacity;
+	int m_count;
+	int m_lookups;
+	int m_probes;
+
+	// Explicitly-disabled copy constructor and copy assignment operator.
+	VertexHash(const VertexHash&);
+	VertexHash& operator=(const VertexHash&);
+};
+}  // namespace
 
 // Last time I checked the if version got compiled using cmov, which was a lot faster than module (with idiv).
 inline int prev(int i, int n) { return i-1 >= 0 ? i-1 : n-1; }
@@ -538,6 +636,281 @@ static void mergePolyVerts(unsigned short* pa, unsigned short* pb, int ea, int e
 	memcpy(pa, tmp, sizeof(unsigned short)*nvp);
 }
 
+namespace
+{
+/// An edge of one of the initial polygons, used to find the polygons that share an edge.
+struct rcMergeEdge
+{
+	unsigned short v0, v1;	///< The edge vertices, smallest first.
+	int poly;				///< The initial polygon.
+};
+
+/// A pair of polygons that can be merged.
+struct rcMergeCandidate
+{
+	int value;				///< The merge value, see getPolyMergeValue().
+	int pa, pb;				///< The polygons, pa < pb.
+	int versionA, versionB;	///< The versions of the polygons when the candidate was created.
+};
+
+int compareMergeEdges(const void* va, const void* vb)
+{
+	const rcMergeEdge* a = (const rcMergeEdge*)va;
+	const rcMergeEdge* b = (const rcMergeEdge*)vb;
+	if (a->v0 != b->v0)
+		return a->v0 < b->v0 ? -1 : 1;
+	if (a->v1 != b->v1)
+		return a->v1 < b->v1 ? -1 : 1;
+	return a->poly - b->poly;
+}
+
+/// Returns true if candidate @p a should be merged before @p b.
+/// Matches the order of a scan over all polygon pairs that keeps the first best value.
+inline bool mergesBefore(const rcMergeCandidate& a, const rcMergeCandidate& b)
+{
+	if (a.value != b.value)
+		return a.value > b.value;
+	if (a.pa != b.pa)
+		return a.pa < b.pa;
+	return a.pb < b.pb;
+}
+
+void pushMergeCandidate(rcTempVector<rcMergeCandidate>& heap, const rcMergeCandidate& cand)
+{
+	heap.push_back(cand);
+	int i = static_cast<int>(heap.size()) - 1;
+	while (i > 0)
+	{
+		const int parent = (i-1) / 2;
+		if (!mergesBefore(cand, heap[parent]))
+			break;
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = cand;
+}
+
+rcMergeCandidate popMergeCandidate(rcTempVector<rcMergeCandidate>& heap)
+{
+	const rcMergeCandidate top = heap[0];
+	const rcMergeCandidate last = heap.back();
+	heap.pop_back();
+	const int n = static_cast<int>(heap.size());
+	if (n > 0)
+	{
+		int i = 0;
+		for (;;)
+		{
+			int child = i*2+1;
+			if (child >= n)
+				break;
+			if (child+1 < n && mergesBefore(heap[child+1], heap[child]))
+				child++;
+			if (!mergesBefore(heap[child], last))
+				break;
+			heap[i] = heap[child];
+			i = child;
+		}
+		heap[i] = last;
+	}
+	return top;
+}
+
+/// Merges polygons into larger convex polygons, always merging the pair that shares the longest edge.
+///
+/// The polygons are merged in the same order as repeatedly scanning all polygon pairs for the best
+/// merge value would, but the candidates are kept in a heap and only the pairs touching a merged or
+/// moved polygon are evaluated again after a merge. Neighbours are found through the edges of the
+/// initial polygons; each polygon is a set of initial polygons, tracked with a disjoint set.
+/// The buffers are kept between calls, so one merger can be reused for all contours of a mesh.
+class PolyMerger
+{
+public:
+	PolyMerger(const unsigned short* verts, const int nvp)
+		: m_polys(0), m_npolys(0), m_verts(verts), m_nvp(nvp) {}
+
+	/// Merges the polygons, moving the region and area of the last polygon with it when a polygon is removed.
+	/// @p pregs and @p pareas are optional.
+	/// Returns the number of polygons after merging, or -1 if out of memory.
+	int merge(unsigned short* polys, const int npolys, unsigned short* tmpPoly, unsigned short* pregs, unsigned char* pareas)
+	{
+		m_polys = polys;
+		m_npolys = npolys;
+		if (!init())
+			return -1;
+		
+		const int nvp = m_nvp;
+		for (int i = 0; i < m_npolys; ++i)
+			queueMerges(i, true);
+		
+		while (!m_heap.empty())
+		{
+			const rcMergeCandidate cand = popMergeCandidate(m_heap);
+			if (cand.pb >= m_npolys || m_version[cand.pa] != cand.versionA || m_version[cand.pb] != cand.versionB)
+				continue;
+			
+			unsigned short* pa = &m_polys[cand.pa*nvp];
+			unsigned short* pb = &m_polys[cand.pb*nvp];
+			int ea, eb;
+			getPolyMergeValue(pa, pb, m_verts, ea, eb, nvp);
+			mergePolyVerts(pa, pb, ea, eb, tmpPoly, nvp);
+			if (pregs && pregs[cand.pa] != pregs[cand.pb])
+				pregs[cand.pa] = RC_MULTIPLE_REGS;
+			
+			const int last = m_npolys-1;
+			unsigned short* lastPoly = &m_polys[last*nvp];
+			if (pb != lastPoly)
+				memcpy(pb, lastPoly, sizeof(unsigned short)*nvp);
+			if (pregs)
+				pregs[cand.pb] = pregs[last];
+			if (pareas)
+				pareas[cand.pb] = pareas[last];
+			m_npolys--;
+			
+			// Join the sets of the merged polygons and move the set of the last polygon.
+			const int ra = m_polyRoot[cand.pa];
+			const int rb = m_polyRoot[cand.pb];
+			m_parent[rb] = ra;
+			m_nextMember[m_lastMember[ra]] = rb;
+			m_lastMember[ra] = m_lastMember[rb];
+			m_polyRoot[cand.pb] = m_polyRoot[last];
+			m_rootPoly[m_polyRoot[cand.pb]] = cand.pb;
+			
+			m_version[cand.pa]++;
+			m_version[cand.pb]++;
+			m_version[last]++;
+			
+			queueMerges(cand.pa, false);
+			if (cand.pb < m_npolys)
+				queueMerges(cand.pb, false);
+		}
+		
+		return m_npolys;
+	}
+
+private:
+	bool init()
+	{
+		const int n = m_npolys;
+		const int nvp = m_nvp;
+		m_edges.clear();
+		m_groupFirst.clear();
+		m_heap.clear();
+		if (!m_edges.reserve(n*nvp) || !m_groupFirst.reserve(n*nvp) || !m_heap.reserve(n*2))
+			return false;
+		m_edgeIndex.assign(n*nvp, -1);
+		m_parent.resize(n);
+		m_nextMember.assign(n, -1);
+		m_lastMember.resize(n);
+		m_polyRoot.resize(n);
+		m_rootPoly.resize(n);
+		m_version.assign(n, 0);
+		if (m_edgeIndex.size() != n*nvp || m_parent.size() != n || m_nextMember.size() != n || m_lastMember.size() != n ||
+			m_polyRoot.size() != n || m_rootPoly.size() != n || m_version.size() != n)
+			return false;
+		
+		for (int i = 0; i < n; ++i)
+		{
+			const unsigned short* p = &m_polys[i*nvp];
+			const int nv = countPolyVerts(p, nvp);
+			for (int j = 0; j < nv; ++j)
+			{
+				rcMergeEdge e;
+				e.v0 = rcMin(p[j], p[(j+1) % nv]);
+				e.v1 = rcMax(p[j], p[(j+1) % nv]);
+				e.poly = i*nvp+j;
+				m_edges.push_back(e);
+			}
+			m_parent[i] = i;
+			m_lastMember[i] = i;
+			m_polyRoot[i] = i;
+			m_rootPoly[i] = i;
+		}
+		
+		// Group the edges with the same vertices.
+		const int nedges = static_cast<int>(m_edges.size());
+		if (nedges > 0)
+			qsort(m_edges.data(), nedges, sizeof(rcMergeEdge), compareMergeEdges);
+		for (int i = 0; i < nedges; ++i)
+		{
+			const bool same = i > 0 && m_edges[i].v0 == m_edges[i-1].v0 && m_edges[i].v1 == m_edges[i-1].v1;
+			m_groupFirst.push_back(same ? m_groupFirst[i-1] : i);
+			m_edgeIndex[m_edges[i].poly] = i;
+			m_edges[i].poly /= nvp;
+		}
+		return true;
+	}
+	
+	int findRoot(int i)
+	{
+		int root = i;
+		while (m_parent[root] != root)
+			root = m_parent[root];
+		while (m_parent[i] != root)
+		{
+			const int next = m_parent[i];
+			m_parent[i] = root;
+			i = next;
+		}
+		return root;
+	}
+	
+	/// Queues the merges of polygon @p p with the polygons it shares an edge with.
+	/// With @p onlyHigher, only the neighbours with a higher index are queued.
+	void queueMerges(const int p, const bool onlyHigher)
+	{
+		const int nvp = m_nvp;
+		const int nedges = static_cast<int>(m_edges.size());
+		for (int m = m_polyRoot[p]; m != -1; m = m_nextMember[m])
+		{
+			for (int j = 0; j < nvp; ++j)
+			{
+				const int e = m_edgeIndex[m*nvp+j];
+				if (e < 0)
+					break;
+				const int group = m_groupFirst[e];
+				for (int k = group; k < nedges && m_groupFirst[k] == group; ++k)
+				{
+					const int q = m_rootPoly[findRoot(m_edges[k].poly)];
+					if (q == p || (onlyHigher && q < p))
+						continue;
+					
+					rcMergeCandidate cand;
+					cand.pa = rcMin(p, q);
+					cand.pb = rcMax(p, q);
+					int ea, eb;
+					cand.value = getPolyMergeValue(&m_polys[cand.pa*nvp], &m_polys[cand.pb*nvp], m_verts, ea, eb, nvp);
+					if (cand.value <= 0)
+						continue;
+					cand.versionA = m_version[cand.pa];
+					cand.versionB = m_version[cand.pb];
+					pushMergeCandidate(m_heap, cand);
+				}
+			}
+		}
+	}
+	
+	unsigned short* m_polys;
+	int m_npolys;
+	const unsigned short* m_verts;
+	const int m_nvp;
+	
+	rcTempVector<rcMergeEdge> m_edges;		///< The edges of the initial polygons, sorted by vertices.
+	rcTempVector<int> m_groupFirst;			///< The first sorted edge with the same vertices as each edge.
+	rcTempVector<int> m_edgeIndex;			///< The sorted edge of each initial polygon edge.
+	rcTempVector<int> m_parent;				///< Disjoint set of the initial polygons.
+	rcTempVector<int> m_nextMember;			///< The initial polygons of each set as a list.
+	rcTempVector<int> m_lastMember;
+	rcTempVector<int> m_polyRoot;			///< The set of each polygon.
+	rcTempVector<int> m_rootPoly;			///< The polygon of each set.
+	rcTempVector<int> m_version;			///< Incremented when a polygon changes, to invalidate queued merges.
+	rcTempVector<rcMergeCandidate> m_heap;
+	
+	// Explicitly-disabled copy constructor and copy assignment operator.
+	PolyMerger(const PolyMerger&);
+	PolyMerger& operator=(const PolyMerger&);
+};
+}  // namespace
 
 static void pushFront(int v, int* arr, int& an)
 {
@@ -902,52 +1275,12 @@ static bool removeVertex(rcContext* ctx, rcPolyMesh& mesh, const unsigned short
 	// Merge polygons.
 	if (nvp > 3)
 	{
-		for (;;)
+		PolyMerger merger(mesh.verts, nvp);
+		npolys = merger.merge(polys, npolys, tmpPoly, pregs, pareas);
+		if (npolys < 0)
 		{
-			// Find best polygons to merge.
-			int bestMergeVal = 0;
-			int bestPa = 0, bestPb = 0, bestEa = 0, bestEb = 0;
-			
-			for (int j = 0; j < npolys-1; ++j)
-			{
-				unsigned short* pj = &polys[j*nvp];
-				for (int k = j+1; k < npolys; ++k)
-				{
-					unsigned short* pk = &polys[k*nvp];
-					int ea, eb;
-					int v = getPolyMergeValue(pj, pk, mesh.verts, ea, eb, nvp);
-					if (v > bestMergeVal)
-					{
-						bestMergeVal = v;
-						bestPa = j;
-						bestPb = k;
-						bestEa = ea;
-						bestEb = eb;
-					}
-				}
-			}
-			
-			if (bestMergeVal > 0)
-			{
-				// Found best, merge.
-				unsigned short* pa = &polys[bestPa*nvp];
-				unsigned short* pb = &polys[bestPb*nvp];
-				mergePolyVerts(pa, pb, bestEa, bestEb, tmpPoly, nvp);
-				if (pregs[bestPa] != pregs[bestPb])
-					pregs[bestPa] = RC_MULTIPLE_REGS;
-
-				unsigned short* last = &polys[(npolys-1)*nvp];
-				if (pb != last)
-					memcpy(pb, last, sizeof(unsigned short)*nvp);
-				pregs[bestPb] = pregs[npolys-1];
-				pareas[bestPb] = pareas[npolys-1];
-				npolys--;
-			}
-			else
-			{
-				// Could not merge any polygons, stop.
-				break;
-			}
+			ctx->log(RC_LOG_ERROR, "removeVertex: Out of memory 'merge' (%d).", ntris);
+			return false;
 		}
 	}
 	
@@ -1052,22 +1385,12 @@ bool rcBuildPolyMesh(rcContext* ctx, const rcContourSet& cset, const int nvp, rc
 	memset(mesh.regs, 0, sizeof(unsigned short)*maxTris);
 	memset(mesh.areas, 0, sizeof(unsigned char)*maxTris);
 	
-	rcScopedDelete<int> nextVert((int*)rcAlloc(sizeof(int)*maxVertices, RC_ALLOC_TEMP));
-	if (!nextVert)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'nextVert' (%d).", maxVertices);
-		return false;
-	}
-	memset(nextVert, 0, sizeof(int)*maxVertices);
-	
-	rcScopedDelete<int> firstVert((int*)rcAlloc(sizeof(int)*VERTEX_BUCKET_COUNT, RC_ALLOC_TEMP));
-	if (!firstVert)
+	VertexHash vertexHash;
+	if (!vertexHash.init(maxVertices))
 	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'firstVert' (%d).", VERTEX_BUCKET_COUNT);
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'vertexHash' (%d).", maxVertices);
 		return false;
 	}
-	for (int i = 0; i < VERTEX_BUCKET_COUNT; ++i)
-		firstVert[i] = -1;
 	
 	rcScopedDelete<int> indices((int*)rcAlloc(sizeof(int)*maxVertsPerCont, RC_ALLOC_TEMP));
 	if (!indices)
@@ -1088,6 +1411,7 @@ bool rcBuildPolyMesh(rcContext* ctx, const rcContourSet& cset, const int nvp, rc
 		return false;
 	}
 	unsigned short* tmpPoly = &polys[maxVertsPerCont*nvp];
+	PolyMerger merger(mesh.verts, nvp);
 
 	for (int i = 0; i < cset.nconts; ++i)
 	{
@@ -1123,8 +1447,13 @@ bool rcBuildPolyMesh(rcContext* ctx, const rcContourSet& cset, const int nvp, rc
 		for (int j = 0; j < cont.nverts; ++j)
 		{
 			const int* v = &cont.verts[j*4];
-			indices[j] = addVertex((unsigned short)v[0], (unsigned short)v[1], (unsigned short)v[2],
-								   mesh.verts, firstVert, nextVert, mesh.nverts);
+			indices[j] = vertexHash.addVertex((unsigned short)v[0], (unsigned short)v[1], (unsigned short)v[2],
+											  mesh.verts, mesh.nverts);
+			if (indices[j] < 0)
+			{
+				ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'vertexHash' (%d).", vertexHash.getCapacity()*2);
+				return false;
+			}
 			if (v[3] & RC_BORDER_VERTEX)
 			{
 				// This vertex should be removed.
@@ -1152,47 +1481,11 @@ bool rcBuildPolyMesh(rcContext* ctx, const rcContourSet& cset, const int nvp, rc
 		// Merge polygons.
 		if (nvp > 3)
 		{
-			for(;;)
+			npolys = merger.merge(polys, npolys, tmpPoly, 0, 0);
+			if (npolys < 0)
 			{
-				// Find best polygons to merge.
-				int bestMergeVal = 0;
-				int bestPa = 0, bestPb = 0, bestEa = 0, bestEb = 0;
-				
-				for (int j = 0; j < npolys-1; ++j)
-				{
-					unsigned short* pj = &polys[j*nvp];
-					for (int k = j+1; k < npolys; ++k)
-					{
-						unsigned short* pk = &polys[k*nvp];
-						int ea, eb;
-						int v = getPolyMergeValue(pj, pk, mesh.verts, ea, eb, nvp);
-						if (v > bestMergeVal)
-						{
-							bestMergeVal = v;
-							bestPa = j;
-							bestPb = k;
-							bestEa = ea;
-							bestEb = eb;
-						}
-					}
-				}
-				
-				if (bestMergeVal > 0)
-				{
-					// Found best, merge.
-					unsigned short* pa = &polys[bestPa*nvp];
-					unsigned short* pb = &polys[bestPb*nvp];
-					mergePolyVerts(pa, pb, bestEa, bestEb, tmpPoly, nvp);
-					unsigned short* lastPoly = &polys[(npolys-1)*nvp];
-					if (pb != lastPoly)
-						memcpy(pb, lastPoly, sizeof(unsigned short)*nvp);
-					npolys--;
-				}
-				else
-				{
-					// Could not merge any polygons, stop.
-					break;
-				}
+				ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'merge' (%d).", ntris);
+				return false;
 			}
 		}
 		
@@ -1365,22 +1658,12 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 	}
 	memset(mesh.flags, 0, sizeof(unsigned short)*maxPolys);
 	
-	rcScopedDelete<int> nextVert((int*)rcAlloc(sizeof(int)*maxVerts, RC_ALLOC_TEMP));
-	if (!nextVert)
-	{
-		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'nextVert' (%d).", maxVerts);
-		return false;
-	}
-	memset(nextVert, 0, sizeof(int)*maxVerts);
-	
-	rcScopedDelete<int> firstVert((int*)rcAlloc(sizeof(int)*VERTEX_BUCKET_COUNT, RC_ALLOC_TEMP));
-	if (!firstVert)
+	VertexHash vertexHash;
+	if (!vertexHash.init(maxVerts))
 	{
-		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'firstVert' (%d).", VERTEX_BUCKET_COUNT);
+		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'vertexHash' (%d).", maxVerts);
 		return false;
 	}
-	for (int i = 0; i < VERTEX_BUCKET_COUNT; ++i)
-		firstVert[i] = -1;
 
 	rcScopedDelete<unsigned short> vremap((unsigned short*)rcAlloc(sizeof(unsigned short)*maxVertsPerMesh, RC_ALLOC_PERM));
 	if (!vremap)
@@ -1406,8 +1689,13 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 		for (int j = 0; j < pmesh->nverts; ++j)
 		{
 			unsigned short* v = &pmesh->verts[j*3];
-			vremap[j] = addVertex(v[0]+ox, v[1], v[2]+oz,
-								  mesh.verts, firstVert, nextVert, mesh.nverts);
+			const int vert = vertexHash.addVertex(v[0]+ox, v[1], v[2]+oz, mesh.verts, mesh.nverts);
+			if (vert < 0)
+			{
+				ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'vertexHash' (%d).", vertexHash.getCapacity()*2);
+				return false;
+			}
+			vremap[j] = (unsigned short)vert;
 		}
 		
 		for (int j = 0; j < pmesh->npolys; ++j)
@@ -1456,6 +1744,9 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 		}
 	}
 
+	ctx->log(RC_LOG_PROGRESS, "rcMergePolyMeshes: Welded %d vertices into %d, hash load %.2f, %.2f probes per vertex.",
+			 maxVerts, mesh.nverts, vertexHash.getLoadFactor(), vertexHash.getAverageProbeLength());
+
 	// Calculate adjacency.
 	if (!buildMeshAdjacency(mesh.polys, mesh.npolys, mesh.nverts, mesh.nvp))
 	{
@@ -24,6 +24,7 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastTaskLog.h"
 
 
 static const unsigned RC_UNSET_HEIGHT = 0xffff;
@@ -63,35 +64,6 @@ inline float vcross2(const float* p1, const float* p2, const float* p3)
 	return u1 * v2 - v1 * u2;
 }
 
-static bool circumCircle(const float* p1, const float* p2, const float* p3,
-						 float* c, float& r)
-{
-	static const float EPS = 1e-6f;
-	// Calculate the circle relative to p1, to avoid some precision issues.
-	const float v1[3] = {0,0,0};
-	float v2[3], v3[3];
-	rcVsub(v2, p2,p1);
-	rcVsub(v3, p3,p1);
-	
-	const float cp = vcross2(v1, v2, v3);
-	if (fabsf(cp) > EPS)
-	{
-		const float v1Sq = vdot2(v1,v1);
-		const float v2Sq = vdot2(v2,v2);
-		const float v3Sq = vdot2(v3,v3);
-		c[0] = (v1Sq*(v2[2]-v3[2]) + v2Sq*(v3[2]-v1[2]) + v3Sq*(v1[2]-v2[2])) / (2*cp);
-		c[1] = 0;
-		c[2] = (v1Sq*(v3[0]-v2[0]) + v2Sq*(v1[0]-v3[0]) + v3Sq*(v2[0]-v1[0])) / (2*cp);
-		r = vdist2(c, v1);
-		rcVadd(c, c, p1);
-		return true;
-	}
-	
-	rcVcopy(c, p1);
-	r = 0;
-	return false;
-}
-
 static float distPtTri(const float* p, const float* a, const float* b, const float* c)
 {
 	float v0[3], v1[3], v2[3];
@@ -280,255 +252,219 @@ static unsigned short getHeight(const float fx, const float fy, const float fz,
 }
 
 
-enum EdgeValues
-{
-	EV_UNDEF = -1,
-	EV_HULL = -2
-};
+// Neighbour of the triangle edges on the hull.
+static const int TRI_HULL_EDGE = -1;
 
-static int findEdge(const int* edges, int nedges, int s, int t)
+// Returns the edge of triangle t that goes from vertex a to vertex b.
+// The edge is looked up by its vertices, as two triangles can share two edges at the hull.
+static int findTriEdge(const int* tris, const int t, const int a, const int b)
 {
-	for (int i = 0; i < nedges; i++)
+	for (int k = 0; k < 3; ++k)
 	{
-		const int* e = &edges[i*4];
-		if ((e[0] == s && e[1] == t) || (e[0] == t && e[1] == s))
-			return i;
+		if (tris[t*4+k] == a && tris[t*4+(k+1)%3] == b)
+			return k;
 	}
-	return EV_UNDEF;
+	rcAssert(false);
+	return 0;
 }
 
-static int addEdge(rcContext* ctx, int* edges, int& nedges, const int maxEdges, int s, int t, int l, int r)
+// Finds the neighbour triangle of each triangle edge, by looking up the reverse of each
+// directed edge in a hash of the edges.
+static void buildTriNeighbours(const rcTempVector<int>& tris, rcTempVector<int>& neis)
 {
-	if (nedges >= maxEdges)
-	{
-		ctx->log(RC_LOG_ERROR, "addEdge: Too many edges (%d/%d).", nedges, maxEdges);
-		return EV_UNDEF;
-	}
+	// Power of two, at least twice the number of edges of a hull triangulation.
+	static const int EDGE_HASH_SIZE = 1024;
+	int keys[EDGE_HASH_SIZE];
+	int values[EDGE_HASH_SIZE];
+	memset(keys, 0xff, sizeof(keys));
 	
-	// Add edge if not already in the triangulation.
-	int e = findEdge(edges, nedges, s, t);
-	if (e == EV_UNDEF)
+	const int ntris = static_cast<int>(tris.size()) / 4;
+	rcAssert(ntris*3 <= EDGE_HASH_SIZE/2);
+	neis.assign(ntris*3, TRI_HULL_EDGE);
+	
+	for (int i = 0; i < ntris*3; ++i)
 	{
-		int* edge = &edges[nedges*4];
-		edge[0] = s;
-		edge[1] = t;
-		edge[2] = l;
-		edge[3] = r;
-		return nedges++;
+		const int* t = &tris[(i/3)*4];
+		const int key = (t[i%3] << 16) | t[(i%3+1)%3];
+		int bucket = (key * 31 + (key >> 16)) & (EDGE_HASH_SIZE-1);
+		while (keys[bucket] != -1)
+			bucket = (bucket+1) & (EDGE_HASH_SIZE-1);
+		keys[bucket] = key;
+		values[bucket] = i;
 	}
-	else
+	
+	for (int i = 0; i < ntris*3; ++i)
 	{
-		return EV_UNDEF;
+		const int* t = &tris[(i/3)*4];
+		const int key = (t[(i%3+1)%3] << 16) | t[i%3];
+		for (int bucket = (key * 31 + (key >> 16)) & (EDGE_HASH_SIZE-1); keys[bucket] != -1; bucket = (bucket+1) & (EDGE_HASH_SIZE-1))
+		{
+			if (keys[bucket] == key)
+			{
+				neis[i] = values[bucket] / 3;
+				break;
+			}
+		}
 	}
 }
 
-static void updateLeftFace(int* e, int s, int t, int f)
+// Returns true if edge k of triangle t is not locally Delaunay, that is the opposite vertex
+// of the neighbour triangle is inside the circumcircle of the triangle.
+// The in-circle determinant is the same from both triangles of the edge, also for slivers,
+// and near-cocircular points are left as they are.
+static bool isIllegalTriEdge(const float* pts, const int* tris, const int* neis, const int t, const int k)
 {
-	if (e[0] == s && e[1] == t && e[2] == EV_UNDEF)
-		e[2] = f;
-	else if (e[1] == s && e[0] == t && e[3] == EV_UNDEF)
-		e[3] = f;
+	static const float EPS = 1e-4f;
+	
+	const int u = neis[t*3+k];
+	if (u == TRI_HULL_EDGE)
+		return false;
+	
+	const int* tv = &tris[t*4];
+	const int j = findTriEdge(tris, u, tv[(k+1)%3], tv[k]);
+	const float* pa = &pts[tv[k]*3];
+	const float* pb = &pts[tv[(k+1)%3]*3];
+	const float* pc = &pts[tv[(k+2)%3]*3];
+	const float* pd = &pts[tris[u*4+(j+2)%3]*3];
+	
+	const float adx = pa[0] - pd[0], adz = pa[2] - pd[2];
+	const float bdx = pb[0] - pd[0], bdz = pb[2] - pd[2];
+	const float cdx = pc[0] - pd[0], cdz = pc[2] - pd[2];
+	const float ad = adx*adx + adz*adz;
+	const float bd = bdx*bdx + bdz*bdz;
+	const float cd = cdx*cdx + cdz*cdz;
+	const float ab = adx*bdz - bdx*adz;
+	const float bc = bdx*cdz - cdx*bdz;
+	const float ca = cdx*adz - adx*cdz;
+	const float det = ad*bc + bd*ca + cd*ab;
+	const float mag = ad*fabsf(bc) + bd*fabsf(ca) + cd*fabsf(ab);
+	
+	// The triangles wind clockwise, so the determinant is negative when d is inside the circle.
+	return det < -mag*EPS;
 }
 
-static int overlapSegSeg2d(const float* a, const float* b, const float* c, const float* d)
+// Replaces edge k of triangle t with the other diagonal of the quad formed by t and its neighbour.
+// Returns false if the quad is not convex.
+static bool flipTriEdge(const float* pts, int* tris, int* neis, const int t, const int k)
 {
-	const float a1 = vcross2(a, b, d);
-	const float a2 = vcross2(a, b, c);
-	if (a1*a2 < 0.0f)
-	{
-		float a3 = vcross2(c, d, a);
-		float a4 = a3 + a2 - a1;
-		if (a3 * a4 < 0.0f)
-			return 1;
-	}
-	return 0;
+	static const float EPS = 1e-5f;
+	
+	const int u = neis[t*3+k];
+	const int a = tris[t*4+k];
+	const int b = tris[t*4+(k+1)%3];
+	const int c = tris[t*4+(k+2)%3];
+	const int j = findTriEdge(tris, u, b, a);
+	const int d = tris[u*4+(j+2)%3];
+	
+	// The new triangles must have the same winding as the others.
+	if (vcross2(&pts[c*3], &pts[a*3], &pts[d*3]) > -EPS ||
+		vcross2(&pts[d*3], &pts[b*3], &pts[c*3]) > -EPS)
+		return false;
+	
+	const int nbc = neis[t*3+(k+1)%3];
+	const int nca = neis[t*3+(k+2)%3];
+	const int nad = neis[u*3+(j+1)%3];
+	const int ndb = neis[u*3+(j+2)%3];
+	
+	tris[t*4+0] = c; tris[t*4+1] = a; tris[t*4+2] = d;
+	neis[t*3+0] = nca; neis[t*3+1] = nad; neis[t*3+2] = u;
+	tris[u*4+0] = d; tris[u*4+1] = b; tris[u*4+2] = c;
+	neis[u*3+0] = ndb; neis[u*3+1] = nbc; neis[u*3+2] = t;
+	
+	if (nad != TRI_HULL_EDGE)
+		neis[nad*3 + findTriEdge(tris, nad, d, a)] = t;
+	if (nbc != TRI_HULL_EDGE)
+		neis[nbc*3 + findTriEdge(tris, nbc, c, b)] = u;
+	
+	return true;
 }
 
-static bool overlapEdges(const float* pts, const int* edges, int nedges, int s1, int t1)
+// Adds triangle t to the triangles to check, unless it is already there.
+// The last value of the triangle marks it as being on the stack.
+static void pushTri(rcTempVector<int>& tris, rcTempVector<int>& stack, const int t)
 {
-	for (int i = 0; i < nedges; ++i)
-	{
-		const int s0 = edges[i*4+0];
-		const int t0 = edges[i*4+1];
-		// Same or connected edges do not overlap.
-		if (s0 == s1 || s0 == t1 || t0 == s1 || t0 == t1)
-			continue;
-		if (overlapSegSeg2d(&pts[s0*3],&pts[t0*3], &pts[s1*3],&pts[t1*3]))
-			return true;
-	}
-	return false;
+	if (tris[t*4+3])
+		return;
+	tris[t*4+3] = 1;
+	stack.push_back(t);
 }
 
-static void completeFacet(rcContext* ctx, const float* pts, int npts, int* edges, int& nedges, const int maxEdges, int& nfaces, int e)
+// Flips the illegal edges of the triangles on the stack, and of the triangles changed
+// by the flips, until the triangulation is Delaunay.
+static void legalizeTris(const float* pts, rcTempVector<int>& tris, rcTempVector<int>& neis, rcTempVector<int>& stack)
 {
-	static const float EPS = 1e-5f;
-	
-	int* edge = &edges[e*4];
-	
-	// Cache s and t.
-	int s,t;
-	if (edge[2] == EV_UNDEF)
+	while (!stack.empty())
 	{
-		s = edge[0];
-		t = edge[1];
-	}
-	else if (edge[3] == EV_UNDEF)
-	{
-		s = edge[1];
-		t = edge[0];
-	}
-	else
-	{
-	    // Edge already completed.
-	    return;
-	}
-    
-	// Find best point on left of edge.
-	int pt = npts;
-	float c[3] = {0,0,0};
-	float r = -1;
-	for (int u = 0; u < npts; ++u)
-	{
-		if (u == s || u == t) continue;
-		if (vcross2(&pts[s*3], &pts[t*3], &pts[u*3]) > EPS)
+		const int t = stack.back();
+		stack.pop_back();
+		tris[t*4+3] = 0;
+		
+		for (int k = 0; k < 3; ++k)
 		{
-			if (r < 0)
-			{
-				// The circle is not updated yet, do it now.
-				pt = u;
-				circumCircle(&pts[s*3], &pts[t*3], &pts[u*3], c, r);
-				continue;
-			}
-			const float d = vdist2(c, &pts[u*3]);
-			const float tol = 0.001f;
-			if (d > r*(1+tol))
-			{
-				// Outside current circumcircle, skip.
-				continue;
-			}
-			else if (d < r*(1-tol))
-			{
-				// Inside safe circumcircle, update circle.
-				pt = u;
-				circumCircle(&pts[s*3], &pts[t*3], &pts[u*3], c, r);
-			}
-			else
+			const int u = neis[t*3+k];
+			if (isIllegalTriEdge(pts, &tris[0], &neis[0], t, k) && flipTriEdge(pts, &tris[0], &neis[0], t, k))
 			{
-				// Inside epsilon circum circle, do extra tests to make sure the edge is valid.
-				// s-u and t-u cannot overlap with s-pt nor t-pt if they exists.
-				if (overlapEdges(pts, edges, nedges, s,u))
-					continue;
-				if (overlapEdges(pts, edges, nedges, t,u))
-					continue;
-				// Edge is valid.
-				pt = u;
-				circumCircle(&pts[s*3], &pts[t*3], &pts[u*3], c, r);
+				pushTri(tris, stack, t);
+				pushTri(tris, stack, u);
+				break;
 			}
 		}
 	}
-	
-	// Add new triangle or update edge info if s-t is on hull.
-	if (pt < npts)
-	{
-		// Update face information of edge being completed.
-		updateLeftFace(&edges[e*4], s, t, nfaces);
-		
-		// Add new edge or update face info of old edge.
-		e = findEdge(edges, nedges, pt, s);
-		if (e == EV_UNDEF)
-		    addEdge(ctx, edges, nedges, maxEdges, pt, s, nfaces, EV_UNDEF);
-		else
-		    updateLeftFace(&edges[e*4], pt, s, nfaces);
-		
-		// Add new edge or update face info of old edge.
-		e = findEdge(edges, nedges, t, pt);
-		if (e == EV_UNDEF)
-		    addEdge(ctx, edges, nedges, maxEdges, t, pt, nfaces, EV_UNDEF);
-		else
-		    updateLeftFace(&edges[e*4], t, pt, nfaces);
-		
-		nfaces++;
-	}
-	else
-	{
-		updateLeftFace(&edges[e*4], s, t, EV_HULL);
-	}
 }
 
-static void delaunayHull(rcContext* ctx, const int npts, const float* pts,
-						 const int nhull, const int* hull,
-						 rcTempVector<int>& tris, rcTempVector<int>& edges)
+// Inserts point p into a Delaunay triangulation of the hull, by splitting the triangle that
+// contains it and flipping the edges that are not Delaunay after the split.
+static bool insertTriPoint(const float* pts, const int p, rcTempVector<int>& tris, rcTempVector<int>& neis, rcTempVector<int>& stack)
 {
-	int nfaces = 0;
-	int nedges = 0;
-	const int maxEdges = npts*10;
-	edges.resize(maxEdges*4);
-	
-	for (int i = 0, j = nhull-1; i < nhull; j=i++)
-		addEdge(ctx, &edges[0], nedges, maxEdges, hull[j],hull[i], EV_HULL, EV_UNDEF);
-	
-	int currentEdge = 0;
-	while (currentEdge < nedges)
-	{
-		if (edges[currentEdge*4+2] == EV_UNDEF)
-			completeFacet(ctx, pts, npts, &edges[0], nedges, maxEdges, nfaces, currentEdge);
-		if (edges[currentEdge*4+3] == EV_UNDEF)
-			completeFacet(ctx, pts, npts, &edges[0], nedges, maxEdges, nfaces, currentEdge);
-		currentEdge++;
-	}
-	
-	// Create tris
-	tris.resize(nfaces*4);
-	for (int i = 0; i < nfaces*4; ++i)
-		tris[i] = -1;
-	
-	for (int i = 0; i < nedges; ++i)
+	// Find the triangle which contains the point best.
+	const float* pt = &pts[p*3];
+	const int ntris = static_cast<int>(tris.size()) / 4;
+	int t = -1;
+	float bestMargin = -FLT_MAX;
+	for (int i = 0; i < ntris; ++i)
 	{
-		const int* e = &edges[i*4];
-		if (e[3] >= 0)
-		{
-			// Left face
-			int* t = &tris[e[3]*4];
-			if (t[0] == -1)
-			{
-				t[0] = e[0];
-				t[1] = e[1];
-			}
-			else if (t[0] == e[1])
-				t[2] = e[0];
-			else if (t[1] == e[0])
-				t[2] = e[1];
-		}
-		if (e[2] >= 0)
+		const int* v = &tris[i*4];
+		float margin = -vcross2(&pts[v[0]*3], &pts[v[1]*3], pt);
+		margin = rcMin(margin, -vcross2(&pts[v[1]*3], &pts[v[2]*3], pt));
+		margin = rcMin(margin, -vcross2(&pts[v[2]*3], &pts[v[0]*3], pt));
+		if (margin > bestMargin)
 		{
-			// Right
-			int* t = &tris[e[2]*4];
-			if (t[0] == -1)
-			{
-				t[0] = e[1];
-				t[1] = e[0];
-			}
-			else if (t[0] == e[0])
-				t[2] = e[1];
-			else if (t[1] == e[1])
-				t[2] = e[0];
+			bestMargin = margin;
+			t = i;
 		}
 	}
+	if (t == -1)
+		return false;
 	
-	for (int i = 0; i < tris.size()/4; ++i)
-	{
-		int* t = &tris[i*4];
-		if (t[0] == -1 || t[1] == -1 || t[2] == -1)
-		{
-			ctx->log(RC_LOG_WARNING, "delaunayHull: Removing dangling face %d [%d,%d,%d].", i, t[0],t[1],t[2]);
-			t[0] = tris[tris.size()-4];
-			t[1] = tris[tris.size()-3];
-			t[2] = tris[tris.size()-2];
-			t[3] = tris[tris.size()-1];
-			tris.resize(tris.size()-4);
-			--i;
-		}
-	}
+	// Split the triangle in three.
+	const int a = tris[t*4+0];
+	const int b = tris[t*4+1];
+	const int c = tris[t*4+2];
+	const int nb = neis[t*3+1];
+	const int nc = neis[t*3+2];
+	const int t1 = ntris;
+	const int t2 = ntris+1;
+	
+	tris[t*4+2] = p;
+	neis[t*3+1] = t1;
+	neis[t*3+2] = t2;
+	
+	tris.push_back(b); tris.push_back(c); tris.push_back(p); tris.push_back(0);
+	neis.push_back(nb); neis.push_back(t2); neis.push_back(t);
+	tris.push_back(c); tris.push_back(a); tris.push_back(p); tris.push_back(0);
+	neis.push_back(nc); neis.push_back(t); neis.push_back(t1);
+	
+	if (nb != TRI_HULL_EDGE)
+		neis[nb*3 + findTriEdge(&tris[0], nb, c, b)] = t1;
+	if (nc != TRI_HULL_EDGE)
+		neis[nc*3 + findTriEdge(&tris[0], nc, a, c)] = t2;
+	
+	pushTri(tris, stack, t);
+	pushTri(tris, stack, t1);
+	pushTri(tris, stack, t2);
+	legalizeTris(pts, tris, neis, stack);
+	
+	return true;
 }
 
 // Calculate minimum extend of the polygon.
@@ -672,7 +608,8 @@ static bool buildPolyDetail(rcContext* ctx, const float* in, const int nin,
 							const float sampleDist, const float sampleMaxError,
 							const int heightSearchRadius, const rcCompactHeightfield& chf,
 							const rcHeightPatch& hp, float* verts, int& nverts,
-							rcTempVector<int>& tris, rcTempVector<int>& edges, rcTempVector<int>& samples)
+							rcTempVector<int>& tris, rcTempVector<int>& neis, rcTempVector<int>& stack,
+							rcTempVector<int>& samples)
 {
 	static const int MAX_VERTS = 127;
 	static const int MAX_TRIS = 255;	// Max tris for delaunay is 2n-2-k (n=num verts, k=num hull verts).
@@ -686,7 +623,6 @@ static bool buildPolyDetail(rcContext* ctx, const float* in, const int nin,
 	for (int i = 0; i < nin; ++i)
 		rcVcopy(&verts[i*3], &in[i*3]);
 	
-	edges.clear();
 	tris.clear();
 	
 	const float cs = chf.cs;
@@ -896,11 +832,22 @@ static bool buildPolyDetail(rcContext* ctx, const float* in, const int nin,
 			rcVcopy(&verts[nverts*3],bestpt);
 			nverts++;
 			
-			// Create new triangulation.
-			// TODO: Incremental add instead of full rebuild.
-			edges.clear();
-			tris.clear();
-			delaunayHull(ctx, nverts, verts, nhull, hull, tris, edges);
+			// Before the first point is added, turn the hull triangulation into a Delaunay triangulation,
+			// which is then updated as each point is added.
+			if (iter == 0)
+			{
+				buildTriNeighbours(tris, neis);
+				stack.clear();
+				for (int i = 0; i < static_cast<int>(tris.size()) / 4; ++i)
+					pushTri(tris, stack, i);
+				legalizeTris(verts, tris, neis, stack);
+			}
+			if (!insertTriPoint(verts, nverts-1, tris, neis, stack))
+			{
+				ctx->log(RC_LOG_WARNING, "buildPolyDetail: Could not add sample point to triangulation.");
+				nverts--;
+				break;
+			}
 		}
 	}
 	
@@ -1174,11 +1121,141 @@ static void getHeightData(rcContext* ctx, const rcCompactHeightfield& chf,
 	}
 }
 
+namespace
+{
+/// The number of polygons handled by each detail mesh task.
+const int DETAIL_POLYS_PER_TASK = 32;
+
+/// The detail meshes built by one task, for a range of polygons.
+struct DetailTaskResult
+{
+	DetailTaskResult() : failed(false) {}
+	rcTempVector<float> verts;
+	rcTempVector<unsigned char> tris;
+	rcTempVector<char> messages;
+	bool failed;
+};
+
+/// Builds the detail meshes of ranges of polygons. The vertex and triangle counts of each
+/// polygon are written to the detail mesh, and the vertices and triangles to the task result.
+class BuildPolyDetailTasks : public rcTaskSet
+{
+public:
+	BuildPolyDetailTasks(const rcPolyMesh& mesh, const rcCompactHeightfield& chf, const int* bounds,
+						 const int maxhw, const int maxhh, const float sampleDist, const float sampleMaxError,
+						 unsigned int* meshes, DetailTaskResult* results)
+		: m_mesh(mesh), m_chf(chf), m_bounds(bounds), m_maxhw(maxhw), m_maxhh(maxhh),
+		  m_sampleDist(sampleDist), m_sampleMaxError(sampleMaxError), m_meshes(meshes), m_results(results) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		const rcPolyMesh& mesh = m_mesh;
+		const rcCompactHeightfield& chf = m_chf;
+		const int nvp = mesh.nvp;
+		const float cs = mesh.cs;
+		const float ch = mesh.ch;
+		const float* orig = mesh.bmin;
+		const int borderSize = mesh.borderSize;
+		const int heightSearchRadius = rcMax(1, (int)ceilf(mesh.maxEdgeError));
+		const int i0 = taskIndex * DETAIL_POLYS_PER_TASK;
+		const int i1 = rcMin(i0 + DETAIL_POLYS_PER_TASK, mesh.npolys);
+		
+		DetailTaskResult& result = m_results[taskIndex];
+		rcTaskLogContext ctx(result.messages);
+		
+		rcTempVector<int> neis(512);
+		rcTempVector<int> stack(64);
+		rcTempVector<int> tris(512);
+		rcTempVector<int> arr(512);
+		rcTempVector<int> samples(512);
+		rcTempVector<float> poly(nvp*3);
+		float verts[256*3];
+		rcHeightPatch hp;
+		hp.data = (unsigned short*)rcAlloc(sizeof(unsigned short)*m_maxhw*m_maxhh, RC_ALLOC_TEMP);
+		if (!hp.data || poly.size() != nvp*3)
+		{
+			ctx.log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'hp.data' (%d).", m_maxhw*m_maxhh);
+			result.failed = true;
+			return;
+		}
+		
+		for (int i = i0; i < i1; ++i)
+		{
+			const unsigned short* p = &mesh.polys[i*nvp*2];
+			
+			// Store polygon vertices for processing.
+			int npoly = 0;
+			for (int j = 0; j < nvp; ++j)
+			{
+				if(p[j] == RC_MESH_NULL_IDX) break;
+				const unsigned short* v = &mesh.verts[p[j]*3];
+				poly[j*3+0] = v[0]*cs;
+				poly[j*3+1] = v[1]*ch;
+				poly[j*3+2] = v[2]*cs;
+				npoly++;
+			}
+			
+			// Get the height data from the area of the polygon.
+			hp.xmin = m_bounds[i*4+0];
+			hp.ymin = m_bounds[i*4+2];
+			hp.width = m_bounds[i*4+1]-m_bounds[i*4+0];
+			hp.height = m_bounds[i*4+3]-m_bounds[i*4+2];
+			getHeightData(&ctx, chf, p, npoly, mesh.verts, borderSize, hp, arr, mesh.regs[i]);
+			
+			// Build detail mesh.
+			int nverts = 0;
+			if (!buildPolyDetail(&ctx, poly.data(), npoly,
+								 m_sampleDist, m_sampleMaxError,
+								 heightSearchRadius, chf, hp,
+								 verts, nverts, tris,
+								 neis, stack, samples))
+			{
+				result.failed = true;
+				return;
+			}
+			
+			// Store the detail verts in world space.
+			for (int j = 0; j < nverts; ++j)
+			{
+				result.verts.push_back(verts[j*3+0] + orig[0]);
+				result.verts.push_back(verts[j*3+1] + orig[1] + chf.ch); // Is this offset necessary?
+				result.verts.push_back(verts[j*3+2] + orig[2]);
+			}
+			
+			const int ntris = static_cast<int>(tris.size()) / 4;
+			for (int j = 0; j < ntris*4; ++j)
+				result.tris.push_back((unsigned char)tris[j]);
+			
+			m_meshes[i*4+1] = (unsigned int)nverts;
+			m_meshes[i*4+3] = (unsigned int)ntris;
+		}
+	}
+
+private:
+	const rcPolyMesh& m_mesh;
+	const rcCompactHeightfield& m_chf;
+	const int* m_bounds;
+	const int m_maxhw;
+	const int m_maxhh;
+	const float m_sampleDist;
+	const float m_sampleMaxError;
+	unsigned int* m_meshes;
+	DetailTaskResult* m_results;
+
+	// Explicitly-disabled copy assignment operator.
+	BuildPolyDetailTasks& operator=(const BuildPolyDetailTasks&);
+};
+}  // namespace
+
 /// @par
 ///
+/// The detail meshes of ranges of polygons are built by a task set run through rcContext::runTasks,
+/// and then copied into the detail mesh in polygon order. Messages logged while building a polygon
+/// are logged once all tasks have completed, in polygon order.
+///
 /// See the #rcConfig documentation for more information on the configuration parameters.
 ///
-/// @see rcAllocPolyMeshDetail, rcPolyMesh, rcCompactHeightfield, rcPolyMeshDetail, rcConfig
+/// @see rcAllocPolyMeshDetail, rcPolyMesh, rcCompactHeightfield, rcPolyMeshDetail, rcContext::runTasks, rcConfig
 bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
 						   const float sampleDist, const float sampleMaxError,
 						   rcPolyMeshDetail& dmesh)
@@ -1191,19 +1268,6 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		return true;
 	
 	const int nvp = mesh.nvp;
-	const float cs = mesh.cs;
-	const float ch = mesh.ch;
-	const float* orig = mesh.bmin;
-	const int borderSize = mesh.borderSize;
-	const int heightSearchRadius = rcMax(1, (int)ceilf(mesh.maxEdgeError));
-	
-	rcTempVector<int> edges(64);
-	rcTempVector<int> tris(512);
-	rcTempVector<int> arr(512);
-	rcTempVector<int> samples(512);
-	float verts[256*3];
-	rcHeightPatch hp;
-	int nPolyVerts = 0;
 	int maxhw = 0, maxhh = 0;
 	
 	rcScopedDelete<int> bounds((int*)rcAlloc(sizeof(int)*mesh.npolys*4, RC_ALLOC_TEMP));
@@ -1212,12 +1276,6 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'bounds' (%d).", mesh.npolys*4);
 		return false;
 	}
-	rcScopedDelete<float> poly((float*)rcAlloc(sizeof(float)*nvp*3, RC_ALLOC_TEMP));
-	if (!poly)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'poly' (%d).", nvp*3);
-		return false;
-	}
 	
 	// Find max size for a polygon area.
 	for (int i = 0; i < mesh.npolys; ++i)
@@ -1239,7 +1297,6 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 			xmax = rcMax(xmax, (int)v[0]);
 			ymin = rcMin(ymin, (int)v[2]);
 			ymax = rcMax(ymax, (int)v[2]);
-			nPolyVerts++;
 		}
 		xmin = rcMax(0,xmin-1);
 		xmax = rcMin(chf.width,xmax+1);
@@ -1250,13 +1307,6 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		maxhh = rcMax(maxhh, ymax-ymin);
 	}
 	
-	hp.data = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxhw*maxhh, RC_ALLOC_TEMP);
-	if (!hp.data)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'hp.data' (%d).", maxhw*maxhh);
-		return false;
-	}
-	
 	dmesh.nmeshes = mesh.npolys;
 	dmesh.nverts = 0;
 	dmesh.ntris = 0;
@@ -1266,132 +1316,57 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.meshes' (%d).", dmesh.nmeshes*4);
 		return false;
 	}
+	memset(dmesh.meshes, 0, sizeof(unsigned int)*dmesh.nmeshes*4);
 	
-	int vcap = nPolyVerts+nPolyVerts/2;
-	int tcap = vcap*2;
-	
-	dmesh.nverts = 0;
-	dmesh.verts = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM);
-	if (!dmesh.verts)
+	// Build the detail meshes of the polygons into per task buffers.
+	const int ntasks = (mesh.npolys + DETAIL_POLYS_PER_TASK-1) / DETAIL_POLYS_PER_TASK;
+	rcTempVector<DetailTaskResult> results(ntasks);
+	if (results.size() != ntasks)
 	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.verts' (%d).", vcap*3);
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'results' (%d).", ntasks);
 		return false;
 	}
-	dmesh.ntris = 0;
-	dmesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM);
-	if (!dmesh.tris)
+	BuildPolyDetailTasks detailTasks(mesh, chf, bounds, maxhw, maxhh, sampleDist, sampleMaxError,
+									 dmesh.meshes, results.data());
+	ctx->runTasks(detailTasks, ntasks);
+	
+	// Log the task messages in polygon order, up to the first failure.
+	for (int i = 0; i < ntasks; ++i)
 	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.tris' (%d).", tcap*4);
-		return false;
+		rcTaskLogContext::replay(ctx, results[i].messages);
+		if (results[i].failed)
+			return false;
 	}
 	
+	// Compact the task buffers into the detail mesh.
 	for (int i = 0; i < mesh.npolys; ++i)
 	{
-		const unsigned short* p = &mesh.polys[i*nvp*2];
-		
-		// Store polygon vertices for processing.
-		int npoly = 0;
-		for (int j = 0; j < nvp; ++j)
-		{
-			if(p[j] == RC_MESH_NULL_IDX) break;
-			const unsigned short* v = &mesh.verts[p[j]*3];
-			poly[j*3+0] = v[0]*cs;
-			poly[j*3+1] = v[1]*ch;
-			poly[j*3+2] = v[2]*cs;
-			npoly++;
-		}
-		
-		// Get the height data from the area of the polygon.
-		hp.xmin = bounds[i*4+0];
-		hp.ymin = bounds[i*4+2];
-		hp.width = bounds[i*4+1]-bounds[i*4+0];
-		hp.height = bounds[i*4+3]-bounds[i*4+2];
-		getHeightData(ctx, chf, p, npoly, mesh.verts, borderSize, hp, arr, mesh.regs[i]);
-		
-		// Build detail mesh.
-		int nverts = 0;
-		if (!buildPolyDetail(ctx, poly, npoly,
-							 sampleDist, sampleMaxError,
-							 heightSearchRadius, chf, hp,
-							 verts, nverts, tris,
-							 edges, samples))
-		{
-			return false;
-		}
-		
-		// Move detail verts to world space.
-		for (int j = 0; j < nverts; ++j)
-		{
-			verts[j*3+0] += orig[0];
-			verts[j*3+1] += orig[1] + chf.ch; // Is this offset necessary?
-			verts[j*3+2] += orig[2];
-		}
-		// Offset poly too, will be used to flag checking.
-		for (int j = 0; j < npoly; ++j)
-		{
-			poly[j*3+0] += orig[0];
-			poly[j*3+1] += orig[1];
-			poly[j*3+2] += orig[2];
-		}
-		
-		// Store detail submesh.
-		const int ntris = static_cast<int>(tris.size()) / 4;
-		
 		dmesh.meshes[i*4+0] = (unsigned int)dmesh.nverts;
-		dmesh.meshes[i*4+1] = (unsigned int)nverts;
 		dmesh.meshes[i*4+2] = (unsigned int)dmesh.ntris;
-		dmesh.meshes[i*4+3] = (unsigned int)ntris;
-		
-		// Store vertices, allocate more memory if necessary.
-		if (dmesh.nverts+nverts > vcap)
-		{
-			while (dmesh.nverts+nverts > vcap)
-				vcap += 256;
-			
-			float* newv = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM);
-			if (!newv)
-			{
-				ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'newv' (%d).", vcap*3);
-				return false;
-			}
-			if (dmesh.nverts)
-				memcpy(newv, dmesh.verts, sizeof(float)*3*dmesh.nverts);
-			rcFree(dmesh.verts);
-			dmesh.verts = newv;
-		}
-		for (int j = 0; j < nverts; ++j)
-		{
-			dmesh.verts[dmesh.nverts*3+0] = verts[j*3+0];
-			dmesh.verts[dmesh.nverts*3+1] = verts[j*3+1];
-			dmesh.verts[dmesh.nverts*3+2] = verts[j*3+2];
-			dmesh.nverts++;
-		}
-		
-		// Store triangles, allocate more memory if necessary.
-		if (dmesh.ntris+ntris > tcap)
-		{
-			while (dmesh.ntris+ntris > tcap)
-				tcap += 256;
-			unsigned char* newt = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM);
-			if (!newt)
-			{
-				ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'newt' (%d).", tcap*4);
-				return false;
-			}
-			if (dmesh.ntris)
-				memcpy(newt, dmesh.tris, sizeof(unsigned char)*4*dmesh.ntris);
-			rcFree(dmesh.tris);
-			dmesh.tris = newt;
-		}
-		for (int j = 0; j < ntris; ++j)
-		{
-			const int* t = &tris[j*4];
-			dmesh.tris[dmesh.ntris*4+0] = (unsigned char)t[0];
-			dmesh.tris[dmesh.ntris*4+1] = (unsigned char)t[1];
-			dmesh.tris[dmesh.ntris*4+2] = (unsigned char)t[2];
-			dmesh.tris[dmesh.ntris*4+3] = (unsigned char)t[3];
-			dmesh.ntris++;
-		}
+		dmesh.nverts += (int)dmesh.meshes[i*4+1];
+		dmesh.ntris += (int)dmesh.meshes[i*4+3];
+	}
+	
+	dmesh.verts = (float*)rcAlloc(sizeof(float)*rcMax(dmesh.nverts, 1)*3, RC_ALLOC_PERM);
+	if (!dmesh.verts)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.verts' (%d).", dmesh.nverts*3);
+		return false;
+	}
+	dmesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*rcMax(dmesh.ntris, 1)*4, RC_ALLOC_PERM);
+	if (!dmesh.tris)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.tris' (%d).", dmesh.ntris*4);
+		return false;
+	}
+	for (int i = 0; i < ntasks; ++i)
+	{
+		const DetailTaskResult& result = results[i];
+		const int firstPoly = i * DETAIL_POLYS_PER_TASK;
+		if (!result.verts.empty())
+			memcpy(&dmesh.verts[dmesh.meshes[firstPoly*4+0]*3], result.verts.data(), sizeof(float)*result.verts.size());
+		if (!result.tris.empty())
+			memcpy(&dmesh.tris[dmesh.meshes[firstPoly*4+2]*4], result.tris.data(), sizeof(unsigned char)*result.tris.size());
 	}
 	
 	return true;
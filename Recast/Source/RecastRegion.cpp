@@ -1667,6 +1667,645 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 }
 
 
+namespace
+{
+// A rectangle of cells [minx,maxx) x [miny,maxy).
+struct CellRect
+{
+	CellRect(int minx_, int miny_, int maxx_, int maxy_) : minx(minx_), miny(miny_), maxx(maxx_), maxy(maxy_) {}
+	bool contains(int x, int y) const { return x >= minx && x < maxx && y >= miny && y < maxy; }
+	int minx;
+	int miny;
+	int maxx;
+	int maxy;
+};
+
+// Values of WatershedPartitions::regionCounts for partitions that failed to flood.
+const int PARTITION_OUT_OF_MEMORY = -1;
+const int PARTITION_REGION_OVERFLOW = -2;
+
+// The square partitions flooded by rcBuildRegionsParallel.
+struct WatershedPartitions
+{
+	WatershedPartitions(rcCompactHeightfield& chf_, unsigned short* srcReg_, unsigned short* srcDist_,
+						int borderSize_, int size_)
+		: chf(chf_), srcReg(srcReg_), srcDist(srcDist_),
+		  borderWidth(borderSize_ > 0 ? rcMin(chf_.width, borderSize_) : 0),
+		  borderHeight(borderSize_ > 0 ? rcMin(chf_.height, borderSize_) : 0),
+		  size(size_), halo(rcMax(size_/4, 8)),
+		  countX((chf_.width + size_ - 1) / size_), countY((chf_.height + size_ - 1) / size_) {}
+
+	CellRect getRect(int partition) const
+	{
+		const int px = partition % countX;
+		const int py = partition / countX;
+		return CellRect(px*size, py*size, rcMin((px+1)*size, chf.width), rcMin((py+1)*size, chf.height));
+	}
+	// The partition expanded by the halo of cells that are flooded along with it.
+	CellRect getFloodRect(int partition) const
+	{
+		const CellRect rect = getRect(partition);
+		return CellRect(rcMax(rect.minx-halo, 0), rcMax(rect.miny-halo, 0),
+						rcMin(rect.maxx+halo, chf.width), rcMin(rect.maxy+halo, chf.height));
+	}
+	int getPartition(int x, int y) const { return x/size + (y/size)*countX; }
+	bool isBorderCell(int x, int y) const
+	{
+		return x < borderWidth || x >= chf.width-borderWidth || y < borderHeight || y >= chf.height-borderHeight;
+	}
+
+	rcCompactHeightfield& chf;
+	unsigned short* srcReg;
+	unsigned short* srcDist;
+	const int borderWidth;
+	const int borderHeight;
+	const int size;
+	const int halo;
+	const int countX;
+	const int countY;
+	// Number of regions in each partition, or one of the PARTITION_* errors.
+	rcTempVector<int> regionCounts;
+	// The first global region id of each partition.
+	rcTempVector<int> firstRegions;
+
+private:
+	// Explicitly-disabled copy assignment operator.
+	WatershedPartitions& operator=(const WatershedPartitions&);
+};
+}  // namespace
+
+// Copies the cells of a rectangle into a compact heightfield of its own,
+// cutting the connections that leave the rectangle.
+static bool copyCellRect(const rcCompactHeightfield& chf, const CellRect& rect, rcCompactHeightfield& sub)
+{
+	const int w = chf.width;
+	const int sw = rect.maxx - rect.minx;
+	const int sh = rect.maxy - rect.miny;
+
+	int spanCount = 0;
+	for (int y = rect.miny; y < rect.maxy; ++y)
+		for (int x = rect.minx; x < rect.maxx; ++x)
+			spanCount += chf.cells[x+y*w].count;
+
+	sub.width = sw;
+	sub.height = sh;
+	sub.spanCount = spanCount;
+	sub.cells = (rcCompactCell*)rcAlloc(sizeof(rcCompactCell)*sw*sh, RC_ALLOC_TEMP);
+	sub.spans = (rcCompactSpan*)rcAlloc(sizeof(rcCompactSpan)*rcMax(spanCount, 1), RC_ALLOC_TEMP);
+	sub.areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*rcMax(spanCount, 1), RC_ALLOC_TEMP);
+	sub.dist = (unsigned short*)rcAlloc(sizeof(unsigned short)*rcMax(spanCount, 1), RC_ALLOC_TEMP);
+	if (!sub.cells || !sub.spans || !sub.areas || !sub.dist)
+		return false;
+
+	int n = 0;
+	for (int y = rect.miny; y < rect.maxy; ++y)
+	{
+		for (int x = rect.minx; x < rect.maxx; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			rcCompactCell& sc = sub.cells[(x-rect.minx)+(y-rect.miny)*sw];
+			sc.index = n;
+			sc.count = c.count;
+			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i, ++n)
+			{
+				rcCompactSpan& s = sub.spans[n];
+				s = chf.spans[i];
+				for (int dir = 0; dir < 4; ++dir)
+				{
+					if (rcGetCon(s, dir) != RC_NOT_CONNECTED &&
+						!rect.contains(x + rcGetDirOffsetX(dir), y + rcGetDirOffsetY(dir)))
+						rcSetCon(s, dir, RC_NOT_CONNECTED);
+				}
+				sub.areas[n] = chf.areas[i];
+				sub.dist[n] = chf.dist[i];
+				sub.maxDistance = rcMax(sub.maxDistance, chf.dist[i]);
+			}
+		}
+	}
+	return true;
+}
+
+namespace
+{
+// Runs the watershed over a copy of a partition and its halo, and writes the regions
+// of the partition's own cells back numbered from 1. The halo lets regions grow across
+// the partition seams like they would in a single watershed, which is what makes the
+// regions on both sides of a seam line up.
+// The partitions cover disjoint sets of spans, so they can be flooded concurrently.
+class FloodPartitionTasks : public rcTaskSet
+{
+public:
+	FloodPartitionTasks(WatershedPartitions& parts, int expandIters) : m_parts(parts), m_expandIters(expandIters) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		m_parts.regionCounts[taskIndex] = floodPartition(taskIndex);
+	}
+
+private:
+	int floodPartition(const int partition)
+	{
+		const rcCompactHeightfield& chf = m_parts.chf;
+		const int w = chf.width;
+		const CellRect core = m_parts.getRect(partition);
+		const CellRect rect = m_parts.getFloodRect(partition);
+		const int sw = rect.maxx - rect.minx;
+
+		rcCompactHeightfield sub;
+		if (!copyCellRect(chf, rect, sub))
+			return PARTITION_OUT_OF_MEMORY;
+
+		rcScopedDelete<unsigned short> buf((unsigned short*)rcAlloc(sizeof(unsigned short)*rcMax(sub.spanCount, 1)*2, RC_ALLOC_TEMP));
+		if (!buf)
+			return PARTITION_OUT_OF_MEMORY;
+
+		unsigned short* srcReg = buf;
+		unsigned short* srcDist = buf+sub.spanCount;
+		memset(srcReg, 0, sizeof(unsigned short)*sub.spanCount);
+		memset(srcDist, 0, sizeof(unsigned short)*sub.spanCount);
+
+		// Copy the border regions, which no task writes to.
+		for (int y = rect.miny; y < rect.maxy; ++y)
+		{
+			for (int x = rect.minx; x < rect.maxx; ++x)
+			{
+				if (!m_parts.isBorderCell(x, y))
+					continue;
+				const rcCompactCell& c = chf.cells[x+y*w];
+				const int si = (int)sub.cells[(x-rect.minx)+(y-rect.miny)*sw].index;
+				for (int i = 0; i < (int)c.count; ++i)
+					srcReg[si+i] = m_parts.srcReg[c.index+i];
+			}
+		}
+
+		const int LOG_NB_STACKS = 3;
+		const int NB_STACKS = 1 << LOG_NB_STACKS;
+		rcTempVector<LevelStackEntry> lvlStacks[NB_STACKS];
+		for (int i=0; i<NB_STACKS; ++i)
+			lvlStacks[i].reserve(256);
+
+		rcTempVector<LevelStackEntry> stack;
+		stack.reserve(256);
+
+		unsigned short regionId = 1;
+		unsigned short level = (sub.maxDistance+1) & ~1;
+
+		int sId = -1;
+		while (level > 0)
+		{
+			level = level >= 2 ? level-2 : 0;
+			sId = (sId+1) & (NB_STACKS-1);
+
+			if (sId == 0)
+				sortCellsByLevel(level, sub, srcReg, NB_STACKS, lvlStacks, 1);
+			else
+				appendStacks(lvlStacks[sId-1], lvlStacks[sId], srcReg); // copy left overs from last level
+
+			// Expand current regions until no empty connected cells found.
+			expandRegions(m_expandIters, level, sub, srcReg, srcDist, lvlStacks[sId], false);
+
+			// Mark new regions with IDs.
+			for (int j = 0; j<lvlStacks[sId].size(); j++)
+			{
+				LevelStackEntry current = lvlStacks[sId][j];
+				int x = current.x;
+				int y = current.y;
+				int i = current.index;
+				if (i >= 0 && srcReg[i] == 0)
+				{
+					if (floodRegion(x, y, i, level, regionId, sub, srcReg, srcDist, stack))
+					{
+						// Region ids must stay clear of the border flag.
+						if (regionId+1 >= RC_BORDER_REG)
+							return PARTITION_REGION_OVERFLOW;
+						regionId++;
+					}
+				}
+			}
+		}
+
+		// Expand current regions until no empty connected cells found.
+		expandRegions(m_expandIters*8, 0, sub, srcReg, srcDist, stack, true);
+
+		// Number the regions found in the partition's own cells from 1, keeping their order.
+		rcTempVector<unsigned short> remap(regionId, 0);
+		for (int y = core.miny; y < core.maxy; ++y)
+		{
+			for (int x = core.minx; x < core.maxx; ++x)
+			{
+				const rcCompactCell& sc = sub.cells[(x-rect.minx)+(y-rect.miny)*sw];
+				for (int i = (int)sc.index, ni = (int)(sc.index+sc.count); i < ni; ++i)
+				{
+					if ((srcReg[i] & RC_BORDER_REG) == 0)
+						remap[srcReg[i]] = 1;
+				}
+			}
+		}
+		int nregions = 0;
+		for (int r = 1; r < regionId; ++r)
+		{
+			if (remap[r])
+				remap[r] = (unsigned short)++nregions;
+		}
+
+		for (int y = core.miny; y < core.maxy; ++y)
+		{
+			for (int x = core.minx; x < core.maxx; ++x)
+			{
+				const rcCompactCell& c = chf.cells[x+y*w];
+				const int si = (int)sub.cells[(x-rect.minx)+(y-rect.miny)*sw].index;
+				for (int i = 0; i < (int)c.count; ++i)
+				{
+					const unsigned short r = srcReg[si+i];
+					if (r & RC_BORDER_REG)
+						continue;
+					m_parts.srcReg[c.index+i] = r ? remap[r] : 0;
+					m_parts.srcDist[c.index+i] = srcDist[si+i];
+				}
+			}
+		}
+
+		return nregions;
+	}
+
+	WatershedPartitions& m_parts;
+	const int m_expandIters;
+};
+
+// Replaces the partition local region ids with the final, stitched region ids.
+class RemapPartitionTasks : public rcTaskSet
+{
+public:
+	RemapPartitionTasks(WatershedPartitions& parts, const unsigned short* regionMap) : m_parts(parts), m_regionMap(regionMap) {}
+
+	virtual void runTask(const int taskIndex)
+	{
+		const rcCompactHeightfield& chf = m_parts.chf;
+		unsigned short* srcReg = m_parts.srcReg;
+		const CellRect rect = m_parts.getRect(taskIndex);
+		const int firstRegion = m_parts.firstRegions[taskIndex];
+		const int w = chf.width;
+
+		for (int y = rect.miny; y < rect.maxy; ++y)
+		{
+			for (int x = rect.minx; x < rect.maxx; ++x)
+			{
+				const rcCompactCell& c = chf.cells[x+y*w];
+				for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+				{
+					if (srcReg[i] != 0 && (srcReg[i] & RC_BORDER_REG) == 0)
+						srcReg[i] = m_regionMap[firstRegion + srcReg[i] - 1];
+				}
+			}
+		}
+	}
+
+private:
+	WatershedPartitions& m_parts;
+	const unsigned short* m_regionMap;
+};
+
+// A pair of regions that touch across a partition seam, seen from one side.
+struct SeamContact
+{
+	int reg;	// Global region id.
+	int dir;	// The direction of the seam as seen from 'reg'.
+	int nei;	// Global region id on the other side of the seam.
+};
+}  // namespace
+
+static int compareSeamContacts(const void* va, const void* vb)
+{
+	const SeamContact* a = (const SeamContact*)va;
+	const SeamContact* b = (const SeamContact*)vb;
+	if (a->reg != b->reg) return a->reg < b->reg ? -1 : 1;
+	if (a->dir != b->dir) return a->dir < b->dir ? -1 : 1;
+	if (a->nei != b->nei) return a->nei < b->nei ? -1 : 1;
+	return 0;
+}
+
+static int findRegionRoot(rcTempVector<int>& parents, int r)
+{
+	while (parents[r] != r)
+	{
+		parents[r] = parents[parents[r]];
+		r = parents[r];
+	}
+	return r;
+}
+
+// Converts a partition local region id to a global one.
+static int getGlobalRegion(const WatershedPartitions& parts, int partition, unsigned short localReg)
+{
+	return parts.firstRegions[partition] + localReg - 1;
+}
+
+static void addSeamContact(const WatershedPartitions& parts, int x, int y, int i, int dir,
+						   rcTempVector<SeamContact>& contacts)
+{
+	const rcCompactHeightfield& chf = parts.chf;
+	const rcCompactSpan& s = chf.spans[i];
+	const unsigned short r = parts.srcReg[i];
+	if (r == 0 || (r & RC_BORDER_REG) || rcGetCon(s, dir) == RC_NOT_CONNECTED)
+		return;
+	const int ax = x + rcGetDirOffsetX(dir);
+	const int ay = y + rcGetDirOffsetY(dir);
+	const int ai = (int)chf.cells[ax+ay*chf.width].index + rcGetCon(s, dir);
+	const unsigned short nr = parts.srcReg[ai];
+	if (nr == 0 || (nr & RC_BORDER_REG) || chf.areas[ai] != chf.areas[i])
+		return;
+
+	SeamContact contact;
+	contact.reg = getGlobalRegion(parts, parts.getPartition(x, y), r);
+	contact.dir = dir;
+	contact.nei = getGlobalRegion(parts, parts.getPartition(ax, ay), nr);
+	contacts.push_back(contact);
+	rcSwap(contact.reg, contact.nei);
+	contact.dir = (dir+2) & 0x3;
+	contacts.push_back(contact);
+}
+
+// Joins the regions that were cut apart by the partition seams and builds the map from
+// global partition region ids to the final region ids.
+// Two regions are joined when each is the other's longest neighbour across the seam
+// between them, unless the joined region would overlap itself.
+static bool stitchPartitionRegions(rcContext* ctx, const WatershedPartitions& parts, int nreg,
+								   unsigned short firstRegionId, rcTempVector<unsigned short>& regionMap,
+								   unsigned short& maxRegionId)
+{
+	const rcCompactHeightfield& chf = parts.chf;
+	const unsigned short* srcReg = parts.srcReg;
+	const int w = chf.width;
+	const int h = chf.height;
+
+	// Collect the span connections across partition seams.
+	rcTempVector<SeamContact> contacts;
+	for (int px = 1; px < parts.countX; ++px)
+	{
+		const int x = px*parts.size - 1;
+		for (int y = 0; y < h; ++y)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+				addSeamContact(parts, x, y, i, 2, contacts);
+		}
+	}
+	for (int py = 1; py < parts.countY; ++py)
+	{
+		const int y = py*parts.size - 1;
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+				addSeamContact(parts, x, y, i, 1, contacts);
+		}
+	}
+	if (contacts.size() > 0)
+		qsort(contacts.data(), contacts.size(), sizeof(SeamContact), compareSeamContacts);
+
+	// Find the neighbour with the longest shared seam in each direction of each region.
+	rcTempVector<int> bestNei(nreg*4, -1);
+	for (int j = 0; j < contacts.size(); )
+	{
+		const int reg = contacts[j].reg;
+		const int dir = contacts[j].dir;
+		int bestCount = 0;
+		while (j < contacts.size() && contacts[j].reg == reg && contacts[j].dir == dir)
+		{
+			const int nei = contacts[j].nei;
+			int count = 0;
+			for (; j < contacts.size() && contacts[j].reg == reg && contacts[j].dir == dir && contacts[j].nei == nei; ++j)
+				count++;
+			if (count > bestCount)
+			{
+				bestCount = count;
+				bestNei[reg*4 + dir] = nei;
+			}
+		}
+	}
+
+	// Join mutually best neighbours. The root of a set is its lowest id.
+	rcTempVector<int> parents(nreg);
+	for (int i = 0; i < nreg; ++i)
+		parents[i] = i;
+	for (int i = 0; i < nreg; ++i)
+	{
+		for (int dir = 1; dir <= 2; ++dir)
+		{
+			const int nei = bestNei[i*4 + dir];
+			if (nei < 0 || bestNei[nei*4 + ((dir+2) & 0x3)] != i)
+				continue;
+			const int ra = findRegionRoot(parents, i);
+			const int rb = findRegionRoot(parents, nei);
+			if (ra != rb)
+				parents[rcMax(ra, rb)] = rcMin(ra, rb);
+		}
+	}
+
+	// Undo the joins that made a region overlap itself.
+	rcTempVector<unsigned char> overlapping(nreg, 0);
+	for (int y = 0; y < h; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			if (c.count < 2)
+				continue;
+			const int partition = parts.getPartition(x, y);
+			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			{
+				if (srcReg[i] == 0 || (srcReg[i] & RC_BORDER_REG))
+					continue;
+				const int ri = getGlobalRegion(parts, partition, srcReg[i]);
+				for (int j = i+1; j < ni; ++j)
+				{
+					if (srcReg[j] == 0 || (srcReg[j] & RC_BORDER_REG) || srcReg[j] == srcReg[i])
+						continue;
+					const int rj = getGlobalRegion(parts, partition, srcReg[j]);
+					const int root = findRegionRoot(parents, ri);
+					if (root == findRegionRoot(parents, rj))
+						overlapping[root] = 1;
+				}
+			}
+		}
+	}
+
+	// Assign the final ids in global id order.
+	if (!regionMap.reserve(nreg))
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildRegionsParallel: Out of memory 'regionMap' (%d).", nreg);
+		return false;
+	}
+	regionMap.resize(nreg);
+	int regionId = firstRegionId;
+	for (int i = 0; i < nreg; ++i)
+	{
+		int root = findRegionRoot(parents, i);
+		if (overlapping[root])
+			root = i;
+		if (root == i)
+		{
+			if (regionId >= 0xFFFF)
+			{
+				ctx->log(RC_LOG_ERROR, "rcBuildRegionsParallel: Region ID overflow");
+				return false;
+			}
+			regionMap[i] = (unsigned short)regionId++;
+		}
+		else
+		{
+			regionMap[i] = regionMap[root];
+		}
+	}
+	maxRegionId = (unsigned short)regionId;
+
+	return true;
+}
+
+/// @par
+/// 
+/// Produces the same kind of partitioning as #rcBuildRegions, but splits the heightfield into square
+/// partitions of @p partitionSize cells and floods them as independent tasks through
+/// rcContext::runTasks. Each partition is flooded together with a margin of its neighbours, and two 
+/// regions that were cut apart by a partition seam are joined again when each is the other's 
+/// longest neighbour across that seam. Small regions are then merged and filtered over the whole 
+/// heightfield like in #rcBuildRegions.
+/// 
+/// The result depends on @p partitionSize but not on how the context schedules the tasks. 
+/// A @p partitionSize that covers the whole heightfield gives the same result as #rcBuildRegions.
+/// 
+/// See the #rcConfig documentation for more information on the configuration parameters.
+/// 
+/// @warning The distance field must be created using #rcBuildDistanceField before attempting to build regions.
+/// 
+/// @see rcCompactHeightfield, rcCompactSpan, rcBuildDistanceField, rcBuildRegions, rcContext::runTasks, rcConfig
+bool rcBuildRegionsParallel(rcContext* ctx, rcCompactHeightfield& chf,
+							const int borderSize, const int minRegionArea, const int mergeRegionArea,
+							const int partitionSize)
+{
+	rcAssert(ctx);
+	rcAssert(partitionSize > 0);
+	
+	rcScopedTimer timer(ctx, RC_TIMER_BUILD_REGIONS);
+	
+	const int w = chf.width;
+	const int h = chf.height;
+	
+	rcScopedDelete<unsigned short> buf((unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount*2, RC_ALLOC_TEMP));
+	if (!buf)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildRegionsParallel: Out of memory 'tmp' (%d).", chf.spanCount*4);
+		return false;
+	}
+	
+	ctx->startTimer(RC_TIMER_BUILD_REGIONS_WATERSHED);
+
+	unsigned short* srcReg = buf;
+	unsigned short* srcDist = buf+chf.spanCount;
+	
+	memset(srcReg, 0, sizeof(unsigned short)*chf.spanCount);
+	memset(srcDist, 0, sizeof(unsigned short)*chf.spanCount);
+	
+	unsigned short regionId = 1;
+	const int expandIters = 8;
+
+	if (borderSize > 0)
+	{
+		// Make sure border will not overflow.
+		const int bw = rcMin(w, borderSize);
+		const int bh = rcMin(h, borderSize);
+		
+		// Paint regions
+		paintRectRegion(0, bw, 0, h, regionId|RC_BORDER_REG, chf, srcReg); regionId++;
+		paintRectRegion(w-bw, w, 0, h, regionId|RC_BORDER_REG, chf, srcReg); regionId++;
+		paintRectRegion(0, w, 0, bh, regionId|RC_BORDER_REG, chf, srcReg); regionId++;
+		paintRectRegion(0, w, h-bh, h, regionId|RC_BORDER_REG, chf, srcReg); regionId++;
+	}
+
+	chf.borderSize = borderSize;
+
+	WatershedPartitions parts(chf, srcReg, srcDist, borderSize, partitionSize);
+	const int npartitions = parts.countX * parts.countY;
+	if (!parts.regionCounts.reserve(npartitions) || !parts.firstRegions.reserve(npartitions))
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildRegionsParallel: Out of memory 'partitions' (%d).", npartitions);
+		return false;
+	}
+	parts.regionCounts.resize(npartitions, 0);
+	parts.firstRegions.resize(npartitions, 0);
+
+	{
+		rcScopedTimer timerFlood(ctx, RC_TIMER_BUILD_REGIONS_FLOOD);
+
+		FloodPartitionTasks floodTasks(parts, expandIters);
+		ctx->runTasks(floodTasks, npartitions);
+	}
+
+	// Give the regions of each partition a range of global ids.
+	int nreg = 0;
+	for (int i = 0; i < npartitions; ++i)
+	{
+		if (parts.regionCounts[i] == PARTITION_OUT_OF_MEMORY)
+		{
+			ctx->log(RC_LOG_ERROR, "rcBuildRegionsParallel: Out of memory flooding partition %d.", i);
+			return false;
+		}
+		if (parts.regionCounts[i] == PARTITION_REGION_OVERFLOW)
+		{
+			ctx->log(RC_LOG_ERROR, "rcBuildRegionsParallel: Region ID overflow");
+			return false;
+		}
+		parts.firstRegions[i] = nreg;
+		nreg += parts.regionCounts[i];
+	}
+
+	{
+		rcScopedTimer timerStitch(ctx, RC_TIMER_BUILD_REGIONS_STITCH);
+
+		rcTempVector<unsigned short> regionMap;
+		if (!stitchPartitionRegions(ctx, parts, nreg, regionId, regionMap, regionId))
+			return false;
+
+		if (nreg > 0)
+		{
+			RemapPartitionTasks remapTasks(parts, regionMap.data());
+			ctx->runTasks(remapTasks, npartitions);
+		}
+	}
+
+	{
+		rcScopedTimer timerExpand(ctx, RC_TIMER_BUILD_REGIONS_EXPAND);
+
+		// Let the joined regions grow into cells that were only reachable across the seams.
+		rcTempVector<LevelStackEntry> stack;
+		expandRegions(expandIters*8, 0, chf, srcReg, srcDist, stack, true);
+	}
+	
+	ctx->stopTimer(RC_TIMER_BUILD_REGIONS_WATERSHED);
+	
+	{
+		rcScopedTimer timerFilter(ctx, RC_TIMER_BUILD_REGIONS_FILTER);
+
+		// Merge regions and filter out small regions.
+		rcTempVector<int> overlaps;
+		chf.maxRegions = regionId;
+		if (!mergeAndFilterRegions(ctx, minRegionArea, mergeRegionArea, chf.maxRegions, chf, srcReg, overlaps))
+			return false;
+
+		// If overlapping regions were found during merging, split those regions.
+		if (overlaps.size() > 0)
+		{
+			ctx->log(RC_LOG_ERROR, "rcBuildRegionsParallel: %d overlapping regions.", overlaps.size());
+		}
+	}
+		
+	// Write the result out.
+	for (int i = 0; i < chf.spanCount; ++i)
+		chf.spans[i].reg = srcReg[i];
+	
+	return true;
+}
+
 bool rcBuildLayerRegions(rcContext* ctx, rcCompactHeightfield& chf,
 						 const int borderSize, const int minRegionArea)
 {
@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef RECASTTASKLOG_H
+#define RECASTTASKLOG_H
+
+#include <string.h>
+#include "Recast.h"
+#include "RecastAlloc.h"
+
+/// A context that keeps the messages logged by a task, so that they can be logged to the build
+/// context once the tasks have completed. (Internal to the Recast library.)
+class rcTaskLogContext : public rcContext
+{
+public:
+	explicit rcTaskLogContext(rcTempVector<char>& messages) : rcContext(true), m_messages(messages) {}
+
+	/// Logs the kept @p messages to @p ctx.
+	static void replay(rcContext* ctx, const rcTempVector<char>& messages)
+	{
+		for (int i = 0; i < static_cast<int>(messages.size()); )
+		{
+			const rcLogCategory category = (rcLogCategory)messages[i];
+			const char* msg = &messages[i+1];
+			ctx->log(category, "%s", msg);
+			i += 2 + (int)strlen(msg);
+		}
+	}
+
+protected:
+	virtual void doLog(const rcLogCategory category, const char* msg, const int len)
+	{
+		m_messages.push_back((char)category);
+		for (int i = 0; i < len; ++i)
+			m_messages.push_back(msg[i]);
+		m_messages.push_back('\0');
+	}
+
+private:
+	rcTempVector<char>& m_messages;
+
+	// Explicitly-disabled copy assignment operator.
+	rcTaskLogContext& operator=(const rcTaskLogContext&);
+};
+
+#endif // RECASTTASKLOG_H
@@ -19,6 +19,8 @@
 #ifndef CHUNKYTRIMESH_H
 #define CHUNKYTRIMESH_H
 
+class rcContext;
+
 struct rcChunkyTriMeshNode
 {
 	float bmin[2];
@@ -29,14 +31,16 @@ struct rcChunkyTriMeshNode
 
 struct rcChunkyTriMesh
 {
-	inline rcChunkyTriMesh() : nodes(0), nnodes(0), tris(0), ntris(0), maxTrisPerChunk(0) {}
-	inline ~rcChunkyTriMesh() { delete [] nodes; delete [] tris; }
+	inline rcChunkyTriMesh() : nodes(0), nnodes(0), tris(0), ntris(0), maxTrisPerChunk(0), ownsData(true) {}
+	inline ~rcChunkyTriMesh() { if (ownsData) { delete [] nodes; delete [] tris; } }
 
 	rcChunkyTriMeshNode* nodes;
 	int nnodes;
 	int* tris;
 	int ntris;
 	int maxTrisPerChunk;
+	/// False if the nodes and triangles are owned by someone else, like a mapped geometry cache.
+	bool ownsData;
 
 private:
 	// Explicitly disabled copy constructor and copy assignment operator.
@@ -46,12 +50,20 @@ private:
 
 /// Creates partitioned triangle mesh (AABB tree),
 /// where each node contains at max trisPerChunk triangles.
+/// The nodes are split with a binned surface area heuristic, and the subtrees are built
+/// as tasks through ctx if one is given.
 bool rcCreateChunkyTriMesh(const float* verts, const int* tris, int ntris,
-						   int trisPerChunk, rcChunkyTriMesh* cm);
+						   int trisPerChunk, rcChunkyTriMesh* cm, rcContext* ctx = 0);
 
 /// Returns the chunk indices which overlap the input rectable.
 int rcGetChunksOverlappingRect(const rcChunkyTriMesh* cm, float bmin[2], float bmax[2], int* ids, const int maxIds);
 
+/// Returns the chunk indices which overlap each of the input rectangles, in one pass over the tree.
+/// The rectangle i spans bmins[i*2..i*2+1] to bmaxs[i*2..i*2+1], its chunks are written to
+/// ids[i*maxIdsPerRect] and their number to counts[i].
+void rcGetChunksOverlappingRects(const rcChunkyTriMesh* cm, const float* bmins, const float* bmaxs, const int nrects,
+								 int* ids, int* counts, const int maxIdsPerRect);
+
 /// Returns the chunk indices which overlap the input segment.
 int rcGetChunksOverlappingSegment(const rcChunkyTriMesh* cm, float p[2], float q[2], int* ids, const int maxIds);
 
@@ -69,10 +69,18 @@ struct BuildSettings
 	float tileSize;
 };
 
+/// Input geometry of the samples, loaded from an OBJ mesh or a geometry set.
+///
+/// Each loaded file gets a binary geometry cache next to it, the file name with ".gcache"
+/// appended. It holds the mesh, its chunky tree, and the off-mesh connections, convex volumes
+/// and build settings of a geometry set, keyed by the hashes of the contents of the file and
+/// of the mesh it refers to. Loading a file whose cache is current maps the cache and uses the
+/// mesh and the chunky tree straight from it, without parsing or partitioning the mesh.
 class InputGeom
 {
 	rcChunkyTriMesh* m_chunkyMesh;
 	rcMeshLoaderObj* m_mesh;
+	class MappedFile* m_cacheFile;
 	float m_meshBMin[3], m_meshBMax[3];
 	BuildSettings m_buildSettings;
 	bool m_hasBuildSettings;
@@ -98,6 +106,9 @@ class InputGeom
 	
 	bool loadMesh(class rcContext* ctx, const std::string& filepath);
 	bool loadGeomSet(class rcContext* ctx, const std::string& filepath);
+	bool loadCache(class rcContext* ctx, const std::string& filepath);
+	void saveCache(class rcContext* ctx, const std::string& filepath);
+	void clearMesh();
 public:
 	InputGeom();
 	~InputGeom();
@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+
+/// Read only view of a whole file. The file is memory mapped when possible, and read into
+/// a buffer otherwise. Empty files cannot be opened.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* path);
+	void close();
+
+	const char* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+
+private:
+	bool map(const char* path);
+	bool read(const char* path);
+
+	const char* m_data;
+	size_t m_size;
+	bool m_mapped;
+	// Handles of the file and its mapping on Windows.
+	void* m_file;
+	void* m_mapping;
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
+
+#endif // MAPPEDFILE_H
@@ -21,13 +21,20 @@
 
 #include <string>
 
+class rcContext;
+
 class rcMeshLoaderObj
 {
 public:
 	rcMeshLoaderObj();
 	~rcMeshLoaderObj();
 	
-	bool load(const std::string& fileName);
+	/// Loads the OBJ file @p fileName. The file is mapped into memory and parsed in chunks, run as
+	/// tasks through @p ctx if one is given.
+	bool load(const std::string& fileName, rcContext* ctx = 0);
+	/// Uses mesh data owned by the caller, like a mapped geometry cache, which must outlive the loader.
+	void setMeshData(const std::string& fileName, const float* verts, const int vertCount,
+					 const int* tris, const float* normals, const int triCount);
 
 	const float* getVerts() const { return m_verts; }
 	const float* getNormals() const { return m_normals; }
@@ -40,17 +47,17 @@ private:
 	// Explicitly disabled copy constructor and copy assignment operator.
 	rcMeshLoaderObj(const rcMeshLoaderObj&);
 	rcMeshLoaderObj& operator=(const rcMeshLoaderObj&);
-	
-	void addVertex(float x, float y, float z, int& cap);
-	void addTriangle(int a, int b, int c, int& cap);
+
+	void clear();
 	
 	std::string m_filename;
 	float m_scale;	
-	float* m_verts;
-	int* m_tris;
-	float* m_normals;
+	const float* m_verts;
+	const int* m_tris;
+	const float* m_normals;
 	int m_vertCount;
 	int m_triCount;
+	bool m_ownsData;
 };
 
 #endif // MESHLOADER_OBJ
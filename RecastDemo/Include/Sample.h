@@ -132,8 +132,10 @@ protected:
 
 	SampleDebugDraw m_dd;
 	
-	dtNavMesh* loadAll(const char* path);
-	void saveAll(const char* path, const dtNavMesh* mesh);
+	/// Loads a navmesh set, and the landmark distances stored with it if @p landmarks is given.
+	dtNavMesh* loadAll(const char* path, class dtNavMeshLandmarks** landmarks = 0);
+	/// Saves a navmesh set, with the distances of @p landmarks if they are given.
+	void saveAll(const char* path, const dtNavMesh* mesh, const class dtNavMeshLandmarks* landmarks = 0);
 
 public:
 	Sample();
@@ -26,6 +26,8 @@
 
 // These are example implementations of various interfaces used in Recast and Detour.
 
+struct BuildTaskPool;
+
 /// Recast build context.
 class BuildContext : public rcContext
 {
@@ -38,9 +40,14 @@ class BuildContext : public rcContext
 	static const int TEXT_POOL_SIZE = 8000;
 	char m_textPool[TEXT_POOL_SIZE];
 	int m_textPoolSize;
+	static const int MAX_THREADS = 16;
+	int m_threadCount;
+	/// Worker threads of doRunTasks, started on the first call.
+	BuildTaskPool* m_taskPool;
 	
 public:
 	BuildContext();
+	virtual ~BuildContext();
 	
 	/// Dumps the log to stdout.
 	void dumpLog(const char* format, ...);
@@ -58,7 +65,13 @@ protected:
 	virtual void doStartTimer(const rcTimerLabel label);
 	virtual void doStopTimer(const rcTimerLabel label);
 	virtual int doGetAccumulatedTime(const rcTimerLabel label) const;
+	virtual void doRunTasks(rcTaskSet& tasks, const int taskCount);
 	///@}
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	BuildContext(const BuildContext&);
+	BuildContext& operator=(const BuildContext&);
 };
 
 /// OpenGL debug draw implementation.
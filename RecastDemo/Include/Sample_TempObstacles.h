@@ -91,7 +91,7 @@ private:
 	Sample_TempObstacles(const Sample_TempObstacles&);
 	Sample_TempObstacles& operator=(const Sample_TempObstacles&);
 
-	int rasterizeTileLayers(const int tx, const int ty, const rcConfig& cfg, struct TileCacheData* tiles, const int maxTiles);
+	int rasterizeTileLayerRow(const int ty, const int tw, const rcConfig& cfg, struct TileCacheData* tiles, const int maxTiles);
 };
 
 
@@ -22,6 +22,7 @@
 #include "Sample.h"
 #include "DetourNavMesh.h"
 #include "Recast.h"
+#include "RecastAlloc.h"
 #include "ChunkyTriMesh.h"
 
 class Sample_TileMesh : public Sample
@@ -74,10 +75,15 @@ protected:
 	float m_tileBuildTime;
 	float m_tileMemUsage;
 	int m_tileTriCount;
+	rcTempArena m_tempArena;
+
+	/// Distances from a few landmarks, which speed up the path queries. Updated with the tiles.
+	class dtNavMeshLandmarks* m_landmarks;
 
 	unsigned char* buildTileMesh(const int tx, const int ty, const float* bmin, const float* bmax, int& dataSize);
 	
 	void cleanup();
+	void freeLandmarks();
 	
 	void saveAll(const char* path, const dtNavMesh* mesh);
 	dtNavMesh* loadAll(const char* path);
@@ -101,6 +107,8 @@ public:
 	void removeTile(const float* pos);
 	void buildAllTiles();
 	void removeAllTiles();
+	/// Builds all the tiles from the mesh file with a StreamingNavMeshBuilder, and writes them to @p path.
+	bool streamBuildAllTiles(const char* path);
 
 private:
 	// Explicitly disabled copy constructor and copy assignment operator.
@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef STREAMINGNAVMESHBUILDER_H
+#define STREAMINGNAVMESHBUILDER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "Recast.h"
+
+struct BuildSettings;
+struct rcChunkyTriMesh;
+
+/// Stages of a streaming build, in the order they run.
+enum StreamingBuildStage
+{
+	STREAMING_STAGE_READ_MESH,			///< Reading the input mesh. Progress is in bytes.
+	STREAMING_STAGE_INDEX_TRIANGLES,	///< Sorting the triangles into cells of tiles. Progress is in triangles.
+	STREAMING_STAGE_BUILD_TILES			///< Building and writing out the tiles. Progress is in tiles.
+};
+
+/// Receives the progress of a streaming build.
+struct StreamingBuildProgress
+{
+	virtual ~StreamingBuildProgress();
+	/// Called as the build advances, @p done of @p total units of @p stage are complete.
+	virtual void report(StreamingBuildStage stage, int64_t done, int64_t total) = 0;
+};
+
+/// Builds a tiled navmesh from an OBJ file which does not need to fit in memory.
+///
+/// The mesh is streamed from disk into scratch files, the triangles are then sorted into
+/// an on-disk index of square cells of tiles, each triangle going to every cell whose
+/// tiles, with their border padding, it overlaps. The cells are built one at a time and
+/// their tiles written straight to a navmesh set file, the same as Sample::saveAll writes.
+///
+/// The memory limit bounds the geometry the builder holds at a time: the read and index
+/// buffers and the triangles of the cell being built. The Recast intermediates of a tile
+/// come on top, and depend on the tile size rather than the size of the input.
+/// Convex volumes and off-mesh connections are not part of the input, only the OBJ geometry.
+class StreamingNavMeshBuilder
+{
+public:
+	StreamingNavMeshBuilder();
+	~StreamingNavMeshBuilder();
+
+	/// Sets the memory limit of the geometry held by the build, in bytes.
+	void setMemoryLimit(const size_t limit) { m_memoryLimit = limit; }
+	/// Sets the progress receiver, or null for none.
+	void setProgress(StreamingBuildProgress* progress) { m_progress = progress; }
+	/// Enables the heightfield filters, see rcFilterLowHangingWalkableObstacles, rcFilterLedgeSpans
+	/// and rcFilterWalkableLowHeightSpans.
+	void setFilters(const bool lowHangingObstacles, const bool ledgeSpans, const bool walkableLowHeightSpans);
+
+	/// Builds the navmesh of the OBJ file @p objPath with @p settings and writes it to @p outPath.
+	/// The navmesh bounds are the bounds of the mesh, the bounds in @p settings are not used.
+	bool build(rcContext* ctx, const char* objPath, const BuildSettings& settings, const char* outPath);
+
+	/// Returns the number of tiles written by the last build.
+	int getTileCount() const { return m_tileCount; }
+	/// Returns the number of triangles read by the last build.
+	int64_t getTriCount() const { return m_triCount; }
+	/// Returns the peak memory of the geometry held by the last build, in bytes.
+	size_t getPeakMemory() const { return m_memoryPeak; }
+
+private:
+	bool readMesh(const char* objPath);
+	int getVertexCachePageCount() const;
+	bool countTileTriangles(int* tileTriCounts);
+	bool chooseCellSize(const int* tileTriCounts);
+	bool indexTriangles();
+	bool flushIndex(struct IndexRecord* records, const int nrecords);
+	bool buildCells(FILE* out);
+	int loadCell(const int cell, float*& verts);
+	unsigned char* buildTile(const int tx, const int ty, const float* verts, const rcChunkyTriMesh& chunkyMesh,
+							 int* chunkIds, int& dataSize);
+
+	void getTileRange(const float* v0, const float* v1, const float* v2, int* range) const;
+	void report(const StreamingBuildStage stage, const int64_t done, const int64_t total);
+	void trackAlloc(const size_t size);
+	void trackFree(const size_t size);
+	void cleanup();
+
+	rcContext* m_ctx;
+	StreamingBuildProgress* m_progress;
+	size_t m_memoryLimit;
+	size_t m_memoryUsed;
+	size_t m_memoryPeak;
+	bool m_filterLowHangingObstacles;
+	bool m_filterLedgeSpans;
+	bool m_filterWalkableLowHeightSpans;
+
+	rcConfig m_cfg;
+	float m_agentHeight;
+	float m_agentRadius;
+	float m_agentMaxClimb;
+	int m_partitionType;
+
+	// Scratch files of the vertices, the triangles and the triangles of the cells.
+	FILE* m_vertFile;
+	FILE* m_triFile;
+	FILE* m_cellFile;
+
+	int m_vertCount;
+	int64_t m_triCount;
+	float m_bmin[3];
+	float m_bmax[3];
+
+	// Tile grid, cells are squares of m_cellTiles tiles.
+	int m_tileWidth;
+	int m_tileHeight;
+	int m_cellTiles;
+	int m_cellWidth;
+	int m_cellHeight;
+	// Offset of the last block of each cell in the cell file, and the number of triangles in the cell.
+	int64_t* m_cellHeads;
+	int* m_cellTriCounts;
+
+	int m_tileCount;
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	StreamingNavMeshBuilder(const StreamingNavMeshBuilder&);
+	StreamingNavMeshBuilder& operator=(const StreamingNavMeshBuilder&);
+};
+
+#endif // STREAMINGNAVMESHBUILDER_H
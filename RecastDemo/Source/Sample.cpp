@@ -24,6 +24,7 @@
 #include "RecastDebugDraw.h"
 #include "DetourDebugDraw.h"
 #include "DetourNavMesh.h"
+#include "DetourNavMeshLandmarks.h"
 #include "DetourNavMeshQuery.h"
 #include "DetourCrowd.h"
 #include "imgui.h"
@@ -348,8 +349,97 @@ struct NavMeshTileHeader
 	int dataSize;
 };
 
-dtNavMesh* Sample::loadAll(const char* path)
+// The landmark distances optionally follow the tiles, with a NavMeshTileHeader per tile.
+static const int LANDMARKSSET_MAGIC = 'L'<<24 | 'M'<<16 | 'R'<<8 | 'K'; //'LMRK';
+static const int LANDMARKSSET_VERSION = 1;
+
+struct LandmarksSetHeader
+{
+	int magic;
+	int version;
+	int numTiles;
+	dtNavMeshLandmarksParams params;
+};
+
+static dtNavMeshLandmarks* loadLandmarks(FILE* fp, const dtNavMesh* mesh)
 {
+	LandmarksSetHeader header;
+	if (fread(&header, sizeof(LandmarksSetHeader), 1, fp) != 1)
+		return 0;
+	if (header.magic != LANDMARKSSET_MAGIC || header.version != LANDMARKSSET_VERSION)
+		return 0;
+
+	dtNavMeshLandmarks* landmarks = dtAllocNavMeshLandmarks();
+	if (!landmarks || dtStatusFailed(landmarks->init(mesh, &header.params)))
+	{
+		dtFreeNavMeshLandmarks(landmarks);
+		return 0;
+	}
+
+	for (int i = 0; i < header.numTiles; ++i)
+	{
+		NavMeshTileHeader tileHeader;
+		if (fread(&tileHeader, sizeof(tileHeader), 1, fp) != 1 || tileHeader.dataSize <= 0)
+			break;
+
+		unsigned char* data = (unsigned char*)dtAlloc(tileHeader.dataSize, DT_ALLOC_TEMP);
+		if (!data) break;
+		if (fread(data, tileHeader.dataSize, 1, fp) != 1)
+		{
+			dtFree(data);
+			break;
+		}
+		const dtMeshTile* tile = mesh->getTileByRef(tileHeader.tileRef);
+		if (tile)
+			landmarks->restoreTileLandmarks(tile, data, tileHeader.dataSize);
+		dtFree(data);
+	}
+
+	return landmarks;
+}
+
+static void saveLandmarks(FILE* fp, const dtNavMesh* mesh, const dtNavMeshLandmarks* landmarks)
+{
+	LandmarksSetHeader header;
+	header.magic = LANDMARKSSET_MAGIC;
+	header.version = LANDMARKSSET_VERSION;
+	header.numTiles = 0;
+	for (int i = 0; i < mesh->getMaxTiles(); ++i)
+	{
+		const dtMeshTile* tile = mesh->getTile(i);
+		if (!tile || !tile->header || !tile->dataSize) continue;
+		header.numTiles++;
+	}
+	memcpy(&header.params, landmarks->getParams(), sizeof(dtNavMeshLandmarksParams));
+	fwrite(&header, sizeof(LandmarksSetHeader), 1, fp);
+
+	for (int i = 0; i < mesh->getMaxTiles(); ++i)
+	{
+		const dtMeshTile* tile = mesh->getTile(i);
+		if (!tile || !tile->header || !tile->dataSize) continue;
+
+		NavMeshTileHeader tileHeader;
+		tileHeader.tileRef = mesh->getTileRef(tile);
+		tileHeader.dataSize = landmarks->getTileLandmarksSize(tile);
+		unsigned char* data = (unsigned char*)dtAlloc(tileHeader.dataSize, DT_ALLOC_TEMP);
+		if (!data || dtStatusFailed(landmarks->storeTileLandmarks(tile, data, tileHeader.dataSize)))
+		{
+			// Keep the record, restoreTileLandmarks rejects it.
+			dtFree(data);
+			data = 0;
+			tileHeader.dataSize = 0;
+		}
+		fwrite(&tileHeader, sizeof(tileHeader), 1, fp);
+		if (data)
+			fwrite(data, tileHeader.dataSize, 1, fp);
+		dtFree(data);
+	}
+}
+
+dtNavMesh* Sample::loadAll(const char* path, dtNavMeshLandmarks** landmarks)
+{
+	if (landmarks) *landmarks = 0;
+
 	FILE* fp = fopen(path, "rb");
 	if (!fp) return 0;
 
@@ -413,12 +503,16 @@ dtNavMesh* Sample::loadAll(const char* path)
 		mesh->addTile(data, tileHeader.dataSize, DT_TILE_FREE_DATA, tileHeader.tileRef, 0);
 	}
 
+	// The landmark distances are restored once all the tiles are in.
+	if (landmarks)
+		*landmarks = loadLandmarks(fp, mesh);
+
 	fclose(fp);
 
 	return mesh;
 }
 
-void Sample::saveAll(const char* path, const dtNavMesh* mesh)
+void Sample::saveAll(const char* path, const dtNavMesh* mesh, const dtNavMeshLandmarks* landmarks)
 {
 	if (!mesh) return;
 
@@ -454,5 +548,8 @@ void Sample::saveAll(const char* path, const dtNavMesh* mesh)
 		fwrite(tile->data, tile->dataSize, 1, fp);
 	}
 
+	if (landmarks && landmarks->getNavMesh() == mesh)
+		saveLandmarks(fp, mesh, landmarks);
+
 	fclose(fp);
 }
@@ -17,13 +17,22 @@
 
 BuildContext::BuildContext() :
 	m_messageCount(0),
-	m_textPoolSize(0)
+	m_textPoolSize(0),
+	m_threadCount(rcClamp(SDL_GetCPUCount(), 1, MAX_THREADS)),
+	m_taskPool(0)
 {
 	memset(m_messages, 0, sizeof(char*) * MAX_MESSAGES);
 
 	resetTimers();
 }
 
+static void freeTaskPool(BuildTaskPool* pool);
+
+BuildContext::~BuildContext()
+{
+	freeTaskPool(m_taskPool);
+}
+
 // Virtual functions for custom implementations.
 void BuildContext::doResetLog()
 {
@@ -79,6 +88,145 @@ int BuildContext::doGetAccumulatedTime(const rcTimerLabel label) const
 	return getPerfTimeUsec(m_accTime[label]);
 }
 
+/// Worker threads of BuildContext::doRunTasks. The threads sleep between the calls, and each
+/// call wakes all of them up; each thread then takes the next task until all of them have been
+/// taken, and reports back before waiting for the next call.
+struct BuildTaskPool
+{
+	SDL_mutex* lock;
+	SDL_cond* start;
+	SDL_cond* done;
+	SDL_Thread** threads;
+	int threadCount;
+	
+	rcTaskSet* tasks;
+	int taskCount;
+	SDL_atomic_t next;
+	int generation;		// Incremented by each call, so that the threads can tell a new call from a spurious wakeup.
+	int busyCount;		// Number of threads which have not reported back for the current call.
+	bool quit;
+};
+
+static void runPoolTasks(BuildTaskPool* pool)
+{
+	for (int i = SDL_AtomicAdd(&pool->next, 1); i < pool->taskCount; i = SDL_AtomicAdd(&pool->next, 1))
+		pool->tasks->runTask(i);
+}
+
+static int taskPoolThread(void* data)
+{
+	BuildTaskPool* pool = (BuildTaskPool*)data;
+	// The pool is created at generation 0, right before the first call, which a thread starting
+	// late must not miss.
+	int generation = 0;
+	SDL_LockMutex(pool->lock);
+	for (;;)
+	{
+		while (!pool->quit && pool->generation == generation)
+			SDL_CondWait(pool->start, pool->lock);
+		if (pool->quit)
+			break;
+		generation = pool->generation;
+		SDL_UnlockMutex(pool->lock);
+		
+		runPoolTasks(pool);
+		
+		SDL_LockMutex(pool->lock);
+		if (--pool->busyCount == 0)
+			SDL_CondSignal(pool->done);
+	}
+	SDL_UnlockMutex(pool->lock);
+	return 0;
+}
+
+static void freeTaskPool(BuildTaskPool* pool)
+{
+	if (!pool)
+		return;
+	if (pool->lock)
+	{
+		SDL_LockMutex(pool->lock);
+		pool->quit = true;
+		if (pool->start)
+			SDL_CondBroadcast(pool->start);
+		SDL_UnlockMutex(pool->lock);
+	}
+	for (int i = 0; i < pool->threadCount; ++i)
+		SDL_WaitThread(pool->threads[i], 0);
+	if (pool->done)
+		SDL_DestroyCond(pool->done);
+	if (pool->start)
+		SDL_DestroyCond(pool->start);
+	if (pool->lock)
+		SDL_DestroyMutex(pool->lock);
+	delete [] pool->threads;
+	delete pool;
+}
+
+// Starts threadCount threads, or returns null if the threads cannot be created.
+static BuildTaskPool* createTaskPool(const int threadCount)
+{
+	BuildTaskPool* pool = new BuildTaskPool;
+	memset(pool, 0, sizeof(BuildTaskPool));
+	pool->lock = SDL_CreateMutex();
+	pool->start = SDL_CreateCond();
+	pool->done = SDL_CreateCond();
+	pool->threads = new SDL_Thread*[threadCount];
+	if (!pool->lock || !pool->start || !pool->done)
+	{
+		freeTaskPool(pool);
+		return 0;
+	}
+	for (int i = 0; i < threadCount; ++i)
+	{
+		SDL_Thread* thread = SDL_CreateThread(taskPoolThread, "BuildContext task", pool);
+		if (thread)
+			pool->threads[pool->threadCount++] = thread;
+	}
+	if (!pool->threadCount)
+	{
+		freeTaskPool(pool);
+		return 0;
+	}
+	return pool;
+}
+
+void BuildContext::doRunTasks(rcTaskSet& tasks, const int taskCount)
+{
+	if (rcMin(m_threadCount, taskCount) <= 1)
+	{
+		rcContext::doRunTasks(tasks, taskCount);
+		return;
+	}
+
+	// The calling thread runs tasks too, so the pool has one thread fewer.
+	if (!m_taskPool)
+		m_taskPool = createTaskPool(m_threadCount-1);
+	if (!m_taskPool)
+	{
+		rcContext::doRunTasks(tasks, taskCount);
+		return;
+	}
+
+	BuildTaskPool* pool = m_taskPool;
+	SDL_LockMutex(pool->lock);
+	pool->tasks = &tasks;
+	pool->taskCount = taskCount;
+	SDL_AtomicSet(&pool->next, 0);
+	pool->busyCount = pool->threadCount;
+	pool->generation++;
+	SDL_CondBroadcast(pool->start);
+	SDL_UnlockMutex(pool->lock);
+	
+	runPoolTasks(pool);
+	
+	// Wait for the threads still running a task.
+	SDL_LockMutex(pool->lock);
+	while (pool->busyCount > 0)
+		SDL_CondWait(pool->done, pool->lock);
+	SDL_UnlockMutex(pool->lock);
+}
+
 void BuildContext::dumpLog(const char* format, ...)
 {
 	// Print header.
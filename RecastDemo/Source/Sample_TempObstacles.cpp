@@ -257,57 +257,41 @@ struct RasterizationContext
 	RasterizationContext() :
 		solid(0),
 		triareas(0),
-		lset(0),
-		chf(0),
-		ntiles(0)
+		chf(0)
 	{
-		memset(tiles, 0, sizeof(TileCacheData)*MAX_LAYERS);
 	}
 	
 	~RasterizationContext()
 	{
 		rcFreeHeightField(solid);
 		delete [] triareas;
-		rcFreeHeightfieldLayerSet(lset);
 		rcFreeCompactHeightfield(chf);
-		for (int i = 0; i < MAX_LAYERS; ++i)
-		{
-			dtFree(tiles[i].data);
-			tiles[i].data = 0;
-		}
 	}
 	
 	rcHeightfield* solid;
 	unsigned char* triareas;
-	rcHeightfieldLayerSet* lset;
 	rcCompactHeightfield* chf;
-	TileCacheData tiles[MAX_LAYERS];
-	int ntiles;
 };
 
-int Sample_TempObstacles::rasterizeTileLayers(
-							   const int tx, const int ty,
-							   const rcConfig& cfg,
-							   TileCacheData* tiles,
-							   const int maxTiles)
+/// Input geometry and filter settings shared by the tiles being rasterized.
+struct TileRasterizationParams
+{
+	const InputGeom* geom;
+	const rcConfig* cfg;
+	bool filterLowHangingObstacles;
+	bool filterLedgeSpans;
+	bool filterWalkableLowHeightSpans;
+};
+
+// Most chunks of the input mesh a tile is rasterized from.
+static const int MAX_TILE_CHUNKS = 512;
+
+// Returns the config of the tile at (tx,ty), with its bounds grown by the border.
+static void calcTileConfig(const rcConfig& cfg, const int tx, const int ty, rcConfig& tcfg)
 {
-	if (!m_geom || !m_geom->getMesh() || !m_geom->getChunkyMesh())
-	{
-		m_ctx->log(RC_LOG_ERROR, "buildTile: Input mesh is not specified.");
-		return 0;
-	}
-	
-	FastLZCompressor comp;
-	RasterizationContext rc;
-	
-	const float* verts = m_geom->getMesh()->getVerts();
-	const int nverts = m_geom->getMesh()->getVertCount();
-	const rcChunkyTriMesh* chunkyMesh = m_geom->getChunkyMesh();
-	
 	// Tile bounds.
 	const float tcs = cfg.tileSize * cfg.cs;
 	
-	rcConfig tcfg;
 	memcpy(&tcfg, &cfg, sizeof(tcfg));
 
 	tcfg.bmin[0] = cfg.bmin[0] + tx*tcs;
@@ -320,18 +304,41 @@ int Sample_TempObstacles::rasterizeTileLayers(
 	tcfg.bmin[2] -= tcfg.borderSize*tcfg.cs;
 	tcfg.bmax[0] += tcfg.borderSize*tcfg.cs;
 	tcfg.bmax[2] += tcfg.borderSize*tcfg.cs;
+}
+
+// Rasterizes the tile at (tx,ty) from the chunks cid of the input mesh into a compact heightfield,
+// eroded and with the convex volumes marked.
+// Returns true with a null heightfield if the tile has no geometry. On failure, error is set to
+// the message to log, whose only argument is the maximum number of triangles of a chunk.
+static bool rasterizeTile(rcContext* ctx, const TileRasterizationParams& params,
+						  const int tx, const int ty, const int* cid, const int ncid,
+						  rcCompactHeightfield*& chf, const char*& error)
+{
+	chf = 0;
+	error = 0;
+	if (!ncid)
+		return true; // empty
+	
+	RasterizationContext rc;
+	
+	const float* verts = params.geom->getMesh()->getVerts();
+	const int nverts = params.geom->getMesh()->getVertCount();
+	const rcChunkyTriMesh* chunkyMesh = params.geom->getChunkyMesh();
+	
+	rcConfig tcfg;
+	calcTileConfig(*params.cfg, tx, ty, tcfg);
 	
 	// Allocate voxel heightfield where we rasterize our input data to.
 	rc.solid = rcAllocHeightfield();
 	if (!rc.solid)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
-		return 0;
+		error = "buildNavigation: Out of memory 'solid'.";
+		return false;
 	}
-	if (!rcCreateHeightfield(m_ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch))
+	if (!rcCreateHeightfield(ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
-		return 0;
+		error = "buildNavigation: Could not create solid heightfield.";
+		return false;
 	}
 	
 	// Allocate array that can hold triangle flags.
@@ -340,20 +347,8 @@ int Sample_TempObstacles::rasterizeTileLayers(
 	rc.triareas = new unsigned char[chunkyMesh->maxTrisPerChunk];
 	if (!rc.triareas)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", chunkyMesh->maxTrisPerChunk);
-		return 0;
-	}
-	
-	float tbmin[2], tbmax[2];
-	tbmin[0] = tcfg.bmin[0];
-	tbmin[1] = tcfg.bmin[2];
-	tbmax[0] = tcfg.bmax[0];
-	tbmax[1] = tcfg.bmax[2];
-	int cid[512];// TODO: Make grow when returning too many items.
-	const int ncid = rcGetChunksOverlappingRect(chunkyMesh, tbmin, tbmax, cid, 512);
-	if (!ncid)
-	{
-		return 0; // empty
+		error = "buildNavigation: Out of memory 'm_triareas' (%d).";
+		return false;
 	}
 	
 	for (int i = 0; i < ncid; ++i)
@@ -363,69 +358,119 @@ int Sample_TempObstacles::rasterizeTileLayers(
 		const int ntris = node.n;
 		
 		memset(rc.triareas, 0, ntris*sizeof(unsigned char));
-		rcMarkWalkableTriangles(m_ctx, tcfg.walkableSlopeAngle,
+		rcMarkWalkableTriangles(ctx, tcfg.walkableSlopeAngle,
 								verts, nverts, tris, ntris, rc.triareas);
 		
-		if (!rcRasterizeTriangles(m_ctx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb))
-			return 0;
+		if (!rcRasterizeTriangles(ctx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb))
+		{
+			error = "buildNavigation: Could not rasterize triangles.";
+			return false;
+		}
 	}
 	
 	// Once all geometry is rasterized, we do initial pass of filtering to
 	// remove unwanted overhangs caused by the conservative rasterization
 	// as well as filter spans where the character cannot possibly stand.
-	if (m_filterLowHangingObstacles)
-		rcFilterLowHangingWalkableObstacles(m_ctx, tcfg.walkableClimb, *rc.solid);
-	if (m_filterLedgeSpans)
-		rcFilterLedgeSpans(m_ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid);
-	if (m_filterWalkableLowHeightSpans)
-		rcFilterWalkableLowHeightSpans(m_ctx, tcfg.walkableHeight, *rc.solid);
-	
+	if (params.filterLowHangingObstacles)
+		rcFilterLowHangingWalkableObstacles(ctx, tcfg.walkableClimb, *rc.solid);
+	if (params.filterLedgeSpans)
+		rcFilterLedgeSpans(ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid);
+	if (params.filterWalkableLowHeightSpans)
+		rcFilterWalkableLowHeightSpans(ctx, tcfg.walkableHeight, *rc.solid);
 	
 	rc.chf = rcAllocCompactHeightfield();
 	if (!rc.chf)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
-		return 0;
+		error = "buildNavigation: Out of memory 'chf'.";
+		return false;
 	}
-	if (!rcBuildCompactHeightfield(m_ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf))
+	if (!rcBuildCompactHeightfield(ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
-		return 0;
+		error = "buildNavigation: Could not build compact data.";
+		return false;
 	}
 	
 	// Erode the walkable area by agent radius.
-	if (!rcErodeWalkableArea(m_ctx, tcfg.walkableRadius, *rc.chf))
+	if (!rcErodeWalkableArea(ctx, tcfg.walkableRadius, *rc.chf))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
-		return 0;
+		error = "buildNavigation: Could not erode.";
+		return false;
 	}
 	
 	// (Optional) Mark areas.
-	const ConvexVolume* vols = m_geom->getConvexVolumes();
-	for (int i  = 0; i < m_geom->getConvexVolumeCount(); ++i)
+	const ConvexVolume* vols = params.geom->getConvexVolumes();
+	for (int i  = 0; i < params.geom->getConvexVolumeCount(); ++i)
 	{
-		rcMarkConvexPolyArea(m_ctx, vols[i].verts, vols[i].nverts,
+		rcMarkConvexPolyArea(ctx, vols[i].verts, vols[i].nverts,
 							 vols[i].hmin, vols[i].hmax,
 							 (unsigned char)vols[i].area, *rc.chf);
 	}
 	
-	rc.lset = rcAllocHeightfieldLayerSet();
-	if (!rc.lset)
+	// Transfer ownership of the heightfield to the caller.
+	chf = rc.chf;
+	rc.chf = 0;
+	
+	return true;
+}
+
+/// Rasterizes the tiles of a row, one task per tile.
+class RasterizeTilesTasks : public rcTaskSet
+{
+public:
+	RasterizeTilesTasks(const TileRasterizationParams& params, const int ty,
+						const int* chunkIds, const int* chunkCounts,
+						rcCompactHeightfield** chfs, const char** errors) :
+		m_params(params),
+		m_ty(ty),
+		m_chunkIds(chunkIds),
+		m_chunkCounts(chunkCounts),
+		m_chfs(chfs),
+		m_errors(errors)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
-		return 0;
 	}
-	if (!rcBuildHeightfieldLayers(m_ctx, *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset))
+	
+	virtual void runTask(const int tx)
+	{
+		// Tasks must not call back into the build context, so each tile is built with a silent context.
+		rcContext ctx(false);
+		rasterizeTile(&ctx, m_params, tx, m_ty, &m_chunkIds[tx*MAX_TILE_CHUNKS], m_chunkCounts[tx],
+					  m_chfs[tx], m_errors[tx]);
+	}
+	
+private:
+	const TileRasterizationParams& m_params;
+	const int m_ty;
+	const int* m_chunkIds;
+	const int* m_chunkCounts;
+	rcCompactHeightfield** m_chfs;
+	const char** m_errors;
+	
+	// Explicitly-disabled copy assignment operator.
+	RasterizeTilesTasks& operator=(const RasterizeTilesTasks&);
+};
+
+/// A heightfield layer to compress into tile cache data.
+struct TileLayer
+{
+	int tx, ty, tlayer;
+	const rcHeightfieldLayer* layer;
+};
+
+/// Compresses heightfield layers into tile cache data, one task per layer.
+class CompressLayersTasks : public rcTaskSet
+{
+public:
+	CompressLayersTasks(const TileLayer* layers, TileCacheData* tiles) :
+		m_layers(layers),
+		m_tiles(tiles)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
-		return 0;
 	}
 	
-	rc.ntiles = 0;
-	for (int i = 0; i < rcMin(rc.lset->nlayers, MAX_LAYERS); ++i)
+	virtual void runTask(const int i)
 	{
-		TileCacheData* tile = &rc.tiles[rc.ntiles++];
-		const rcHeightfieldLayer* layer = &rc.lset->layers[i];
+		const TileLayer& tl = m_layers[i];
+		const rcHeightfieldLayer* layer = tl.layer;
+		TileCacheData* tile = &m_tiles[i];
 		
 		// Store header
 		dtTileCacheLayerHeader header;
@@ -433,9 +478,9 @@ int Sample_TempObstacles::rasterizeTileLayers(
 		header.version = DT_TILECACHE_VERSION;
 		
 		// Tile layer location in the navmesh.
-		header.tx = tx;
-		header.ty = ty;
-		header.tlayer = i;
+		header.tx = tl.tx;
+		header.ty = tl.ty;
+		header.tlayer = tl.tlayer;
 		dtVcopy(header.bmin, layer->bmin);
 		dtVcopy(header.bmax, layer->bmax);
 		
@@ -449,21 +494,174 @@ int Sample_TempObstacles::rasterizeTileLayers(
 		header.hmin = (unsigned short)layer->hmin;
 		header.hmax = (unsigned short)layer->hmax;
 
+		FastLZCompressor comp;
 		dtStatus status = dtBuildTileCacheLayer(&comp, &header, layer->heights, layer->areas, layer->cons,
 												&tile->data, &tile->dataSize);
 		if (dtStatusFailed(status))
 		{
-			return 0;
+			tile->data = 0;
+			tile->dataSize = 0;
 		}
 	}
+	
+private:
+	const TileLayer* m_layers;
+	TileCacheData* m_tiles;
+	
+	// Explicitly-disabled copy assignment operator.
+	CompressLayersTasks& operator=(const CompressLayersTasks&);
+};
+
+/// Intermediate results of building the layers of a row of tiles.
+struct TileRowContext
+{
+	TileRowContext(const int tw) :
+		chfs(new rcCompactHeightfield*[tw]),
+		lsets(new rcHeightfieldLayerSet*[tw]),
+		errors(new const char*[tw]),
+		built(new bool[tw]),
+		tileX(new int[tw]),
+		layers(new TileLayer[tw*MAX_LAYERS]),
+		tileBmin(new float[tw*2]),
+		tileBmax(new float[tw*2]),
+		chunkIds(new int[tw*MAX_TILE_CHUNKS]),
+		chunkCounts(new int[tw]),
+		tw(tw)
+	{
+		memset(chfs, 0, sizeof(rcCompactHeightfield*)*tw);
+		memset(lsets, 0, sizeof(rcHeightfieldLayerSet*)*tw);
+	}
+	
+	~TileRowContext()
+	{
+		for (int i = 0; i < tw; ++i)
+		{
+			rcFreeCompactHeightfield(chfs[i]);
+			rcFreeHeightfieldLayerSet(lsets[i]);
+		}
+		delete [] chfs;
+		delete [] lsets;
+		delete [] errors;
+		delete [] built;
+		delete [] tileX;
+		delete [] layers;
+		delete [] tileBmin;
+		delete [] tileBmax;
+		delete [] chunkIds;
+		delete [] chunkCounts;
+	}
+	
+	rcCompactHeightfield** chfs;
+	rcHeightfieldLayerSet** lsets;
+	const char** errors;
+	bool* built;
+	int* tileX;
+	TileLayer* layers;
+	// XZ bounds of the tiles, and the chunks of the input mesh that overlap them.
+	float* tileBmin;
+	float* tileBmax;
+	int* chunkIds;
+	int* chunkCounts;
+	int tw;
+	
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	TileRowContext(const TileRowContext&);
+	TileRowContext& operator=(const TileRowContext&);
+};
 
-	// Transfer ownsership of tile data from build context to the caller.
+int Sample_TempObstacles::rasterizeTileLayerRow(
+							   const int ty, const int tw,
+							   const rcConfig& cfg,
+							   TileCacheData* tiles,
+							   const int maxTiles)
+{
+	if (!m_geom || !m_geom->getMesh() || !m_geom->getChunkyMesh())
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildTile: Input mesh is not specified.");
+		return 0;
+	}
+	
+	TileRowContext rc(tw);
+	
+	// Rasterize the tiles of the row into compact heightfields.
+	TileRasterizationParams params;
+	params.geom = m_geom;
+	params.cfg = &cfg;
+	params.filterLowHangingObstacles = m_filterLowHangingObstacles;
+	params.filterLedgeSpans = m_filterLedgeSpans;
+	params.filterWalkableLowHeightSpans = m_filterWalkableLowHeightSpans;
+	
+	// Find the chunks of the input mesh under the tiles of the row in one query.
+	for (int x = 0; x < tw; ++x)
+	{
+		rcConfig tcfg;
+		calcTileConfig(cfg, x, ty, tcfg);
+		rc.tileBmin[x*2+0] = tcfg.bmin[0];
+		rc.tileBmin[x*2+1] = tcfg.bmin[2];
+		rc.tileBmax[x*2+0] = tcfg.bmax[0];
+		rc.tileBmax[x*2+1] = tcfg.bmax[2];
+	}
+	rcGetChunksOverlappingRects(m_geom->getChunkyMesh(), rc.tileBmin, rc.tileBmax, tw,
+								rc.chunkIds, rc.chunkCounts, MAX_TILE_CHUNKS);
+	
+	RasterizeTilesTasks rasterizeTasks(params, ty, rc.chunkIds, rc.chunkCounts, rc.chfs, rc.errors);
+	m_ctx->runTasks(rasterizeTasks, tw);
+	
+	// Gather the non-empty tiles to the front of the row, the tiles which failed are skipped.
+	int nchfs = 0;
+	for (int x = 0; x < tw; ++x)
+	{
+		if (rc.errors[x])
+			m_ctx->log(RC_LOG_ERROR, rc.errors[x], m_geom->getChunkyMesh()->maxTrisPerChunk);
+		if (!rc.chfs[x])
+			continue;
+		rc.tileX[nchfs] = x;
+		rc.chfs[nchfs++] = rc.chfs[x];
+		if (nchfs-1 != x)
+			rc.chfs[x] = 0;
+	}
+	
+	for (int i = 0; i < nchfs; ++i)
+	{
+		rc.lsets[i] = rcAllocHeightfieldLayerSet();
+		if (!rc.lsets[i])
+		{
+			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
+			return 0;
+		}
+	}
+	rcBuildHeightfieldLayersBatch(m_ctx, nchfs, rc.chfs, cfg.borderSize, cfg.walkableHeight, rc.lsets, rc.built);
+	
+	// Compress the layers in tile and layer order.
+	int nlayers = 0;
+	for (int i = 0; i < nchfs; ++i)
+	{
+		if (!rc.built[i])
+		{
+			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
+			continue;
+		}
+		const rcHeightfieldLayerSet* lset = rc.lsets[i];
+		for (int j = 0; j < rcMin(lset->nlayers, MAX_LAYERS) && nlayers < maxTiles; ++j)
+		{
+			TileLayer& tl = rc.layers[nlayers++];
+			tl.tx = rc.tileX[i];
+			tl.ty = ty;
+			tl.tlayer = j;
+			tl.layer = &lset->layers[j];
+		}
+	}
+	
+	CompressLayersTasks compressTasks(rc.layers, tiles);
+	m_ctx->runTasks(compressTasks, nlayers);
+	
+	// Drop the layers that could not be compressed.
 	int n = 0;
-	for (int i = 0; i < rcMin(rc.ntiles, maxTiles); ++i)
+	for (int i = 0; i < nlayers; ++i)
 	{
-		tiles[n++] = rc.tiles[i];
-		rc.tiles[i].data = 0;
-		rc.tiles[i].dataSize = 0;
+		if (tiles[i].data)
+			tiles[n++] = tiles[i];
 	}
 	
 	return n;
@@ -1299,6 +1497,14 @@ bool Sample_TempObstacles::handleBuild()
 		m_ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Could not init navmesh.");
 		return false;
 	}
+
+	// All the tiles are within the bounds of the input mesh.
+	status = m_navMesh->initTileGrid(0, 0, tw, th);
+	if (dtStatusFailed(status))
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Could not init navmesh tile grid.");
+		return false;
+	}
 	
 	status = m_navQuery->init(m_navMesh, 2048);
 	if (dtStatusFailed(status))
@@ -1316,31 +1522,32 @@ bool Sample_TempObstacles::handleBuild()
 	m_cacheCompressedSize = 0;
 	m_cacheRawSize = 0;
 	
+	// The tiles are built a row at a time, the tiles and layers of the row in parallel
+	// through the build context.
+	const int maxRowTiles = tw*MAX_LAYERS;
+	TileCacheData* tiles = new TileCacheData[maxRowTiles];
 	for (int y = 0; y < th; ++y)
 	{
-		for (int x = 0; x < tw; ++x)
-		{
-			TileCacheData tiles[MAX_LAYERS];
-			memset(tiles, 0, sizeof(tiles));
-			int ntiles = rasterizeTileLayers(x, y, cfg, tiles, MAX_LAYERS);
+		memset(tiles, 0, sizeof(TileCacheData)*maxRowTiles);
+		int ntiles = rasterizeTileLayerRow(y, tw, cfg, tiles, maxRowTiles);
 
-			for (int i = 0; i < ntiles; ++i)
+		for (int i = 0; i < ntiles; ++i)
+		{
+			TileCacheData* tile = &tiles[i];
+			status = m_tileCache->addTile(tile->data, tile->dataSize, DT_COMPRESSEDTILE_FREE_DATA, 0);
+			if (dtStatusFailed(status))
 			{
-				TileCacheData* tile = &tiles[i];
-				status = m_tileCache->addTile(tile->data, tile->dataSize, DT_COMPRESSEDTILE_FREE_DATA, 0);
-				if (dtStatusFailed(status))
-				{
-					dtFree(tile->data);
-					tile->data = 0;
-					continue;
-				}
-				
-				m_cacheLayerCount++;
-				m_cacheCompressedSize += tile->dataSize;
-				m_cacheRawSize += calcLayerBufferSize(tcparams.width, tcparams.height);
+				dtFree(tile->data);
+				tile->data = 0;
+				continue;
 			}
+			
+			m_cacheLayerCount++;
+			m_cacheCompressedSize += tile->dataSize;
+			m_cacheRawSize += calcLayerBufferSize(tcparams.width, tcparams.height);
 		}
 	}
+	delete [] tiles;
 
 	// Build initial meshes
 	m_ctx->startTimer(RC_TIMER_TOTAL);
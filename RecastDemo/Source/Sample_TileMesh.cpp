@@ -34,18 +34,27 @@
 #include "RecastDebugDraw.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshBuilder.h"
+#include "DetourNavMeshLandmarks.h"
+#include "DetourNavMeshQuery.h"
 #include "DetourDebugDraw.h"
 #include "NavMeshTesterTool.h"
 #include "NavMeshPruneTool.h"
 #include "OffMeshConnectionTool.h"
 #include "ConvexVolumeTool.h"
 #include "CrowdTool.h"
+#include "StreamingNavMeshBuilder.h"
 
 
 #ifdef WIN32
 #	define snprintf _snprintf
 #endif
 
+// Size of the arena serving the temporary allocations of a tile build.
+// Larger builds fall back to the heap for the allocations that do not fit.
+static const size_t TEMP_ARENA_SIZE = 32*1024*1024;
+
+// Memory limit of the geometry held by a streaming build.
+static const size_t STREAMING_MEMORY_LIMIT = 256*1024*1024;
 
 inline unsigned int nextPow2(unsigned int v)
 {
@@ -191,7 +200,8 @@ Sample_TileMesh::Sample_TileMesh() :
 	m_tileCol(duRGBA(0,0,0,32)),
 	m_tileBuildTime(0),
 	m_tileMemUsage(0),
-	m_tileTriCount(0)
+	m_tileTriCount(0),
+	m_landmarks(0)
 {
 	resetCommonSettings();
 	memset(m_lastBuiltTileBmin, 0, sizeof(m_lastBuiltTileBmin));
@@ -203,6 +213,7 @@ Sample_TileMesh::Sample_TileMesh() :
 Sample_TileMesh::~Sample_TileMesh()
 {
 	cleanup();
+	freeLandmarks();
 	dtFreeNavMesh(m_navMesh);
 	m_navMesh = 0;
 }
@@ -223,6 +234,14 @@ void Sample_TileMesh::cleanup()
 	m_dmesh = 0;
 }
 
+void Sample_TileMesh::freeLandmarks()
+{
+	if (m_navQuery)
+		m_navQuery->setLandmarks(0);
+	dtFreeNavMeshLandmarks(m_landmarks);
+	m_landmarks = 0;
+}
+
 void Sample_TileMesh::handleSettings()
 {
 	Sample::handleCommonSettings();
@@ -274,14 +293,27 @@ void Sample_TileMesh::handleSettings()
 	
 	if (imguiButton("Save"))
 	{
-		Sample::saveAll("all_tiles_navmesh.bin", m_navMesh);
+		Sample::saveAll("all_tiles_navmesh.bin", m_navMesh, m_landmarks);
 	}
 
 	if (imguiButton("Load"))
 	{
+		freeLandmarks();
 		dtFreeNavMesh(m_navMesh);
-		m_navMesh = Sample::loadAll("all_tiles_navmesh.bin");
+		m_navMesh = Sample::loadAll("all_tiles_navmesh.bin", &m_landmarks);
 		m_navQuery->init(m_navMesh, 2048);
+		m_navQuery->setLandmarks(m_landmarks);
+	}
+
+	if (imguiButton("Streaming Build", m_geom != 0))
+	{
+		if (streamBuildAllTiles("all_tiles_navmesh.bin"))
+		{
+			freeLandmarks();
+			dtFreeNavMesh(m_navMesh);
+			m_navMesh = Sample::loadAll("all_tiles_navmesh.bin");
+			m_navQuery->init(m_navMesh, 2048);
+		}
 	}
 
 	imguiUnindent();
@@ -574,6 +606,7 @@ void Sample_TileMesh::handleMeshChanged(InputGeom* geom)
 
 	cleanup();
 
+	freeLandmarks();
 	dtFreeNavMesh(m_navMesh);
 	m_navMesh = 0;
 
@@ -594,6 +627,7 @@ bool Sample_TileMesh::handleBuild()
 		return false;
 	}
 	
+	freeLandmarks();
 	dtFreeNavMesh(m_navMesh);
 	
 	m_navMesh = dtAllocNavMesh();
@@ -618,6 +652,17 @@ bool Sample_TileMesh::handleBuild()
 		m_ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Could not init navmesh.");
 		return false;
 	}
+
+	// All the tiles are within the bounds of the input mesh.
+	int gw = 0, gh = 0;
+	rcCalcGridSize(m_geom->getNavMeshBoundsMin(), m_geom->getNavMeshBoundsMax(), m_cellSize, &gw, &gh);
+	const int ts = (int)m_tileSize;
+	status = m_navMesh->initTileGrid(0, 0, (gw + ts-1) / ts, (gh + ts-1) / ts);
+	if (dtStatusFailed(status))
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Could not init navmesh tile grid.");
+		return false;
+	}
 	
 	status = m_navQuery->init(m_navMesh, 2048);
 	if (dtStatusFailed(status))
@@ -671,15 +716,21 @@ void Sample_TileMesh::buildTile(const float* pos)
 	unsigned char* data = buildTileMesh(tx, ty, m_lastBuiltTileBmin, m_lastBuiltTileBmax, dataSize);
 
 	// Remove any previous data (navmesh owns and deletes the data).
-	m_navMesh->removeTile(m_navMesh->getTileRefAt(tx,ty,0),0,0);
+	const dtTileRef oldRef = m_navMesh->getTileRefAt(tx,ty,0);
+	m_navMesh->removeTile(oldRef,0,0);
+	if (m_landmarks && oldRef)
+		m_landmarks->removeTile(oldRef);
 
 	// Add tile, or leave the location empty.
 	if (data)
 	{
 		// Let the navmesh own the data.
-		dtStatus status = m_navMesh->addTile(data,dataSize,DT_TILE_FREE_DATA,0,0);
+		dtTileRef ref = 0;
+		dtStatus status = m_navMesh->addTile(data,dataSize,DT_TILE_FREE_DATA,0,&ref);
 		if (dtStatusFailed(status))
 			dtFree(data);
+		else if (m_landmarks)
+			m_landmarks->addTile(ref);
 	}
 	
 	m_ctx->dumpLog("Build Tile (%d,%d):", tx,ty);
@@ -718,7 +769,10 @@ void Sample_TileMesh::removeTile(const float* pos)
 	
 	m_tileCol = duRGBA(128,32,16,64);
 	
-	m_navMesh->removeTile(m_navMesh->getTileRefAt(tx,ty,0),0,0);
+	const dtTileRef ref = m_navMesh->getTileRefAt(tx,ty,0);
+	m_navMesh->removeTile(ref,0,0);
+	if (m_landmarks && ref)
+		m_landmarks->removeTile(ref);
 }
 
 void Sample_TileMesh::buildAllTiles()
@@ -738,6 +792,7 @@ void Sample_TileMesh::buildAllTiles()
 	
 	// Start the build process.
 	m_ctx->startTimer(RC_TIMER_TEMP);
+	freeLandmarks();
 
 	for (int y = 0; y < th; ++y)
 	{
@@ -765,6 +820,15 @@ void Sample_TileMesh::buildAllTiles()
 		}
 	}
 	
+	// The landmarks are then kept up to date as tiles are rebuilt.
+	m_landmarks = dtAllocNavMeshLandmarks();
+	if (!m_landmarks || dtStatusFailed(m_landmarks->build(m_navMesh, 8)))
+	{
+		m_ctx->log(RC_LOG_WARNING, "buildTiledNavigation: Could not build landmarks.");
+		freeLandmarks();
+	}
+	m_navQuery->setLandmarks(m_landmarks);
+
 	// Start the build process.	
 	m_ctx->stopTimer(RC_TIMER_TEMP);
 
@@ -772,6 +836,60 @@ void Sample_TileMesh::buildAllTiles()
 	
 }
 
+/// Logs the progress of a streaming build every tenth of a stage.
+class StreamingBuildLog : public StreamingBuildProgress
+{
+public:
+	StreamingBuildLog(rcContext* ctx) : m_ctx(ctx), m_stage(-1), m_step(0) {}
+
+	virtual void report(StreamingBuildStage stage, int64_t done, int64_t total)
+	{
+		static const char* names[] = { "Reading mesh", "Indexing triangles", "Building tiles" };
+		const int step = total > 0 ? (int)(done*10 / total) : 10;
+		if (stage == m_stage && step == m_step)
+			return;
+		m_stage = stage;
+		m_step = step;
+		m_ctx->log(RC_LOG_PROGRESS, "%s: %d%%", names[stage], step*10);
+	}
+
+private:
+	rcContext* m_ctx;
+	int m_stage;
+	int m_step;
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	StreamingBuildLog(const StreamingBuildLog&);
+	StreamingBuildLog& operator=(const StreamingBuildLog&);
+};
+
+bool Sample_TileMesh::streamBuildAllTiles(const char* path)
+{
+	if (!m_geom || !m_geom->getMesh())
+		return false;
+
+	// The geometry is read again from its file, the way a world too large for memory would be.
+	BuildSettings settings;
+	collectSettings(settings);
+
+	StreamingBuildLog log(m_ctx);
+	StreamingNavMeshBuilder builder;
+	builder.setMemoryLimit(STREAMING_MEMORY_LIMIT);
+	builder.setProgress(&log);
+	builder.setFilters(m_filterLowHangingObstacles, m_filterLedgeSpans, m_filterWalkableLowHeightSpans);
+
+	m_ctx->resetLog();
+	m_ctx->resetTimers();
+	m_ctx->startTimer(RC_TIMER_TEMP);
+	const bool built = builder.build(m_ctx, m_geom->getMesh()->getFileName().c_str(), settings, path);
+	m_ctx->stopTimer(RC_TIMER_TEMP);
+
+	m_totalBuildTimeMs = m_ctx->getAccumulatedTime(RC_TIMER_TEMP)/1000.0f;
+	m_ctx->dumpLog("Streaming Build:");
+
+	return built;
+}
+
 void Sample_TileMesh::removeAllTiles()
 {
 	if (!m_geom || !m_navMesh)
@@ -788,6 +906,8 @@ void Sample_TileMesh::removeAllTiles()
 	for (int y = 0; y < th; ++y)
 		for (int x = 0; x < tw; ++x)
 			m_navMesh->removeTile(m_navMesh->getTileRefAt(x,y,0),0,0);
+
+	freeLandmarks();
 }
 
 
@@ -804,6 +924,12 @@ unsigned char* Sample_TileMesh::buildTileMesh(const int tx, const int ty, const
 	
 	cleanup();
 	
+	// Serve the temporary allocations of the build from an arena, which is reset after every tile.
+	if (m_tempArena.getCapacity() == 0)
+		m_tempArena.init(TEMP_ARENA_SIZE);
+	rcScopedTempArena tempArenaScope(m_tempArena);
+	m_tempArena.resetStats();
+	
 	const float* verts = m_geom->getMesh()->getVerts();
 	const int nverts = m_geom->getMesh()->getVertCount();
 	const int ntris = m_geom->getMesh()->getTriCount();
@@ -857,8 +983,10 @@ unsigned char* Sample_TileMesh::buildTileMesh(const int tx, const int ty, const
 	m_cfg.bmax[0] += m_cfg.borderSize*m_cfg.cs;
 	m_cfg.bmax[2] += m_cfg.borderSize*m_cfg.cs;
 	
-	// Reset build times gathering.
+	// Reset build times and memory usage gathering.
 	m_ctx->resetTimers();
+	m_ctx->enableAllocStats(true);
+	m_ctx->resetAllocStats();
 	
 	// Start the build process.
 	m_ctx->startTimer(RC_TIMER_TOTAL);
@@ -1163,7 +1291,10 @@ unsigned char* Sample_TileMesh::buildTileMesh(const int tx, const int ty, const
 	
 	// Show performance stats.
 	duLogBuildTimes(*m_ctx, m_ctx->getAccumulatedTime(RC_TIMER_TOTAL));
+	duLogAllocStats(*m_ctx);
 	m_ctx->log(RC_LOG_PROGRESS, ">> Polymesh: %d vertices  %d polygons", m_pmesh->nverts, m_pmesh->npolys);
+	m_ctx->log(RC_LOG_PROGRESS, ">> Temp memory: %.1fkB peak, %d allocations outside the arena",
+			   m_tempArena.getPeakUsed()/1024.0f, m_tempArena.getOverflowCount());
 	
 	m_tileBuildTime = m_ctx->getAccumulatedTime(RC_TIMER_TOTAL)/1000.0f;
 
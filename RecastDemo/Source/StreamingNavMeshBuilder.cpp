@@ -0,0 +1,1214 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "StreamingNavMeshBuilder.h"
+#include "InputGeom.h"
+#include "ChunkyTriMesh.h"
+#include "Sample.h"
+#include "Recast.h"
+#include "DetourCommon.h"
+#include "DetourNavMesh.h"
+#include "DetourNavMeshBuilder.h"
+
+// Same layout as the navmesh set written by Sample::saveAll.
+static const int NAVMESHSET_MAGIC = 'M'<<24 | 'S'<<16 | 'E'<<8 | 'T'; //'MSET';
+static const int NAVMESHSET_VERSION = 1;
+
+struct NavMeshSetHeader
+{
+	int magic;
+	int version;
+	int numTiles;
+	dtNavMeshParams params;
+};
+
+struct NavMeshTileHeader
+{
+	dtTileRef tileRef;
+	int dataSize;
+};
+
+static const int MAX_READ_BUFFER_SIZE = 1 << 20;
+static const int MAX_WRITE_BUFFER_SIZE = 1 << 16;
+static const int MAX_ROW_SIZE = 512;
+static const int TRIS_PER_BATCH = 1024;
+static const int VERTS_PER_PAGE = 1024;
+static const int TRIS_PER_CHUNK = 256;
+static const int MAX_CELL_TILES = 64;
+// Memory of a triangle of the cell being built: its vertices, indices and chunky mesh, with the build items.
+static const int CELL_BYTES_PER_TRI = 88;
+
+StreamingBuildProgress::~StreamingBuildProgress()
+{
+	// Defined out of line to fix the weak v-tables warning
+}
+
+static bool seekFile(FILE* fp, const int64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(fp, offset, SEEK_SET) == 0;
+#else
+	return fseeko(fp, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static int64_t tellFile(FILE* fp)
+{
+#ifdef _WIN32
+	return _ftelli64(fp);
+#else
+	return ftello(fp);
+#endif
+}
+
+static int64_t getFileSize(FILE* fp)
+{
+	if (fseek(fp, 0, SEEK_END) != 0)
+		return -1;
+	const int64_t size = tellFile(fp);
+	if (!seekFile(fp, 0))
+		return -1;
+	return size;
+}
+
+/// Buffered sequential writes to a file.
+struct FileWriter
+{
+	FileWriter(FILE* fp_, unsigned char* buf_, const int cap_) : fp(fp_), buf(buf_), n(0), cap(cap_) {}
+
+	bool write(const void* data, const int size)
+	{
+		if (n + size > cap && !flush())
+			return false;
+		memcpy(&buf[n], data, size);
+		n += size;
+		return true;
+	}
+
+	bool flush()
+	{
+		if (n && fwrite(buf, n, 1, fp) != 1)
+			return false;
+		n = 0;
+		return true;
+	}
+
+	FILE* fp;
+	unsigned char* buf;
+	int n;
+	int cap;
+};
+
+/// Vertices of the vertex scratch file, read a page at a time into a direct mapped cache.
+struct VertexCache
+{
+	VertexCache(FILE* fp_, const int nverts_, float* verts_, int* pageIds_, const int npages_) :
+		fp(fp_), nverts(nverts_), verts(verts_), pageIds(pageIds_), npages(npages_), failed(false)
+	{
+		for (int i = 0; i < npages; ++i)
+			pageIds[i] = -1;
+	}
+
+	// The vertex is only valid until the next call.
+	const float* get(const int i)
+	{
+		const int page = i / VERTS_PER_PAGE;
+		const int slot = page % npages;
+		float* dst = &verts[slot*VERTS_PER_PAGE*3];
+		if (pageIds[slot] != page)
+		{
+			const int first = page*VERTS_PER_PAGE;
+			const int n = rcMin(VERTS_PER_PAGE, nverts - first);
+			if (!seekFile(fp, (int64_t)first*3*sizeof(float)) ||
+				fread(dst, sizeof(float)*3, n, fp) != (size_t)n)
+			{
+				failed = true;
+				memset(dst, 0, sizeof(float)*3*VERTS_PER_PAGE);
+			}
+			pageIds[slot] = page;
+		}
+		return &dst[(i - page*VERTS_PER_PAGE)*3];
+	}
+
+	FILE* fp;
+	int nverts;
+	float* verts;
+	int* pageIds;
+	int npages;
+	bool failed;
+};
+
+/// Reads the triangles of the triangle scratch file in order, with their vertices.
+struct TriangleReader
+{
+	TriangleReader(FILE* fp_, const int64_t ntris_, int* batch_, VertexCache& cache_) :
+		fp(fp_), ntris(ntris_), batch(batch_), cache(cache_), next(0), nbatch(0), ibatch(0), failed(false)
+	{
+	}
+
+	bool read(float* v)
+	{
+		if (ibatch == nbatch)
+		{
+			if (next == ntris)
+				return false;
+			if (next == 0 && !seekFile(fp, 0))
+			{
+				failed = true;
+				return false;
+			}
+			nbatch = (int)rcMin((int64_t)TRIS_PER_BATCH, ntris - next);
+			if (fread(batch, sizeof(int)*3, nbatch, fp) != (size_t)nbatch)
+			{
+				failed = true;
+				return false;
+			}
+			ibatch = 0;
+		}
+		const int* t = &batch[ibatch*3];
+		ibatch++;
+		next++;
+		for (int j = 0; j < 3; ++j)
+			rcVcopy(&v[j*3], cache.get(t[j]));
+		return true;
+	}
+
+	FILE* fp;
+	int64_t ntris;
+	int* batch;
+	VertexCache& cache;
+	int64_t next;
+	int nbatch;
+	int ibatch;
+	bool failed;
+
+private:
+	// Explicitly disabled copy assignment operator.
+	TriangleReader& operator=(const TriangleReader&);
+};
+
+/// A triangle waiting to be written to the cell file.
+struct IndexRecord
+{
+	int cell;
+	float verts[9];
+};
+
+/// Header of a block of triangles in the cell file. The blocks of a cell are chained
+/// from the last one written, which is the head of the cell.
+struct CellBlockHeader
+{
+	int64_t prev;
+	int count;
+	int pad;
+};
+
+static int compareRecordCell(const void* va, const void* vb)
+{
+	const IndexRecord* a = (const IndexRecord*)va;
+	const IndexRecord* b = (const IndexRecord*)vb;
+	if (a->cell < b->cell)
+		return -1;
+	if (a->cell > b->cell)
+		return 1;
+	return 0;
+}
+
+static int parseFace(char* row, int* data, int n, int vcnt)
+{
+	int j = 0;
+	while (*row != '\0')
+	{
+		// Skip initial white space
+		while (*row != '\0' && (*row == ' ' || *row == '\t'))
+			row++;
+		char* s = row;
+		// Find vertex delimiter and terminated the string there for conversion.
+		while (*row != '\0' && *row != ' ' && *row != '\t')
+		{
+			if (*row == '/') *row = '\0';
+			row++;
+		}
+		if (*s == '\0')
+			continue;
+		int vi = atoi(s);
+		data[j++] = vi < 0 ? vi+vcnt : vi-1;
+		if (j >= n) return j;
+	}
+	return j;
+}
+
+StreamingNavMeshBuilder::StreamingNavMeshBuilder() :
+	m_ctx(0),
+	m_progress(0),
+	m_memoryLimit(256*1024*1024),
+	m_memoryUsed(0),
+	m_memoryPeak(0),
+	m_filterLowHangingObstacles(true),
+	m_filterLedgeSpans(true),
+	m_filterWalkableLowHeightSpans(true),
+	m_agentHeight(0),
+	m_agentRadius(0),
+	m_agentMaxClimb(0),
+	m_partitionType(SAMPLE_PARTITION_WATERSHED),
+	m_vertFile(0),
+	m_triFile(0),
+	m_cellFile(0),
+	m_vertCount(0),
+	m_triCount(0),
+	m_tileWidth(0),
+	m_tileHeight(0),
+	m_cellTiles(0),
+	m_cellWidth(0),
+	m_cellHeight(0),
+	m_cellHeads(0),
+	m_cellTriCounts(0),
+	m_tileCount(0)
+{
+	memset(&m_cfg, 0, sizeof(m_cfg));
+}
+
+StreamingNavMeshBuilder::~StreamingNavMeshBuilder()
+{
+	cleanup();
+}
+
+void StreamingNavMeshBuilder::setFilters(const bool lowHangingObstacles, const bool ledgeSpans, const bool walkableLowHeightSpans)
+{
+	m_filterLowHangingObstacles = lowHangingObstacles;
+	m_filterLedgeSpans = ledgeSpans;
+	m_filterWalkableLowHeightSpans = walkableLowHeightSpans;
+}
+
+void StreamingNavMeshBuilder::cleanup()
+{
+	// Scratch files from tmpfile() are removed when closed.
+	if (m_vertFile)
+		fclose(m_vertFile);
+	if (m_triFile)
+		fclose(m_triFile);
+	if (m_cellFile)
+		fclose(m_cellFile);
+	m_vertFile = 0;
+	m_triFile = 0;
+	m_cellFile = 0;
+	delete [] m_cellHeads;
+	delete [] m_cellTriCounts;
+	m_cellHeads = 0;
+	m_cellTriCounts = 0;
+}
+
+void StreamingNavMeshBuilder::report(const StreamingBuildStage stage, const int64_t done, const int64_t total)
+{
+	if (m_progress)
+		m_progress->report(stage, done, total);
+}
+
+void StreamingNavMeshBuilder::trackAlloc(const size_t size)
+{
+	m_memoryUsed += size;
+	m_memoryPeak = rcMax(m_memoryPeak, m_memoryUsed);
+}
+
+void StreamingNavMeshBuilder::trackFree(const size_t size)
+{
+	m_memoryUsed -= size;
+}
+
+bool StreamingNavMeshBuilder::build(rcContext* ctx, const char* objPath, const BuildSettings& settings, const char* outPath)
+{
+	cleanup();
+
+	m_ctx = ctx;
+	m_memoryUsed = 0;
+	m_memoryPeak = 0;
+	m_vertCount = 0;
+	m_triCount = 0;
+	m_tileCount = 0;
+
+	// Init build configuration the same way as the tile mesh sample does.
+	memset(&m_cfg, 0, sizeof(m_cfg));
+	m_cfg.cs = settings.cellSize;
+	m_cfg.ch = settings.cellHeight;
+	m_cfg.walkableSlopeAngle = settings.agentMaxSlope;
+	m_cfg.walkableHeight = (int)ceilf(settings.agentHeight / m_cfg.ch);
+	m_cfg.walkableClimb = (int)floorf(settings.agentMaxClimb / m_cfg.ch);
+	m_cfg.walkableRadius = (int)ceilf(settings.agentRadius / m_cfg.cs);
+	m_cfg.maxEdgeLen = (int)(settings.edgeMaxLen / settings.cellSize);
+	m_cfg.maxSimplificationError = settings.edgeMaxError;
+	m_cfg.minRegionArea = (int)rcSqr(settings.regionMinSize);		// Note: area = size*size
+	m_cfg.mergeRegionArea = (int)rcSqr(settings.regionMergeSize);	// Note: area = size*size
+	m_cfg.maxVertsPerPoly = (int)settings.vertsPerPoly;
+	m_cfg.tileSize = (int)settings.tileSize;
+	m_cfg.borderSize = m_cfg.walkableRadius + 3; // Reserve enough padding.
+	m_cfg.width = m_cfg.tileSize + m_cfg.borderSize*2;
+	m_cfg.height = m_cfg.tileSize + m_cfg.borderSize*2;
+	m_cfg.detailSampleDist = settings.detailSampleDist < 0.9f ? 0 : settings.cellSize * settings.detailSampleDist;
+	m_cfg.detailSampleMaxError = settings.cellHeight * settings.detailSampleMaxError;
+	m_agentHeight = settings.agentHeight;
+	m_agentRadius = settings.agentRadius;
+	m_agentMaxClimb = settings.agentMaxClimb;
+	m_partitionType = settings.partitionType;
+
+	if (m_cfg.tileSize <= 0)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Invalid tile size %d.", m_cfg.tileSize);
+		return false;
+	}
+
+	if (!readMesh(objPath))
+	{
+		cleanup();
+		return false;
+	}
+	if (m_triCount == 0)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: No vertices and triangles in '%s'.", objPath);
+		cleanup();
+		return false;
+	}
+
+	int gw = 0, gh = 0;
+	rcCalcGridSize(m_bmin, m_bmax, m_cfg.cs, &gw, &gh);
+	m_tileWidth = (gw + m_cfg.tileSize-1) / m_cfg.tileSize;
+	m_tileHeight = (gh + m_cfg.tileSize-1) / m_cfg.tileSize;
+
+	const int ntiles = m_tileWidth*m_tileHeight;
+	int* tileTriCounts = new int[ntiles];
+	trackAlloc(sizeof(int)*ntiles);
+	memset(tileTriCounts, 0, sizeof(int)*ntiles);
+	const bool counted = countTileTriangles(tileTriCounts) && chooseCellSize(tileTriCounts);
+	delete [] tileTriCounts;
+	trackFree(sizeof(int)*ntiles);
+	if (!counted || !indexTriangles())
+	{
+		cleanup();
+		return false;
+	}
+
+	// The vertices and triangles are all in the cell file now.
+	fclose(m_vertFile);
+	fclose(m_triFile);
+	m_vertFile = 0;
+	m_triFile = 0;
+
+	FILE* out = fopen(outPath, "wb");
+	if (!out)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not open '%s' for writing.", outPath);
+		cleanup();
+		return false;
+	}
+	const bool built = buildCells(out);
+	if (fclose(out) != 0 && built)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not write '%s'.", outPath);
+		cleanup();
+		return false;
+	}
+	cleanup();
+	if (!built)
+		return false;
+
+	m_ctx->log(RC_LOG_PROGRESS, "Streaming build: %d tiles from %.1fK triangles, %d x %d tiles per cell, %.1f MB peak geometry memory.",
+			   m_tileCount, m_triCount/1000.0f, m_cellTiles, m_cellTiles, m_memoryPeak/(1024.0f*1024.0f));
+
+	return true;
+}
+
+bool StreamingNavMeshBuilder::readMesh(const char* objPath)
+{
+	FILE* fp = fopen(objPath, "rb");
+	if (!fp)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not open '%s'.", objPath);
+		return false;
+	}
+	const int64_t fileSize = getFileSize(fp);
+
+	m_vertFile = tmpfile();
+	m_triFile = tmpfile();
+	if (fileSize < 0 || !m_vertFile || !m_triFile)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not create scratch files for '%s'.", objPath);
+		fclose(fp);
+		return false;
+	}
+
+	const int readSize = (int)rcClamp(m_memoryLimit/8, (size_t)4096, (size_t)MAX_READ_BUFFER_SIZE);
+	const int writeSize = (int)rcClamp(m_memoryLimit/32, (size_t)256, (size_t)MAX_WRITE_BUFFER_SIZE);
+	const size_t bufSize = readSize + writeSize*2;
+	char* buf = new char[readSize];
+	unsigned char* vertBuf = new unsigned char[writeSize];
+	unsigned char* triBuf = new unsigned char[writeSize];
+	trackAlloc(bufSize);
+	FileWriter vertWriter(m_vertFile, vertBuf, writeSize);
+	FileWriter triWriter(m_triFile, triBuf, writeSize);
+
+	m_bmin[0] = m_bmin[1] = m_bmin[2] = FLT_MAX;
+	m_bmax[0] = m_bmax[1] = m_bmax[2] = -FLT_MAX;
+
+	// Rows are split the same way as rcMeshLoaderObj does, across the reads of the file.
+	char row[MAX_ROW_SIZE];
+	int n = 0;
+	bool start = true;
+	int face[32];
+	int64_t done = 0;
+	bool ok = true;
+
+	report(STREAMING_STAGE_READ_MESH, 0, fileSize);
+
+	for (;;)
+	{
+		const size_t len = fread(buf, 1, readSize, fp);
+		const bool eof = len < (size_t)readSize;
+		for (size_t i = 0; i <= len && ok; ++i)
+		{
+			bool rowDone = false;
+			if (i == len)
+			{
+				// The last row of the file does not need to end in a new line.
+				if (!eof)
+					break;
+				rowDone = !start;
+			}
+			else
+			{
+				const char c = buf[i];
+				switch (c)
+				{
+					case '\\':
+					case '\r':
+						break;
+					case '\n':
+						rowDone = !start;
+						break;
+					case '\t':
+					case ' ':
+						if (start) break;
+						// else falls through
+					default:
+						start = false;
+						row[n++] = c;
+						if (n >= MAX_ROW_SIZE-1)
+							rowDone = true;
+						break;
+				}
+			}
+			if (!rowDone)
+				continue;
+
+			row[n] = '\0';
+			n = 0;
+			start = true;
+
+			if (row[0] == 'v' && row[1] != 'n' && row[1] != 't')
+			{
+				// Vertex pos
+				float v[3] = { 0, 0, 0 };
+				sscanf(row+1, "%f %f %f", &v[0], &v[1], &v[2]);
+				rcVmin(m_bmin, v);
+				rcVmax(m_bmax, v);
+				ok = vertWriter.write(v, sizeof(v));
+				m_vertCount++;
+			}
+			else if (row[0] == 'f')
+			{
+				// Faces
+				const int nv = parseFace(row+1, face, 32, m_vertCount);
+				for (int j = 2; j < nv && ok; ++j)
+				{
+					const int tri[3] = { face[0], face[j-1], face[j] };
+					if (tri[0] < 0 || tri[0] >= m_vertCount || tri[1] < 0 || tri[1] >= m_vertCount || tri[2] < 0 || tri[2] >= m_vertCount)
+						continue;
+					ok = triWriter.write(tri, sizeof(tri));
+					m_triCount++;
+				}
+			}
+		}
+
+		done += len;
+		report(STREAMING_STAGE_READ_MESH, done, fileSize);
+
+		if (eof || !ok)
+			break;
+	}
+
+	if (ferror(fp))
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not read '%s'.", objPath);
+		ok = false;
+	}
+	else if (!ok || !vertWriter.flush() || !triWriter.flush())
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not write the scratch files of '%s'.", objPath);
+		ok = false;
+	}
+	fclose(fp);
+
+	delete [] buf;
+	delete [] vertBuf;
+	delete [] triBuf;
+	trackFree(bufSize);
+
+	return ok;
+}
+
+void StreamingNavMeshBuilder::getTileRange(const float* v0, const float* v1, const float* v2, int* range) const
+{
+	// The tiles whose bounds, expanded by the border, overlap the triangle.
+	const float tcs = m_cfg.tileSize*m_cfg.cs;
+	const float border = m_cfg.borderSize*m_cfg.cs;
+	const float minx = rcMin(v0[0], rcMin(v1[0], v2[0])) - border - m_bmin[0];
+	const float minz = rcMin(v0[2], rcMin(v1[2], v2[2])) - border - m_bmin[2];
+	const float maxx = rcMax(v0[0], rcMax(v1[0], v2[0])) + border - m_bmin[0];
+	const float maxz = rcMax(v0[2], rcMax(v1[2], v2[2])) + border - m_bmin[2];
+	range[0] = rcClamp((int)ceilf(minx / tcs) - 1, 0, m_tileWidth-1);
+	range[1] = rcClamp((int)ceilf(minz / tcs) - 1, 0, m_tileHeight-1);
+	range[2] = rcClamp((int)floorf(maxx / tcs), 0, m_tileWidth-1);
+	range[3] = rcClamp((int)floorf(maxz / tcs), 0, m_tileHeight-1);
+}
+
+int StreamingNavMeshBuilder::getVertexCachePageCount() const
+{
+	// A quarter of the memory for the vertex cache, but no more pages than there are vertices.
+	const size_t pageSize = sizeof(float)*3*VERTS_PER_PAGE + sizeof(int);
+	const int maxPages = (m_vertCount + VERTS_PER_PAGE-1) / VERTS_PER_PAGE;
+	return (int)rcClamp((m_memoryLimit/4) / pageSize, (size_t)1, (size_t)maxPages);
+}
+
+bool StreamingNavMeshBuilder::countTileTriangles(int* tileTriCounts)
+{
+	const int npages = getVertexCachePageCount();
+	const size_t pageSize = sizeof(float)*3*VERTS_PER_PAGE + sizeof(int);
+	const size_t bufSize = pageSize*npages + sizeof(int)*3*TRIS_PER_BATCH;
+	float* verts = new float[npages*VERTS_PER_PAGE*3];
+	int* pageIds = new int[npages];
+	int* batch = new int[TRIS_PER_BATCH*3];
+	trackAlloc(bufSize);
+
+	VertexCache cache(m_vertFile, m_vertCount, verts, pageIds, npages);
+	TriangleReader reader(m_triFile, m_triCount, batch, cache);
+
+	report(STREAMING_STAGE_INDEX_TRIANGLES, 0, m_triCount*2);
+
+	float v[9];
+	int range[4];
+	while (reader.read(v))
+	{
+		getTileRange(&v[0], &v[3], &v[6], range);
+		for (int y = range[1]; y <= range[3]; ++y)
+			for (int x = range[0]; x <= range[2]; ++x)
+				tileTriCounts[x + y*m_tileWidth]++;
+
+		if ((reader.next % (TRIS_PER_BATCH*16)) == 0)
+			report(STREAMING_STAGE_INDEX_TRIANGLES, reader.next, m_triCount*2);
+	}
+
+	const bool ok = !reader.failed && !cache.failed;
+	if (!ok)
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not read the scratch files.");
+
+	delete [] verts;
+	delete [] pageIds;
+	delete [] batch;
+	trackFree(bufSize);
+
+	return ok;
+}
+
+bool StreamingNavMeshBuilder::chooseCellSize(const int* tileTriCounts)
+{
+	// The triangles of a cell must fit in half of the memory, the cells are made as large
+	// as they can be to cut down on the triangles which are stored in more than one cell.
+	// The tile counts add up to more than the triangles of a cell, so the estimate is safe.
+	const int64_t maxCellTris = (int64_t)(m_memoryLimit/2) / CELL_BYTES_PER_TRI;
+
+	m_cellTiles = 0;
+	for (int size = 1; size <= MAX_CELL_TILES; size *= 2)
+	{
+		int64_t maxTris = 0;
+		int maxx = 0, maxy = 0;
+		for (int cy = 0; cy < m_tileHeight; cy += size)
+		{
+			for (int cx = 0; cx < m_tileWidth; cx += size)
+			{
+				int64_t ntris = 0;
+				for (int y = cy; y < rcMin(cy+size, m_tileHeight); ++y)
+					for (int x = cx; x < rcMin(cx+size, m_tileWidth); ++x)
+						ntris += tileTriCounts[x + y*m_tileWidth];
+				if (ntris > maxTris)
+				{
+					maxTris = ntris;
+					maxx = cx;
+					maxy = cy;
+				}
+			}
+		}
+
+		if (maxTris > maxCellTris)
+		{
+			if (size == 1)
+			{
+				m_ctx->log(RC_LOG_ERROR, "streamingBuild: Tile (%d,%d) has %.1fK triangles, more than fit in the memory limit.",
+						   maxx, maxy, maxTris/1000.0f);
+				return false;
+			}
+			break;
+		}
+
+		m_cellTiles = size;
+		if (size >= m_tileWidth && size >= m_tileHeight)
+			break;
+	}
+
+	m_cellWidth = (m_tileWidth + m_cellTiles-1) / m_cellTiles;
+	m_cellHeight = (m_tileHeight + m_cellTiles-1) / m_cellTiles;
+
+	return true;
+}
+
+bool StreamingNavMeshBuilder::indexTriangles()
+{
+	m_cellFile = tmpfile();
+	if (!m_cellFile)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not create the cell scratch file.");
+		return false;
+	}
+
+	const int ncells = m_cellWidth*m_cellHeight;
+	m_cellHeads = new int64_t[ncells];
+	m_cellTriCounts = new int[ncells];
+	trackAlloc((sizeof(int64_t) + sizeof(int))*ncells);
+	for (int i = 0; i < ncells; ++i)
+	{
+		m_cellHeads[i] = -1;
+		m_cellTriCounts[i] = 0;
+	}
+
+	// A quarter of the memory for the triangles waiting to be written, there are usually not
+	// many more of them than there are triangles.
+	const int npages = getVertexCachePageCount();
+	const size_t pageSize = sizeof(float)*3*VERTS_PER_PAGE + sizeof(int);
+	const int maxRecords = (int)rcMax((int64_t)256, rcMin((int64_t)(m_memoryLimit/4 / sizeof(IndexRecord)), m_triCount*2));
+	const size_t bufSize = pageSize*npages + sizeof(int)*3*TRIS_PER_BATCH + sizeof(IndexRecord)*maxRecords;
+	float* verts = new float[npages*VERTS_PER_PAGE*3];
+	int* pageIds = new int[npages];
+	int* batch = new int[TRIS_PER_BATCH*3];
+	IndexRecord* records = new IndexRecord[maxRecords];
+	trackAlloc(bufSize);
+
+	VertexCache cache(m_vertFile, m_vertCount, verts, pageIds, npages);
+	TriangleReader reader(m_triFile, m_triCount, batch, cache);
+
+	int nrecords = 0;
+	bool ok = true;
+	float v[9];
+	int range[4];
+	while (ok && reader.read(v))
+	{
+		getTileRange(&v[0], &v[3], &v[6], range);
+		for (int cy = range[1] / m_cellTiles; cy <= range[3] / m_cellTiles && ok; ++cy)
+		{
+			for (int cx = range[0] / m_cellTiles; cx <= range[2] / m_cellTiles && ok; ++cx)
+			{
+				if (nrecords == maxRecords)
+				{
+					ok = flushIndex(records, nrecords);
+					nrecords = 0;
+				}
+				IndexRecord& rec = records[nrecords++];
+				rec.cell = cx + cy*m_cellWidth;
+				memcpy(rec.verts, v, sizeof(v));
+			}
+		}
+
+		if ((reader.next % (TRIS_PER_BATCH*16)) == 0)
+			report(STREAMING_STAGE_INDEX_TRIANGLES, m_triCount + reader.next, m_triCount*2);
+	}
+	if (ok)
+		ok = flushIndex(records, nrecords);
+
+	if (reader.failed || cache.failed)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not read the scratch files.");
+		ok = false;
+	}
+	else if (!ok)
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not write the cell scratch file.");
+	}
+	else
+	{
+		report(STREAMING_STAGE_INDEX_TRIANGLES, m_triCount*2, m_triCount*2);
+	}
+
+	delete [] verts;
+	delete [] pageIds;
+	delete [] batch;
+	delete [] records;
+	trackFree(bufSize);
+
+	return ok;
+}
+
+bool StreamingNavMeshBuilder::flushIndex(IndexRecord* records, const int nrecords)
+{
+	if (!nrecords)
+		return true;
+
+	// Append a block of triangles for each cell, chained to the previous block of the cell.
+	qsort(records, nrecords, sizeof(IndexRecord), compareRecordCell);
+
+	// Reading the cells only starts once all the blocks are written, so the file stays at its end.
+	int64_t offset = tellFile(m_cellFile);
+	if (offset < 0)
+		return false;
+
+	for (int i = 0; i < nrecords; )
+	{
+		const int cell = records[i].cell;
+		int j = i;
+		while (j < nrecords && records[j].cell == cell)
+			j++;
+
+		CellBlockHeader header;
+		header.prev = m_cellHeads[cell];
+		header.count = j - i;
+		header.pad = 0;
+		if (fwrite(&header, sizeof(header), 1, m_cellFile) != 1)
+			return false;
+		for (int k = i; k < j; ++k)
+		{
+			if (fwrite(records[k].verts, sizeof(records[k].verts), 1, m_cellFile) != 1)
+				return false;
+		}
+
+		m_cellHeads[cell] = offset;
+		m_cellTriCounts[cell] += header.count;
+		offset += sizeof(header) + sizeof(float)*9*header.count;
+		i = j;
+	}
+
+	return true;
+}
+
+int StreamingNavMeshBuilder::loadCell(const int cell, float*& verts)
+{
+	const int ntris = m_cellTriCounts[cell];
+	verts = new float[ntris*9];
+
+	// Read the blocks from the last one back.
+	int n = ntris;
+	for (int64_t offset = m_cellHeads[cell]; offset != -1; )
+	{
+		CellBlockHeader header;
+		if (!seekFile(m_cellFile, offset) ||
+			fread(&header, sizeof(header), 1, m_cellFile) != 1 ||
+			header.count > n ||
+			fread(&verts[(n - header.count)*9], sizeof(float)*9, header.count, m_cellFile) != (size_t)header.count)
+		{
+			delete [] verts;
+			verts = 0;
+			return -1;
+		}
+		n -= header.count;
+		offset = header.prev;
+	}
+
+	return ntris;
+}
+
+bool StreamingNavMeshBuilder::buildCells(FILE* out)
+{
+	dtNavMeshParams params;
+	memset(&params, 0, sizeof(params));
+	rcVcopy(params.orig, m_bmin);
+	params.tileWidth = m_cfg.tileSize*m_cfg.cs;
+	params.tileHeight = m_cfg.tileSize*m_cfg.cs;
+#ifdef DT_POLYREF64
+	params.maxTiles = m_tileWidth*m_tileHeight;
+	params.maxPolys = 1 << DT_POLY_BITS;
+#else
+	// Max tiles and max polys affect how the tile IDs are caculated.
+	// There are 22 bits available for identifying a tile and a polygon.
+	const int tileBits = rcMin((int)dtIlog2(dtNextPow2((unsigned int)(m_tileWidth*m_tileHeight))), 14);
+	params.maxTiles = 1 << tileBits;
+	params.maxPolys = 1 << (22 - tileBits);
+#endif
+
+	// The tile references are those the tiles get when added in order to an empty navmesh.
+	dtNavMesh* refMesh = dtAllocNavMesh();
+	if (!refMesh || dtStatusFailed(refMesh->init(&params)))
+	{
+		m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not init navmesh.");
+		dtFreeNavMesh(refMesh);
+		return false;
+	}
+
+	NavMeshSetHeader header;
+	header.magic = NAVMESHSET_MAGIC;
+	header.version = NAVMESHSET_VERSION;
+	header.numTiles = 0;
+	memcpy(&header.params, &params, sizeof(dtNavMeshParams));
+	bool ok = fwrite(&header, sizeof(NavMeshSetHeader), 1, out) == 1;
+
+	const int ntiles = m_tileWidth*m_tileHeight;
+	int tilesDone = 0;
+	report(STREAMING_STAGE_BUILD_TILES, 0, ntiles);
+
+	for (int cy = 0; cy < m_cellHeight && ok; ++cy)
+	{
+		for (int cx = 0; cx < m_cellWidth && ok; ++cx)
+		{
+			const int cell = cx + cy*m_cellWidth;
+			const int x0 = cx*m_cellTiles, x1 = rcMin(x0 + m_cellTiles, m_tileWidth);
+			const int y0 = cy*m_cellTiles, y1 = rcMin(y0 + m_cellTiles, m_tileHeight);
+			if (!m_cellTriCounts[cell])
+			{
+				tilesDone += (x1-x0)*(y1-y0);
+				report(STREAMING_STAGE_BUILD_TILES, tilesDone, ntiles);
+				continue;
+			}
+
+			float* verts = 0;
+			const int ntris = loadCell(cell, verts);
+			if (ntris < 0)
+			{
+				m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not read the cell scratch file.");
+				ok = false;
+				break;
+			}
+			trackAlloc((size_t)ntris*CELL_BYTES_PER_TRI);
+
+			int* tris = new int[ntris*3];
+			for (int i = 0; i < ntris*3; ++i)
+				tris[i] = i;
+			rcChunkyTriMesh* chunkyMesh = new rcChunkyTriMesh;
+			int* chunkIds = 0;
+			if (!rcCreateChunkyTriMesh(verts, tris, ntris, TRIS_PER_CHUNK, chunkyMesh, m_ctx))
+			{
+				m_ctx->log(RC_LOG_ERROR, "streamingBuild: Failed to build chunky mesh of cell (%d,%d).", cx, cy);
+				ok = false;
+			}
+			else
+			{
+				chunkIds = new int[chunkyMesh->nnodes];
+			}
+
+			for (int y = y0; y < y1 && ok; ++y)
+			{
+				for (int x = x0; x < x1 && ok; ++x)
+				{
+					int dataSize = 0;
+					unsigned char* data = buildTile(x, y, verts, *chunkyMesh, chunkIds, dataSize);
+					if (data)
+					{
+						if (m_tileCount >= params.maxTiles)
+						{
+							m_ctx->log(RC_LOG_ERROR, "streamingBuild: Too many tiles (max: %d).", params.maxTiles);
+							ok = false;
+						}
+						else
+						{
+							NavMeshTileHeader tileHeader;
+							tileHeader.tileRef = refMesh->encodePolyId(1, (unsigned int)m_tileCount, 0);
+							tileHeader.dataSize = dataSize;
+							ok = fwrite(&tileHeader, sizeof(tileHeader), 1, out) == 1 &&
+								fwrite(data, dataSize, 1, out) == 1;
+							m_tileCount++;
+						}
+						dtFree(data);
+					}
+					tilesDone++;
+					report(STREAMING_STAGE_BUILD_TILES, tilesDone, ntiles);
+				}
+			}
+
+			delete [] chunkIds;
+			delete chunkyMesh;
+			delete [] tris;
+			delete [] verts;
+			trackFree((size_t)ntris*CELL_BYTES_PER_TRI);
+		}
+	}
+
+	dtFreeNavMesh(refMesh);
+
+	// Store the number of tiles now that it is known.
+	if (ok)
+	{
+		header.numTiles = m_tileCount;
+		ok = seekFile(out, 0) && fwrite(&header, sizeof(NavMeshSetHeader), 1, out) == 1;
+		if (!ok)
+			m_ctx->log(RC_LOG_ERROR, "streamingBuild: Could not write the navmesh set.");
+	}
+
+	return ok;
+}
+
+/// Intermediate results of building a tile.
+struct TileBuildContext
+{
+	TileBuildContext() : triareas(0), solid(0), chf(0), cset(0), pmesh(0), dmesh(0) {}
+	~TileBuildContext()
+	{
+		delete [] triareas;
+		rcFreeHeightField(solid);
+		rcFreeCompactHeightfield(chf);
+		rcFreeContourSet(cset);
+		rcFreePolyMesh(pmesh);
+		rcFreePolyMeshDetail(dmesh);
+	}
+
+	unsigned char* triareas;
+	rcHeightfield* solid;
+	rcCompactHeightfield* chf;
+	rcContourSet* cset;
+	rcPolyMesh* pmesh;
+	rcPolyMeshDetail* dmesh;
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	TileBuildContext(const TileBuildContext&);
+	TileBuildContext& operator=(const TileBuildContext&);
+};
+
+unsigned char* StreamingNavMeshBuilder::buildTile(const int tx, const int ty, const float* verts,
+												  const rcChunkyTriMesh& chunkyMesh, int* chunkIds, int& dataSize)
+{
+	TileBuildContext tc;
+
+	rcConfig cfg;
+	memcpy(&cfg, &m_cfg, sizeof(cfg));
+
+	// Tile bounds, expanded by the border so that the tiles connect correctly.
+	const float tcs = cfg.tileSize*cfg.cs;
+	cfg.bmin[0] = m_bmin[0] + tx*tcs - cfg.borderSize*cfg.cs;
+	cfg.bmin[1] = m_bmin[1];
+	cfg.bmin[2] = m_bmin[2] + ty*tcs - cfg.borderSize*cfg.cs;
+	cfg.bmax[0] = m_bmin[0] + (tx+1)*tcs + cfg.borderSize*cfg.cs;
+	cfg.bmax[1] = m_bmax[1];
+	cfg.bmax[2] = m_bmin[2] + (ty+1)*tcs + cfg.borderSize*cfg.cs;
+
+	float tbmin[2], tbmax[2];
+	tbmin[0] = cfg.bmin[0];
+	tbmin[1] = cfg.bmin[2];
+	tbmax[0] = cfg.bmax[0];
+	tbmax[1] = cfg.bmax[2];
+	const int ncid = rcGetChunksOverlappingRect(&chunkyMesh, tbmin, tbmax, chunkIds, chunkyMesh.nnodes);
+	if (!ncid)
+		return 0;
+
+	tc.solid = rcAllocHeightfield();
+	if (!tc.solid)
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
+		return 0;
+	}
+	if (!rcCreateHeightfield(m_ctx, *tc.solid, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch))
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
+		return 0;
+	}
+
+	tc.triareas = new unsigned char[chunkyMesh.maxTrisPerChunk];
+	const int nverts = chunkyMesh.ntris*3;
+	for (int i = 0; i < ncid; ++i)
+	{
+		const rcChunkyTriMeshNode& node = chunkyMesh.nodes[chunkIds[i]];
+		const int* ctris = &chunkyMesh.tris[node.i*3];
+		const int nctris = node.n;
+
+		memset(tc.triareas, 0, nctris*sizeof(unsigned char));
+		rcMarkWalkableTriangles(m_ctx, cfg.walkableSlopeAngle, verts, nverts, ctris, nctris, tc.triareas);
+
+		if (!rcRasterizeTriangles(m_ctx, verts, nverts, ctris, tc.triareas, nctris, *tc.solid, cfg.walkableClimb))
+			return 0;
+	}
+
+	if (m_filterLowHangingObstacles)
+		rcFilterLowHangingWalkableObstacles(m_ctx, cfg.walkableClimb, *tc.solid);
+	if (m_filterLedgeSpans)
+		rcFilterLedgeSpans(m_ctx, cfg.walkableHeight, cfg.walkableClimb, *tc.solid);
+	if (m_filterWalkableLowHeightSpans)
+		rcFilterWalkableLowHeightSpans(m_ctx, cfg.walkableHeight, *tc.solid);
+
+	tc.chf = rcAllocCompactHeightfield();
+	if (!tc.chf)
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
+		return 0;
+	}
+	if (!rcBuildCompactHeightfield(m_ctx, cfg.walkableHeight, cfg.walkableClimb, *tc.solid, *tc.chf))
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
+		return 0;
+	}
+	rcFreeHeightField(tc.solid);
+	tc.solid = 0;
+
+	if (!rcErodeWalkableArea(m_ctx, cfg.walkableRadius, *tc.chf))
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
+		return 0;
+	}
+
+	if (m_partitionType == SAMPLE_PARTITION_WATERSHED)
+	{
+		if (!rcBuildDistanceField(m_ctx, *tc.chf))
+		{
+			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build distance field.");
+			return 0;
+		}
+		if (!rcBuildRegions(m_ctx, *tc.chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+		{
+			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build watershed regions.");
+			return 0;
+		}
+	}
+	else if (m_partitionType == SAMPLE_PARTITION_MONOTONE)
+	{
+		if (!rcBuildRegionsMonotone(m_ctx, *tc.chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+		{
+			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build monotone regions.");
+			return 0;
+		}
+	}
+	else // SAMPLE_PARTITION_LAYERS
+	{
+		if (!rcBuildLayerRegions(m_ctx, *tc.chf, cfg.borderSize, cfg.minRegionArea))
+		{
+			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build layer regions.");
+			return 0;
+		}
+	}
+
+	tc.cset = rcAllocContourSet();
+	if (!tc.cset)
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'cset'.");
+		return 0;
+	}
+	if (!rcBuildContours(m_ctx, *tc.chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *tc.cset))
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create contours.");
+		return 0;
+	}
+	if (tc.cset->nconts == 0)
+		return 0;
+
+	tc.pmesh = rcAllocPolyMesh();
+	if (!tc.pmesh)
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmesh'.");
+		return 0;
+	}
+	if (!rcBuildPolyMesh(m_ctx, *tc.cset, cfg.maxVertsPerPoly, *tc.pmesh))
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not triangulate contours.");
+		return 0;
+	}
+
+	tc.dmesh = rcAllocPolyMeshDetail();
+	if (!tc.dmesh)
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'dmesh'.");
+		return 0;
+	}
+	if (!rcBuildPolyMeshDetail(m_ctx, *tc.pmesh, *tc.chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *tc.dmesh))
+	{
+		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could build polymesh detail.");
+		return 0;
+	}
+
+	if (cfg.maxVertsPerPoly > DT_VERTS_PER_POLYGON)
+		return 0;
+	if (tc.pmesh->nverts >= 0xffff)
+	{
+		// The vertex indices are ushorts, and cannot point to more than 0xffff vertices.
+		m_ctx->log(RC_LOG_ERROR, "Too many vertices per tile %d (max: %d).", tc.pmesh->nverts, 0xffff);
+		return 0;
+	}
+
+	// Update poly flags from areas.
+	rcPolyMesh& pmesh = *tc.pmesh;
+	for (int i = 0; i < pmesh.npolys; ++i)
+	{
+		if (pmesh.areas[i] == RC_WALKABLE_AREA)
+			pmesh.areas[i] = SAMPLE_POLYAREA_GROUND;
+
+		if (pmesh.areas[i] == SAMPLE_POLYAREA_GROUND ||
+			pmesh.areas[i] == SAMPLE_POLYAREA_GRASS ||
+			pmesh.areas[i] == SAMPLE_POLYAREA_ROAD)
+		{
+			pmesh.flags[i] = SAMPLE_POLYFLAGS_WALK;
+		}
+		else if (pmesh.areas[i] == SAMPLE_POLYAREA_WATER)
+		{
+			pmesh.flags[i] = SAMPLE_POLYFLAGS_SWIM;
+		}
+		else if (pmesh.areas[i] == SAMPLE_POLYAREA_DOOR)
+		{
+			pmesh.flags[i] = SAMPLE_POLYFLAGS_WALK | SAMPLE_POLYFLAGS_DOOR;
+		}
+	}
+
+	dtNavMeshCreateParams params;
+	memset(&params, 0, sizeof(params));
+	params.verts = pmesh.verts;
+	params.vertCount = pmesh.nverts;
+	params.polys = pmesh.polys;
+	params.polyAreas = pmesh.areas;
+	params.polyFlags = pmesh.flags;
+	params.polyCount = pmesh.npolys;
+	params.nvp = pmesh.nvp;
+	params.detailMeshes = tc.dmesh->meshes;
+	params.detailVerts = tc.dmesh->verts;
+	params.detailVertsCount = tc.dmesh->nverts;
+	params.detailTris = tc.dmesh->tris;
+	params.detailTriCount = tc.dmesh->ntris;
+	params.walkableHeight = m_agentHeight;
+	params.walkableRadius = m_agentRadius;
+	params.walkableClimb = m_agentMaxClimb;
+	params.tileX = tx;
+	params.tileY = ty;
+	params.tileLayer = 0;
+	rcVcopy(params.bmin, pmesh.bmin);
+	rcVcopy(params.bmax, pmesh.bmax);
+	params.cs = cfg.cs;
+	params.ch = cfg.ch;
+	params.buildBvTree = true;
+
+	unsigned char* navData = 0;
+	int navDataSize = 0;
+	if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
+	{
+		m_ctx->log(RC_LOG_ERROR, "Could not build Detour navmesh.");
+		return 0;
+	}
+
+	dataSize = navDataSize;
+	return navData;
+}
@@ -0,0 +1,61 @@
+#ifndef RECAST_TESTS_BENCH_H
+#define RECAST_TESTS_BENCH_H
+
+#include <stdio.h>
+
+#include "catch2/catch_all.hpp"
+
+// TODO: Implement benchmarking for platforms other than posix.
+#ifdef __unix__
+#include <unistd.h>
+#ifdef _POSIX_TIMERS
+#include <time.h>
+#include <stdint.h>
+
+#define RC_BENCHMARKS_ENABLED 1
+
+// CPU time consumed by the process.
+inline int64_t NowNanos() {
+	struct timespec tp;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tp);
+	return tp.tv_nsec + 1000000000LL * tp.tv_sec;
+}
+
+// Elapsed real time, for benchmarks that run work on several threads.
+inline int64_t NowWallNanos() {
+	struct timespec tp;
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return tp.tv_nsec + 1000000000LL * tp.tv_sec;
+}
+
+#define BM_WITH_CLOCK(name, iterations, clock) \
+	struct BM_ ## name { \
+		static void Run() { \
+			int64_t begin_time = clock(); \
+			for (int i = 0 ; i < iterations; i++) { \
+				Body(); \
+			} \
+			int64_t nanos = clock() - begin_time; \
+			printf("BM_%-35s %ld iterations in %10ld nanos: %10.2f nanos/it\n", #name ":", (int64_t)iterations, nanos, double(nanos) / iterations); \
+		} \
+		static void Body(); \
+	}; \
+	TEST_CASE(#name) { \
+		BM_ ## name::Run(); \
+	} \
+	void BM_ ## name::Body()
+
+#define BM(name, iterations) BM_WITH_CLOCK(name, iterations, NowNanos)
+#define BM_WALL(name, iterations) BM_WITH_CLOCK(name, iterations, NowWallNanos)
+
+// Prevent compiler from eliding a calculation.
+// TODO: Implement for MSVC.
+template <typename T>
+void DoNotOptimize(T* v) {
+	asm volatile ("" : "+r" (v));
+}
+
+#endif  // _POSIX_TIMERS
+#endif  // __unix__
+
+#endif  // RECAST_TESTS_BENCH_H
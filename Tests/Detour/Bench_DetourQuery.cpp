@@ -0,0 +1,597 @@
+#include <stdio.h>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+#include "../Bench.h"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshLandmarks.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourNavMeshWallField.h"
+#include "DetourNode.h"
+#include "DetourPathCache.h"
+#include "DetourPortalCache.h"
+#include "DetourTestUtils.h"
+
+#ifdef RC_BENCHMARKS_ENABLED
+
+const int kNumLoops = 5;
+const int kTiles = 8;
+const int kTileSize = 64;
+const int kRequestCount = 2048;
+// Agents heading to a few shared goals, several of them from the same spot.
+const int kGoalCount = 32;
+const int kMaxPathPerRequest = 256;
+
+struct QueryBench
+{
+	dtNavMesh* nav;
+	dtNavMeshQuery* query;
+	dtQueryFilter filter;
+	std::vector<dtPathRequest> requests;
+	std::vector<dtPathResult> results;
+	std::vector<dtPolyRef> path;
+	std::vector<float> straightPath;
+};
+
+// The navmesh and the queries are shared by the benchmarks.
+static QueryBench& getQueryBench()
+{
+	static QueryBench bench;
+	static bool built = false;
+	if (!built)
+	{
+		rcContext ctx(false);
+		bench.nav = buildTestNavMesh(&ctx, kTiles, kTileSize);
+		bench.query = dtAllocNavMeshQuery();
+		bench.query->init(bench.nav, 4096);
+
+		testRandomSeed() = 1;
+		dtPathRequest goals[kGoalCount];
+		for (int i = 0; i < kGoalCount; ++i)
+			bench.query->findRandomPoint(&bench.filter, testRandom, &goals[i].endRef, goals[i].endPos);
+
+		bench.requests.resize(kRequestCount);
+		for (int i = 0; i < kRequestCount; ++i)
+		{
+			dtPathRequest& r = bench.requests[i];
+			if (i % 4 != 0)
+			{
+				r = bench.requests[i - 1];
+			}
+			else
+			{
+				bench.query->findRandomPoint(&bench.filter, testRandom, &r.startRef, r.startPos);
+			}
+			const dtPathRequest& goal = goals[(int)(testRandom() * kGoalCount)];
+			r.endRef = goal.endRef;
+			dtVcopy(r.endPos, goal.endPos);
+			r.filter = &bench.filter;
+		}
+
+		bench.results.resize(kRequestCount);
+		bench.path.resize(kRequestCount * kMaxPathPerRequest);
+		bench.straightPath.resize(kRequestCount * kMaxPathPerRequest * 3);
+		built = true;
+	}
+	return bench;
+}
+
+static void printPathsPerSecond(const char* name, const int64_t nanos)
+{
+	printf("%-38s %10.0f paths/s\n", name, (double)kRequestCount * kNumLoops * 1e9 / (double)nanos);
+}
+
+BM(BuildBenchNavMesh, 1)
+{
+	getQueryBench();
+}
+
+BM(FindPath_Single, kNumLoops)
+{
+	QueryBench& b = getQueryBench();
+	int pathUsed = 0;
+	int straightPathUsed = 0;
+	for (int i = 0; i < kRequestCount; ++i)
+	{
+		const dtPathRequest& r = b.requests[i];
+		int pathCount = 0;
+		b.query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, r.filter,
+						  &b.path[pathUsed], &pathCount, kMaxPathPerRequest);
+		int straightPathCount = 0;
+		b.query->findStraightPath(r.startPos, r.endPos, &b.path[pathUsed], pathCount,
+								  &b.straightPath[straightPathUsed * 3], 0, 0, &straightPathCount, kMaxPathPerRequest);
+		pathUsed += pathCount;
+		straightPathUsed += straightPathCount;
+	}
+	DoNotOptimize(&b.path[0]);
+}
+
+BM(FindPath_Batch, kNumLoops)
+{
+	QueryBench& b = getQueryBench();
+	b.query->findPathBatch(&b.requests[0], kRequestCount, &b.results[0],
+						   &b.path[0], (int)b.path.size(),
+						   &b.straightPath[0], 0, 0, (int)b.straightPath.size() / 3);
+	DoNotOptimize(&b.results[0]);
+}
+
+TEST_CASE("FindPath_Throughput")
+{
+	QueryBench& b = getQueryBench();
+	int64_t begin = NowNanos();
+	for (int i = 0; i < kNumLoops; ++i)
+		BM_FindPath_Single::Body();
+	printPathsPerSecond("FindPath_Single:", NowNanos() - begin);
+
+	begin = NowNanos();
+	for (int i = 0; i < kNumLoops; ++i)
+		BM_FindPath_Batch::Body();
+	printPathsPerSecond("FindPath_Batch:", NowNanos() - begin);
+	DoNotOptimize(&b);
+}
+
+// A room open on the side away from the left of the terrain, so that paths from the left into
+// it have to go around it.
+static bool culDeSacWalls(int x, int z)
+{
+	const bool inX = x >= 150 && x < 272;
+	const bool inZ = z >= 80 && z < 212;
+	if (inX && (z == 80 || z == 81 || z == 210 || z == 211))
+		return true;
+	if (inZ && (x == 150 || x == 151))
+		return true;
+	return (x % 13 < 2) && (z % 17 < 2);
+}
+
+// Gets paths from the left of the cul-de-sac terrain to the far end of its room.
+static void getCulDeSacRequests(const dtNavMeshQuery* query, const dtQueryFilter* filter, std::vector<dtPathRequest>& requests)
+{
+	const float cs = 0.3f;
+	const float extents[3] = { 2.0f, 10.0f, 2.0f };
+	requests.clear();
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int j = 0; j < 16; ++j)
+		{
+			dtPathRequest r;
+			const float startPos[3] = { (10 + i * 2) * cs, 5.0f, (40 + j * 12) * cs };
+			const float endPos[3] = { (160 + i * 2) * cs, 5.0f, (100 + j * 6) * cs };
+			query->findNearestPoly(startPos, extents, filter, &r.startRef, r.startPos);
+			query->findNearestPoly(endPos, extents, filter, &r.endRef, r.endPos);
+			r.filter = filter;
+			if (r.startRef && r.endRef)
+				requests.push_back(r);
+		}
+	}
+}
+
+// Runs the path suite forward and bidirectionally, prints the nodes the searches visit and their speed.
+static void reportBidirectionalSearch(const char* name, dtNavMeshQuery* query, const std::vector<dtPathRequest>& requests)
+{
+	const unsigned int options[2] = { 0, DT_FINDPATH_BIDIRECTIONAL };
+	const char* optionNames[2] = { "forward", "bidirectional" };
+	for (int k = 0; k < 2; ++k)
+	{
+		int64_t nodes = 0;
+		dtPolyRef path[kMaxPathPerRequest];
+		const int64_t begin = NowNanos();
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			const dtPathRequest& r = requests[i];
+			int pathCount = 0;
+			query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, r.filter, path, &pathCount, kMaxPathPerRequest, options[k]);
+			nodes += query->getNodePool()->getNodeCount();
+			if (options[k] & DT_FINDPATH_BIDIRECTIONAL)
+				nodes += query->getReverseNodePool()->getNodeCount();
+		}
+		const int64_t nanos = NowNanos() - begin;
+		char label[64];
+		snprintf(label, sizeof(label), "FindPath_%s_%s:", name, optionNames[k]);
+		printf("%-38s %8.1f nodes/path %10.0f paths/s\n", label,
+			   (double)nodes / requests.size(), (double)requests.size() * 1e9 / (double)nanos);
+	}
+}
+
+TEST_CASE("FindPath_Bidirectional")
+{
+	QueryBench& b = getQueryBench();
+	std::vector<dtPathRequest> requests(b.requests.begin(), b.requests.begin() + 512);
+	reportBidirectionalSearch("Rooms", b.query, requests);
+
+	rcContext ctx(false);
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 6, 48, culDeSacWalls);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	query->init(nav, 8192);
+	getCulDeSacRequests(query, &b.filter, requests);
+	reportBidirectionalSearch("CulDeSac", query, requests);
+
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
+
+// Runs the path suite with the straight line heuristic and with landmarks, prints the nodes
+// the searches visit and their speed.
+static void reportLandmarkSearch(const char* name, dtNavMeshQuery* query, const std::vector<dtPathRequest>& requests)
+{
+	dtNavMeshLandmarks* landmarks = dtAllocNavMeshLandmarks();
+	const int64_t buildBegin = NowNanos();
+	landmarks->build(query->getAttachedNavMesh(), 8);
+	const int64_t buildNanos = NowNanos() - buildBegin;
+
+	const char* heuristicNames[2] = { "straight", "landmarks" };
+	for (int k = 0; k < 2; ++k)
+	{
+		query->setLandmarks(k ? landmarks : 0);
+		int64_t nodes = 0;
+		dtPolyRef path[kMaxPathPerRequest];
+		const int64_t begin = NowNanos();
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			const dtPathRequest& r = requests[i];
+			int pathCount = 0;
+			query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, r.filter, path, &pathCount, kMaxPathPerRequest);
+			nodes += query->getNodePool()->getNodeCount();
+		}
+		const int64_t nanos = NowNanos() - begin;
+		char label[64];
+		snprintf(label, sizeof(label), "FindPath_%s_%s:", name, heuristicNames[k]);
+		printf("%-38s %8.1f nodes/path %10.0f paths/s\n", label,
+			   (double)nodes / requests.size(), (double)requests.size() * 1e9 / (double)nanos);
+	}
+	char label[64];
+	snprintf(label, sizeof(label), "BuildLandmarks_%s:", name);
+	printf("%-38s %8.1f ms\n", label, (double)buildNanos / 1e6);
+
+	query->setLandmarks(0);
+	dtFreeNavMeshLandmarks(landmarks);
+}
+
+TEST_CASE("FindPath_Landmarks")
+{
+	QueryBench& b = getQueryBench();
+	std::vector<dtPathRequest> requests(b.requests.begin(), b.requests.begin() + 512);
+	reportLandmarkSearch("Rooms", b.query, requests);
+
+	rcContext ctx(false);
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 6, 48, culDeSacWalls);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	query->init(nav, 8192);
+	getCulDeSacRequests(query, &b.filter, requests);
+	reportLandmarkSearch("CulDeSac", query, requests);
+
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
+
+static double benchTime()
+{
+	return (double)NowNanos();
+}
+
+TEST_CASE("FindPath_Cache")
+{
+	QueryBench& b = getQueryBench();
+
+	// Agents going back and forth between a few places.
+	const int placeCount = 12;
+	dtPathRequest places[placeCount];
+	testRandomSeed() = 5;
+	for (int i = 0; i < placeCount; ++i)
+		b.query->findRandomPoint(&b.filter, testRandom, &places[i].startRef, places[i].startPos);
+	std::vector<dtPathRequest> requests(kRequestCount);
+	for (int i = 0; i < kRequestCount; ++i)
+	{
+		const dtPathRequest& from = places[(int)(testRandom() * placeCount)];
+		const dtPathRequest& to = places[(int)(testRandom() * placeCount)];
+		dtPathRequest& r = requests[i];
+		r.startRef = from.startRef;
+		dtVcopy(r.startPos, from.startPos);
+		r.endRef = to.startRef;
+		dtVcopy(r.endPos, to.startPos);
+		r.filter = &b.filter;
+	}
+
+	dtPathCache* cache = dtAllocPathCache();
+	cache->init(b.nav, 256, kMaxPathPerRequest);
+	cache->setTimer(benchTime);
+
+	dtPolyRef path[kMaxPathPerRequest];
+	for (int k = 0; k < 2; ++k)
+	{
+		const int64_t begin = NowNanos();
+		for (int i = 0; i < kRequestCount; ++i)
+		{
+			const dtPathRequest& r = requests[i];
+			int pathCount = 0;
+			if (k == 0)
+				b.query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, r.filter, path, &pathCount, kMaxPathPerRequest);
+			else
+				cache->findPath(b.query, r.startRef, r.endRef, r.startPos, r.endPos, r.filter, path, &pathCount, kMaxPathPerRequest);
+		}
+		const int64_t nanos = NowNanos() - begin;
+		printf("%-38s %10.0f paths/s\n", k == 0 ? "FindPath_Uncached:" : "FindPath_Cached:",
+			   (double)kRequestCount * 1e9 / (double)nanos);
+	}
+
+	const dtPathCacheStats& stats = cache->getStats();
+	printf("%-38s %8.1f %% hits %8.2f us/hit %8.2f us/miss\n", "FindPath_CacheStats:",
+		   100.0 * stats.hits / (stats.hits + stats.misses),
+		   stats.hits ? stats.hitTime / stats.hits / 1e3 : 0.0,
+		   stats.misses ? stats.missTime / stats.misses / 1e3 : 0.0);
+	dtFreePathCache(cache);
+}
+
+// Times the tile lookups of a navmesh of many small tiles, with its current lookup.
+static void reportTileLookup(const char* name, dtNavMesh* nav, int tiles)
+{
+	const dtNavMesh* cnav = nav;
+	const int loops = 2000;
+	int64_t begin = NowNanos();
+	int found = 0;
+	for (int k = 0; k < loops; ++k)
+	{
+		for (int y = 0; y < tiles; ++y)
+		{
+			for (int x = 0; x < tiles; ++x)
+			{
+				const dtMeshTile* tileList[4];
+				found += cnav->getTilesAt(x, y, tileList, 4);
+			}
+		}
+	}
+	const double tilesAtNanos = (double)(NowNanos() - begin) / ((double)loops * tiles * tiles);
+
+	// Wide queries, which look up the tiles of a large area.
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	query->init(nav, 2048);
+	dtQueryFilter filter;
+	const float halfExtents[3] = { 20.0f, 10.0f, 20.0f };
+	const int queryCount = 2000;
+	testRandomSeed() = 3;
+	std::vector<float> centers(queryCount * 3);
+	for (int i = 0; i < queryCount; ++i)
+	{
+		centers[i * 3 + 0] = testRandom() * tiles * nav->getParams()->tileWidth;
+		centers[i * 3 + 1] = 4.0f;
+		centers[i * 3 + 2] = testRandom() * tiles * nav->getParams()->tileHeight;
+	}
+	dtPolyRef polys[64];
+	begin = NowNanos();
+	for (int i = 0; i < queryCount; ++i)
+	{
+		int polyCount = 0;
+		query->queryPolygons(&centers[i * 3], halfExtents, &filter, polys, &polyCount, 64);
+		found += polyCount;
+	}
+	const double queryNanos = (double)(NowNanos() - begin) / queryCount;
+	dtFreeNavMeshQuery(query);
+
+	// Tiles removed and added back, which look up their neighbours. (With a copy of their data.)
+	const int reAddCount = 1000;
+	begin = NowNanos();
+	for (int i = 0; i < reAddCount; ++i)
+	{
+		const dtMeshTile* tile = cnav->getTileAt((i * 7) % tiles, (i * 13) % tiles, 0);
+		const int dataSize = tile->dataSize;
+		unsigned char* data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+		memcpy(data, tile->data, dataSize);
+		nav->removeTile(nav->getTileRef(tile), 0, 0);
+		nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0);
+	}
+	const double reAddNanos = (double)(NowNanos() - begin) / reAddCount;
+	DoNotOptimize(&found);
+
+	printf("%-38s %8.1f ns/getTilesAt %8.0f ns/queryPolygons %8.0f ns/tile re-add\n", name,
+		   tilesAtNanos, queryNanos, reAddNanos);
+}
+
+TEST_CASE("TileLookup")
+{
+	// Many small tiles.
+	const int tiles = 32;
+	rcContext ctx(false);
+	dtNavMesh* nav = buildTestNavMesh(&ctx, tiles, 16);
+	REQUIRE(nav);
+	reportTileLookup("TileLookup_Hash:", nav, tiles);
+	REQUIRE(nav->initTileGrid(0, 0, tiles, tiles) == DT_SUCCESS);
+	reportTileLookup("TileLookup_Grid:", nav, tiles);
+	dtFreeNavMesh(nav);
+}
+
+// Times the corners of agents moving along their paths, one call per polygon of the path,
+// as dtPathCorridor::findCorners does each frame.
+static double timeCorners(QueryBench& b, dtPortalCache* portals, int maxCorners)
+{
+	const int agentCount = 256;
+	float corners[16 * 3];
+	int calls = 0;
+	int found = 0;
+	const int64_t begin = NowNanos();
+	for (int i = 0; i < agentCount; ++i)
+	{
+		const dtPathRequest& r = b.requests[i];
+		const dtPolyRef* path = &b.path[i * kMaxPathPerRequest];
+		const int pathCount = b.results[i].pathCount;
+		const float* positions = &b.straightPath[i * kMaxPathPerRequest * 3];
+		for (int k = 0; k < pathCount; ++k)
+		{
+			int cornerCount = 0;
+			b.query->findStraightPath(&positions[k * 3], r.endPos, path + k, pathCount - k, portals,
+									  corners, 0, 0, &cornerCount, maxCorners);
+			found += cornerCount;
+			calls++;
+		}
+	}
+	const int64_t nanos = NowNanos() - begin;
+	DoNotOptimize(&found);
+	return (double)nanos / calls;
+}
+
+TEST_CASE("StraightPath_PortalCache")
+{
+	QueryBench& b = getQueryBench();
+	const int agentCount = 256;
+	for (int i = 0; i < agentCount; ++i)
+	{
+		const dtPathRequest& r = b.requests[i];
+		dtPolyRef* path = &b.path[i * kMaxPathPerRequest];
+		int pathCount = 0;
+		b.query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, r.filter, path, &pathCount, kMaxPathPerRequest);
+		b.results[i].pathCount = pathCount;
+		// A position of the agent in each polygon of its path.
+		for (int k = 0; k < pathCount; ++k)
+			b.query->closestPointOnPoly(path[k], r.startPos, &b.straightPath[(i * kMaxPathPerRequest + k) * 3], 0);
+	}
+
+	dtPortalCache* portals = dtAllocPortalCache();
+	REQUIRE(portals->init(kMaxPathPerRequest) == DT_SUCCESS);
+	const int cornerCounts[2] = { 4, 16 };
+	for (int j = 0; j < 2; ++j)
+	{
+		const double uncached = timeCorners(b, 0, cornerCounts[j]);
+		const double cached = timeCorners(b, portals, cornerCounts[j]);
+		printf("%-38s %8.0f ns/call uncached %8.0f ns/call cached\n",
+			   cornerCounts[j] == 4 ? "StraightPath_4Corners:" : "StraightPath_16Corners:", uncached, cached);
+	}
+	dtFreePortalCache(portals);
+}
+
+TEST_CASE("Raycast_Batch")
+{
+	QueryBench& b = getQueryBench();
+
+	// Line of sight checks of agents toward points around them, several from each agent.
+	const int rayCount = 8192;
+	const float range = 10.0f;
+	testRandomSeed() = 5;
+	std::vector<dtRaycastRequest> requests(rayCount);
+	for (int i = 0; i < rayCount; ++i)
+	{
+		dtRaycastRequest& r = requests[i];
+		const dtPathRequest& agent = b.requests[(i / 16) % kRequestCount];
+		r.startRef = agent.startRef;
+		dtVcopy(r.startPos, agent.startPos);
+		r.endPos[0] = r.startPos[0] + (testRandom() * 2.0f - 1.0f) * range;
+		r.endPos[1] = r.startPos[1];
+		r.endPos[2] = r.startPos[2] + (testRandom() * 2.0f - 1.0f) * range;
+		r.filter = &b.filter;
+		r.prevRef = 0;
+	}
+	std::vector<dtRaycastHit> hits(rayCount);
+	for (int i = 0; i < rayCount; ++i)
+	{
+		hits[i].path = 0;
+		hits[i].maxPath = 0;
+	}
+
+	const int loops = 10;
+	int64_t begin = NowNanos();
+	for (int k = 0; k < loops; ++k)
+	{
+		for (int i = 0; i < rayCount; ++i)
+		{
+			const dtRaycastRequest& r = requests[i];
+			b.query->raycast(r.startRef, r.startPos, r.endPos, r.filter, 0, &hits[i]);
+		}
+	}
+	const int64_t singleNanos = NowNanos() - begin;
+	DoNotOptimize(&hits[0]);
+
+	begin = NowNanos();
+	for (int k = 0; k < loops; ++k)
+		b.query->raycastBatch(&requests[0], rayCount, 0, &hits[0], 0);
+	const int64_t batchNanos = NowNanos() - begin;
+	DoNotOptimize(&hits[0]);
+
+	printf("%-38s %10.0f rays/s\n", "Raycast_Single:", (double)rayCount * loops * 1e9 / (double)singleNanos);
+	printf("%-38s %10.0f rays/s\n", "Raycast_Batch:", (double)rayCount * loops * 1e9 / (double)batchNanos);
+}
+
+TEST_CASE("DistanceToWall_Field")
+{
+	QueryBench& b = getQueryBench();
+
+	// Steering agents checking for walls within a large radius.
+	const float radius = 20.0f;
+	float hitDist, hitPos[3], hitNormal[3];
+	const int loops = 10;
+	int64_t begin = NowNanos();
+	for (int k = 0; k < loops; ++k)
+	{
+		for (int i = 0; i < kRequestCount; ++i)
+		{
+			const dtPathRequest& r = b.requests[i];
+			b.query->findDistanceToWall(r.startRef, r.startPos, radius, &b.filter, &hitDist, hitPos, hitNormal);
+		}
+	}
+	const int64_t searchNanos = NowNanos() - begin;
+	DoNotOptimize(hitPos);
+	printf("%-38s %10.0f queries/s\n", "DistanceToWall_Search:", (double)kRequestCount * loops * 1e9 / (double)searchNanos);
+
+	const float cellSizes[3] = { 0.5f, 2.0f, 8.0f };
+	for (int c = 0; c < 3; ++c)
+	{
+		dtNavMeshWallFieldParams params;
+		params.cellSize = cellSizes[c];
+		params.includeFlags = b.filter.getIncludeFlags();
+		params.excludeFlags = b.filter.getExcludeFlags();
+		dtNavMeshWallField* field = dtAllocNavMeshWallField();
+		const int64_t buildBegin = NowNanos();
+		field->build(b.query->getAttachedNavMesh(), &params);
+		const int64_t buildNanos = NowNanos() - buildBegin;
+
+		b.query->setWallField(field);
+		begin = NowNanos();
+		for (int k = 0; k < loops; ++k)
+		{
+			for (int i = 0; i < kRequestCount; ++i)
+			{
+				const dtPathRequest& r = b.requests[i];
+				b.query->findDistanceToWall(r.startRef, r.startPos, radius, &b.filter, &hitDist, hitPos, hitNormal);
+			}
+		}
+		const int64_t fieldNanos = NowNanos() - begin;
+		DoNotOptimize(hitPos);
+		b.query->setWallField(0);
+
+		char label[64];
+		snprintf(label, sizeof(label), "DistanceToWall_Field_%.1f:", cellSizes[c]);
+		printf("%-38s %10.0f queries/s %8d KB %8.1f ms build\n", label,
+			   (double)kRequestCount * loops * 1e9 / (double)fieldNanos,
+			   field->getMemoryUsed() / 1024, (double)buildNanos / 1e6);
+		dtFreeNavMeshWallField(field);
+	}
+}
+
+// The same paths with the filter called through findPath and through findPathT, which only
+// differ with DT_VIRTUAL_QUERYFILTER, where findPath calls the filter through its virtual table.
+TEST_CASE("FindPath_FilterDispatch")
+{
+	QueryBench& b = getQueryBench();
+	std::vector<dtPathRequest> requests(b.requests.begin(), b.requests.begin() + 512);
+
+	for (int t = 0; t < 2; ++t)
+	{
+		dtPolyRef path[kMaxPathPerRequest];
+		const int64_t begin = NowNanos();
+		for (int k = 0; k < kNumLoops; ++k)
+		{
+			for (size_t i = 0; i < requests.size(); ++i)
+			{
+				const dtPathRequest& r = requests[i];
+				int pathCount = 0;
+				if (t == 0)
+					b.query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, &b.filter, path, &pathCount, kMaxPathPerRequest);
+				else
+					b.query->findPathT(r.startRef, r.endRef, r.startPos, r.endPos, &b.filter, path, &pathCount, kMaxPathPerRequest);
+			}
+		}
+		const int64_t nanos = NowNanos() - begin;
+		DoNotOptimize(path);
+		printf("%-38s %10.0f paths/s\n", t == 0 ? "FindPath_Filter:" : "FindPathT_Filter:",
+			   (double)requests.size() * kNumLoops * 1e9 / (double)nanos);
+	}
+}
+
+#endif // RC_BENCHMARKS_ENABLED
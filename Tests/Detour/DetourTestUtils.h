@@ -0,0 +1,258 @@
+#ifndef DETOUR_TESTS_DETOURTESTUTILS_H
+#define DETOUR_TESTS_DETOURTESTUTILS_H
+
+#include <math.h>
+#include <string.h>
+
+#include "Recast.h"
+#include "DetourAlloc.h"
+#include "DetourCommon.h"
+#include "DetourNavMesh.h"
+#include "DetourNavMeshBuilder.h"
+#include "DetourNavMeshQuery.h"
+
+/// Height of the test terrain at a cell, in cell heights.
+inline int testTerrainHeight(int x, int z)
+{
+	return 20 + (int)(8.0f * sinf(x * 0.05f) * cosf(z * 0.07f));
+}
+
+/// Returns true if a cell of the test terrain is blocked: the terrain is cut into rooms by walls
+/// with doorways, with pillars scattered over it, so that paths have to wind between tiles.
+inline bool testRoomWalls(int x, int z)
+{
+	const bool wall = (x % 47 == 0 && z % 31 > 6) || (z % 53 == 0 && x % 29 > 5);
+	const bool pillar = (x % 13 < 2) && (z % 17 < 2);
+	return wall || pillar;
+}
+
+/// Returns true if a cell of the test terrain is blocked: a closed room in its middle.
+inline bool testClosedRoomWalls(int x, int z)
+{
+	const bool inRoom = x >= 40 && x < 72 && z >= 40 && z < 72;
+	const bool inside = x >= 42 && x < 70 && z >= 42 && z < 70;
+	return inRoom && !inside;
+}
+
+/// Gets the point on the test terrain at the middle of a cell.
+inline void testTerrainPoint(int x, int z, float* pt)
+{
+	pt[0] = (x + 0.5f) * 0.3f;
+	pt[1] = testTerrainHeight(x, z) * 0.2f;
+	pt[2] = (z + 0.5f) * 0.3f;
+}
+
+/// Off-mesh connections of a test navmesh.
+struct TestOffMeshConnections
+{
+	const float* verts;			///< Start and end points of the connections. [(ax, ay, az, bx, by, bz) * count]
+	const unsigned char* dirs;	///< Direction of the connections, DT_OFFMESH_CON_BIDIR or 0. [count]
+	int count;
+};
+
+/// Builds the navmesh of a tile of the test terrain, with the walls of @p isWall.
+inline bool buildTestNavMeshTile(rcContext* ctx, dtNavMesh* nav, int tx, int tz, int tileSize, int worldSize,
+								 bool (*isWall)(int x, int z), const TestOffMeshConnections* offMeshCons)
+{
+	const float cs = 0.3f;
+	const float ch = 0.2f;
+	const int walkableHeight = 10;
+	const int walkableClimb = 4;
+	const int walkableRadius = 2;
+	const int borderSize = walkableRadius + 3;
+	const int size = tileSize + borderSize * 2;
+
+	float bmin[3] = { (tx * tileSize - borderSize) * cs, 0.0f, (tz * tileSize - borderSize) * cs };
+	float bmax[3] = { bmin[0] + size * cs, 100.0f, bmin[2] + size * cs };
+
+	rcHeightfield hf;
+	if (!rcCreateHeightfield(ctx, hf, size, size, bmin, bmax, cs, ch))
+		return false;
+
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			const int gx = tx * tileSize - borderSize + x;
+			const int gz = tz * tileSize - borderSize + z;
+			if (gx < 0 || gz < 0 || gx >= worldSize || gz >= worldSize)
+				continue;
+			const int ground = testTerrainHeight(gx, gz);
+			if (isWall(gx, gz))
+				rcAddSpan(ctx, hf, x, z, 0, (unsigned short)(ground + 40), RC_NULL_AREA, 1);
+			else
+				rcAddSpan(ctx, hf, x, z, 0, (unsigned short)ground, RC_WALKABLE_AREA, 1);
+		}
+	}
+
+	rcCompactHeightfield chf;
+	if (!rcBuildCompactHeightfield(ctx, walkableHeight, walkableClimb, hf, chf) ||
+		!rcErodeWalkableArea(ctx, walkableRadius, chf) ||
+		!rcBuildDistanceField(ctx, chf) ||
+		!rcBuildRegions(ctx, chf, borderSize, 8, 20))
+	{
+		return false;
+	}
+
+	rcContourSet cset;
+	if (!rcBuildContours(ctx, chf, 1.3f, 12, cset))
+		return false;
+	rcPolyMesh pmesh;
+	if (!rcBuildPolyMesh(ctx, cset, 6, pmesh))
+		return false;
+	rcPolyMeshDetail dmesh;
+	if (!rcBuildPolyMeshDetail(ctx, pmesh, chf, cs * 6.0f, ch, dmesh))
+		return false;
+	if (pmesh.npolys == 0)
+		return true;
+
+	for (int i = 0; i < pmesh.npolys; ++i)
+		pmesh.flags[i] = 1;
+
+	// Each tile gets the connections which start in it.
+	const int maxCons = 16;
+	float conRads[maxCons];
+	unsigned char conAreas[maxCons];
+	unsigned short conFlags[maxCons];
+	unsigned int conIds[maxCons];
+	const int nCons = offMeshCons ? dtMin(offMeshCons->count, maxCons) : 0;
+	for (int i = 0; i < nCons; ++i)
+	{
+		conRads[i] = 0.6f;
+		conAreas[i] = RC_WALKABLE_AREA;
+		conFlags[i] = 1;
+		conIds[i] = 1000 + i;
+	}
+
+	dtNavMeshCreateParams params;
+	memset(&params, 0, sizeof(params));
+	params.verts = pmesh.verts;
+	params.vertCount = pmesh.nverts;
+	params.polys = pmesh.polys;
+	params.polyAreas = pmesh.areas;
+	params.polyFlags = pmesh.flags;
+	params.polyCount = pmesh.npolys;
+	params.nvp = pmesh.nvp;
+	params.detailMeshes = dmesh.meshes;
+	params.detailVerts = dmesh.verts;
+	params.detailVertsCount = dmesh.nverts;
+	params.detailTris = dmesh.tris;
+	params.detailTriCount = dmesh.ntris;
+	if (nCons > 0)
+	{
+		params.offMeshConVerts = offMeshCons->verts;
+		params.offMeshConRad = conRads;
+		params.offMeshConDir = offMeshCons->dirs;
+		params.offMeshConAreas = conAreas;
+		params.offMeshConFlags = conFlags;
+		params.offMeshConUserID = conIds;
+		params.offMeshConCount = nCons;
+	}
+	params.walkableHeight = walkableHeight * ch;
+	params.walkableRadius = walkableRadius * cs;
+	params.walkableClimb = walkableClimb * ch;
+	params.tileX = tx;
+	params.tileY = tz;
+	rcVcopy(params.bmin, pmesh.bmin);
+	rcVcopy(params.bmax, pmesh.bmax);
+	params.cs = cs;
+	params.ch = ch;
+	params.buildBvTree = true;
+
+	unsigned char* data = 0;
+	int dataSize = 0;
+	if (!dtCreateNavMeshData(&params, &data, &dataSize))
+		return false;
+	if (dtStatusFailed(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0)))
+	{
+		dtFree(data);
+		return false;
+	}
+	return true;
+}
+
+/// Builds a navmesh of @p tiles by @p tiles tiles of @p tileSize cells over the test terrain,
+/// with the walls of @p isWall and the optional off-mesh connections. Returns null if the build fails.
+inline dtNavMesh* buildTestNavMesh(rcContext* ctx, int tiles, int tileSize, bool (*isWall)(int x, int z) = testRoomWalls,
+								   const TestOffMeshConnections* offMeshCons = 0)
+{
+	const float cs = 0.3f;
+	const int tileBits = dtMin((int)dtIlog2(dtNextPow2(tiles * tiles)), 14);
+	const int polyBits = 22 - tileBits;
+
+	dtNavMeshParams params;
+	memset(&params, 0, sizeof(params));
+	params.tileWidth = tileSize * cs;
+	params.tileHeight = tileSize * cs;
+	params.maxTiles = 1 << tileBits;
+	params.maxPolys = 1 << polyBits;
+
+	dtNavMesh* nav = dtAllocNavMesh();
+	if (!nav || dtStatusFailed(nav->init(&params)))
+	{
+		dtFreeNavMesh(nav);
+		return 0;
+	}
+
+	for (int tz = 0; tz < tiles; ++tz)
+	{
+		for (int tx = 0; tx < tiles; ++tx)
+		{
+			if (!buildTestNavMeshTile(ctx, nav, tx, tz, tileSize, tiles * tileSize, isWall, offMeshCons))
+			{
+				dtFreeNavMesh(nav);
+				return 0;
+			}
+		}
+	}
+	return nav;
+}
+
+/// Returns true if each polygon of the path links to the next.
+inline bool isTestPathConnected(const dtNavMesh* nav, const dtPolyRef* path, int pathCount)
+{
+	for (int i = 0; i + 1 < pathCount; ++i)
+	{
+		const dtMeshTile* tile = 0;
+		const dtPoly* poly = 0;
+		if (dtStatusFailed(nav->getTileAndPolyByRef(path[i], &tile, &poly)))
+			return false;
+		bool linked = false;
+		for (unsigned int j = poly->firstLink; j != DT_NULL_LINK; j = tile->links[j].next)
+			linked = linked || tile->links[j].ref == path[i + 1];
+		if (!linked)
+			return false;
+	}
+	return true;
+}
+
+/// Returns the length of the straight path along a path.
+inline float getTestStraightPathLength(const dtNavMeshQuery* query, const float* startPos, const float* endPos,
+									   const dtPolyRef* path, int pathCount)
+{
+	const int maxStraightPath = 512;
+	float straightPath[maxStraightPath * 3];
+	int straightPathCount = 0;
+	query->findStraightPath(startPos, endPos, path, pathCount, straightPath, 0, 0, &straightPathCount, maxStraightPath);
+	float length = 0.0f;
+	for (int i = 0; i + 1 < straightPathCount; ++i)
+		length += dtVdist(&straightPath[i * 3], &straightPath[(i + 1) * 3]);
+	return length;
+}
+
+/// Seed of testRandom().
+inline unsigned int& testRandomSeed()
+{
+	static unsigned int seed = 1;
+	return seed;
+}
+
+/// Repeatable random number in [0, 1), for dtNavMeshQuery::findRandomPoint.
+inline float testRandom()
+{
+	unsigned int& seed = testRandomSeed();
+	seed = seed * 1103515245u + 12345u;
+	return (float)((seed >> 8) & 0xffff) / 65536.0f;
+}
+
+#endif  // DETOUR_TESTS_DETOURTESTUTILS_H
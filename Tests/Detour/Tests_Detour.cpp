@@ -1,5 +1,6 @@
 #include "catch2/catch_all.hpp"
 
+#include "DetourAlloc.h"
 #include "DetourCommon.h"
 
 TEST_CASE("dtRandomPointInConvexPoly")
@@ -31,3 +32,47 @@ TEST_CASE("dtRandomPointInConvexPoly")
 		REQUIRE(out[2] == Catch::Approx(0));
 	}
 }
+
+/// Counts the live bytes of each allocation hint.
+class CountingTracker : public dtAllocTracker
+{
+public:
+	CountingTracker() : permBytes(0), tempBytes(0), frees(0) {}
+
+	virtual void trackAlloc(void* ptr, size_t size, dtAllocHint hint)
+	{
+		(void)ptr;
+		(hint == DT_ALLOC_PERM ? permBytes : tempBytes) += size;
+		// Allocations made by the tracker itself are not tracked.
+		dtFree(dtAlloc(16, DT_ALLOC_TEMP));
+	}
+
+	virtual void trackFree(void* ptr)
+	{
+		(void)ptr;
+		frees++;
+	}
+
+	size_t permBytes;
+	size_t tempBytes;
+	int frees;
+};
+
+TEST_CASE("dtAllocSetThreadTracker")
+{
+	CountingTracker tracker;
+	REQUIRE(dtAllocSetThreadTracker(&tracker) == 0);
+
+	void* perm = dtAlloc(64, DT_ALLOC_PERM);
+	void* temp = dtAlloc(32, DT_ALLOC_TEMP);
+	dtFree(temp);
+	dtFree(perm);
+
+	REQUIRE(dtAllocSetThreadTracker(0) == &tracker);
+	REQUIRE(tracker.permBytes == 64);
+	REQUIRE(tracker.tempBytes == 32);
+	REQUIRE(tracker.frees == 2);
+
+	dtFree(dtAlloc(8, DT_ALLOC_PERM));
+	REQUIRE(tracker.permBytes == 64);
+}
@@ -0,0 +1,204 @@
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourNode.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+const int kMaxPath = 512;
+
+// Checks that findPathT finds the path findPath finds.
+void checkSamePath(const dtNavMeshQuery* query, dtPolyRef startRef, dtPolyRef endRef,
+				   const float* startPos, const float* endPos, const dtQueryFilter* filter, int maxPath)
+{
+	dtPolyRef path[kMaxPath];
+	int pathCount = 0;
+	const dtStatus status = query->findPath(startRef, endRef, startPos, endPos, filter, path, &pathCount, maxPath);
+	dtPolyRef templatePath[kMaxPath];
+	int templatePathCount = 0;
+	const dtStatus templateStatus = query->findPathT(startRef, endRef, startPos, endPos, filter,
+													 templatePath, &templatePathCount, maxPath);
+	REQUIRE(templateStatus == status);
+	REQUIRE(templatePathCount == pathCount);
+	REQUIRE(memcmp(templatePath, path, sizeof(dtPolyRef) * pathCount) == 0);
+}
+}
+
+TEST_CASE("dtNavMeshQuery::findPath bidirectional")
+{
+	rcContext ctx(false);
+	dtQueryFilter filter;
+
+	SECTION("Finds paths as short as the forward search")
+	{
+		dtNavMesh* nav = buildTestNavMesh(&ctx, 4, 48);
+		REQUIRE(nav);
+		dtNavMeshQuery* query = dtAllocNavMeshQuery();
+		REQUIRE(dtStatusSucceed(query->init(nav, 4096)));
+
+		testRandomSeed() = 17;
+		float forwardLength = 0.0f;
+		float bidirectionalLength = 0.0f;
+		for (int i = 0; i < 64; ++i)
+		{
+			dtPolyRef startRef, endRef;
+			float startPos[3], endPos[3];
+			query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+			query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+
+			dtPolyRef path[kMaxPath];
+			int pathCount = 0;
+			const dtStatus status = query->findPath(startRef, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath);
+			dtPolyRef bidirectionalPath[kMaxPath];
+			int bidirectionalPathCount = 0;
+			const dtStatus bidirectionalStatus = query->findPath(startRef, endRef, startPos, endPos, &filter,
+				bidirectionalPath, &bidirectionalPathCount, kMaxPath, DT_FINDPATH_BIDIRECTIONAL);
+
+			REQUIRE(bidirectionalStatus == status);
+			REQUIRE(bidirectionalPath[0] == startRef);
+			REQUIRE(bidirectionalPath[bidirectionalPathCount - 1] == endRef);
+			REQUIRE(isTestPathConnected(nav, bidirectionalPath, bidirectionalPathCount));
+
+			forwardLength += getTestStraightPathLength(query, startPos, endPos, path, pathCount);
+			bidirectionalLength += getTestStraightPathLength(query, startPos, endPos, bidirectionalPath, bidirectionalPathCount);
+		}
+		// Both searches place the nodes at the first edge they reach a polygon through,
+		// which makes the costs approximate, the paths differ but are as short overall.
+		REQUIRE(bidirectionalLength == Catch::Approx(forwardLength).epsilon(0.02));
+
+		dtFreeNavMeshQuery(query);
+		dtFreeNavMesh(nav);
+	}
+
+	SECTION("Follows one way off-mesh connections")
+	{
+		float conVerts[6];
+		testTerrainPoint(30, 56, &conVerts[0]);
+		testTerrainPoint(56, 56, &conVerts[3]);
+		const unsigned char conDirs[1] = { 0 };
+		TestOffMeshConnections cons = { conVerts, conDirs, 1 };
+		dtNavMesh* nav = buildTestNavMesh(&ctx, 3, 32, testClosedRoomWalls, &cons);
+		REQUIRE(nav);
+		dtNavMeshQuery* query = dtAllocNavMeshQuery();
+		REQUIRE(dtStatusSucceed(query->init(nav, 2048)));
+		// Only the bidirectional queries get the nodes of the backward search.
+		REQUIRE(query->getReverseNodePool() == 0);
+
+		const float extents[3] = { 1.0f, 2.0f, 1.0f };
+		float outsidePos[3], insidePos[3];
+		testTerrainPoint(8, 80, outsidePos);
+		testTerrainPoint(64, 48, insidePos);
+		dtPolyRef outsideRef = 0, insideRef = 0;
+		query->findNearestPoly(outsidePos, extents, &filter, &outsideRef, outsidePos);
+		query->findNearestPoly(insidePos, extents, &filter, &insideRef, insidePos);
+		REQUIRE(outsideRef);
+		REQUIRE(insideRef);
+
+		dtPolyRef path[kMaxPath];
+		int pathCount = 0;
+		dtStatus status = query->findPath(outsideRef, insideRef, outsidePos, insidePos, &filter,
+										  path, &pathCount, kMaxPath, DT_FINDPATH_BIDIRECTIONAL);
+		REQUIRE(status == DT_SUCCESS);
+		REQUIRE(query->getReverseNodePool() != 0);
+		REQUIRE(query->getReverseNodePool()->getMaxNodes() == 2048);
+		REQUIRE(path[pathCount - 1] == insideRef);
+		REQUIRE(isTestPathConnected(nav, path, pathCount));
+		bool usesConnection = false;
+		for (int i = 0; i < pathCount; ++i)
+			usesConnection = usesConnection || nav->getOffMeshConnectionByRef(path[i]) != 0;
+		REQUIRE(usesConnection);
+
+		// There is no way back out.
+		status = query->findPath(insideRef, outsideRef, insidePos, outsidePos, &filter,
+								 path, &pathCount, kMaxPath, DT_FINDPATH_BIDIRECTIONAL);
+		REQUIRE(dtStatusSucceed(status));
+		REQUIRE(dtStatusDetail(status, DT_PARTIAL_RESULT));
+		REQUIRE(path[0] == insideRef);
+		REQUIRE(path[pathCount - 1] != outsideRef);
+
+		// The path is filled from the start when it does not fit.
+		status = query->findPath(outsideRef, insideRef, outsidePos, insidePos, &filter,
+								 path, &pathCount, kMaxPath, DT_FINDPATH_BIDIRECTIONAL);
+		REQUIRE(pathCount > 3);
+		dtPolyRef shortPath[3];
+		int shortPathCount = 0;
+		status = query->findPath(outsideRef, insideRef, outsidePos, insidePos, &filter,
+								 shortPath, &shortPathCount, 3, DT_FINDPATH_BIDIRECTIONAL);
+		REQUIRE(status == (DT_SUCCESS | DT_BUFFER_TOO_SMALL));
+		REQUIRE(shortPathCount == 3);
+		REQUIRE(memcmp(shortPath, path, sizeof(shortPath)) == 0);
+
+		// A larger init gets larger nodes for the backward search on its next query.
+		REQUIRE(dtStatusSucceed(query->init(nav, 4096)));
+		REQUIRE(query->getReverseNodePool() == 0);
+		status = query->findPath(outsideRef, insideRef, outsidePos, insidePos, &filter,
+								 path, &pathCount, kMaxPath, DT_FINDPATH_BIDIRECTIONAL);
+		REQUIRE(status == DT_SUCCESS);
+		REQUIRE(query->getReverseNodePool()->getMaxNodes() == 4096);
+
+		dtFreeNavMeshQuery(query);
+		dtFreeNavMesh(nav);
+	}
+}
+
+TEST_CASE("dtNavMeshQuery::findPathT")
+{
+	rcContext ctx(false);
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 4, 48);
+	REQUIRE(nav);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	REQUIRE(dtStatusSucceed(query->init(nav, 4096)));
+	dtQueryFilter filter;
+
+	// Some polygons of another area to avoid.
+	for (int i = 0; i < nav->getMaxTiles(); ++i)
+	{
+		const dtMeshTile* tile = ((const dtNavMesh*)nav)->getTile(i);
+		if (!tile->header)
+			continue;
+		for (int j = 0; j < tile->header->polyCount; j += 4)
+			nav->setPolyArea(nav->getPolyRefBase(tile) | (dtPolyRef)j, 2);
+	}
+
+	testRandomSeed() = 23;
+	dtPolyRef startRef, endRef;
+	float startPos[3], endPos[3];
+	query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+	query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+
+	SECTION("Checks its parameters")
+	{
+		dtPolyRef path[kMaxPath];
+		int pathCount = 0;
+		REQUIRE(query->findPathT(startRef, endRef, startPos, endPos, &filter, path, 0, kMaxPath) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(query->findPathT(0, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(query->findPathT(startRef, endRef, startPos, endPos, (const dtQueryFilter*)0, path, &pathCount, kMaxPath) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(query->findPathT(startRef, endRef, startPos, endPos, &filter, path, &pathCount, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(query->findPathT(startRef, startRef, startPos, startPos, &filter, path, &pathCount, kMaxPath) == DT_SUCCESS);
+		REQUIRE(pathCount == 1);
+		REQUIRE(path[0] == startRef);
+	}
+
+	SECTION("Finds the paths of findPath")
+	{
+		dtQueryFilter avoidFilter;
+		avoidFilter.setIncludeFlags(1);
+		avoidFilter.setAreaCost(2, 4.0f);
+
+		for (int i = 0; i < 64; ++i)
+		{
+			query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+			query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+			checkSamePath(query, startRef, endRef, startPos, endPos, &filter, kMaxPath);
+			checkSamePath(query, startRef, endRef, startPos, endPos, &avoidFilter, kMaxPath);
+			checkSamePath(query, startRef, endRef, startPos, endPos, &avoidFilter, 4);
+		}
+	}
+
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
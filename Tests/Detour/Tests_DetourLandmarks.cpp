@@ -0,0 +1,276 @@
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshLandmarks.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourNode.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+const int kMaxPath = 512;
+const int kTiles = 4;
+const int kTileSize = 48;
+
+// Gets the distance ranges of all the polygons, in tile grid order.
+std::vector<unsigned short> getAllBounds(const dtNavMesh* nav, const dtNavMeshLandmarks* landmarks)
+{
+	std::vector<unsigned short> all;
+	const int count = landmarks->getParams()->landmarkCount;
+	for (int y = 0; y < kTiles; ++y)
+	{
+		for (int x = 0; x < kTiles; ++x)
+		{
+			const dtMeshTile* tile = nav->getTileAt(x, y, 0);
+			if (!tile)
+				continue;
+			const dtPolyRef base = nav->getPolyRefBase(tile);
+			for (int i = 0; i < tile->header->polyCount; ++i)
+			{
+				const unsigned short* bounds = landmarks->getPolyBounds(base | (dtPolyRef)i);
+				REQUIRE(bounds);
+				all.insert(all.end(), bounds, bounds + count * 2);
+			}
+		}
+	}
+	return all;
+}
+
+// Removes a tile from the navmesh and returns a copy of its data, which the navmesh frees.
+void removeTestTile(dtNavMesh* nav, dtTileRef ref, unsigned char** data, int* dataSize)
+{
+	const dtMeshTile* tile = nav->getTileByRef(ref);
+	REQUIRE(tile);
+	*dataSize = tile->dataSize;
+	*data = (unsigned char*)dtAlloc(*dataSize, DT_ALLOC_PERM);
+	memcpy(*data, tile->data, *dataSize);
+	REQUIRE(dtStatusSucceed(nav->removeTile(ref, 0, 0)));
+}
+
+// Gets the cost of the path the last findPath call found to a polygon.
+float getPathCost(const dtNavMeshQuery* query, dtPolyRef endRef)
+{
+	dtNode* nodes[DT_MAX_STATES_PER_NODE];
+	const int count = (int)query->getNodePool()->findNodes(endRef, nodes, DT_MAX_STATES_PER_NODE);
+	REQUIRE(count > 0);
+	float cost = nodes[0]->total;
+	for (int i = 1; i < count; ++i)
+		cost = dtMin(cost, nodes[i]->total);
+	return cost;
+}
+
+// Checks that the landmark bound between random points is never longer than the cost findPath finds between them.
+void checkBoundsArePathLowerBounds(dtNavMeshQuery* query, const dtNavMeshLandmarks* landmarks, unsigned int seed)
+{
+	dtQueryFilter filter;
+	testRandomSeed() = seed;
+	query->setLandmarks(0);
+	int bounded = 0;
+	for (int i = 0; i < 128; ++i)
+	{
+		dtPolyRef startRef, endRef;
+		float startPos[3], endPos[3];
+		query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+		query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+
+		dtPolyRef path[kMaxPath];
+		int pathCount = 0;
+		const dtStatus status = query->findPath(startRef, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath);
+		if (status != DT_SUCCESS || startRef == endRef || path[pathCount - 1] != endRef)
+			continue;
+		const float cost = getPathCost(query, endRef);
+		const float bound = landmarks->getDistanceBound(landmarks->getPolyBounds(startRef), landmarks->getPolyBounds(endRef));
+		REQUIRE(bound <= cost + 0.01f);
+		if (bound > dtVdist(startPos, endPos))
+			bounded++;
+	}
+	// The bound is better than the straight line for some of the paths.
+	REQUIRE(bounded > 0);
+}
+}
+
+TEST_CASE("dtNavMeshLandmarks")
+{
+	rcContext ctx(false);
+	dtQueryFilter filter;
+
+	dtNavMesh* nav = buildTestNavMesh(&ctx, kTiles, kTileSize);
+	REQUIRE(nav);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	REQUIRE(dtStatusSucceed(query->init(nav, 4096)));
+	dtNavMeshLandmarks* landmarks = dtAllocNavMeshLandmarks();
+	REQUIRE(landmarks);
+
+	SECTION("Checks its parameters")
+	{
+		REQUIRE(landmarks->build(0, 8) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(landmarks->build(nav, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(landmarks->build(nav, DT_MAX_LANDMARKS + 1) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(landmarks->getPolyBounds(nav->getPolyRefBase(nav->getTileAt(0, 0, 0))) == 0);
+	}
+
+	SECTION("Bound the path length and make findPath visit fewer nodes")
+	{
+		REQUIRE(landmarks->build(nav, 8) == DT_SUCCESS);
+		checkBoundsArePathLowerBounds(query, landmarks, 5);
+
+		testRandomSeed() = 9;
+		float length = 0.0f;
+		float landmarkLength = 0.0f;
+		int nodes = 0;
+		int landmarkNodes = 0;
+		for (int i = 0; i < 64; ++i)
+		{
+			dtPolyRef startRef, endRef;
+			float startPos[3], endPos[3];
+			query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+			query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+
+			dtPolyRef path[kMaxPath];
+			int pathCount = 0;
+			query->setLandmarks(0);
+			const dtStatus status = query->findPath(startRef, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath);
+			nodes += query->getNodePool()->getNodeCount();
+			length += getTestStraightPathLength(query, startPos, endPos, path, pathCount);
+
+			query->setLandmarks(landmarks);
+			const dtStatus landmarkStatus = query->findPath(startRef, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath);
+			landmarkNodes += query->getNodePool()->getNodeCount();
+			landmarkLength += getTestStraightPathLength(query, startPos, endPos, path, pathCount);
+
+			REQUIRE(landmarkStatus == status);
+			REQUIRE(path[0] == startRef);
+			REQUIRE(isTestPathConnected(nav, path, pathCount));
+		}
+		// The costs of the nodes are approximate, so the paths may differ, but not their overall length.
+		REQUIRE(landmarkLength == Catch::Approx(length).epsilon(0.02));
+		REQUIRE(landmarkNodes < nodes);
+
+		// The sliced query uses them too.
+		testRandomSeed() = 11;
+		nodes = 0;
+		landmarkNodes = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			dtPolyRef startRef, endRef;
+			float startPos[3], endPos[3];
+			query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+			query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+
+			dtPolyRef path[kMaxPath];
+			int pathCount = 0;
+			query->setLandmarks(0);
+			query->initSlicedFindPath(startRef, endRef, startPos, endPos, &filter);
+			while (query->updateSlicedFindPath(8, 0) == DT_IN_PROGRESS) {}
+			query->finalizeSlicedFindPath(path, &pathCount, kMaxPath);
+			const dtPolyRef lastRef = path[pathCount - 1];
+			nodes += query->getNodePool()->getNodeCount();
+
+			query->setLandmarks(landmarks);
+			query->initSlicedFindPath(startRef, endRef, startPos, endPos, &filter);
+			while (query->updateSlicedFindPath(8, 0) == DT_IN_PROGRESS) {}
+			query->finalizeSlicedFindPath(path, &pathCount, kMaxPath);
+			landmarkNodes += query->getNodePool()->getNodeCount();
+			REQUIRE(path[pathCount - 1] == lastRef);
+			REQUIRE(isTestPathConnected(nav, path, pathCount));
+		}
+		REQUIRE(landmarkNodes < nodes);
+	}
+
+	SECTION("Are updated when tiles are removed and added")
+	{
+		// Add the tile after the landmarks are built, paths then go through it.
+		unsigned char* data = 0;
+		int dataSize = 0;
+		removeTestTile(nav, nav->getTileRefAt(1, 1, 0), &data, &dataSize);
+		REQUIRE(landmarks->build(nav, 8) == DT_SUCCESS);
+		dtTileRef ref = 0;
+		REQUIRE(dtStatusSucceed(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, &ref)));
+		REQUIRE(landmarks->addTile(ref) == DT_SUCCESS);
+		checkBoundsArePathLowerBounds(query, landmarks, 7);
+
+		// Replacing a tile by the same one gives back the same distances.
+		const std::vector<unsigned short> bounds = getAllBounds(nav, landmarks);
+		for (int i = 0; i < kTiles * kTiles; ++i)
+		{
+			const dtTileRef tileRef = nav->getTileRefAt(i % kTiles, i / kTiles, 0);
+			removeTestTile(nav, tileRef, &data, &dataSize);
+			REQUIRE(landmarks->removeTile(tileRef) == DT_SUCCESS);
+			REQUIRE(landmarks->removeTile(tileRef) == (DT_FAILURE | DT_INVALID_PARAM));
+			REQUIRE(dtStatusSucceed(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, &ref)));
+			REQUIRE(landmarks->addTile(ref) == DT_SUCCESS);
+		}
+		REQUIRE(getAllBounds(nav, landmarks) == bounds);
+	}
+
+	SECTION("Are stored and restored")
+	{
+		REQUIRE(landmarks->build(nav, 8) == DT_SUCCESS);
+		dtNavMeshLandmarks* restored = dtAllocNavMeshLandmarks();
+		REQUIRE(restored->init(nav, landmarks->getParams()) == DT_SUCCESS);
+		for (int i = 0; i < kTiles * kTiles; ++i)
+		{
+			const dtMeshTile* tile = nav->getTileAt(i % kTiles, i / kTiles, 0);
+			const int size = landmarks->getTileLandmarksSize(tile);
+			std::vector<unsigned char> data(size);
+			REQUIRE(landmarks->storeTileLandmarks(tile, &data[0], size - 1) == (DT_FAILURE | DT_BUFFER_TOO_SMALL));
+			REQUIRE(landmarks->storeTileLandmarks(tile, &data[0], size) == DT_SUCCESS);
+			REQUIRE(restored->restoreTileLandmarks(tile, &data[0], size) == DT_SUCCESS);
+		}
+		REQUIRE(getAllBounds(nav, restored) == getAllBounds(nav, landmarks));
+		dtFreeNavMeshLandmarks(restored);
+	}
+
+	dtFreeNavMeshLandmarks(landmarks);
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
+
+TEST_CASE("dtNavMeshLandmarks one way off-mesh connections")
+{
+	rcContext ctx(false);
+	dtQueryFilter filter;
+
+	float conVerts[6];
+	testTerrainPoint(30, 56, &conVerts[0]);
+	testTerrainPoint(56, 56, &conVerts[3]);
+	const unsigned char conDirs[1] = { 0 };
+	TestOffMeshConnections cons = { conVerts, conDirs, 1 };
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 3, 32, testClosedRoomWalls, &cons);
+	REQUIRE(nav);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	REQUIRE(dtStatusSucceed(query->init(nav, 2048)));
+	dtNavMeshLandmarks* landmarks = dtAllocNavMeshLandmarks();
+	REQUIRE(landmarks->build(nav, 4) == DT_SUCCESS);
+	query->setLandmarks(landmarks);
+
+	const float extents[3] = { 1.0f, 2.0f, 1.0f };
+	float outsidePos[3], insidePos[3];
+	testTerrainPoint(8, 80, outsidePos);
+	testTerrainPoint(64, 48, insidePos);
+	dtPolyRef outsideRef = 0, insideRef = 0;
+	query->findNearestPoly(outsidePos, extents, &filter, &outsideRef, outsidePos);
+	query->findNearestPoly(insidePos, extents, &filter, &insideRef, insidePos);
+	REQUIRE(outsideRef);
+	REQUIRE(insideRef);
+
+	// The room is only reachable through the connection.
+	dtPolyRef path[kMaxPath];
+	int pathCount = 0;
+	dtStatus status = query->findPath(outsideRef, insideRef, outsidePos, insidePos, &filter, path, &pathCount, kMaxPath);
+	REQUIRE(status == DT_SUCCESS);
+	REQUIRE(path[pathCount - 1] == insideRef);
+	REQUIRE(isTestPathConnected(nav, path, pathCount));
+	const float cost = getPathCost(query, insideRef);
+	const float bound = landmarks->getDistanceBound(landmarks->getPolyBounds(outsideRef), landmarks->getPolyBounds(insideRef));
+	REQUIRE(bound <= cost + 0.01f);
+
+	status = query->findPath(insideRef, outsideRef, insidePos, outsidePos, &filter, path, &pathCount, kMaxPath);
+	REQUIRE(dtStatusDetail(status, DT_PARTIAL_RESULT));
+
+	dtFreeNavMeshLandmarks(landmarks);
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
@@ -0,0 +1,238 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+const int kTiles = 3;
+const int kTileSize = 48;
+const int kMaxPath = 256;
+
+// Removes a tile owning its data, and returns a copy of the data to add it back.
+void removeTestTile(dtNavMesh* nav, dtTileRef ref, unsigned char** data, int* dataSize)
+{
+	const dtMeshTile* tile = nav->getTileByRef(ref);
+	REQUIRE(tile);
+	*dataSize = tile->dataSize;
+	*data = (unsigned char*)dtAlloc(*dataSize, DT_ALLOC_PERM);
+	memcpy(*data, tile->data, *dataSize);
+	REQUIRE(nav->removeTile(ref, 0, 0) == DT_SUCCESS);
+}
+
+// Returns the number of links of the tiles in the lookup to a tile index.
+int countLinksTo(const dtNavMesh* nav, unsigned int tileIndex)
+{
+	int n = 0;
+	for (int y = 0; y < kTiles; ++y)
+	{
+		for (int x = 0; x < kTiles; ++x)
+		{
+			const dtMeshTile* tile = nav->getTileAt(x, y, 0);
+			if (!tile)
+				continue;
+			for (int i = 0; i < tile->header->polyCount; ++i)
+			{
+				for (unsigned int j = tile->polys[i].firstLink; j != DT_NULL_LINK; j = tile->links[j].next)
+				{
+					if (nav->decodePolyIdTile(tile->links[j].ref) == tileIndex)
+						n++;
+				}
+			}
+		}
+	}
+	return n;
+}
+
+// Gets a tile by index, including the removed tiles kept for the readers.
+const dtMeshTile* getTestTile(const dtNavMesh* nav, unsigned int tileIndex)
+{
+	return nav->getTile((int)tileIndex);
+}
+
+thread_local unsigned int threadSeed = 1;
+
+float threadRandom()
+{
+	threadSeed = threadSeed * 1103515245u + 12345u;
+	return (float)((threadSeed >> 8) & 0xffff) / 65536.0f;
+}
+}
+
+TEST_CASE("dtNavMesh readers")
+{
+	rcContext ctx(false);
+	dtNavMesh* nav = buildTestNavMesh(&ctx, kTiles, kTileSize);
+	REQUIRE(nav);
+
+	SECTION("Checks its parameters")
+	{
+		REQUIRE(nav->initReaders(0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(nav->initReaders(2) == DT_SUCCESS);
+		const dtTileRef ref = nav->getTileRefAt(1, 1, 0);
+		const unsigned int tileIndex = nav->decodePolyIdTile((dtPolyRef)ref);
+		nav->beginRead(0);
+		REQUIRE(nav->removeTile(ref, 0, 0) == DT_SUCCESS);
+		// A removed tile can't be removed again.
+		REQUIRE(nav->removeTile(ref, 0, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		// Nor with the reference of the tile kept for the reader.
+		REQUIRE(nav->removeTile(nav->getTileRef(getTestTile(nav, tileIndex)), 0, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		nav->endRead(0);
+		REQUIRE(nav->reclaim() == 0);
+	}
+
+	SECTION("Frees removed tiles at once when nobody reads")
+	{
+		REQUIRE(nav->initReaders(2) == DT_SUCCESS);
+		const dtTileRef ref = nav->getTileRefAt(1, 1, 0);
+		const unsigned int tileIndex = nav->decodePolyIdTile((dtPolyRef)ref);
+		REQUIRE(countLinksTo(nav, tileIndex) > 0);
+
+		unsigned char* data = 0;
+		int dataSize = 0;
+		removeTestTile(nav, ref, &data, &dataSize);
+		REQUIRE(nav->reclaim() == 0);
+		REQUIRE(getTestTile(nav, tileIndex)->header == 0);
+		REQUIRE(countLinksTo(nav, tileIndex) == 0);
+
+		dtTileRef newRef = 0;
+		REQUIRE(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, &newRef) == DT_SUCCESS);
+		REQUIRE(countLinksTo(nav, nav->decodePolyIdTile((dtPolyRef)newRef)) > 0);
+	}
+
+	SECTION("Keeps removed tiles until the readers which may see them are done")
+	{
+		REQUIRE(nav->initReaders(2) == DT_SUCCESS);
+		const dtTileRef ref = nav->getTileRefAt(1, 1, 0);
+		const unsigned int tileIndex = nav->decodePolyIdTile((dtPolyRef)ref);
+		const dtPolyRef polyRef = nav->getPolyRefBase(nav->getTileByRef(ref));
+		REQUIRE(nav->isValidPolyRef(polyRef));
+
+		nav->beginRead(0);
+		unsigned char* data = 0;
+		int dataSize = 0;
+		removeTestTile(nav, ref, &data, &dataSize);
+
+		// Gone for new reads, but its memory is still there.
+		REQUIRE(!nav->isValidPolyRef(polyRef));
+		REQUIRE(nav->getTileRefAt(1, 1, 0) == 0);
+		REQUIRE(countLinksTo(nav, tileIndex) == 0);
+		const dtMeshTile* tile = getTestTile(nav, tileIndex);
+		REQUIRE(tile->header);
+		REQUIRE(tile->polys[0].vertCount > 0);
+		const int kept = nav->reclaim();
+		REQUIRE(kept > 1);
+
+		// Adding the tile back while it is kept takes another slot.
+		dtTileRef newRef = 0;
+		REQUIRE(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, &newRef) == DT_SUCCESS);
+		REQUIRE(nav->decodePolyIdTile((dtPolyRef)newRef) != tileIndex);
+		REQUIRE(nav->getTileRefAt(1, 1, 0) == newRef);
+
+		// A reader which began after the removal doesn't keep it.
+		nav->beginRead(1);
+		REQUIRE(nav->reclaim() == kept);
+		nav->endRead(0);
+		REQUIRE(nav->reclaim() == 0);
+		nav->endRead(1);
+		REQUIRE(tile->header == 0);
+	}
+
+	SECTION("Queries run while tiles are added and removed")
+	{
+		const int kReaders = 3;
+		REQUIRE(nav->initReaders(kReaders) == DT_SUCCESS);
+
+		std::atomic<bool> stop(false);
+		std::atomic<int> queries(0);
+		std::atomic<int> badLinks(0);
+		std::vector<std::thread> readers;
+		for (int r = 0; r < kReaders; ++r)
+		{
+			readers.push_back(std::thread([&, r]() {
+				threadSeed = 17 + r;
+				dtNavMeshQuery* query = dtAllocNavMeshQuery();
+				query->init(nav, 2048);
+				dtQueryFilter filter;
+				dtPolyRef path[kMaxPath];
+				while (!stop)
+				{
+					nav->beginRead(r);
+					dtPolyRef startRef, endRef;
+					float startPos[3], endPos[3];
+					int pathCount = 0;
+					if (dtStatusSucceed(query->findRandomPoint(&filter, threadRandom, &startRef, startPos)) &&
+						dtStatusSucceed(query->findRandomPoint(&filter, threadRandom, &endRef, endPos)))
+					{
+						query->findPath(startRef, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath);
+						// Walk the links of the path, which may lead into removed tiles.
+						for (int i = 0; i < pathCount; ++i)
+						{
+							const dtMeshTile* tile = 0;
+							const dtPoly* poly = 0;
+							nav->getTileAndPolyByRefUnsafe(path[i], &tile, &poly);
+							for (unsigned int j = poly->firstLink; j != DT_NULL_LINK; j = tile->links[j].next)
+							{
+								const dtMeshTile* neiTile = 0;
+								const dtPoly* neiPoly = 0;
+								nav->getTileAndPolyByRefUnsafe(tile->links[j].ref, &neiTile, &neiPoly);
+								if (neiPoly->vertCount < 3)
+									badLinks++;
+							}
+						}
+					}
+					nav->endRead(r);
+					queries++;
+				}
+				dtFreeNavMeshQuery(query);
+			}));
+		}
+
+		testRandomSeed() = 5;
+		for (int i = 0; i < 200; ++i)
+		{
+			const int x = (int)(testRandom() * kTiles);
+			const int y = (int)(testRandom() * kTiles);
+			unsigned char* data = 0;
+			int dataSize = 0;
+			removeTestTile(nav, nav->getTileRefAt(x, y, 0), &data, &dataSize);
+			// All the free tiles may be kept for the readers, wait for them.
+			dtStatus status;
+			while ((status = nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0)) == (DT_FAILURE | DT_OUT_OF_MEMORY))
+				std::this_thread::yield();
+			REQUIRE(status == DT_SUCCESS);
+		}
+		stop = true;
+		for (size_t r = 0; r < readers.size(); ++r)
+			readers[r].join();
+
+		REQUIRE(queries > 0);
+		REQUIRE(badLinks == 0);
+		REQUIRE(nav->reclaim() == 0);
+
+		// Back to the mesh it was.
+		dtNavMeshQuery* query = dtAllocNavMeshQuery();
+		REQUIRE(query->init(nav, 2048) == DT_SUCCESS);
+		dtQueryFilter filter;
+		testRandomSeed() = 9;
+		for (int i = 0; i < 32; ++i)
+		{
+			dtPolyRef startRef, endRef;
+			float startPos[3], endPos[3];
+			query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+			query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+			dtPolyRef path[kMaxPath];
+			int pathCount = 0;
+			REQUIRE(dtStatusSucceed(query->findPath(startRef, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath)));
+			REQUIRE(isTestPathConnected(nav, path, pathCount));
+		}
+		dtFreeNavMeshQuery(query);
+	}
+
+	dtFreeNavMesh(nav);
+}
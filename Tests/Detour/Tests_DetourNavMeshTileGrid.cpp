@@ -0,0 +1,157 @@
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+const int kTiles = 4;
+const int kTileSize = 32;
+const int kMaxPath = 256;
+
+// Removes a tile owning its data and adds it back.
+void reAddTestTile(dtNavMesh* nav, int x, int y)
+{
+	const dtMeshTile* tile = nav->getTileAt(x, y, 0);
+	REQUIRE(tile);
+	const int dataSize = tile->dataSize;
+	unsigned char* data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+	memcpy(data, tile->data, dataSize);
+	REQUIRE(nav->removeTile(nav->getTileRef(tile), 0, 0) == DT_SUCCESS);
+	REQUIRE(nav->getTileAt(x, y, 0) == 0);
+	REQUIRE(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0) == DT_SUCCESS);
+}
+
+// Adds a copy of the first layer of a location as another layer.
+void addTestTileLayer(dtNavMesh* nav, int x, int y, int layer)
+{
+	const dtMeshTile* tile = nav->getTileAt(x, y, 0);
+	REQUIRE(tile);
+	const int dataSize = tile->dataSize;
+	unsigned char* data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+	memcpy(data, tile->data, dataSize);
+	((dtMeshHeader*)data)->layer = layer;
+	REQUIRE(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0) == DT_SUCCESS);
+}
+
+// Checks that two navmeshes with the same tiles find the same tiles at each location.
+void checkSameTiles(const dtNavMesh* a, const dtNavMesh* b)
+{
+	for (int y = -1; y <= kTiles; ++y)
+	{
+		for (int x = -1; x <= kTiles; ++x)
+		{
+			REQUIRE(a->getTileRefAt(x, y, 0) == b->getTileRefAt(x, y, 0));
+			const dtMeshTile* tilesA[4];
+			const dtMeshTile* tilesB[4];
+			REQUIRE(a->getTilesAt(x, y, tilesA, 4) == b->getTilesAt(x, y, tilesB, 4));
+		}
+	}
+}
+}
+
+TEST_CASE("dtNavMesh tile grid")
+{
+	rcContext ctx(false);
+	dtNavMesh* hashed = buildTestNavMesh(&ctx, kTiles, kTileSize);
+	dtNavMesh* gridded = buildTestNavMesh(&ctx, kTiles, kTileSize);
+	REQUIRE(hashed);
+	REQUIRE(gridded);
+
+	SECTION("Checks its parameters")
+	{
+		dtNavMesh* uninitialized = dtAllocNavMesh();
+		REQUIRE(uninitialized->initTileGrid(0, 0, 4, 4) == (DT_FAILURE | DT_INVALID_PARAM));
+		dtFreeNavMesh(uninitialized);
+		REQUIRE(gridded->initTileGrid(0, 0, 0, 4) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(gridded->initTileGrid(0, 0, 4, -1) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(gridded->initTileGrid(0, 0, 0x10000, 0x10000) == (DT_FAILURE | DT_INVALID_PARAM));
+	}
+
+	SECTION("Finds the same tiles as the hash lookup")
+	{
+		// The grid covers part of the tiles, the others stay in the hash lookup.
+		REQUIRE(gridded->initTileGrid(1, 1, 2, 3) == DT_SUCCESS);
+		checkSameTiles(hashed, gridded);
+
+		// Tiles inside and outside the grid, removed and added again.
+		const int locations[3][2] = { { 1, 2 }, { 0, 0 }, { 2, 3 } };
+		for (int i = 0; i < 3; ++i)
+		{
+			reAddTestTile(hashed, locations[i][0], locations[i][1]);
+			reAddTestTile(gridded, locations[i][0], locations[i][1]);
+		}
+		checkSameTiles(hashed, gridded);
+
+		// The tiles are linked the same way.
+		dtNavMeshQuery* queryA = dtAllocNavMeshQuery();
+		dtNavMeshQuery* queryB = dtAllocNavMeshQuery();
+		REQUIRE(queryA->init(hashed, 2048) == DT_SUCCESS);
+		REQUIRE(queryB->init(gridded, 2048) == DT_SUCCESS);
+		dtQueryFilter filter;
+		testRandomSeed() = 11;
+		for (int i = 0; i < 32; ++i)
+		{
+			dtPolyRef startRef, endRef;
+			float startPos[3], endPos[3];
+			queryA->findRandomPoint(&filter, testRandom, &startRef, startPos);
+			queryA->findRandomPoint(&filter, testRandom, &endRef, endPos);
+			dtPolyRef pathA[kMaxPath], pathB[kMaxPath];
+			int countA = 0, countB = 0;
+			queryA->findPath(startRef, endRef, startPos, endPos, &filter, pathA, &countA, kMaxPath);
+			queryB->findPath(startRef, endRef, startPos, endPos, &filter, pathB, &countB, kMaxPath);
+			REQUIRE(countA == countB);
+			REQUIRE(memcmp(pathA, pathB, sizeof(dtPolyRef) * countA) == 0);
+
+			const float halfExtents[3] = { 20.0f, 10.0f, 20.0f };
+			dtPolyRef polysA[512], polysB[512];
+			int polyCountA = 0, polyCountB = 0;
+			queryA->queryPolygons(startPos, halfExtents, &filter, polysA, &polyCountA, 512);
+			queryB->queryPolygons(startPos, halfExtents, &filter, polysB, &polyCountB, 512);
+			REQUIRE(polyCountA == polyCountB);
+		}
+		dtFreeNavMeshQuery(queryA);
+		dtFreeNavMeshQuery(queryB);
+	}
+
+	dtFreeNavMesh(hashed);
+	dtFreeNavMesh(gridded);
+}
+
+TEST_CASE("dtNavMesh tile grid keeps the order of the layers")
+{
+	rcContext ctx(false);
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 3, kTileSize);
+	REQUIRE(nav);
+
+	// Layers in and out of the order of their tile indices.
+	addTestTileLayer(nav, 1, 1, 1);
+	reAddTestTile(nav, 0, 0);
+	addTestTileLayer(nav, 1, 1, 2);
+	addTestTileLayer(nav, 2, 0, 1);
+	addTestTileLayer(nav, 0, 2, 1);
+
+	const dtMeshTile* before[3][3][4];
+	int countBefore[3][3];
+	for (int y = 0; y < 3; ++y)
+	{
+		for (int x = 0; x < 3; ++x)
+			countBefore[y][x] = nav->getTilesAt(x, y, before[y][x], 4);
+	}
+	REQUIRE(countBefore[1][1] == 3);
+
+	// Part of the locations move to the grid, the others stay in the hash lookup.
+	REQUIRE(nav->initTileGrid(1, 0, 2, 3) == DT_SUCCESS);
+	for (int y = 0; y < 3; ++y)
+	{
+		for (int x = 0; x < 3; ++x)
+		{
+			const dtMeshTile* after[4];
+			REQUIRE(nav->getTilesAt(x, y, after, 4) == countBefore[y][x]);
+			REQUIRE(memcmp(after, before[y][x], sizeof(dtMeshTile*) * countBefore[y][x]) == 0);
+		}
+	}
+
+	dtFreeNavMesh(nav);
+}
@@ -0,0 +1,130 @@
+#include <string.h>
+
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourNavMeshWallField.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+// Checks that the wall field gives the distances to the walls found without it.
+void checkSameWallDistances(dtNavMeshQuery* query, const dtNavMeshWallField* field, const dtQueryFilter* filter,
+							int count, unsigned int seed)
+{
+	testRandomSeed() = seed;
+	for (int i = 0; i < count; ++i)
+	{
+		dtPolyRef ref;
+		float pos[3];
+		REQUIRE(dtStatusSucceed(query->findRandomPoint(filter, testRandom, &ref, pos)));
+		const float radius = 1.0f + testRandom() * 30.0f;
+
+		float expectedDist, expectedPos[3], expectedNormal[3];
+		query->setWallField(0);
+		const dtStatus expectedStatus = query->findDistanceToWall(ref, pos, radius, filter,
+																  &expectedDist, expectedPos, expectedNormal);
+		float dist, hitPos[3], hitNormal[3];
+		query->setWallField(field);
+		const dtStatus status = query->findDistanceToWall(ref, pos, radius, filter, &dist, hitPos, hitNormal);
+
+		REQUIRE(status == expectedStatus);
+		REQUIRE(dist == expectedDist);
+		if (dist < radius)
+		{
+			float t;
+			REQUIRE(dtDistancePtSegSqr2D(pos, hitPos, hitPos, t) == Catch::Approx(dist * dist).margin(1e-3f));
+		}
+	}
+	query->setWallField(0);
+}
+}
+
+TEST_CASE("dtNavMeshWallField")
+{
+	rcContext ctx(false);
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 4, 48);
+	REQUIRE(nav);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	REQUIRE(dtStatusSucceed(query->init(nav, 2048)));
+	dtQueryFilter filter;
+	dtNavMeshWallField* field = dtAllocNavMeshWallField();
+	REQUIRE(field);
+
+	dtNavMeshWallFieldParams params;
+	memset(&params, 0, sizeof(params));
+	params.cellSize = 1.0f;
+	params.includeFlags = filter.getIncludeFlags();
+	params.excludeFlags = filter.getExcludeFlags();
+
+	SECTION("Checks its parameters")
+	{
+		REQUIRE(field->build(0, &params) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(field->build(nav, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		params.cellSize = 0.0f;
+		REQUIRE(field->build(nav, &params) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(field->addTile(0) == DT_FAILURE);
+		params.cellSize = 2.0f;
+		REQUIRE(field->build(nav, &params) == DT_SUCCESS);
+		REQUIRE(field->getParams()->cellSize == 2.0f);
+		REQUIRE(field->getNavMesh() == nav);
+		REQUIRE(field->addTile(0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(field->removeTile(0) == (DT_FAILURE | DT_INVALID_PARAM));
+	}
+
+	SECTION("Gives the distances to the walls found without it")
+	{
+		REQUIRE(field->build(nav, &params) == DT_SUCCESS);
+		REQUIRE(field->matchesFilter(&filter));
+		checkSameWallDistances(query, field, &filter, 512, 7);
+
+		// Coarser cells only make the first searches wider.
+		params.cellSize = 16.0f;
+		REQUIRE(field->build(nav, &params) == DT_SUCCESS);
+		checkSameWallDistances(query, field, &filter, 128, 9);
+
+		// The walls of other flags.
+		params.cellSize = 1.0f;
+		params.excludeFlags = 1;
+		REQUIRE(field->build(nav, &params) == DT_SUCCESS);
+		REQUIRE(!field->matchesFilter(&filter));
+		checkSameWallDistances(query, field, &filter, 32, 11);
+	}
+
+	SECTION("Uses memory by cell size")
+	{
+		REQUIRE(field->build(nav, &params) == DT_SUCCESS);
+		const int fineSize = field->getMemoryUsed();
+		params.cellSize = 4.0f;
+		REQUIRE(field->build(nav, &params) == DT_SUCCESS);
+		const int coarseSize = field->getMemoryUsed();
+		REQUIRE(coarseSize > 0);
+		REQUIRE(fineSize > coarseSize);
+	}
+
+	SECTION("Follows the tiles added and removed")
+	{
+		REQUIRE(field->build(nav, &params) == DT_SUCCESS);
+
+		const dtMeshTile* tile = nav->getTileAt(1, 1, 0);
+		REQUIRE(tile);
+		const dtTileRef tileRef = nav->getTileRef(tile);
+		const int dataSize = tile->dataSize;
+		unsigned char* data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+		memcpy(data, tile->data, dataSize);
+		REQUIRE(dtStatusSucceed(nav->removeTile(tileRef, 0, 0)));
+		REQUIRE(field->removeTile(tileRef) == DT_SUCCESS);
+		REQUIRE(field->removeTile(tileRef) == (DT_FAILURE | DT_INVALID_PARAM));
+		checkSameWallDistances(query, field, &filter, 128, 13);
+
+		dtTileRef ref = 0;
+		REQUIRE(dtStatusSucceed(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, &ref)));
+		REQUIRE(field->addTile(ref) == DT_SUCCESS);
+		checkSameWallDistances(query, field, &filter, 128, 15);
+	}
+
+	dtFreeNavMeshWallField(field);
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
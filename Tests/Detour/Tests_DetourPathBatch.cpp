@@ -0,0 +1,176 @@
+#include <string.h>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+const int kMaxPath = 256;
+const int kMaxStraightPath = 256;
+
+struct PathBatchFixture
+{
+	PathBatchFixture() : nav(0), query(0)
+	{
+		rcContext ctx(false);
+		nav = buildTestNavMesh(&ctx, 4, 48);
+		query = dtAllocNavMeshQuery();
+		if (nav)
+			query->init(nav, 4096);
+	}
+
+	~PathBatchFixture()
+	{
+		dtFreeNavMeshQuery(query);
+		dtFreeNavMesh(nav);
+	}
+
+	std::vector<dtPathRequest> makeRequests(int count, unsigned int seed)
+	{
+		testRandomSeed() = seed;
+		std::vector<dtPathRequest> requests(count);
+		for (int i = 0; i < count; ++i)
+		{
+			dtPathRequest& r = requests[i];
+			query->findRandomPoint(&filter, testRandom, &r.startRef, r.startPos);
+			query->findRandomPoint(&filter, testRandom, &r.endRef, r.endPos);
+			r.filter = &filter;
+		}
+		return requests;
+	}
+
+	dtNavMesh* nav;
+	dtNavMeshQuery* query;
+	dtQueryFilter filter;
+};
+}
+
+TEST_CASE("dtNavMeshQuery::findPathBatch")
+{
+	PathBatchFixture f;
+	REQUIRE(f.nav);
+
+	SECTION("Gives the same paths as findPath and findStraightPath")
+	{
+		dtQueryFilter otherFilter;
+		otherFilter.setAreaCost(RC_WALKABLE_AREA, 2.0f);
+
+		std::vector<dtPathRequest> requests = f.makeRequests(64, 7);
+		for (size_t i = 0; i < requests.size(); i += 3)
+			requests[i].filter = &otherFilter;
+		const int count = (int)requests.size();
+
+		std::vector<dtPathResult> results(count);
+		std::vector<dtPolyRef> path(count * kMaxPath);
+		std::vector<float> straightPath(count * kMaxStraightPath * 3);
+		std::vector<unsigned char> straightPathFlags(count * kMaxStraightPath);
+		std::vector<dtPolyRef> straightPathRefs(count * kMaxStraightPath);
+		const dtStatus status = f.query->findPathBatch(&requests[0], count, &results[0],
+			&path[0], (int)path.size(),
+			&straightPath[0], &straightPathFlags[0], &straightPathRefs[0], count * kMaxStraightPath,
+			DT_STRAIGHTPATH_AREA_CROSSINGS);
+		REQUIRE(status == DT_SUCCESS);
+
+		int longPaths = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			const dtPathRequest& r = requests[i];
+			const dtPathResult& res = results[i];
+
+			dtPolyRef expectedPath[kMaxPath];
+			int expectedPathCount = 0;
+			const dtStatus pathStatus = f.query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, r.filter,
+														  expectedPath, &expectedPathCount, kMaxPath);
+			REQUIRE(res.pathStatus == pathStatus);
+			REQUIRE(res.pathCount == expectedPathCount);
+			REQUIRE(memcmp(&path[res.pathOffset], expectedPath, sizeof(dtPolyRef) * expectedPathCount) == 0);
+			if (expectedPathCount > 10)
+				longPaths++;
+
+			float expectedStraight[kMaxStraightPath * 3];
+			unsigned char expectedFlags[kMaxStraightPath];
+			dtPolyRef expectedRefs[kMaxStraightPath];
+			int expectedStraightCount = 0;
+			const dtStatus straightStatus = f.query->findStraightPath(r.startPos, r.endPos, expectedPath, expectedPathCount,
+				expectedStraight, expectedFlags, expectedRefs, &expectedStraightCount, kMaxStraightPath,
+				DT_STRAIGHTPATH_AREA_CROSSINGS);
+			REQUIRE(res.straightPathStatus == straightStatus);
+			REQUIRE(res.straightPathCount == expectedStraightCount);
+			REQUIRE(memcmp(&straightPath[res.straightPathOffset * 3], expectedStraight, sizeof(float) * 3 * expectedStraightCount) == 0);
+			REQUIRE(memcmp(&straightPathFlags[res.straightPathOffset], expectedFlags, expectedStraightCount) == 0);
+			REQUIRE(memcmp(&straightPathRefs[res.straightPathOffset], expectedRefs, sizeof(dtPolyRef) * expectedStraightCount) == 0);
+		}
+		// The paths cross the tiles of the mesh.
+		REQUIRE(longPaths > count / 4);
+	}
+
+	SECTION("Identical queries share their result")
+	{
+		std::vector<dtPathRequest> requests = f.makeRequests(4, 11);
+		requests.push_back(requests[1]);
+		requests.push_back(requests[1]);
+		const int count = (int)requests.size();
+
+		std::vector<dtPathResult> results(count);
+		std::vector<dtPolyRef> path(count * kMaxPath);
+		REQUIRE(f.query->findPathBatch(&requests[0], count, &results[0], &path[0], (int)path.size(), 0, 0, 0, 0) == DT_SUCCESS);
+
+		for (int i = 4; i < count; ++i)
+		{
+			REQUIRE(results[i].pathStatus == results[1].pathStatus);
+			REQUIRE(results[i].pathOffset == results[1].pathOffset);
+			REQUIRE(results[i].pathCount == results[1].pathCount);
+			REQUIRE(results[i].straightPathStatus == 0);
+			REQUIRE(results[i].straightPathCount == 0);
+		}
+
+		int used = 0;
+		for (int i = 0; i < 4; ++i)
+			used += results[i].pathCount;
+		for (int i = 0; i < 4; ++i)
+			REQUIRE(results[i].pathOffset + results[i].pathCount <= used);
+	}
+
+	SECTION("Reports the queries that do not fit the path array")
+	{
+		std::vector<dtPathRequest> requests = f.makeRequests(16, 23);
+		const int count = (int)requests.size();
+
+		std::vector<dtPathResult> results(count);
+		dtPolyRef path[16];
+		const dtStatus status = f.query->findPathBatch(&requests[0], count, &results[0], path, 16, 0, 0, 0, 0);
+		REQUIRE(dtStatusSucceed(status));
+		REQUIRE(dtStatusDetail(status, DT_BUFFER_TOO_SMALL));
+
+		int used = 0;
+		int failed = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			used += results[i].pathCount;
+			if (dtStatusFailed(results[i].pathStatus))
+			{
+				REQUIRE(dtStatusDetail(results[i].pathStatus, DT_BUFFER_TOO_SMALL));
+				REQUIRE(results[i].pathCount == 0);
+				failed++;
+			}
+		}
+		REQUIRE(used == 16);
+		REQUIRE(failed > 0);
+	}
+
+	SECTION("Invalid arguments")
+	{
+		std::vector<dtPathRequest> requests = f.makeRequests(1, 5);
+		dtPathResult result;
+		dtPolyRef path[4];
+		float straightPath[3 * 4];
+		REQUIRE(f.query->findPathBatch(0, 1, &result, path, 4, 0, 0, 0, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(f.query->findPathBatch(&requests[0], 1, &result, path, 0, 0, 0, 0, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(f.query->findPathBatch(&requests[0], 1, &result, path, 4, straightPath, 0, 0, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(f.query->findPathBatch(&requests[0], 0, &result, path, 4, 0, 0, 0, 0) == DT_SUCCESS);
+	}
+}
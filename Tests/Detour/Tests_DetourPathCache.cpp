@@ -0,0 +1,187 @@
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourPathCache.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+const int kMaxPath = 256;
+
+struct PathCacheRequest
+{
+	dtPolyRef startRef;
+	dtPolyRef endRef;
+	float startPos[3];
+	float endPos[3];
+};
+
+std::vector<PathCacheRequest> makeRequests(dtNavMeshQuery* query, const dtQueryFilter* filter, int count, unsigned int seed)
+{
+	testRandomSeed() = seed;
+	std::vector<PathCacheRequest> requests(count);
+	for (int i = 0; i < count; ++i)
+	{
+		PathCacheRequest& r = requests[i];
+		do
+		{
+			query->findRandomPoint(filter, testRandom, &r.startRef, r.startPos);
+			query->findRandomPoint(filter, testRandom, &r.endRef, r.endPos);
+		} while (r.startRef == r.endRef);
+	}
+	return requests;
+}
+
+double testTime()
+{
+	static double time = 0.0;
+	time += 1.0;
+	return time;
+}
+}
+
+TEST_CASE("dtPathCache")
+{
+	rcContext ctx(false);
+	dtQueryFilter filter;
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 4, 48);
+	REQUIRE(nav);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	REQUIRE(dtStatusSucceed(query->init(nav, 4096)));
+	dtPathCache* cache = dtAllocPathCache();
+	REQUIRE(cache);
+
+	std::vector<PathCacheRequest> requests = makeRequests(query, &filter, 8, 3);
+	dtPolyRef path[kMaxPath];
+	dtPolyRef expected[kMaxPath];
+	int pathCount = 0;
+	int expectedCount = 0;
+
+	SECTION("Checks its parameters")
+	{
+		REQUIRE(cache->init(0, 16, kMaxPath) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(cache->init(nav, 0, kMaxPath) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(cache->init(nav, 0xffff, kMaxPath) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(cache->init(nav, 16, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		const PathCacheRequest& r = requests[0];
+		REQUIRE(cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &filter, path, &pathCount, kMaxPath) ==
+				(DT_FAILURE | DT_INVALID_PARAM));
+	}
+
+	SECTION("Gives the paths of findPath, and the cached ones the second time")
+	{
+		REQUIRE(cache->init(nav, 16, kMaxPath) == DT_SUCCESS);
+		cache->setTimer(testTime);
+		for (int k = 0; k < 2; ++k)
+		{
+			for (size_t i = 0; i < requests.size(); ++i)
+			{
+				const PathCacheRequest& r = requests[i];
+				const dtStatus status = cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &filter, path, &pathCount, kMaxPath);
+				const dtStatus expectedStatus = query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, &filter, expected, &expectedCount, kMaxPath);
+				REQUIRE(status == expectedStatus);
+				REQUIRE(std::vector<dtPolyRef>(path, path + pathCount) == std::vector<dtPolyRef>(expected, expected + expectedCount));
+			}
+		}
+		const dtPathCacheStats& stats = cache->getStats();
+		REQUIRE(stats.misses == requests.size());
+		REQUIRE(stats.hits == requests.size());
+		REQUIRE(stats.stores == requests.size());
+		REQUIRE(stats.hitTime == Catch::Approx((double)requests.size()));
+		REQUIRE(stats.missTime == Catch::Approx((double)requests.size()));
+		REQUIRE(cache->getPathCount() == (int)requests.size());
+
+		// A short buffer gets the start of the path.
+		const PathCacheRequest& r = requests[0];
+		query->findPath(r.startRef, r.endRef, r.startPos, r.endPos, &filter, expected, &expectedCount, kMaxPath);
+		REQUIRE(expectedCount > 2);
+		const dtStatus status = cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &filter, path, &pathCount, 2);
+		REQUIRE(status == (DT_SUCCESS | DT_BUFFER_TOO_SMALL));
+		REQUIRE(pathCount == 2);
+		REQUIRE(path[0] == expected[0]);
+		REQUIRE(path[1] == expected[1]);
+
+		cache->clear();
+		cache->resetStats();
+		REQUIRE(cache->getPathCount() == 0);
+		cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &filter, path, &pathCount, kMaxPath);
+		REQUIRE(cache->getStats().misses == 1);
+	}
+
+	SECTION("Keys the paths by filter")
+	{
+		REQUIRE(cache->init(nav, 16, kMaxPath) == DT_SUCCESS);
+		dtQueryFilter otherFilter;
+		otherFilter.setAreaCost(RC_WALKABLE_AREA, 2.0f);
+		REQUIRE(dtPathCache::getFilterSignature(&filter) != dtPathCache::getFilterSignature(&otherFilter));
+
+		const PathCacheRequest& r = requests[0];
+		cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &filter, path, &pathCount, kMaxPath);
+		cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &otherFilter, path, &pathCount, kMaxPath);
+		REQUIRE(cache->getStats().misses == 2);
+		cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &otherFilter, path, &pathCount, kMaxPath);
+		REQUIRE(cache->getStats().hits == 1);
+	}
+
+	SECTION("Evicts the least recently used paths")
+	{
+		REQUIRE(cache->init(nav, 4, kMaxPath) == DT_SUCCESS);
+		for (int i = 0; i < 4; ++i)
+		{
+			const PathCacheRequest& r = requests[i];
+			cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &filter, path, &pathCount, kMaxPath);
+		}
+		// Use the first path again, the second one is then the least recently used.
+		const PathCacheRequest& first = requests[0];
+		cache->findPath(query, first.startRef, first.endRef, first.startPos, first.endPos, &filter, path, &pathCount, kMaxPath);
+		const PathCacheRequest& fifth = requests[4];
+		cache->findPath(query, fifth.startRef, fifth.endRef, fifth.startPos, fifth.endPos, &filter, path, &pathCount, kMaxPath);
+		REQUIRE(cache->getStats().evictions == 1);
+		REQUIRE(cache->getPathCount() == 4);
+
+		cache->resetStats();
+		cache->findPath(query, first.startRef, first.endRef, first.startPos, first.endPos, &filter, path, &pathCount, kMaxPath);
+		REQUIRE(cache->getStats().hits == 1);
+		const PathCacheRequest& second = requests[1];
+		cache->findPath(query, second.startRef, second.endRef, second.startPos, second.endPos, &filter, path, &pathCount, kMaxPath);
+		REQUIRE(cache->getStats().misses == 1);
+	}
+
+	SECTION("Drops the paths crossing removed tiles")
+	{
+		REQUIRE(cache->init(nav, 16, kMaxPath) == DT_SUCCESS);
+		const PathCacheRequest& r = requests[0];
+		cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &filter, path, &pathCount, kMaxPath);
+		REQUIRE(cache->getPathCount() == 1);
+
+		// Rebuild a tile of the path in the middle, which changes its salt.
+		const dtPolyRef middle = path[pathCount / 2];
+		const dtMeshTile* tile = 0;
+		const dtPoly* poly = 0;
+		REQUIRE(dtStatusSucceed(nav->getTileAndPolyByRef(middle, &tile, &poly)));
+		const unsigned int it = nav->decodePolyIdTile(middle);
+		const int dataSize = tile->dataSize;
+		unsigned char* data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+		memcpy(data, tile->data, dataSize);
+		REQUIRE(dtStatusSucceed(nav->removeTile(nav->getTileRef(tile), 0, 0)));
+		REQUIRE(dtStatusSucceed(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0)));
+
+		const dtStatus status = cache->findPath(query, r.startRef, r.endRef, r.startPos, r.endPos, &filter, path, &pathCount, kMaxPath);
+		REQUIRE(cache->getStats().stale == 1);
+		REQUIRE(cache->getStats().hits == 0);
+		REQUIRE(cache->getStats().misses == 2);
+		// The polygons of the rebuilt tile have new references.
+		if (nav->decodePolyIdTile(r.startRef) != it && nav->decodePolyIdTile(r.endRef) != it)
+		{
+			REQUIRE(status == DT_SUCCESS);
+			REQUIRE(isTestPathConnected(nav, path, pathCount));
+		}
+	}
+
+	dtFreePathCache(cache);
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
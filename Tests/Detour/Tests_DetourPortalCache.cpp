@@ -0,0 +1,149 @@
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourPortalCache.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+const int kMaxPath = 256;
+const int kMaxStraightPath = 256;
+
+struct StraightPath
+{
+	float verts[kMaxStraightPath * 3];
+	unsigned char flags[kMaxStraightPath];
+	dtPolyRef refs[kMaxStraightPath];
+	int count;
+	dtStatus status;
+};
+
+// Checks that the portal cache gives the straight path found without it.
+void checkSameStraightPath(const dtNavMeshQuery* query, dtPortalCache* portals, const float* startPos, const float* endPos,
+						   const dtPolyRef* path, int pathCount, int maxStraightPath, int options)
+{
+	StraightPath expected, cached;
+	expected.status = query->findStraightPath(startPos, endPos, path, pathCount,
+											  expected.verts, expected.flags, expected.refs, &expected.count, maxStraightPath, options);
+	cached.status = query->findStraightPath(startPos, endPos, path, pathCount, portals,
+											cached.verts, cached.flags, cached.refs, &cached.count, maxStraightPath, options);
+	REQUIRE(cached.status == expected.status);
+	REQUIRE(cached.count == expected.count);
+	REQUIRE(memcmp(cached.verts, expected.verts, sizeof(float) * 3 * expected.count) == 0);
+	REQUIRE(memcmp(cached.flags, expected.flags, expected.count) == 0);
+	REQUIRE(memcmp(cached.refs, expected.refs, sizeof(dtPolyRef) * expected.count) == 0);
+}
+}
+
+TEST_CASE("dtPortalCache")
+{
+	rcContext ctx(false);
+	dtQueryFilter filter;
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 4, 48);
+	REQUIRE(nav);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	REQUIRE(dtStatusSucceed(query->init(nav, 4096)));
+	dtPortalCache* portals = dtAllocPortalCache();
+	REQUIRE(portals);
+
+	// Some area crossings along the paths.
+	for (int i = 0; i < nav->getMaxTiles(); ++i)
+	{
+		const dtMeshTile* tile = ((const dtNavMesh*)nav)->getTile(i);
+		if (!tile->header)
+			continue;
+		for (int j = 0; j < tile->header->polyCount; j += 3)
+			nav->setPolyArea(nav->getPolyRefBase(tile) | (dtPolyRef)j, 2);
+	}
+
+	testRandomSeed() = 7;
+	dtPolyRef startRef, endRef;
+	float startPos[3], endPos[3];
+	dtPolyRef path[kMaxPath];
+	int pathCount = 0;
+	do
+	{
+		query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+		query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+		query->findPath(startRef, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath);
+	} while (pathCount < 16);
+
+	SECTION("Checks its parameters")
+	{
+		REQUIRE(portals->init(0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(portals->init(1) == DT_SUCCESS);
+		checkSameStraightPath(query, portals, startPos, endPos, path, pathCount, kMaxStraightPath, 0);
+		REQUIRE(portals->getPortalCount() == 0);
+	}
+
+	SECTION("Gives the straight paths found without it")
+	{
+		REQUIRE(portals->init(kMaxPath) == DT_SUCCESS);
+		testRandomSeed() = 3;
+		const int options[3] = { 0, DT_STRAIGHTPATH_AREA_CROSSINGS, DT_STRAIGHTPATH_ALL_CROSSINGS };
+		for (int i = 0; i < 64; ++i)
+		{
+			query->findRandomPoint(&filter, testRandom, &startRef, startPos);
+			query->findRandomPoint(&filter, testRandom, &endRef, endPos);
+			query->findPath(startRef, endRef, startPos, endPos, &filter, path, &pathCount, kMaxPath);
+			for (int k = 0; k < 3; ++k)
+			{
+				checkSameStraightPath(query, portals, startPos, endPos, path, pathCount, kMaxStraightPath, options[k]);
+				checkSameStraightPath(query, portals, startPos, endPos, path, pathCount, 3, options[k]);
+			}
+		}
+
+		// Portals past the cached path.
+		REQUIRE(portals->init(4) == DT_SUCCESS);
+		for (int k = 0; k < 3; ++k)
+			checkSameStraightPath(query, portals, startPos, endPos, path, pathCount, kMaxStraightPath, options[k]);
+	}
+
+	SECTION("Extracts the portals once while the corridor moves along them")
+	{
+		REQUIRE(portals->init(kMaxPath) == DT_SUCCESS);
+		checkSameStraightPath(query, portals, startPos, endPos, path, pathCount, kMaxStraightPath, 0);
+		REQUIRE(portals->getPortalCount() == pathCount - 1);
+		REQUIRE(portals->getExtractCount() == (unsigned int)(pathCount - 1));
+
+		// The agent leaves the first polygons behind.
+		float pos[3];
+		query->closestPointOnPoly(path[4], endPos, pos, 0);
+		checkSameStraightPath(query, portals, pos, endPos, path + 4, pathCount - 4, kMaxStraightPath, 0);
+		REQUIRE(portals->getPortalCount() == pathCount - 5);
+		REQUIRE(portals->getExtractCount() == (unsigned int)(pathCount - 1));
+
+		// A new end of the corridor.
+		checkSameStraightPath(query, portals, pos, endPos, path + 4, pathCount - 6, kMaxStraightPath, 0);
+		REQUIRE(portals->getExtractCount() == (unsigned int)(pathCount - 1));
+		dtPolyRef otherPath[kMaxPath];
+		memcpy(otherPath, path + 4, sizeof(dtPolyRef) * (pathCount - 4));
+		otherPath[8] = path[0];
+		checkSameStraightPath(query, portals, pos, endPos, otherPath, pathCount - 4, kMaxStraightPath, 0);
+		REQUIRE(portals->getPortalCount() == 7);
+	}
+
+	SECTION("Drops the portals of removed tiles")
+	{
+		REQUIRE(portals->init(kMaxPath) == DT_SUCCESS);
+		checkSameStraightPath(query, portals, startPos, endPos, path, pathCount, kMaxStraightPath, 0);
+
+		// Remove the tile of a polygon in the middle of the path.
+		const dtMeshTile* tile = 0;
+		const dtPoly* poly = 0;
+		nav->getTileAndPolyByRefUnsafe(path[pathCount / 2], &tile, &poly);
+		const int dataSize = tile->dataSize;
+		unsigned char* data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+		memcpy(data, tile->data, dataSize);
+		REQUIRE(nav->removeTile(nav->getTileRef(tile), 0, 0) == DT_SUCCESS);
+		checkSameStraightPath(query, portals, startPos, endPos, path, pathCount, kMaxStraightPath, 0);
+		REQUIRE(portals->getPortalCount() < pathCount - 1);
+		REQUIRE(nav->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0) == DT_SUCCESS);
+		checkSameStraightPath(query, portals, startPos, endPos, path, pathCount, kMaxStraightPath, 0);
+	}
+
+	dtFreePortalCache(portals);
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
@@ -0,0 +1,122 @@
+#include <float.h>
+#include <string.h>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourTestUtils.h"
+
+namespace
+{
+const int kMaxPath = 32;
+
+// Rays from a few agents toward random points, several from each agent.
+std::vector<dtRaycastRequest> makeRaycastRequests(dtNavMeshQuery* query, const dtQueryFilter* filter, int count, unsigned int seed)
+{
+	testRandomSeed() = seed;
+	std::vector<dtRaycastRequest> requests(count);
+	for (int i = 0; i < count; ++i)
+	{
+		dtRaycastRequest& r = requests[i];
+		if (i % 8 != 0)
+		{
+			r = requests[i - 1];
+		}
+		else
+		{
+			query->findRandomPoint(filter, testRandom, &r.startRef, r.startPos);
+		}
+		dtPolyRef endRef;
+		query->findRandomPoint(filter, testRandom, &endRef, r.endPos);
+		r.filter = filter;
+		r.prevRef = 0;
+	}
+	return requests;
+}
+}
+
+TEST_CASE("dtNavMeshQuery::raycastBatch")
+{
+	rcContext ctx(false);
+	dtNavMesh* nav = buildTestNavMesh(&ctx, 4, 48);
+	REQUIRE(nav);
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	REQUIRE(dtStatusSucceed(query->init(nav, 2048)));
+	dtQueryFilter filter;
+
+	SECTION("Checks its parameters")
+	{
+		dtRaycastHit hit;
+		REQUIRE(query->raycastBatch(0, 1, 0, &hit, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		std::vector<dtRaycastRequest> requests = makeRaycastRequests(query, &filter, 1, 3);
+		REQUIRE(query->raycastBatch(&requests[0], -1, 0, &hit, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(query->raycastBatch(&requests[0], 1, 0, 0, 0) == (DT_FAILURE | DT_INVALID_PARAM));
+		REQUIRE(query->raycastBatch(&requests[0], 0, 0, &hit, 0) == DT_SUCCESS);
+	}
+
+	SECTION("Gives the same hits as raycast")
+	{
+		dtQueryFilter otherFilter;
+		otherFilter.setAreaCost(RC_WALKABLE_AREA, 2.0f);
+
+		std::vector<dtRaycastRequest> requests = makeRaycastRequests(query, &filter, 256, 7);
+		const int count = (int)requests.size();
+		for (int i = 0; i < count; i += 5)
+			requests[i].filter = &otherFilter;
+		// A ray from an invalid polygon, and one with a previous polygon for the costs.
+		requests[3].startRef = 0;
+		requests[9].prevRef = requests[17].startRef;
+
+		for (int k = 0; k < 2; ++k)
+		{
+			// With paths too small for the long rays.
+			const int maxPath = k == 0 ? kMaxPath : 2;
+			const unsigned int options = k == 0 ? DT_RAYCAST_USE_COSTS : 0;
+
+			std::vector<dtRaycastHit> hits(count);
+			std::vector<dtPolyRef> paths(count * maxPath);
+			std::vector<dtStatus> statuses(count);
+			for (int i = 0; i < count; ++i)
+			{
+				hits[i].path = &paths[i * maxPath];
+				hits[i].maxPath = maxPath;
+			}
+			const dtStatus status = query->raycastBatch(&requests[0], count, options, &hits[0], &statuses[0]);
+			REQUIRE(dtStatusSucceed(status));
+			REQUIRE((status & DT_BUFFER_TOO_SMALL) == (k == 0 ? 0 : DT_BUFFER_TOO_SMALL));
+
+			int wallHits = 0;
+			for (int i = 0; i < count; ++i)
+			{
+				const dtRaycastRequest& r = requests[i];
+				dtRaycastHit expected;
+				dtPolyRef expectedPath[kMaxPath];
+				expected.path = expectedPath;
+				expected.maxPath = maxPath;
+				const dtStatus expectedStatus = query->raycast(r.startRef, r.startPos, r.endPos, r.filter, options, &expected, r.prevRef);
+
+				REQUIRE(statuses[i] == expectedStatus);
+				const dtRaycastHit& hit = hits[i];
+				REQUIRE(hit.t == expected.t);
+				REQUIRE(hit.pathCount == expected.pathCount);
+				REQUIRE(memcmp(hit.path, expected.path, sizeof(dtPolyRef) * expected.pathCount) == 0);
+				REQUIRE(hit.pathCost == expected.pathCost);
+				if (dtStatusSucceed(expectedStatus) && expected.t < 1.0f)
+				{
+					REQUIRE(hit.hitEdgeIndex == expected.hitEdgeIndex);
+					REQUIRE(memcmp(hit.hitNormal, expected.hitNormal, sizeof(hit.hitNormal)) == 0);
+					wallHits++;
+				}
+				if (k == 0 && expected.t == FLT_MAX)
+					REQUIRE(isTestPathConnected(nav, hit.path, hit.pathCount));
+			}
+			REQUIRE(statuses[3] == (DT_FAILURE | DT_INVALID_PARAM));
+			REQUIRE(wallHits > 0);
+		}
+	}
+
+	dtFreeNavMeshQuery(query);
+	dtFreeNavMesh(nav);
+}
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+#include "../Bench.h"
+
+#include "Recast.h"
+#include "RecastTestUtils.h"
+
+#ifdef RC_BENCHMARKS_ENABLED
+
+const int kNumLoops = 3;
+const int kFieldSize = 1024;
+const int kPartitionSize = 128;
+
+// The compact heightfield is shared by the benchmarks, building regions only rewrites the span regions.
+static rcCompactHeightfield& getBenchHeightfield()
+{
+	static rcCompactHeightfield chf;
+	static bool built = false;
+	if (!built)
+	{
+		rcContext ctx;
+		buildTestCompactHeightfield(&ctx, kFieldSize, chf);
+		built = true;
+	}
+	return chf;
+}
+
+// Builds the shared heightfield, so that the benchmarks below do not time it.
+BM_WALL(BuildBenchHeightfield, 1)
+{
+	getBenchHeightfield();
+}
+
+BM_WALL(BuildRegions_Serial, kNumLoops)
+{
+	rcContext ctx(false);
+	rcBuildRegions(&ctx, getBenchHeightfield(), 0, 8, 20);
+}
+
+BM_WALL(BuildRegions_Partitioned_1Thread, kNumLoops)
+{
+	TestTaskContext ctx(1);
+	rcBuildRegionsParallel(&ctx, getBenchHeightfield(), 0, 8, 20, kPartitionSize);
+}
+
+BM_WALL(BuildRegions_Partitioned_4Threads, kNumLoops)
+{
+	TestTaskContext ctx(4);
+	rcBuildRegionsParallel(&ctx, getBenchHeightfield(), 0, 8, 20, kPartitionSize);
+}
+
+// Erodes from the same areas every iteration.
+static void benchErode(rcCompactHeightfield& chf)
+{
+	std::vector<unsigned char> areas(chf.areas, chf.areas + chf.spanCount);
+	rcContext ctx(false);
+	rcErodeWalkableArea(&ctx, 2, chf);
+	memcpy(chf.areas, areas.data(), areas.size());
+}
+
+BM(ErodeWalkableArea, kNumLoops)
+{
+	benchErode(getBenchHeightfield());
+}
+
+BM(BuildDistanceField, kNumLoops)
+{
+	rcContext ctx(false);
+	rcBuildDistanceField(&ctx, getBenchHeightfield());
+}
+
+const int kLargeFieldSize = 2048;
+
+static rcCompactHeightfield& getLargeBenchHeightfield()
+{
+	static rcCompactHeightfield chf;
+	static bool built = false;
+	if (!built)
+	{
+		rcContext ctx;
+		buildTestCompactHeightfield(&ctx, kLargeFieldSize, chf);
+		built = true;
+	}
+	return chf;
+}
+
+// Runs the area filters from the same areas every iteration.
+static void benchAreaFilters(rcContext* ctx)
+{
+	rcCompactHeightfield& chf = getLargeBenchHeightfield();
+	std::vector<unsigned char> areas(chf.areas, chf.areas + chf.spanCount);
+	rcErodeWalkableArea(ctx, 2, chf);
+	rcMedianFilterWalkableArea(ctx, chf);
+	memcpy(chf.areas, areas.data(), areas.size());
+}
+
+BM_WALL(BuildLargeBenchHeightfield, 1)
+{
+	getLargeBenchHeightfield();
+}
+
+BM_WALL(AreaFilters2048_1Thread, kNumLoops)
+{
+	TestTaskContext ctx(1);
+	benchAreaFilters(&ctx);
+}
+
+BM_WALL(AreaFilters2048_4Threads, kNumLoops)
+{
+	TestTaskContext ctx(4);
+	benchAreaFilters(&ctx);
+}
+
+// The large field with regions, for the contour benchmarks.
+static rcCompactHeightfield& getLargeBenchRegions()
+{
+	static bool built = false;
+	rcCompactHeightfield& chf = getLargeBenchHeightfield();
+	if (!built)
+	{
+		rcContext ctx(false);
+		rcBuildRegions(&ctx, chf, 0, 8, 20);
+		built = true;
+	}
+	return chf;
+}
+
+static void benchContours(rcContext* ctx)
+{
+	rcContourSet cset;
+	rcBuildContours(ctx, getLargeBenchRegions(), 1.3f, 12, cset);
+}
+
+BM_WALL(BuildLargeBenchRegions, 1)
+{
+	getLargeBenchRegions();
+}
+
+BM_WALL(BuildContours2048_1Thread, kNumLoops)
+{
+	TestTaskContext ctx(1);
+	benchContours(&ctx);
+}
+
+BM_WALL(BuildContours2048_4Threads, kNumLoops)
+{
+	TestTaskContext ctx(4);
+	benchContours(&ctx);
+}
+
+// A single convex contour with the given number of vertices, so that polygon merging has many candidates.
+static void benchMergePolys(int nverts)
+{
+	rcContext ctx(false);
+	rcContourSet cset;
+	cset.cs = 0.3f;
+	cset.ch = 0.2f;
+	cset.bmin[0] = cset.bmin[1] = cset.bmin[2] = 0.0f;
+	cset.bmax[0] = cset.bmax[2] = nverts * 4 * cset.cs;
+	cset.bmax[1] = 10.0f;
+	cset.width = cset.height = nverts * 4;
+	cset.borderSize = 0;
+	cset.maxError = 1.3f;
+	cset.nconts = 1;
+	cset.conts = (rcContour*)rcAlloc(sizeof(rcContour), RC_ALLOC_PERM);
+	rcContour& cont = cset.conts[0];
+	cont.nverts = nverts;
+	cont.verts = (int*)rcAlloc(sizeof(int) * nverts * 4, RC_ALLOC_PERM);
+	cont.nrverts = 0;
+	cont.rverts = 0;
+	cont.reg = 1;
+	cont.area = RC_WALKABLE_AREA;
+	for (int i = 0; i < nverts; ++i)
+	{
+		const float angle = -2.0f * RC_PI * i / nverts;
+		int* v = &cont.verts[i * 4];
+		v[0] = (int)(nverts * 2 * (1.0f + cosf(angle)));
+		v[1] = 0;
+		v[2] = (int)(nverts * 2 * (1.0f + sinf(angle)));
+		v[3] = 0;
+	}
+
+	rcPolyMesh mesh;
+	rcBuildPolyMesh(&ctx, cset, 6, mesh);
+}
+
+BM(BuildPolyMesh_Contour256, kNumLoops)
+{
+	benchMergePolys(256);
+}
+
+BM(BuildPolyMesh_Contour1024, kNumLoops)
+{
+	benchMergePolys(1024);
+}
+
+BM(BuildPolyMesh_Contour4096, 1)
+{
+	benchMergePolys(4096);
+}
+
+// A field and its polygon mesh for the detail mesh benchmarks. The mesh of the large field
+// would have too many vertices for the 16-bit indices.
+const int kDetailBenchSize = 768;
+
+static rcCompactHeightfield& getDetailBenchField()
+{
+	static rcCompactHeightfield chf;
+	static bool built = false;
+	if (!built)
+	{
+		rcContext ctx(false);
+		buildTestCompactHeightfield(&ctx, kDetailBenchSize, chf);
+		rcBuildRegions(&ctx, chf, 0, 8, 20);
+		built = true;
+	}
+	return chf;
+}
+
+static rcPolyMesh& getDetailBenchPolyMesh()
+{
+	static rcPolyMesh mesh;
+	static bool built = false;
+	if (!built)
+	{
+		rcContext ctx(false);
+		rcContourSet cset;
+		rcBuildContours(&ctx, getDetailBenchField(), 1.3f, 12, cset);
+		rcBuildPolyMesh(&ctx, cset, 6, mesh);
+		built = true;
+	}
+	return mesh;
+}
+
+static void benchPolyMeshDetail(rcContext* ctx, const float sampleDist = 1.8f, const float sampleMaxError = 0.2f)
+{
+	rcPolyMeshDetail dmesh;
+	rcBuildPolyMeshDetail(ctx, getDetailBenchPolyMesh(), getDetailBenchField(), sampleDist, sampleMaxError, dmesh);
+}
+
+BM_WALL(BuildDetailBenchPolyMesh, 1)
+{
+	getDetailBenchPolyMesh();
+}
+
+BM_WALL(BuildPolyMeshDetail768_1Thread, kNumLoops)
+{
+	TestTaskContext ctx(1);
+	benchPolyMeshDetail(&ctx);
+}
+
+BM_WALL(BuildPolyMeshDetail768_4Threads, kNumLoops)
+{
+	TestTaskContext ctx(4);
+	benchPolyMeshDetail(&ctx);
+}
+
+// Samples at every other cell with a low error, so that most samples are added to the triangulations.
+BM_WALL(BuildPolyMeshDetail768_DenseSamples, kNumLoops)
+{
+	TestTaskContext ctx(1);
+	benchPolyMeshDetail(&ctx, 2 * getDetailBenchField().cs, 0.02f);
+}
+
+const int kMergeTileSize = 64;
+const int kMergeTilesPerSide = 20;
+
+// A grid of copies of one tile mesh, as merged into a solo mesh for export.
+static std::vector<rcPolyMesh*>& getBenchTileMeshes()
+{
+	static std::vector<rcPolyMesh*> meshes;
+	if (meshes.empty())
+	{
+		rcContext ctx(false);
+		rcCompactHeightfield chf;
+		buildTestCompactHeightfield(&ctx, kMergeTileSize, chf);
+		rcBuildRegions(&ctx, chf, 0, 8, 20);
+		rcContourSet cset;
+		rcBuildContours(&ctx, chf, 1.3f, 12, cset);
+		rcPolyMesh tile;
+		rcBuildPolyMesh(&ctx, cset, 6, tile);
+
+		const float tileWidth = kMergeTileSize * tile.cs;
+		for (int z = 0; z < kMergeTilesPerSide; ++z)
+		{
+			for (int x = 0; x < kMergeTilesPerSide; ++x)
+			{
+				rcPolyMesh* mesh = rcAllocPolyMesh();
+				rcCopyPolyMesh(&ctx, tile, *mesh);
+				mesh->bmin[0] += x * tileWidth;
+				mesh->bmax[0] += x * tileWidth;
+				mesh->bmin[2] += z * tileWidth;
+				mesh->bmax[2] += z * tileWidth;
+				meshes.push_back(mesh);
+			}
+		}
+	}
+	return meshes;
+}
+
+BM_WALL(BuildBenchTileMeshes, 1)
+{
+	getBenchTileMeshes();
+}
+
+BM(MergePolyMeshes_400Tiles, kNumLoops)
+{
+	rcContext ctx(false);
+	std::vector<rcPolyMesh*>& meshes = getBenchTileMeshes();
+	rcPolyMesh mesh;
+	rcMergePolyMeshes(&ctx, meshes.data(), (int)meshes.size(), mesh);
+}
+
+#endif  // RC_BENCHMARKS_ENABLED
@@ -0,0 +1,98 @@
+#ifndef RECAST_TESTS_RECASTTESTUTILS_H
+#define RECAST_TESTS_RECASTTESTUTILS_H
+
+#include <math.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Recast.h"
+
+/// Build context that runs task sets on a fixed number of threads and counts logged errors.
+class TestTaskContext : public rcContext
+{
+public:
+	explicit TestTaskContext(int threadCount) : rcContext(true), m_threadCount(threadCount), m_errorCount(0) {}
+
+	int getErrorCount() const { return m_errorCount; }
+
+protected:
+	virtual void doLog(const rcLogCategory category, const char* msg, const int len)
+	{
+		if (category == RC_LOG_ERROR)
+		{
+			printf("%.*s\n", len, msg);
+			m_errorCount++;
+		}
+	}
+
+	virtual void doRunTasks(rcTaskSet& tasks, const int taskCount)
+	{
+		if (m_threadCount <= 1)
+		{
+			rcContext::doRunTasks(tasks, taskCount);
+			return;
+		}
+
+		std::atomic<int> next(0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < m_threadCount; ++t)
+		{
+			threads.push_back(std::thread([&]() {
+				for (int i = next++; i < taskCount; i = next++)
+					tasks.runTask(i);
+			}));
+		}
+		for (size_t t = 0; t < threads.size(); ++t)
+			threads[t].join();
+	}
+
+private:
+	int m_threadCount;
+	int m_errorCount;
+};
+
+/// Builds a compact heightfield with a distance field over rolling terrain that is cut into
+/// rooms by walls with doorways and crossed by a bridge, so that the build steps see
+/// irregular regions, holes and overlapping floors.
+inline bool buildTestCompactHeightfield(rcContext* ctx, int size, rcCompactHeightfield& chf)
+{
+	const float cs = 0.3f;
+	const float ch = 0.2f;
+	const float bmin[3] = { 0.0f, 0.0f, 0.0f };
+	const float bmax[3] = { size * cs, 100.0f, size * cs };
+
+	rcHeightfield hf;
+	if (!rcCreateHeightfield(ctx, hf, size, size, bmin, bmax, cs, ch))
+		return false;
+
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			const int ground = 20 + (int)(8.0f * sinf(x * 0.05f) * cosf(z * 0.07f));
+			const bool wall = (x % 47 == 0 && z % 31 > 6) || (z % 53 == 0 && x % 29 > 5);
+			const bool pillar = (x % 13 < 2) && (z % 17 < 2);
+			if (wall || pillar)
+			{
+				rcAddSpan(ctx, hf, x, z, 0, (unsigned short)(ground + 40), RC_NULL_AREA, 1);
+				continue;
+			}
+			rcAddSpan(ctx, hf, x, z, 0, (unsigned short)ground, RC_WALKABLE_AREA, 1);
+
+			// A bridge over the terrain.
+			if (z >= size/2 - 4 && z < size/2 + 4)
+				rcAddSpan(ctx, hf, x, z, (unsigned short)(ground + 30), (unsigned short)(ground + 32), RC_WALKABLE_AREA, 1);
+		}
+	}
+
+	const int walkableHeight = 10;
+	const int walkableClimb = 4;
+	return rcBuildCompactHeightfield(ctx, walkableHeight, walkableClimb, hf, chf) &&
+		rcErodeWalkableArea(ctx, 2, chf) &&
+		rcBuildDistanceField(ctx, chf);
+}
+
+#endif  // RECAST_TESTS_RECASTTESTUTILS_H
@@ -258,3 +258,111 @@ TEST_CASE("rcVector", "[recast, alloc]")
 		v.clear();
 	}
 }
+
+TEST_CASE("rcTempArena", "[recast, alloc]")
+{
+	rcTempArena arena;
+	REQUIRE(arena.init(4096));
+
+	SECTION("Temp allocations come from the bound arena")
+	{
+		void* perm = NULL;
+		{
+			rcScopedTempArena scope(arena);
+			void* temp = rcAlloc(100, RC_ALLOC_TEMP);
+			perm = rcAlloc(100, RC_ALLOC_PERM);
+			REQUIRE(arena.owns(temp));
+			REQUIRE(!arena.owns(perm));
+			REQUIRE((reinterpret_cast<uintptr_t>(temp) & 15) == 0);
+			REQUIRE(arena.getUsed() > 100);
+			rcFree(temp);
+			REQUIRE(arena.getUsed() == 0);
+		}
+
+		// Outside of the scope temp allocations come from the heap again.
+		void* temp = rcAlloc(100, RC_ALLOC_TEMP);
+		REQUIRE(!arena.owns(temp));
+		rcFree(temp);
+		rcFree(perm);
+	}
+
+	SECTION("Freed blocks are reclaimed once they reach the top")
+	{
+		rcScopedTempArena scope(arena);
+		void* a = rcAlloc(64, RC_ALLOC_TEMP);
+		const size_t usedA = arena.getUsed();
+		void* b = rcAlloc(64, RC_ALLOC_TEMP);
+		void* c = rcAlloc(64, RC_ALLOC_TEMP);
+		const size_t peak = arena.getUsed();
+
+		rcFree(b);
+		REQUIRE(arena.getUsed() == peak);
+		rcFree(c);
+		REQUIRE(arena.getUsed() == usedA);
+		rcFree(a);
+		REQUIRE(arena.getUsed() == 0);
+		REQUIRE(arena.getPeakUsed() == peak);
+
+		arena.resetStats();
+		REQUIRE(arena.getPeakUsed() == 0);
+	}
+
+	SECTION("Allocations that do not fit fall back to the heap")
+	{
+		rcScopedTempArena scope(arena);
+		void* small = rcAlloc(1024, RC_ALLOC_TEMP);
+		void* big = rcAlloc(8192, RC_ALLOC_TEMP);
+		REQUIRE(arena.owns(small));
+		REQUIRE(big != NULL);
+		REQUIRE(!arena.owns(big));
+		REQUIRE(arena.getOverflowCount() == 1);
+		rcFree(big);
+		rcFree(small);
+	}
+
+	SECTION("The arena is reset when the scope ends")
+	{
+		{
+			rcScopedTempArena scope(arena);
+			rcAlloc(256, RC_ALLOC_TEMP);
+			REQUIRE(arena.getUsed() > 0);
+		}
+		REQUIRE(arena.getUsed() == 0);
+		REQUIRE(arena.getPeakUsed() > 256);
+	}
+
+	SECTION("Nested scopes")
+	{
+		rcTempArena inner;
+		REQUIRE(inner.init(4096));
+
+		rcScopedTempArena outerScope(arena);
+		void* a = rcAlloc(32, RC_ALLOC_TEMP);
+		{
+			rcScopedTempArena innerScope(inner);
+			void* b = rcAlloc(32, RC_ALLOC_TEMP);
+			REQUIRE(inner.owns(b));
+			// Memory of the outer arena can still be freed while the inner one is bound.
+			rcFree(a);
+			REQUIRE(arena.getUsed() == 0);
+			rcFree(b);
+		}
+		void* c = rcAlloc(32, RC_ALLOC_TEMP);
+		REQUIRE(arena.owns(c));
+		rcFree(c);
+	}
+
+	SECTION("rcTempVector growth reuses the arena")
+	{
+		rcScopedTempArena scope(arena);
+		{
+			rcTempVector<int> v;
+			for (int i = 0; i < 256; i++)
+				v.push_back(i);
+			REQUIRE(arena.owns(v.data()));
+			REQUIRE(v[255] == 255);
+		}
+		REQUIRE(arena.getUsed() == 0);
+		REQUIRE(arena.getOverflowCount() == 0);
+	}
+}
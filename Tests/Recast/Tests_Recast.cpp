@@ -935,3 +935,135 @@ TEST_CASE("rcRasterizeTriangles", "[recast]")
 		REQUIRE(!solid.spans[1 + 2 * width]->next);
 	}
 }
+
+TEST_CASE("rcContext allocation statistics", "[recast]")
+{
+	rcContext context;
+
+	SECTION("Nothing is tracked until enabled")
+	{
+		void* ptr = rcAlloc(100, RC_ALLOC_PERM);
+		rcFree(ptr);
+		REQUIRE(context.getAllocStats(RC_ALLOC_PERM).allocCount == 0);
+	}
+
+	SECTION("Allocations are charged to their hint")
+	{
+		REQUIRE(context.enableAllocStats(true));
+		void* perm = rcAlloc(100, RC_ALLOC_PERM);
+		void* temp = rcAlloc(50, RC_ALLOC_TEMP);
+
+		REQUIRE(context.getAllocStats(RC_ALLOC_PERM).allocCount == 1);
+		REQUIRE(context.getAllocStats(RC_ALLOC_PERM).liveBytes == 100);
+		REQUIRE(context.getAllocStats(RC_ALLOC_TEMP).liveBytes == 50);
+
+		rcFree(temp);
+		REQUIRE(context.getAllocStats(RC_ALLOC_TEMP).liveBytes == 0);
+		REQUIRE(context.getAllocStats(RC_ALLOC_TEMP).peakBytes == 50);
+
+		rcFree(perm);
+		REQUIRE(context.getAllocStats(RC_ALLOC_PERM).liveBytes == 0);
+		context.enableAllocStats(false);
+	}
+
+	SECTION("Allocations are charged to the innermost timer")
+	{
+		REQUIRE(context.enableAllocStats(true));
+		void* outer = NULL;
+		void* inner = NULL;
+		{
+			rcScopedTimer regionsTimer(&context, RC_TIMER_BUILD_REGIONS);
+			outer = rcAlloc(1000, RC_ALLOC_PERM);
+			{
+				rcScopedTimer filterTimer(&context, RC_TIMER_BUILD_REGIONS_FILTER);
+				inner = rcAlloc(200, RC_ALLOC_TEMP);
+				rcFree(inner);
+			}
+		}
+
+		const rcAllocCounters regions = context.getAllocStats(RC_TIMER_BUILD_REGIONS);
+		const rcAllocCounters filter = context.getAllocStats(RC_TIMER_BUILD_REGIONS_FILTER);
+		REQUIRE(regions.allocCount == 1);
+		REQUIRE(regions.liveBytes == 1000);
+		REQUIRE(regions.peakBytes == 1200);
+		REQUIRE(filter.allocCount == 1);
+		REQUIRE(filter.liveBytes == 0);
+		REQUIRE(filter.peakBytes == 1200);
+
+		rcFree(outer);
+		REQUIRE(context.getAllocStats(RC_TIMER_BUILD_REGIONS).liveBytes == 0);
+
+		context.resetAllocStats();
+		REQUIRE(context.getAllocStats(RC_TIMER_BUILD_REGIONS).allocCount == 0);
+		context.enableAllocStats(false);
+	}
+
+	SECTION("Many live blocks")
+	{
+		REQUIRE(context.enableAllocStats(true));
+		const int count = 5000;
+		void* ptrs[count];
+		for (int i = 0; i < count; ++i)
+			ptrs[i] = rcAlloc(i + 1, RC_ALLOC_TEMP);
+		REQUIRE(context.getAllocStats(RC_ALLOC_TEMP).liveBytes == (size_t)count*(count+1)/2);
+		for (int i = 0; i < count; i += 2)
+			rcFree(ptrs[i]);
+		for (int i = 1; i < count; i += 2)
+			rcFree(ptrs[i]);
+		REQUIRE(context.getAllocStats(RC_ALLOC_TEMP).liveBytes == 0);
+		REQUIRE(context.getAllocStats(RC_ALLOC_TEMP).allocCount == count);
+		context.enableAllocStats(false);
+	}
+
+	SECTION("Statistics can be disabled out of order")
+	{
+		rcContext inner;
+		REQUIRE(context.enableAllocStats(true));
+		REQUIRE(inner.enableAllocStats(true));
+		const int outerCount = context.getAllocStats(RC_ALLOC_PERM).allocCount;
+		void* first = rcAlloc(10, RC_ALLOC_PERM);
+
+		REQUIRE(context.enableAllocStats(false));
+		void* second = rcAlloc(20, RC_ALLOC_PERM);
+		REQUIRE(context.getAllocStats(RC_ALLOC_PERM).allocCount == outerCount);
+		REQUIRE(inner.getAllocStats(RC_ALLOC_PERM).allocCount == 2);
+		REQUIRE(inner.getAllocStats(RC_ALLOC_PERM).liveBytes == 30);
+
+		REQUIRE(inner.enableAllocStats(false));
+		REQUIRE(rcAllocSetThreadTracker(NULL) == NULL);
+		rcFree(first);
+		rcFree(second);
+		REQUIRE(inner.getAllocStats(RC_ALLOC_PERM).liveBytes == 30);
+	}
+
+	SECTION("Statistics under a custom tracker stay bound")
+	{
+		struct NullTracker : public rcAllocTracker
+		{
+			virtual void trackAlloc(void*, size_t, rcAllocHint) {}
+			virtual void trackFree(void*) {}
+		} tracker;
+
+		REQUIRE(context.enableAllocStats(true));
+		rcAllocTracker* previous = rcAllocSetThreadTracker(&tracker);
+		REQUIRE(!context.enableAllocStats(false));
+		REQUIRE(rcAllocSetThreadTracker(previous) == &tracker);
+		REQUIRE(context.enableAllocStats(false));
+	}
+
+	SECTION("Copies start without statistics")
+	{
+		REQUIRE(context.enableAllocStats(true));
+		void* ptr = rcAlloc(100, RC_ALLOC_PERM);
+		{
+			rcContext copy(context);
+			REQUIRE(copy.getAllocStats(RC_ALLOC_PERM).allocCount == 0);
+			copy = context;
+			REQUIRE(copy.getAllocStats(RC_ALLOC_PERM).allocCount == 0);
+		}
+		rcFree(ptr);
+		REQUIRE(context.getAllocStats(RC_ALLOC_PERM).allocCount == 1);
+		REQUIRE(context.getAllocStats(RC_ALLOC_PERM).liveBytes == 0);
+		context.enableAllocStats(false);
+	}
+}
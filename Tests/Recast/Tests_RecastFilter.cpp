@@ -1,11 +1,13 @@
 ﻿#include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <vector>
 
 #include "catch2/catch_all.hpp"
 
 #include "Recast.h"
 #include "RecastAlloc.h"
+#include "RecastTestUtils.h"
 
 TEST_CASE("rcFilterLowHangingWalkableObstacles", "[recast, filtering]")
 {
@@ -336,4 +338,196 @@ TEST_CASE("rcFilterWalkableLowHeightSpans", "[recast, filtering]")
 		rcFree(overheadSpan);
 		rcFree(span);
 	}
-}
\ No newline at end of file
+}
+
+// Reference median filter, sorting the 9 areas around each span.
+static std::vector<unsigned char> referenceMedianFilter(const rcCompactHeightfield& chf)
+{
+	std::vector<unsigned char> result(chf.areas, chf.areas + chf.spanCount);
+	for (int y = 0; y < chf.height; ++y)
+	{
+		for (int x = 0; x < chf.width; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x + y * chf.width];
+			for (int i = (int)c.index, ni = (int)(c.index + c.count); i < ni; ++i)
+			{
+				if (chf.areas[i] == RC_NULL_AREA)
+					continue;
+				unsigned char nei[9];
+				for (int j = 0; j < 9; ++j)
+					nei[j] = chf.areas[i];
+				const rcCompactSpan& s = chf.spans[i];
+				for (int dir = 0; dir < 4; ++dir)
+				{
+					if (rcGetCon(s, dir) == RC_NOT_CONNECTED)
+						continue;
+					const int ax = x + rcGetDirOffsetX(dir);
+					const int ay = y + rcGetDirOffsetY(dir);
+					const int ai = (int)chf.cells[ax + ay * chf.width].index + rcGetCon(s, dir);
+					if (chf.areas[ai] != RC_NULL_AREA)
+						nei[dir * 2 + 0] = chf.areas[ai];
+					const int dir2 = (dir + 1) & 0x3;
+					if (rcGetCon(chf.spans[ai], dir2) != RC_NOT_CONNECTED)
+					{
+						const int bx = ax + rcGetDirOffsetX(dir2);
+						const int by = ay + rcGetDirOffsetY(dir2);
+						const int bi = (int)chf.cells[bx + by * chf.width].index + rcGetCon(chf.spans[ai], dir2);
+						if (chf.areas[bi] != RC_NULL_AREA)
+							nei[dir * 2 + 1] = chf.areas[bi];
+					}
+				}
+				std::sort(nei, nei + 9);
+				result[i] = nei[4];
+			}
+		}
+	}
+	return result;
+}
+
+TEST_CASE("Area filters on multiple threads", "[recast, filtering]")
+{
+	TestTaskContext serialContext(1);
+	TestTaskContext threadedContext(4);
+	const int size = 200;
+
+	rcCompactHeightfield serial;
+	REQUIRE(buildTestCompactHeightfield(&serialContext, size, serial));
+	rcCompactHeightfield threaded;
+	REQUIRE(buildTestCompactHeightfield(&threadedContext, size, threaded));
+
+	// Scatter a few area types so the median has something to choose from.
+	for (int i = 0; i < serial.spanCount; ++i)
+	{
+		if (serial.areas[i] != RC_NULL_AREA)
+		{
+			const unsigned char area = (unsigned char)(1 + (i * 7919) % 5);
+			serial.areas[i] = area;
+			threaded.areas[i] = area;
+		}
+	}
+
+	SECTION("Median filter matches sorting all 9 areas")
+	{
+		const std::vector<unsigned char> expected = referenceMedianFilter(serial);
+		REQUIRE(rcMedianFilterWalkableArea(&threadedContext, threaded));
+		REQUIRE(std::vector<unsigned char>(threaded.areas, threaded.areas + threaded.spanCount) == expected);
+	}
+
+	SECTION("Erosion is independent of the thread count")
+	{
+		REQUIRE(rcErodeWalkableArea(&serialContext, 3, serial));
+		REQUIRE(rcErodeWalkableArea(&threadedContext, 3, threaded));
+		REQUIRE(memcmp(serial.areas, threaded.areas, sizeof(unsigned char) * serial.spanCount) == 0);
+	}
+}
+
+// Lowers the distance of a span to the distance of a neighbour plus a cost.
+static void relaxErodeDistance(std::vector<unsigned char>& dist, int i, int nei, int cost)
+{
+	const unsigned char d = (unsigned char)rcMin((int)dist[nei] + cost, 255);
+	if (d < dist[i])
+		dist[i] = d;
+}
+
+// Reference erosion, the chamfer distance of rcErodeWalkableArea computed one span at a time.
+static std::vector<unsigned char> referenceErode(const rcCompactHeightfield& chf, int radius)
+{
+	const int w = chf.width;
+	std::vector<unsigned char> dist(chf.spanCount, 0xff);
+	for (int y = 0; y < chf.height; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x + y * w];
+			for (int i = (int)c.index, ni = (int)(c.index + c.count); i < ni; ++i)
+			{
+				int neis = 0;
+				for (int dir = 0; dir < 4 && chf.areas[i] != RC_NULL_AREA; ++dir)
+				{
+					const int con = rcGetCon(chf.spans[i], dir);
+					if (con == RC_NOT_CONNECTED)
+						break;
+					const int ai = (int)chf.cells[(x + rcGetDirOffsetX(dir)) + (y + rcGetDirOffsetY(dir)) * w].index + con;
+					if (chf.areas[ai] == RC_NULL_AREA)
+						break;
+					neis++;
+				}
+				if (neis != 4)
+					dist[i] = 0;
+			}
+		}
+	}
+
+	// The two sweeps, each through a straight and a diagonal neighbour in two directions.
+	const int sweepDirs[2][2][2] = { { { 0, 3 }, { 3, 2 } }, { { 2, 1 }, { 1, 0 } } };
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (int k = 0; k < chf.width * chf.height; ++k)
+		{
+			const int cellIndex = pass == 0 ? k : chf.width * chf.height - 1 - k;
+			const int x = cellIndex % w;
+			const int y = cellIndex / w;
+			const rcCompactCell& c = chf.cells[cellIndex];
+			for (int i = (int)c.index, ni = (int)(c.index + c.count); i < ni; ++i)
+			{
+				for (int n = 0; n < 2; ++n)
+				{
+					const int dir = sweepDirs[pass][n][0];
+					const int dir2 = sweepDirs[pass][n][1];
+					if (rcGetCon(chf.spans[i], dir) == RC_NOT_CONNECTED)
+						continue;
+					const int ax = x + rcGetDirOffsetX(dir);
+					const int ay = y + rcGetDirOffsetY(dir);
+					const int ai = (int)chf.cells[ax + ay * w].index + rcGetCon(chf.spans[i], dir);
+					relaxErodeDistance(dist, i, ai, 2);
+					if (rcGetCon(chf.spans[ai], dir2) == RC_NOT_CONNECTED)
+						continue;
+					const int bi = (int)chf.cells[(ax + rcGetDirOffsetX(dir2)) + (ay + rcGetDirOffsetY(dir2)) * w].index + rcGetCon(chf.spans[ai], dir2);
+					relaxErodeDistance(dist, i, bi, 3);
+				}
+			}
+		}
+	}
+
+	std::vector<unsigned char> result(chf.areas, chf.areas + chf.spanCount);
+	for (int i = 0; i < chf.spanCount; ++i)
+	{
+		if (dist[i] < radius * 2)
+			result[i] = RC_NULL_AREA;
+	}
+	return result;
+}
+
+TEST_CASE("Erosion with empty cells", "[recast, filtering]")
+{
+	TestTaskContext serialContext(1);
+	TestTaskContext threadedContext(4);
+	const int size = 64;
+	const float bmin[3] = { 0.0f, 0.0f, 0.0f };
+	const float bmax[3] = { size * 0.3f, 10.0f, size * 0.3f };
+
+	// A field with an empty last column, empty first cells of some bands of rows and a hole.
+	rcHeightfield hf;
+	REQUIRE(rcCreateHeightfield(&serialContext, hf, size, size, bmin, bmax, 0.3f, 0.2f));
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			const bool empty = x == size - 1 || (x == 0 && z % 32 == 0) || (x > 20 && x < 26 && z > 10 && z < 50);
+			if (!empty)
+				REQUIRE(rcAddSpan(&serialContext, hf, x, z, 0, 10, RC_WALKABLE_AREA, 1));
+		}
+	}
+
+	rcCompactHeightfield serial;
+	REQUIRE(rcBuildCompactHeightfield(&serialContext, 10, 4, hf, serial));
+	rcCompactHeightfield threaded;
+	REQUIRE(rcBuildCompactHeightfield(&threadedContext, 10, 4, hf, threaded));
+
+	const int radius = 2;
+	const std::vector<unsigned char> expected = referenceErode(serial, radius);
+	REQUIRE(rcErodeWalkableArea(&serialContext, radius, serial));
+	REQUIRE(rcErodeWalkableArea(&threadedContext, radius, threaded));
+	REQUIRE(std::vector<unsigned char>(serial.areas, serial.areas + serial.spanCount) == expected);
+	REQUIRE(std::vector<unsigned char>(threaded.areas, threaded.areas + threaded.spanCount) == expected);
+}
@@ -0,0 +1,107 @@
+#include <string.h>
+
+#include "catch2/catch_all.hpp"
+
+#include "Recast.h"
+#include "RecastAlloc.h"
+#include "RecastTestUtils.h"
+
+TEST_CASE("rcBuildHeightfieldLayersBatch on multiple threads", "[recast, layers]")
+{
+	TestTaskContext serialContext(1);
+	TestTaskContext threadedContext(4);
+
+	// Tiles of different sizes, with a border like the tiles of a tile cache.
+	const int count = 5;
+	const int borderSize = 4;
+	const int walkableHeight = 10;
+	rcCompactHeightfield chfs[count];
+	const rcCompactHeightfield* chfPtrs[count];
+	for (int i = 0; i < count; ++i)
+	{
+		REQUIRE(buildTestCompactHeightfield(&serialContext, 48 + i * 16, chfs[i]));
+		chfPtrs[i] = &chfs[i];
+	}
+
+	rcHeightfieldLayerSet lsets[count];
+	rcHeightfieldLayerSet* lsetPtrs[count];
+	for (int i = 0; i < count; ++i)
+		lsetPtrs[i] = &lsets[i];
+	bool built[count];
+	REQUIRE(rcBuildHeightfieldLayersBatch(&threadedContext, count, chfPtrs, borderSize, walkableHeight, lsetPtrs, built));
+	REQUIRE(threadedContext.getErrorCount() == 0);
+
+	for (int i = 0; i < count; ++i)
+	{
+		REQUIRE(built[i]);
+		rcHeightfieldLayerSet expected;
+		REQUIRE(rcBuildHeightfieldLayers(&serialContext, chfs[i], borderSize, walkableHeight, expected));
+		REQUIRE(expected.nlayers > 1);
+		REQUIRE(lsets[i].nlayers == expected.nlayers);
+		for (int j = 0; j < expected.nlayers; ++j)
+		{
+			const rcHeightfieldLayer& layer = lsets[i].layers[j];
+			const rcHeightfieldLayer& expectedLayer = expected.layers[j];
+			REQUIRE(memcmp(layer.bmin, expectedLayer.bmin, sizeof(layer.bmin)) == 0);
+			REQUIRE(memcmp(layer.bmax, expectedLayer.bmax, sizeof(layer.bmax)) == 0);
+			REQUIRE(layer.width == expectedLayer.width);
+			REQUIRE(layer.height == expectedLayer.height);
+			REQUIRE(layer.minx == expectedLayer.minx);
+			REQUIRE(layer.maxx == expectedLayer.maxx);
+			REQUIRE(layer.miny == expectedLayer.miny);
+			REQUIRE(layer.maxy == expectedLayer.maxy);
+			REQUIRE(layer.hmin == expectedLayer.hmin);
+			REQUIRE(layer.hmax == expectedLayer.hmax);
+			const int size = layer.width * layer.height;
+			REQUIRE(memcmp(layer.heights, expectedLayer.heights, size) == 0);
+			REQUIRE(memcmp(layer.areas, expectedLayer.areas, size) == 0);
+			REQUIRE(memcmp(layer.cons, expectedLayer.cons, size) == 0);
+		}
+	}
+}
+
+TEST_CASE("rcBuildHeightfieldLayersBatch with a failed heightfield", "[recast, layers]")
+{
+	TestTaskContext serialContext(1);
+	TestTaskContext threadedContext(4);
+
+	const int borderSize = 4;
+	const int walkableHeight = 10;
+	rcCompactHeightfield chfs[3];
+	REQUIRE(buildTestCompactHeightfield(&serialContext, 48, chfs[0]));
+	REQUIRE(buildTestCompactHeightfield(&serialContext, 64, chfs[2]));
+
+	// A floor under more separate platforms than a region can overlap.
+	const int size = 32;
+	const float bmin[3] = { 0.0f, 0.0f, 0.0f };
+	const float bmax[3] = { size * 0.3f, 100.0f, size * 0.3f };
+	rcHeightfield hf;
+	REQUIRE(rcCreateHeightfield(&serialContext, hf, size, size, bmin, bmax, 0.3f, 0.2f));
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			REQUIRE(rcAddSpan(&serialContext, hf, x, z, 0, 2, RC_WALKABLE_AREA, 1));
+			if (x % 2 == 0 && z % 2 == 0)
+				REQUIRE(rcAddSpan(&serialContext, hf, x, z, 20, 22, RC_WALKABLE_AREA, 1));
+		}
+	}
+	REQUIRE(rcBuildCompactHeightfield(&serialContext, walkableHeight, 4, hf, chfs[1]));
+
+	const rcCompactHeightfield* chfPtrs[3] = { &chfs[0], &chfs[1], &chfs[2] };
+	rcHeightfieldLayerSet lsets[3];
+	rcHeightfieldLayerSet* lsetPtrs[3] = { &lsets[0], &lsets[1], &lsets[2] };
+	bool built[3];
+	REQUIRE(!rcBuildHeightfieldLayersBatch(&threadedContext, 3, chfPtrs, borderSize, walkableHeight, lsetPtrs, built));
+	// The error of the failed heightfield is logged once, by its task.
+	REQUIRE(threadedContext.getErrorCount() == 1);
+
+	// Only the layers of the failed heightfield are missing.
+	REQUIRE(built[0]);
+	REQUIRE(!built[1]);
+	REQUIRE(lsets[1].nlayers == 0);
+	REQUIRE(lsets[1].layers == 0);
+	REQUIRE(built[2]);
+	REQUIRE(lsets[0].nlayers > 0);
+	REQUIRE(lsets[2].nlayers > 0);
+}
@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+#include "Recast.h"
+#include "RecastTestUtils.h"
+
+typedef std::vector<unsigned short> Poly;
+
+static bool isLeft(const unsigned short* a, const unsigned short* b, const unsigned short* c)
+{
+	return ((int)b[0] - (int)a[0]) * ((int)c[2] - (int)a[2]) -
+		   ((int)c[0] - (int)a[0]) * ((int)b[2] - (int)a[2]) < 0;
+}
+
+// Reference for the merge value of two polygons: the squared length of the shared edge if
+// the merged polygon is convex and small enough, otherwise -1.
+static int referenceMergeValue(const Poly& pa, const Poly& pb, const unsigned short* verts, int nvp, int& ea, int& eb)
+{
+	const int na = (int)pa.size();
+	const int nb = (int)pb.size();
+	if (na + nb - 2 > nvp)
+		return -1;
+
+	ea = -1;
+	eb = -1;
+	for (int i = 0; i < na; ++i)
+	{
+		const int a0 = std::min(pa[i], pa[(i+1) % na]);
+		const int a1 = std::max(pa[i], pa[(i+1) % na]);
+		for (int j = 0; j < nb; ++j)
+		{
+			if (a0 == std::min(pb[j], pb[(j+1) % nb]) && a1 == std::max(pb[j], pb[(j+1) % nb]))
+			{
+				ea = i;
+				eb = j;
+				break;
+			}
+		}
+	}
+	if (ea == -1)
+		return -1;
+
+	if (!isLeft(&verts[pa[(ea+na-1) % na]*3], &verts[pa[ea]*3], &verts[pb[(eb+2) % nb]*3]))
+		return -1;
+	if (!isLeft(&verts[pb[(eb+nb-1) % nb]*3], &verts[pb[eb]*3], &verts[pa[(ea+2) % na]*3]))
+		return -1;
+
+	const int dx = (int)verts[pa[ea]*3+0] - (int)verts[pa[(ea+1) % na]*3+0];
+	const int dz = (int)verts[pa[ea]*3+2] - (int)verts[pa[(ea+1) % na]*3+2];
+	return dx*dx + dz*dz;
+}
+
+// Reference merge that scans every pair of polygons for the best merge each step.
+static void referenceMerge(std::vector<Poly>& polys, const unsigned short* verts, int nvp)
+{
+	for (;;)
+	{
+		int bestValue = 0;
+		int bestA = 0, bestB = 0, bestEa = 0, bestEb = 0;
+		for (size_t a = 0; a + 1 < polys.size(); ++a)
+		{
+			for (size_t b = a + 1; b < polys.size(); ++b)
+			{
+				int ea, eb;
+				const int value = referenceMergeValue(polys[a], polys[b], verts, nvp, ea, eb);
+				if (value > bestValue)
+				{
+					bestValue = value;
+					bestA = (int)a;
+					bestB = (int)b;
+					bestEa = ea;
+					bestEb = eb;
+				}
+			}
+		}
+		if (bestValue <= 0)
+			break;
+
+		const Poly pa = polys[bestA];
+		const Poly pb = polys[bestB];
+		Poly merged;
+		for (size_t i = 0; i + 1 < pa.size(); ++i)
+			merged.push_back(pa[(bestEa + 1 + i) % pa.size()]);
+		for (size_t i = 0; i + 1 < pb.size(); ++i)
+			merged.push_back(pb[(bestEb + 1 + i) % pb.size()]);
+		polys[bestA] = merged;
+		polys[bestB] = polys.back();
+		polys.pop_back();
+	}
+}
+
+static Poly getPoly(const rcPolyMesh& mesh, int i)
+{
+	Poly poly;
+	const unsigned short* p = &mesh.polys[i * mesh.nvp * 2];
+	for (int j = 0; j < mesh.nvp && p[j] != RC_MESH_NULL_IDX; ++j)
+		poly.push_back(p[j]);
+	return poly;
+}
+
+TEST_CASE("rcBuildPolyMesh merges in the same order as an exhaustive search", "[recast, mesh]")
+{
+	rcContext ctx;
+	rcCompactHeightfield chf;
+	REQUIRE(buildTestCompactHeightfield(&ctx, 128, chf));
+	REQUIRE(rcBuildRegions(&ctx, chf, 0, 8, 20));
+	rcContourSet cset;
+	REQUIRE(rcBuildContours(&ctx, chf, 1.3f, 12, cset));
+
+	const int nvp = 6;
+	rcPolyMesh triMesh;
+	REQUIRE(rcBuildPolyMesh(&ctx, cset, 3, triMesh));
+	rcPolyMesh mesh;
+	REQUIRE(rcBuildPolyMesh(&ctx, cset, nvp, mesh));
+	REQUIRE(mesh.nverts == triMesh.nverts);
+	REQUIRE(memcmp(mesh.verts, triMesh.verts, sizeof(unsigned short) * mesh.nverts * 3) == 0);
+
+	// The triangles of each contour are stored together, merge them with the reference.
+	std::vector<Poly> expected;
+	for (int first = 0; first < triMesh.npolys;)
+	{
+		int last = first + 1;
+		while (last < triMesh.npolys && triMesh.regs[last] == triMesh.regs[first])
+			last++;
+
+		std::vector<Poly> polys;
+		for (int i = first; i < last; ++i)
+			polys.push_back(getPoly(triMesh, i));
+		referenceMerge(polys, triMesh.verts, nvp);
+		expected.insert(expected.end(), polys.begin(), polys.end());
+		first = last;
+	}
+
+	REQUIRE(mesh.npolys == (int)expected.size());
+	for (int i = 0; i < mesh.npolys; ++i)
+		REQUIRE(getPoly(mesh, i) == expected[i]);
+}
+
+TEST_CASE("rcMergePolyMeshes welds the vertices of overlapping meshes", "[recast, mesh]")
+{
+	rcContext ctx;
+	rcCompactHeightfield chf;
+	REQUIRE(buildTestCompactHeightfield(&ctx, 96, chf));
+	REQUIRE(rcBuildRegions(&ctx, chf, 0, 8, 20));
+	rcContourSet cset;
+	REQUIRE(rcBuildContours(&ctx, chf, 1.3f, 12, cset));
+
+	// The same mesh three times, shifted so that they overlap.
+	const int nmeshes = 3;
+	const int shift = 32;
+	rcPolyMesh meshes[nmeshes];
+	rcPolyMesh* meshPtrs[nmeshes];
+	for (int i = 0; i < nmeshes; ++i)
+	{
+		REQUIRE(rcBuildPolyMesh(&ctx, cset, 6, meshes[i]));
+		meshes[i].bmin[0] += i * shift * meshes[i].cs;
+		meshes[i].bmax[0] += i * shift * meshes[i].cs;
+		meshPtrs[i] = &meshes[i];
+	}
+
+	rcPolyMesh merged;
+	REQUIRE(rcMergePolyMeshes(&ctx, meshPtrs, nmeshes, merged));
+
+	// Reference weld: the most recently added vertex at the same xz-position within 2 units of height.
+	std::vector<unsigned short> verts;
+	std::vector<int> remap;
+	for (int i = 0; i < nmeshes; ++i)
+	{
+		for (int j = 0; j < meshes[i].nverts; ++j)
+		{
+			const unsigned short* v = &meshes[i].verts[j * 3];
+			const unsigned short x = (unsigned short)(v[0] + i * shift);
+			int found = -1;
+			for (int k = (int)verts.size() / 3 - 1; k >= 0 && found == -1; --k)
+			{
+				if (verts[k*3+0] == x && verts[k*3+2] == v[2] && rcAbs((int)verts[k*3+1] - (int)v[1]) <= 2)
+					found = k;
+			}
+			if (found == -1)
+			{
+				found = (int)verts.size() / 3;
+				verts.push_back(x);
+				verts.push_back(v[1]);
+				verts.push_back(v[2]);
+			}
+			remap.push_back(found);
+		}
+	}
+
+	REQUIRE(merged.nverts == (int)verts.size() / 3);
+	REQUIRE(merged.nverts < meshes[0].nverts * nmeshes);
+	REQUIRE(memcmp(merged.verts, verts.data(), sizeof(unsigned short) * verts.size()) == 0);
+
+	int firstVert = 0;
+	int poly = 0;
+	for (int i = 0; i < nmeshes; ++i)
+	{
+		for (int j = 0; j < meshes[i].npolys; ++j, ++poly)
+		{
+			const unsigned short* src = &meshes[i].polys[j * meshes[i].nvp * 2];
+			const unsigned short* dst = &merged.polys[poly * merged.nvp * 2];
+			for (int k = 0; k < merged.nvp && src[k] != RC_MESH_NULL_IDX; ++k)
+				REQUIRE(dst[k] == remap[firstVert + src[k]]);
+		}
+		firstVert += meshes[i].nverts;
+	}
+}
+
+TEST_CASE("rcBuildPolyMeshDetail on multiple threads", "[recast, mesh]")
+{
+	TestTaskContext serialContext(1);
+	TestTaskContext threadedContext(4);
+
+	rcCompactHeightfield chf;
+	REQUIRE(buildTestCompactHeightfield(&serialContext, 256, chf));
+	REQUIRE(rcBuildRegions(&serialContext, chf, 0, 8, 20));
+	rcContourSet cset;
+	REQUIRE(rcBuildContours(&serialContext, chf, 1.3f, 12, cset));
+	rcPolyMesh mesh;
+	REQUIRE(rcBuildPolyMesh(&serialContext, cset, 6, mesh));
+
+	rcPolyMeshDetail expected;
+	REQUIRE(rcBuildPolyMeshDetail(&serialContext, mesh, chf, 1.8f, 0.2f, expected));
+	rcPolyMeshDetail dmesh;
+	REQUIRE(rcBuildPolyMeshDetail(&threadedContext, mesh, chf, 1.8f, 0.2f, dmesh));
+	REQUIRE(threadedContext.getErrorCount() == 0);
+
+	REQUIRE(dmesh.nmeshes == mesh.npolys);
+	REQUIRE(dmesh.nmeshes == expected.nmeshes);
+	REQUIRE(dmesh.nverts == expected.nverts);
+	REQUIRE(dmesh.ntris == expected.ntris);
+	REQUIRE(memcmp(dmesh.meshes, expected.meshes, sizeof(unsigned int) * dmesh.nmeshes * 4) == 0);
+	REQUIRE(memcmp(dmesh.verts, expected.verts, sizeof(float) * dmesh.nverts * 3) == 0);
+	REQUIRE(memcmp(dmesh.tris, expected.tris, sizeof(unsigned char) * dmesh.ntris * 4) == 0);
+
+	// The submeshes follow each other.
+	unsigned int nverts = 0;
+	unsigned int ntris = 0;
+	for (int i = 0; i < dmesh.nmeshes; ++i)
+	{
+		REQUIRE(dmesh.meshes[i * 4 + 0] == nverts);
+		REQUIRE(dmesh.meshes[i * 4 + 2] == ntris);
+		nverts += dmesh.meshes[i * 4 + 1];
+		ntris += dmesh.meshes[i * 4 + 3];
+	}
+	REQUIRE((int)nverts == dmesh.nverts);
+	REQUIRE((int)ntris == dmesh.ntris);
+}
+
+static float cross2(const float* a, const float* b, const float* c)
+{
+	return (b[0] - a[0]) * (c[2] - a[2]) - (b[2] - a[2]) * (c[0] - a[0]);
+}
+
+TEST_CASE("rcBuildPolyMeshDetail builds Delaunay triangulations of the sampled polygons", "[recast, mesh]")
+{
+	rcContext ctx;
+	rcCompactHeightfield chf;
+	REQUIRE(buildTestCompactHeightfield(&ctx, 128, chf));
+	REQUIRE(rcBuildRegions(&ctx, chf, 0, 8, 20));
+	rcContourSet cset;
+	REQUIRE(rcBuildContours(&ctx, chf, 1.3f, 12, cset));
+	rcPolyMesh mesh;
+	REQUIRE(rcBuildPolyMesh(&ctx, cset, 6, mesh));
+
+	// Dense samples with a low error, so that many sample points are added.
+	rcPolyMeshDetail dmesh;
+	REQUIRE(rcBuildPolyMeshDetail(&ctx, mesh, chf, 2 * chf.cs, 0.02f, dmesh));
+	REQUIRE(dmesh.nmeshes == mesh.npolys);
+
+	int nsampled = 0;
+	for (int i = 0; i < dmesh.nmeshes; ++i)
+	{
+		const unsigned int* m = &dmesh.meshes[i * 4];
+		const float* verts = &dmesh.verts[m[0] * 3];
+		const unsigned char* tris = &dmesh.tris[m[2] * 4];
+
+		// The triangles cover the polygon and all have the winding of the polygon.
+		const unsigned short* p = &mesh.polys[i * mesh.nvp * 2];
+		std::vector<float> poly;
+		for (int j = 0; j < mesh.nvp && p[j] != RC_MESH_NULL_IDX; ++j)
+		{
+			poly.push_back(mesh.bmin[0] + mesh.verts[p[j] * 3 + 0] * mesh.cs);
+			poly.push_back(0.0f);
+			poly.push_back(mesh.bmin[2] + mesh.verts[p[j] * 3 + 2] * mesh.cs);
+		}
+		const int npoly = (int)poly.size() / 3;
+		float polyArea = 0.0f;
+		for (int j = 2; j < npoly; ++j)
+			polyArea += cross2(&poly[0], &poly[(j - 1) * 3], &poly[j * 3]);
+
+		float area = 0.0f;
+		for (unsigned int j = 0; j < m[3]; ++j)
+		{
+			const unsigned char* t = &tris[j * 4];
+			const float a = cross2(&verts[t[0] * 3], &verts[t[1] * 3], &verts[t[2] * 3]);
+			REQUIRE(a < 0.0f);
+			area += a;
+		}
+		REQUIRE(area == Catch::Approx(polyArea).epsilon(1e-4));
+
+		// Polygons with sample points inside are triangulated with empty circumcircles.
+		if (m[1] <= (unsigned int)npoly * 2)
+			continue;
+		bool inside = false;
+		for (unsigned int j = 0; j < m[1] && !inside; ++j)
+		{
+			inside = true;
+			for (int k = 0, l = npoly - 1; k < npoly; l = k++)
+				inside = inside && cross2(&poly[l * 3], &poly[k * 3], &verts[j * 3]) < -1e-3f;
+		}
+		if (!inside)
+			continue;
+		nsampled++;
+
+		for (unsigned int j = 0; j < m[3]; ++j)
+		{
+			const float* a = &verts[tris[j * 4 + 0] * 3];
+			const float* b = &verts[tris[j * 4 + 1] * 3];
+			const float* c = &verts[tris[j * 4 + 2] * 3];
+			const float d = 2.0f * cross2(a, b, c);
+			const float ab = (b[0] - a[0]) * (b[0] - a[0]) + (b[2] - a[2]) * (b[2] - a[2]);
+			const float ac = (c[0] - a[0]) * (c[0] - a[0]) + (c[2] - a[2]) * (c[2] - a[2]);
+			const float cx = ((c[2] - a[2]) * ab - (b[2] - a[2]) * ac) / d;
+			const float cz = ((b[0] - a[0]) * ac - (c[0] - a[0]) * ab) / d;
+			const float r = sqrtf(cx * cx + cz * cz);
+			for (unsigned int k = 0; k < m[1]; ++k)
+			{
+				const float* v = &verts[k * 3];
+				const float dist = sqrtf((v[0] - a[0] - cx) * (v[0] - a[0] - cx) + (v[2] - a[2] - cz) * (v[2] - a[2] - cz));
+				REQUIRE(dist >= r * (1.0f - 0.01f));
+			}
+		}
+	}
+	REQUIRE(nsampled > 0);
+}
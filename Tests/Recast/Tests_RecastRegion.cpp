@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+#include "Recast.h"
+#include "RecastAlloc.h"
+#include "RecastTestUtils.h"
+
+static std::vector<unsigned short> getRegions(const rcCompactHeightfield& chf)
+{
+	std::vector<unsigned short> regs(chf.spanCount);
+	for (int i = 0; i < chf.spanCount; ++i)
+		regs[i] = chf.spans[i].reg;
+	return regs;
+}
+
+TEST_CASE("rcBuildRegionsParallel", "[recast, region]")
+{
+	TestTaskContext serialContext(1);
+	TestTaskContext threadedContext(4);
+
+	const int size = 256;
+	const int minRegionArea = 8;
+	const int mergeRegionArea = 20;
+
+	rcCompactHeightfield chf;
+	REQUIRE(buildTestCompactHeightfield(&serialContext, size, chf));
+
+	SECTION("A single partition produces the same regions as rcBuildRegions")
+	{
+		REQUIRE(rcBuildRegions(&serialContext, chf, 0, minRegionArea, mergeRegionArea));
+		const std::vector<unsigned short> expected = getRegions(chf);
+		const unsigned short expectedMaxRegions = chf.maxRegions;
+
+		REQUIRE(rcBuildRegionsParallel(&threadedContext, chf, 0, minRegionArea, mergeRegionArea, size));
+		REQUIRE(chf.maxRegions == expectedMaxRegions);
+		REQUIRE(getRegions(chf) == expected);
+	}
+
+	SECTION("The result does not depend on the number of threads")
+	{
+		const int borderSize = 4;
+		REQUIRE(rcBuildRegionsParallel(&serialContext, chf, borderSize, minRegionArea, mergeRegionArea, 32));
+		const std::vector<unsigned short> expected = getRegions(chf);
+		const unsigned short expectedMaxRegions = chf.maxRegions;
+
+		REQUIRE(rcBuildRegionsParallel(&threadedContext, chf, borderSize, minRegionArea, mergeRegionArea, 32));
+		REQUIRE(chf.maxRegions == expectedMaxRegions);
+		REQUIRE(getRegions(chf) == expected);
+	}
+
+	SECTION("Regions produce valid contours")
+	{
+		REQUIRE(rcBuildRegionsParallel(&threadedContext, chf, 0, minRegionArea, mergeRegionArea, 64));
+		REQUIRE(threadedContext.getErrorCount() == 0);
+
+		std::vector<bool> used(chf.maxRegions, false);
+		for (int i = 0; i < chf.spanCount; ++i)
+		{
+			const unsigned short reg = chf.spans[i].reg;
+			REQUIRE(reg < chf.maxRegions);
+			used[reg] = true;
+		}
+
+		rcContourSet cset;
+		REQUIRE(rcBuildContours(&threadedContext, chf, 1.3f, 12, cset));
+		REQUIRE(threadedContext.getErrorCount() == 0);
+		REQUIRE(cset.nconts > 0);
+
+		std::vector<bool> contoured(chf.maxRegions, false);
+		for (int i = 0; i < cset.nconts; ++i)
+		{
+			// Holes merged into their outline are left without vertices.
+			REQUIRE((cset.conts[i].nverts == 0 || cset.conts[i].nverts >= 3));
+			contoured[cset.conts[i].reg] = true;
+		}
+		for (int r = 1; r < chf.maxRegions; ++r)
+			REQUIRE(contoured[r] == used[r]);
+	}
+}
+
+TEST_CASE("rcBuildContours on multiple threads", "[recast, contour]")
+{
+	TestTaskContext serialContext(1);
+	TestTaskContext threadedContext(4);
+
+	const int borderSize = 4;
+	rcCompactHeightfield chf;
+	REQUIRE(buildTestCompactHeightfield(&serialContext, 256, chf));
+	REQUIRE(rcBuildRegions(&serialContext, chf, borderSize, 8, 20));
+
+	rcContourSet expected;
+	REQUIRE(rcBuildContours(&serialContext, chf, 1.3f, 12, expected));
+	rcContourSet cset;
+	REQUIRE(rcBuildContours(&threadedContext, chf, 1.3f, 12, cset));
+	REQUIRE(threadedContext.getErrorCount() == 0);
+
+	REQUIRE(cset.nconts == expected.nconts);
+	for (int i = 0; i < cset.nconts; ++i)
+	{
+		const rcContour& cont = cset.conts[i];
+		const rcContour& expectedCont = expected.conts[i];
+		REQUIRE(cont.reg == expectedCont.reg);
+		REQUIRE(cont.area == expectedCont.area);
+		REQUIRE(cont.nverts == expectedCont.nverts);
+		REQUIRE(cont.nrverts == expectedCont.nrverts);
+		REQUIRE(memcmp(cont.verts, expectedCont.verts, sizeof(int) * cont.nverts * 4) == 0);
+		REQUIRE(memcmp(cont.rverts, expectedCont.rverts, sizeof(int) * cont.nrverts * 4) == 0);
+	}
+}
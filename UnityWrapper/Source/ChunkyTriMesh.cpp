@@ -17,9 +17,13 @@
 //
 
 #include "ChunkyTriMesh.h"
+#include "Recast.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <float.h>
 #include <math.h>
+#include <algorithm>
 
 struct BoundsItem
 {
@@ -28,30 +32,10 @@ struct BoundsItem
 	int i;
 };
 
-static int compareItemX(const void* va, const void* vb)
-{
-	const BoundsItem* a = (const BoundsItem*)va;
-	const BoundsItem* b = (const BoundsItem*)vb;
-	if (a->bmin[0] < b->bmin[0])
-		return -1;
-	if (a->bmin[0] > b->bmin[0])
-		return 1;
-	return 0;
-}
-
-static int compareItemY(const void* va, const void* vb)
-{
-	const BoundsItem* a = (const BoundsItem*)va;
-	const BoundsItem* b = (const BoundsItem*)vb;
-	if (a->bmin[1] < b->bmin[1])
-		return -1;
-	if (a->bmin[1] > b->bmin[1])
-		return 1;
-	return 0;
-}
+// Number of bins the centroids are sorted into along each axis to find the best split.
+static const int CHUNKY_BINS = 32;
 
-static void calcExtends(const BoundsItem* items, const int /*nitems*/,
-						const int imin, const int imax,
+static void calcExtends(const BoundsItem* items, const int imin, const int imax,
 						float* bmin, float* bmax)
 {
 	bmin[0] = items[imin].bmin[0];
@@ -76,32 +60,175 @@ inline int longestAxis(float x, float y)
 	return y > x ? 1 : 0;
 }
 
-static void subdivide(BoundsItem* items, int nitems, int imin, int imax, int trisPerChunk,
-					  int& curNode, rcChunkyTriMeshNode* nodes, const int maxNodes,
-					  int& curTri, int* outTris, const int* inTris)
+// Twice the centroid of an item along an axis.
+inline float itemCenter(const BoundsItem& it, const int axis)
 {
-	int inum = imax - imin;
-	int icur = curNode;
-	
-	if (curNode >= maxNodes)
-		return;
+	return it.bmin[axis] + it.bmax[axis];
+}
+
+inline int binIndex(const float c, const float cmin, const float scale)
+{
+	const int b = (int)((c - cmin) * scale);
+	return b < 0 ? 0 : (b >= CHUNKY_BINS ? CHUNKY_BINS-1 : b);
+}
+
+inline float halfPerimeter(const float* bmin, const float* bmax)
+{
+	return (bmax[0] - bmin[0]) + (bmax[1] - bmin[1]);
+}
+
+inline void mergeBounds(float* bmin, float* bmax, const float* omin, const float* omax)
+{
+	if (omin[0] < bmin[0]) bmin[0] = omin[0];
+	if (omin[1] < bmin[1]) bmin[1] = omin[1];
+	if (omax[0] > bmax[0]) bmax[0] = omax[0];
+	if (omax[1] > bmax[1]) bmax[1] = omax[1];
+}
+
+struct CompareItemCenter
+{
+	explicit CompareItemCenter(const int axis_) : axis(axis_) {}
+	bool operator()(const BoundsItem& a, const BoundsItem& b) const { return itemCenter(a, axis) < itemCenter(b, axis); }
+	int axis;
+};
+
+struct ChunkyBin
+{
+	float bmin[2];
+	float bmax[2];
+	int n;
+};
+
+/// Splits the items [imin,imax) in two and returns the index of the first item on the right.
+/// The split minimizes the surface area heuristic over the centroid bins along both axes, where
+/// the area of a 2D node is its half perimeter. Both sides keep at least half a chunk of items, so
+/// that leaves stay full, and a quarter of the items, which bounds the depth of the tree. If no
+/// bin boundary satisfies that, the items are split at the median along the longest axis.
+static int splitItems(BoundsItem* items, const int imin, const int imax, const int trisPerChunk)
+{
+	const int n = imax - imin;
+	const int minSide = rcMax(rcMax(trisPerChunk/2, n/4), 1);
+
+	float cmin[2] = { FLT_MAX, FLT_MAX };
+	float cmax[2] = { -FLT_MAX, -FLT_MAX };
+	for (int i = imin; i < imax; ++i)
+	{
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			const float c = itemCenter(items[i], axis);
+			if (c < cmin[axis]) cmin[axis] = c;
+			if (c > cmax[axis]) cmax[axis] = c;
+		}
+	}
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestBin = -1;
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		const float extent = cmax[axis] - cmin[axis];
+		if (!(extent > 0.0f))
+			continue;
+		const float scale = CHUNKY_BINS / extent;
+
+		ChunkyBin bins[CHUNKY_BINS];
+		for (int b = 0; b < CHUNKY_BINS; ++b)
+		{
+			bins[b].bmin[0] = bins[b].bmin[1] = FLT_MAX;
+			bins[b].bmax[0] = bins[b].bmax[1] = -FLT_MAX;
+			bins[b].n = 0;
+		}
+		for (int i = imin; i < imax; ++i)
+		{
+			const BoundsItem& it = items[i];
+			ChunkyBin& bin = bins[binIndex(itemCenter(it, axis), cmin[axis], scale)];
+			mergeBounds(bin.bmin, bin.bmax, it.bmin, it.bmax);
+			bin.n++;
+		}
 
+		// Cost of the right side of the split after each bin.
+		float rightCost[CHUNKY_BINS];
+		float rmin[2] = { FLT_MAX, FLT_MAX };
+		float rmax[2] = { -FLT_MAX, -FLT_MAX };
+		int nright = 0;
+		for (int b = CHUNKY_BINS-1; b > 0; --b)
+		{
+			if (bins[b].n)
+				mergeBounds(rmin, rmax, bins[b].bmin, bins[b].bmax);
+			nright += bins[b].n;
+			rightCost[b-1] = nright ? halfPerimeter(rmin, rmax) * nright : 0.0f;
+		}
+
+		float lmin[2] = { FLT_MAX, FLT_MAX };
+		float lmax[2] = { -FLT_MAX, -FLT_MAX };
+		int nleft = 0;
+		for (int b = 0; b < CHUNKY_BINS-1; ++b)
+		{
+			if (bins[b].n)
+				mergeBounds(lmin, lmax, bins[b].bmin, bins[b].bmax);
+			nleft += bins[b].n;
+			if (nleft < minSide || n - nleft < minSide)
+				continue;
+			const float cost = halfPerimeter(lmin, lmax) * nleft + rightCost[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	if (bestAxis == -1)
+	{
+		// Median split.
+		const int axis = longestAxis(cmax[0] - cmin[0], cmax[1] - cmin[1]);
+		const int isplit = imin + n/2;
+		std::nth_element(items + imin, items + isplit, items + imax, CompareItemCenter(axis));
+		return isplit;
+	}
+
+	// Partition the items by bin.
+	const float scale = CHUNKY_BINS / (cmax[bestAxis] - cmin[bestAxis]);
+	int left = imin;
+	int right = imax - 1;
+	while (left <= right)
+	{
+		if (binIndex(itemCenter(items[left], bestAxis), cmin[bestAxis], scale) <= bestBin)
+		{
+			left++;
+		}
+		else
+		{
+			std::swap(items[left], items[right]);
+			right--;
+		}
+	}
+	return left;
+}
+
+/// Builds the subtree of the items [imin,imax) in depth first order, each internal node followed by
+/// its left and right subtree. The triangles of a leaf go to the same range of @p outTris as its items.
+static void subdivide(BoundsItem* items, const int imin, const int imax, const int trisPerChunk,
+					  rcChunkyTriMeshNode* nodes, int& curNode, int* outTris, const int* inTris)
+{
+	const int inum = imax - imin;
+	const int icur = curNode;
+	
 	rcChunkyTriMeshNode& node = nodes[curNode++];
+	calcExtends(items, imin, imax, node.bmin, node.bmax);
+	node.n = inum;
 	
 	if (inum <= trisPerChunk)
 	{
 		// Leaf
-		calcExtends(items, nitems, imin, imax, node.bmin, node.bmax);
+		node.i = imin;
 		
 		// Copy triangles.
-		node.i = curTri;
-		node.n = inum;
-		
 		for (int i = imin; i < imax; ++i)
 		{
 			const int* src = &inTris[items[i].i*3];
-			int* dst = &outTris[curTri*3];
-			curTri++;
+			int* dst = &outTris[i*3];
 			dst[0] = src[0];
 			dst[1] = src[1];
 			dst[2] = src[2];
@@ -110,84 +237,223 @@ static void subdivide(BoundsItem* items, int nitems, int imin, int imax, int tri
 	else
 	{
 		// Split
-		calcExtends(items, nitems, imin, imax, node.bmin, node.bmax);
-		
-		int	axis = longestAxis(node.bmax[0] - node.bmin[0],
-							   node.bmax[1] - node.bmin[1]);
-		
-		if (axis == 0)
-		{
-			// Sort along x-axis
-			qsort(items+imin, static_cast<size_t>(inum), sizeof(BoundsItem), compareItemX);
-		}
-		else if (axis == 1)
-		{
-			// Sort along y-axis
-			qsort(items+imin, static_cast<size_t>(inum), sizeof(BoundsItem), compareItemY);
-		}
-		
-		int isplit = imin+inum/2;
+		const int isplit = splitItems(items, imin, imax, trisPerChunk);
 		
 		// Left
-		subdivide(items, nitems, imin, isplit, trisPerChunk, curNode, nodes, maxNodes, curTri, outTris, inTris);
+		subdivide(items, imin, isplit, trisPerChunk, nodes, curNode, outTris, inTris);
 		// Right
-		subdivide(items, nitems, isplit, imax, trisPerChunk, curNode, nodes, maxNodes, curTri, outTris, inTris);
+		subdivide(items, isplit, imax, trisPerChunk, nodes, curNode, outTris, inTris);
 		
-		int iescape = curNode - icur;
 		// Negative index means escape.
-		node.i = -iescape;
+		node.i = -(curNode - icur);
 	}
 }
 
-bool rcCreateChunkyTriMesh(const float* verts, const int* tris, int ntris,
-						   int trisPerChunk, rcChunkyTriMesh* cm)
+/// Returns the most nodes the subtree of @p n items can have. Every leaf but a lone root holds at
+/// least half a chunk, see splitItems.
+static int maxSubtreeNodes(const int n, const int trisPerChunk)
 {
-	int nchunks = (ntris + trisPerChunk-1) / trisPerChunk;
+	const int minLeaf = rcMax(trisPerChunk/2, 1);
+	return 2*rcMax(n / minLeaf, 1) + 1;
+}
 
-	cm->nodes = new rcChunkyTriMeshNode[nchunks*4];
-	if (!cm->nodes)
-		return false;
-		
+/// A subtree built by a task, with its own nodes.
+struct ChunkySubtree
+{
+	int imin;
+	int imax;
+	rcChunkyTriMeshNode* nodes;
+	int nnodes;
+};
+
+/// A node of the top of the tree, which is split before the subtrees are built.
+struct ChunkyTopNode
+{
+	float bmin[2];
+	float bmax[2];
+	int imin;
+	int imax;
+	// Index of the subtree if the node is built by a task, -1 otherwise.
+	int subtree;
+	// Index of the top node after the subtree of this one.
+	int end;
+};
+
+static void splitTop(BoundsItem* items, const int imin, const int imax, const int trisPerChunk, const int maxSubtreeItems,
+					 ChunkyTopNode* top, int& ntop, ChunkySubtree* subtrees, int& nsubtrees)
+{
+	ChunkyTopNode& node = top[ntop++];
+	node.imin = imin;
+	node.imax = imax;
+	if (imax - imin <= maxSubtreeItems)
+	{
+		ChunkySubtree& subtree = subtrees[nsubtrees];
+		subtree.imin = imin;
+		subtree.imax = imax;
+		subtree.nodes = 0;
+		subtree.nnodes = 0;
+		node.subtree = nsubtrees++;
+		node.end = ntop;
+		return;
+	}
+	
+	calcExtends(items, imin, imax, node.bmin, node.bmax);
+	node.subtree = -1;
+	const int isplit = splitItems(items, imin, imax, trisPerChunk);
+	splitTop(items, imin, isplit, trisPerChunk, maxSubtreeItems, top, ntop, subtrees, nsubtrees);
+	splitTop(items, isplit, imax, trisPerChunk, maxSubtreeItems, top, ntop, subtrees, nsubtrees);
+	node.end = ntop;
+}
+
+/// Calculates the XZ bounds of a range of triangles, one task per range.
+class CalcTriBoundsTasks : public rcTaskSet
+{
+public:
+	static const int TRIS_PER_TASK = 16384;
+
+	CalcTriBoundsTasks(const float* verts, const int* tris, const int ntris, BoundsItem* items) :
+		m_verts(verts), m_tris(tris), m_ntris(ntris), m_items(items)
+	{
+	}
+
+	virtual void runTask(const int taskIndex)
+	{
+		const int imin = taskIndex*TRIS_PER_TASK;
+		const int imax = rcMin(imin + TRIS_PER_TASK, m_ntris);
+		for (int i = imin; i < imax; i++)
+		{
+			const int* t = &m_tris[i*3];
+			BoundsItem& it = m_items[i];
+			it.i = i;
+			// Calc triangle XZ bounds.
+			it.bmin[0] = it.bmax[0] = m_verts[t[0]*3+0];
+			it.bmin[1] = it.bmax[1] = m_verts[t[0]*3+2];
+			for (int j = 1; j < 3; ++j)
+			{
+				const float* v = &m_verts[t[j]*3];
+				if (v[0] < it.bmin[0]) it.bmin[0] = v[0]; 
+				if (v[2] < it.bmin[1]) it.bmin[1] = v[2]; 
+
+				if (v[0] > it.bmax[0]) it.bmax[0] = v[0]; 
+				if (v[2] > it.bmax[1]) it.bmax[1] = v[2]; 
+			}
+		}
+	}
+
+private:
+	const float* m_verts;
+	const int* m_tris;
+	const int m_ntris;
+	BoundsItem* m_items;
+
+	// Explicitly-disabled copy assignment operator.
+	CalcTriBoundsTasks& operator=(const CalcTriBoundsTasks&);
+};
+
+/// Builds the subtrees below the top of the tree, one task per subtree.
+class BuildChunkySubtreesTasks : public rcTaskSet
+{
+public:
+	BuildChunkySubtreesTasks(BoundsItem* items, const int trisPerChunk, const int* inTris, int* outTris,
+							 ChunkySubtree* subtrees) :
+		m_items(items), m_trisPerChunk(trisPerChunk), m_inTris(inTris), m_outTris(outTris), m_subtrees(subtrees)
+	{
+	}
+
+	virtual void runTask(const int taskIndex)
+	{
+		ChunkySubtree& subtree = m_subtrees[taskIndex];
+		subtree.nodes = new rcChunkyTriMeshNode[maxSubtreeNodes(subtree.imax - subtree.imin, m_trisPerChunk)];
+		subtree.nnodes = 0;
+		subdivide(m_items, subtree.imin, subtree.imax, m_trisPerChunk, subtree.nodes, subtree.nnodes, m_outTris, m_inTris);
+	}
+
+private:
+	BoundsItem* m_items;
+	const int m_trisPerChunk;
+	const int* m_inTris;
+	int* m_outTris;
+	ChunkySubtree* m_subtrees;
+
+	// Explicitly-disabled copy assignment operator.
+	BuildChunkySubtreesTasks& operator=(const BuildChunkySubtreesTasks&);
+};
+
+bool rcCreateChunkyTriMesh(const float* verts, const int* tris, int ntris,
+						   int trisPerChunk, rcChunkyTriMesh* cm, rcContext* ctx)
+{
+	rcContext serial(false);
+	if (!ctx)
+		ctx = &serial;
+	
 	cm->tris = new int[ntris*3];
-	if (!cm->tris)
-		return false;
-		
 	cm->ntris = ntris;
+	cm->nnodes = 0;
+	cm->maxTrisPerChunk = 0;
+	if (!ntris)
+	{
+		cm->nodes = new rcChunkyTriMeshNode[1];
+		return true;
+	}
 
 	// Build tree
 	BoundsItem* items = new BoundsItem[ntris];
-	if (!items)
-		return false;
+	CalcTriBoundsTasks boundsTasks(verts, tris, ntris, items);
+	ctx->runTasks(boundsTasks, (ntris + CalcTriBoundsTasks::TRIS_PER_TASK-1) / CalcTriBoundsTasks::TRIS_PER_TASK);
+
+	// Split the top of the tree serially, until the subtrees are small enough to spread over the tasks.
+	const int maxSubtreeItems = rcMax(trisPerChunk*4, ntris/64);
+	const int maxSubtrees = 4*(ntris/maxSubtreeItems) + 2;
+	ChunkyTopNode* top = new ChunkyTopNode[maxSubtrees*2];
+	ChunkySubtree* subtrees = new ChunkySubtree[maxSubtrees];
+	int ntop = 0;
+	int nsubtrees = 0;
+	splitTop(items, 0, ntris, trisPerChunk, maxSubtreeItems, top, ntop, subtrees, nsubtrees);
+
+	BuildChunkySubtreesTasks subtreeTasks(items, trisPerChunk, tris, cm->tris, subtrees);
+	ctx->runTasks(subtreeTasks, nsubtrees);
+	
+	delete [] items;
 
-	for (int i = 0; i < ntris; i++)
+	// Lay the top nodes and the subtrees out in depth first order.
+	int* start = new int[ntop+1];
+	int nnodes = 0;
+	for (int i = 0; i < ntop; ++i)
 	{
-		const int* t = &tris[i*3];
-		BoundsItem& it = items[i];
-		it.i = i;
-		// Calc triangle XZ bounds.
-		it.bmin[0] = it.bmax[0] = verts[t[0]*3+0];
-		it.bmin[1] = it.bmax[1] = verts[t[0]*3+2];
-		for (int j = 1; j < 3; ++j)
-		{
-			const float* v = &verts[t[j]*3];
-			if (v[0] < it.bmin[0]) it.bmin[0] = v[0]; 
-			if (v[2] < it.bmin[1]) it.bmin[1] = v[2]; 
+		start[i] = nnodes;
+		nnodes += top[i].subtree >= 0 ? subtrees[top[i].subtree].nnodes : 1;
+	}
+	start[ntop] = nnodes;
 
-			if (v[0] > it.bmax[0]) it.bmax[0] = v[0]; 
-			if (v[2] > it.bmax[1]) it.bmax[1] = v[2]; 
+	cm->nodes = new rcChunkyTriMeshNode[nnodes];
+	cm->nnodes = nnodes;
+	for (int i = 0; i < ntop; ++i)
+	{
+		const ChunkyTopNode& tn = top[i];
+		if (tn.subtree >= 0)
+		{
+			const ChunkySubtree& subtree = subtrees[tn.subtree];
+			memcpy(&cm->nodes[start[i]], subtree.nodes, subtree.nnodes*sizeof(rcChunkyTriMeshNode));
+			delete [] subtree.nodes;
+		}
+		else
+		{
+			rcChunkyTriMeshNode& node = cm->nodes[start[i]];
+			node.bmin[0] = tn.bmin[0];
+			node.bmin[1] = tn.bmin[1];
+			node.bmax[0] = tn.bmax[0];
+			node.bmax[1] = tn.bmax[1];
+			node.n = tn.imax - tn.imin;
+			// Negative index means escape.
+			node.i = -(start[tn.end] - start[i]);
 		}
 	}
 
-	int curTri = 0;
-	int curNode = 0;
-	subdivide(items, ntris, 0, ntris, trisPerChunk, curNode, cm->nodes, nchunks*4, curTri, cm->tris, tris);
-	
-	delete [] items;
-	
-	cm->nnodes = curNode;
+	delete [] start;
+	delete [] subtrees;
+	delete [] top;
 	
 	// Calc max tris per node.
-	cm->maxTrisPerChunk = 0;
 	for (int i = 0; i < cm->nnodes; ++i)
 	{
 		rcChunkyTriMeshNode& node = cm->nodes[i];
@@ -245,6 +511,120 @@ int rcGetChunksOverlappingRect(const rcChunkyTriMesh* cm,
 }
 
 
+void rcGetChunksOverlappingRects(const rcChunkyTriMesh* cm,
+								 const float* bmins, const float* bmaxs, const int nrects,
+								 int* ids, int* counts, const int maxIdsPerRect)
+{
+	for (int r = 0; r < nrects; ++r)
+		counts[r] = 0;
+	if (!nrects || !cm->nnodes)
+		return;
+	
+	// Bounds of all the rectangles and their average size.
+	float umin[2] = { bmins[0], bmins[1] };
+	float umax[2] = { bmaxs[0], bmaxs[1] };
+	float avgSize = 0.0f;
+	for (int r = 0; r < nrects; ++r)
+	{
+		const float* rmin = &bmins[r*2];
+		const float* rmax = &bmaxs[r*2];
+		mergeBounds(umin, umax, rmin, rmax);
+		avgSize += rcMax(rmax[0] - rmin[0], rmax[1] - rmin[1]);
+	}
+	avgSize /= nrects;
+	
+	// Bucket the rectangles into a grid of cells about their size, so that the rectangles near
+	// a chunk are found without testing all of them.
+	const int MAX_GRID_SIZE = 1024;
+	const float cellSize = rcMax(avgSize, rcMax(umax[0] - umin[0], umax[1] - umin[1]) / MAX_GRID_SIZE);
+	const float ics = cellSize > 0.0f ? 1.0f / cellSize : 0.0f;
+	const int gw = rcClamp((int)((umax[0] - umin[0]) * ics) + 1, 1, MAX_GRID_SIZE);
+	const int gh = rcClamp((int)((umax[1] - umin[1]) * ics) + 1, 1, MAX_GRID_SIZE);
+	
+	int* cellStart = new int[gw*gh+1];
+	memset(cellStart, 0, sizeof(int)*(gw*gh+1));
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		int* cellRects = pass ? new int[cellStart[gw*gh]] : 0;
+		for (int r = 0; r < nrects; ++r)
+		{
+			const int x0 = rcClamp((int)((bmins[r*2+0] - umin[0]) * ics), 0, gw-1);
+			const int y0 = rcClamp((int)((bmins[r*2+1] - umin[1]) * ics), 0, gh-1);
+			const int x1 = rcClamp((int)((bmaxs[r*2+0] - umin[0]) * ics), 0, gw-1);
+			const int y1 = rcClamp((int)((bmaxs[r*2+1] - umin[1]) * ics), 0, gh-1);
+			for (int y = y0; y <= y1; ++y)
+			{
+				for (int x = x0; x <= x1; ++x)
+				{
+					// The first pass counts the rectangles of each cell, the second places them.
+					if (pass)
+						cellRects[cellStart[x+y*gw]++] = r;
+					else
+						cellStart[x+y*gw+1]++;
+				}
+			}
+		}
+		if (!pass)
+		{
+			for (int i = 0; i < gw*gh; ++i)
+				cellStart[i+1] += cellStart[i];
+			continue;
+		}
+		
+		// The placement moved each start to the end of its cell, which is the start of the next one.
+		for (int i = gw*gh; i > 0; --i)
+			cellStart[i] = cellStart[i-1];
+		cellStart[0] = 0;
+		
+		// Walk the tree once with the bounds of all the rectangles, and match each chunk against
+		// the rectangles in its cells. Chunks come in tree order, the same as for a single query.
+		int* lastChunk = new int[nrects];
+		for (int r = 0; r < nrects; ++r)
+			lastChunk[r] = -1;
+		int i = 0;
+		while (i < cm->nnodes)
+		{
+			const rcChunkyTriMeshNode* node = &cm->nodes[i];
+			const bool overlap = checkOverlapRect(umin, umax, node->bmin, node->bmax);
+			const bool isLeafNode = node->i >= 0;
+			
+			if (isLeafNode && overlap)
+			{
+				const int x0 = rcClamp((int)((node->bmin[0] - umin[0]) * ics), 0, gw-1);
+				const int y0 = rcClamp((int)((node->bmin[1] - umin[1]) * ics), 0, gh-1);
+				const int x1 = rcClamp((int)((node->bmax[0] - umin[0]) * ics), 0, gw-1);
+				const int y1 = rcClamp((int)((node->bmax[1] - umin[1]) * ics), 0, gh-1);
+				for (int y = y0; y <= y1; ++y)
+				{
+					for (int x = x0; x <= x1; ++x)
+					{
+						const int cell = x+y*gw;
+						for (int j = cellStart[cell]; j < cellStart[cell+1]; ++j)
+						{
+							const int r = cellRects[j];
+							if (lastChunk[r] == i)
+								continue;
+							lastChunk[r] = i;
+							if (!checkOverlapRect(&bmins[r*2], &bmaxs[r*2], node->bmin, node->bmax))
+								continue;
+							if (counts[r] < maxIdsPerRect)
+								ids[r*maxIdsPerRect + counts[r]++] = i;
+						}
+					}
+				}
+			}
+			
+			if (overlap || isLeafNode)
+				i++;
+			else
+				i += -node->i;
+		}
+		
+		delete [] lastChunk;
+		delete [] cellRects;
+	}
+	delete [] cellStart;
+}
 
 static bool checkOverlapSegment(const float p[2], const float q[2],
 								const float bmin[2], const float bmax[2])
@@ -20,11 +20,13 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
 #include <algorithm>
 #include "Recast.h"
 #include "InputGeom.h"
 #include "ChunkyTriMesh.h"
 #include "MeshLoaderObj.h"
+#include "MappedFile.h"
 #include "DebugDraw.h"
 #include "RecastDebugDraw.h"
 #include "DetourNavMesh.h"
@@ -104,11 +106,138 @@ static char* parseRow(char* buf, char* bufEnd, char* row, int len)
 	return buf;
 }
 
+static const int GEOMCACHE_MAGIC = 'G'<<24 | 'C'<<16 | 'C'<<8 | 'H'; // 'GCCH'
+static const int GEOMCACHE_VERSION = 2;
 
+struct GeomCacheHeader
+{
+	int magic;
+	int version;
+	// Sizes of the structures stored as they are, so that a cache from a different build is not used.
+	int buildSettingsSize;
+	int convexVolumeSize;
+	int chunkyNodeSize;
+	// Hashes and sizes of the loaded file, and of the mesh file of a geometry set.
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	uint64_t meshHash;
+	uint64_t meshSize;
+	int meshPathLen;
+	int vertCount;
+	int triCount;
+	int nodeCount;
+	int maxTrisPerChunk;
+	int offMeshConCount;
+	int volumeCount;
+	int hasBuildSettings;
+	float meshBMin[3];
+	float meshBMax[3];
+	BuildSettings buildSettings;
+};
+
+/// Offsets of the sections of a geometry cache, which follow the header.
+struct GeomCacheLayout
+{
+	size_t meshPath;
+	size_t verts;
+	size_t tris;
+	size_t normals;
+	size_t nodes;
+	size_t chunkyTris;
+	size_t offMeshConVerts;
+	size_t offMeshConRads;
+	size_t offMeshConDirs;
+	size_t offMeshConAreas;
+	size_t offMeshConFlags;
+	size_t offMeshConIds;
+	size_t volumes;
+	size_t size;
+};
+
+// Sections are 16 byte aligned, so that they can be used in place from the mapped file.
+static size_t addCacheSection(size_t& offset, const size_t size)
+{
+	const size_t start = offset;
+	offset = (offset + size + 15) & ~(size_t)15;
+	return start;
+}
+
+static void calcCacheLayout(const GeomCacheHeader& header, GeomCacheLayout& layout)
+{
+	size_t offset = 0;
+	addCacheSection(offset, sizeof(GeomCacheHeader));
+	layout.meshPath = addCacheSection(offset, (size_t)header.meshPathLen);
+	layout.verts = addCacheSection(offset, (size_t)header.vertCount*3*sizeof(float));
+	layout.tris = addCacheSection(offset, (size_t)header.triCount*3*sizeof(int));
+	layout.normals = addCacheSection(offset, (size_t)header.triCount*3*sizeof(float));
+	layout.nodes = addCacheSection(offset, (size_t)header.nodeCount*sizeof(rcChunkyTriMeshNode));
+	layout.chunkyTris = addCacheSection(offset, (size_t)header.triCount*sizeof(int));
+	layout.offMeshConVerts = addCacheSection(offset, (size_t)header.offMeshConCount*3*2*sizeof(float));
+	layout.offMeshConRads = addCacheSection(offset, (size_t)header.offMeshConCount*sizeof(float));
+	layout.offMeshConDirs = addCacheSection(offset, (size_t)header.offMeshConCount*sizeof(unsigned char));
+	layout.offMeshConAreas = addCacheSection(offset, (size_t)header.offMeshConCount*sizeof(unsigned char));
+	layout.offMeshConFlags = addCacheSection(offset, (size_t)header.offMeshConCount*sizeof(unsigned short));
+	layout.offMeshConIds = addCacheSection(offset, (size_t)header.offMeshConCount*sizeof(unsigned int));
+	layout.volumes = addCacheSection(offset, (size_t)header.volumeCount*sizeof(ConvexVolume));
+	layout.size = offset;
+}
+
+/// Writes a section at @p offset, padding from @p pos, the end of the previous section.
+static bool writeCacheSection(FILE* fp, size_t& pos, const size_t offset, const void* data, const size_t size)
+{
+	static const char zeros[16] = { 0 };
+	if (offset < pos || offset - pos > sizeof(zeros))
+		return false;
+	if (offset > pos && fwrite(zeros, offset - pos, 1, fp) != 1)
+		return false;
+	if (size && fwrite(data, size, 1, fp) != 1)
+		return false;
+	pos = offset + size;
+	return true;
+}
+
+/// Hashes the contents of a file, 8 bytes at a time. The hash only detects changes to the file,
+/// it is not meant to resist collisions made on purpose.
+static bool hashFile(const char* path, uint64_t& hash, uint64_t& size)
+{
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+
+	const uint64_t prime = ((uint64_t)0x9e3779b9 << 32) | 0x7f4a7c15;
+	const char* data = file.getData();
+	const size_t n = file.getSize();
+	uint64_t h = (uint64_t)n * prime;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		uint64_t w;
+		memcpy(&w, data + i, sizeof(w));
+		h = (h ^ w) * prime;
+		h = (h << 31) | (h >> 33);
+	}
+	uint64_t tail = 0;
+	for (; i < n; ++i)
+		tail = (tail << 8) | (unsigned char)data[i];
+	h = (h ^ tail) * prime;
+	h ^= h >> 32;
+	h *= prime;
+	h ^= h >> 29;
+
+	hash = h;
+	size = (uint64_t)n;
+	return true;
+}
+
+static std::string getCachePath(const std::string& filepath)
+{
+	return filepath + ".gcache";
+}
 
 InputGeom::InputGeom() :
 	m_chunkyMesh(0),
 	m_mesh(0),
+	m_cacheFile(0),
 	m_hasBuildSettings(false),
 	m_offMeshConCount(0),
 	m_volumeCount(0)
@@ -116,20 +245,24 @@ InputGeom::InputGeom() :
 }
 
 InputGeom::~InputGeom()
+{
+	clearMesh();
+}
+
+void InputGeom::clearMesh()
 {
 	delete m_chunkyMesh;
+	m_chunkyMesh = 0;
 	delete m_mesh;
+	m_mesh = 0;
+	// The mesh and the chunky tree may point to the mapped cache, so it goes last.
+	delete m_cacheFile;
+	m_cacheFile = 0;
 }
 		
 bool InputGeom::loadMesh(rcContext* ctx, const std::string& filepath)
 {
-	if (m_mesh)
-	{
-		delete m_chunkyMesh;
-		m_chunkyMesh = 0;
-		delete m_mesh;
-		m_mesh = 0;
-	}
+	clearMesh();
 	m_offMeshConCount = 0;
 	m_volumeCount = 0;
 	
@@ -139,7 +272,7 @@ bool InputGeom::loadMesh(rcContext* ctx, const std::string& filepath)
 		ctx->log(RC_LOG_ERROR, "loadMesh: Out of memory 'm_mesh'.");
 		return false;
 	}
-	if (!m_mesh->load(filepath))
+	if (!m_mesh->load(filepath, ctx))
 	{
 		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Could not load '%s'", filepath.c_str());
 		return false;
@@ -153,7 +286,7 @@ bool InputGeom::loadMesh(rcContext* ctx, const std::string& filepath)
 		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Out of memory 'm_chunkyMesh'.");
 		return false;
 	}
-	if (!rcCreateChunkyTriMesh(m_mesh->getVerts(), m_mesh->getTris(), m_mesh->getTriCount(), 256, m_chunkyMesh))
+	if (!rcCreateChunkyTriMesh(m_mesh->getVerts(), m_mesh->getTris(), m_mesh->getTriCount(), 256, m_chunkyMesh, ctx))
 	{
 		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Failed to build chunky mesh.");
 		return false;
@@ -203,8 +336,7 @@ bool InputGeom::loadGeomSet(rcContext* ctx, const std::string& filepath)
 	
 	m_offMeshConCount = 0;
 	m_volumeCount = 0;
-	delete m_mesh;
-	m_mesh = 0;
+	clearMesh();
 
 	char* src = buf;
 	char* srcEnd = buf + bufSize;
@@ -244,6 +376,7 @@ bool InputGeom::loadGeomSet(rcContext* ctx, const std::string& filepath)
 				m_offMeshConDirs[m_offMeshConCount] = (unsigned char)bidir;
 				m_offMeshConAreas[m_offMeshConCount] = (unsigned char)area;
 				m_offMeshConFlags[m_offMeshConCount] = (unsigned short)flags;
+				m_offMeshConId[m_offMeshConCount] = 1000 + m_offMeshConCount;
 				m_offMeshConCount++;
 			}
 		}
@@ -305,12 +438,173 @@ bool InputGeom::load(rcContext* ctx, const std::string& filepath)
 	std::string extension = filepath.substr(extensionPos);
 	std::transform(extension.begin(), extension.end(), extension.begin(), tolower);
 
-	if (extension == ".gset")
-		return loadGeomSet(ctx, filepath);
-	if (extension == ".obj")
-		return loadMesh(ctx, filepath);
+	const bool geomSet = extension == ".gset";
+	if (!geomSet && extension != ".obj")
+		return false;
+
+	// The cache may be mapped, release it before it is rewritten.
+	clearMesh();
+	if (loadCache(ctx, filepath))
+		return true;
+
+	if (geomSet ? !loadGeomSet(ctx, filepath) : !loadMesh(ctx, filepath))
+		return false;
+	saveCache(ctx, filepath);
+	return true;
+}
+
+bool InputGeom::loadCache(rcContext* ctx, const std::string& filepath)
+{
+	MappedFile* file = new MappedFile;
+	if (!file->open(getCachePath(filepath).c_str()) || file->getSize() < sizeof(GeomCacheHeader))
+	{
+		delete file;
+		return false;
+	}
+
+	const char* data = file->getData();
+	GeomCacheHeader header;
+	memcpy(&header, data, sizeof(header));
+	GeomCacheLayout layout;
+	if (header.magic != GEOMCACHE_MAGIC || header.version != GEOMCACHE_VERSION ||
+		header.buildSettingsSize != (int)sizeof(BuildSettings) ||
+		header.convexVolumeSize != (int)sizeof(ConvexVolume) ||
+		header.chunkyNodeSize != (int)sizeof(rcChunkyTriMeshNode) ||
+		header.meshPathLen < 0 || header.vertCount < 0 || header.triCount < 0 || header.nodeCount < 0 ||
+		header.offMeshConCount < 0 || header.offMeshConCount > MAX_OFFMESH_CONNECTIONS ||
+		header.volumeCount < 0 || header.volumeCount > MAX_VOLUMES)
+	{
+		delete file;
+		return false;
+	}
+	calcCacheLayout(header, layout);
+	if (layout.size > file->getSize())
+	{
+		delete file;
+		return false;
+	}
+
+	// The cache is current if neither the file nor the mesh it refers to have changed since.
+	const std::string meshPath = header.meshPathLen ? std::string(data + layout.meshPath, header.meshPathLen) : filepath;
+	uint64_t hash, size;
+	if (!hashFile(filepath.c_str(), hash, size) || hash != header.sourceHash || size != header.sourceSize)
+	{
+		delete file;
+		return false;
+	}
+	if (header.meshPathLen && (!hashFile(meshPath.c_str(), hash, size) || hash != header.meshHash || size != header.meshSize))
+	{
+		delete file;
+		return false;
+	}
+
+	m_cacheFile = file;
 
-	return false;
+	m_mesh = new rcMeshLoaderObj;
+	m_mesh->setMeshData(meshPath, (const float*)(data + layout.verts), header.vertCount,
+						(const int*)(data + layout.tris), (const float*)(data + layout.normals), header.triCount);
+	rcVcopy(m_meshBMin, header.meshBMin);
+	rcVcopy(m_meshBMax, header.meshBMax);
+
+	// The chunky tree is only read, the mapping is read only.
+	m_chunkyMesh = new rcChunkyTriMesh;
+	m_chunkyMesh->nodes = (rcChunkyTriMeshNode*)(data + layout.nodes);
+	m_chunkyMesh->nnodes = header.nodeCount;
+	m_chunkyMesh->tris = (int*)(data + layout.chunkyTris);
+	m_chunkyMesh->ntris = header.triCount;
+	m_chunkyMesh->maxTrisPerChunk = header.maxTrisPerChunk;
+	m_chunkyMesh->ownsData = false;
+
+	// Off-mesh connections and convex volumes can be edited, so they are copied.
+	m_offMeshConCount = header.offMeshConCount;
+	memcpy(m_offMeshConVerts, data + layout.offMeshConVerts, m_offMeshConCount*3*2*sizeof(float));
+	memcpy(m_offMeshConRads, data + layout.offMeshConRads, m_offMeshConCount*sizeof(float));
+	memcpy(m_offMeshConDirs, data + layout.offMeshConDirs, m_offMeshConCount*sizeof(unsigned char));
+	memcpy(m_offMeshConAreas, data + layout.offMeshConAreas, m_offMeshConCount*sizeof(unsigned char));
+	memcpy(m_offMeshConFlags, data + layout.offMeshConFlags, m_offMeshConCount*sizeof(unsigned short));
+	memcpy(m_offMeshConId, data + layout.offMeshConIds, m_offMeshConCount*sizeof(unsigned int));
+	m_volumeCount = header.volumeCount;
+	memcpy(m_volumes, data + layout.volumes, m_volumeCount*sizeof(ConvexVolume));
+	if (header.hasBuildSettings)
+	{
+		m_hasBuildSettings = true;
+		m_buildSettings = header.buildSettings;
+	}
+
+	ctx->log(RC_LOG_PROGRESS, "Loaded '%s' from the geometry cache.", filepath.c_str());
+	return true;
+}
+
+void InputGeom::saveCache(rcContext* ctx, const std::string& filepath)
+{
+	if (!m_mesh || !m_chunkyMesh)
+		return;
+
+	GeomCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = GEOMCACHE_MAGIC;
+	header.version = GEOMCACHE_VERSION;
+	header.buildSettingsSize = (int)sizeof(BuildSettings);
+	header.convexVolumeSize = (int)sizeof(ConvexVolume);
+	header.chunkyNodeSize = (int)sizeof(rcChunkyTriMeshNode);
+
+	// A geometry set refers to its mesh by name, which is stored with the hash of the mesh.
+	const std::string& meshPath = m_mesh->getFileName();
+	if (!hashFile(filepath.c_str(), header.sourceHash, header.sourceSize))
+		return;
+	if (meshPath != filepath)
+	{
+		if (!hashFile(meshPath.c_str(), header.meshHash, header.meshSize))
+			return;
+		header.meshPathLen = (int)meshPath.size();
+	}
+
+	header.vertCount = m_mesh->getVertCount();
+	header.triCount = m_mesh->getTriCount();
+	header.nodeCount = m_chunkyMesh->nnodes;
+	header.maxTrisPerChunk = m_chunkyMesh->maxTrisPerChunk;
+	header.offMeshConCount = m_offMeshConCount;
+	header.volumeCount = m_volumeCount;
+	header.hasBuildSettings = m_hasBuildSettings ? 1 : 0;
+	rcVcopy(header.meshBMin, m_meshBMin);
+	rcVcopy(header.meshBMax, m_meshBMax);
+	if (m_hasBuildSettings)
+		header.buildSettings = m_buildSettings;
+
+	GeomCacheLayout layout;
+	calcCacheLayout(header, layout);
+
+	const std::string cachePath = getCachePath(filepath);
+	FILE* fp = fopen(cachePath.c_str(), "wb");
+	if (!fp)
+	{
+		ctx->log(RC_LOG_WARNING, "saveCache: Could not write the geometry cache '%s'.", cachePath.c_str());
+		return;
+	}
+	size_t pos = 0;
+	const bool ok =
+		writeCacheSection(fp, pos, 0, &header, sizeof(header)) &&
+		writeCacheSection(fp, pos, layout.meshPath, meshPath.c_str(), (size_t)header.meshPathLen) &&
+		writeCacheSection(fp, pos, layout.verts, m_mesh->getVerts(), (size_t)header.vertCount*3*sizeof(float)) &&
+		writeCacheSection(fp, pos, layout.tris, m_mesh->getTris(), (size_t)header.triCount*3*sizeof(int)) &&
+		writeCacheSection(fp, pos, layout.normals, m_mesh->getNormals(), (size_t)header.triCount*3*sizeof(float)) &&
+		writeCacheSection(fp, pos, layout.nodes, m_chunkyMesh->nodes, (size_t)header.nodeCount*sizeof(rcChunkyTriMeshNode)) &&
+		writeCacheSection(fp, pos, layout.chunkyTris, m_chunkyMesh->tris, (size_t)header.triCount*sizeof(int)) &&
+		writeCacheSection(fp, pos, layout.offMeshConVerts, m_offMeshConVerts, (size_t)m_offMeshConCount*3*2*sizeof(float)) &&
+		writeCacheSection(fp, pos, layout.offMeshConRads, m_offMeshConRads, (size_t)m_offMeshConCount*sizeof(float)) &&
+		writeCacheSection(fp, pos, layout.offMeshConDirs, m_offMeshConDirs, (size_t)m_offMeshConCount*sizeof(unsigned char)) &&
+		writeCacheSection(fp, pos, layout.offMeshConAreas, m_offMeshConAreas, (size_t)m_offMeshConCount*sizeof(unsigned char)) &&
+		writeCacheSection(fp, pos, layout.offMeshConFlags, m_offMeshConFlags, (size_t)m_offMeshConCount*sizeof(unsigned short)) &&
+		writeCacheSection(fp, pos, layout.offMeshConIds, m_offMeshConId, (size_t)m_offMeshConCount*sizeof(unsigned int)) &&
+		writeCacheSection(fp, pos, layout.volumes, m_volumes, (size_t)m_volumeCount*sizeof(ConvexVolume)) &&
+		writeCacheSection(fp, pos, layout.size, 0, 0);
+	fclose(fp);
+	if (!ok)
+	{
+		// Leave no partial cache behind.
+		remove(cachePath.c_str());
+		ctx->log(RC_LOG_WARNING, "saveCache: Could not write the geometry cache '%s'.", cachePath.c_str());
+	}
 }
 
 bool InputGeom::saveGeomSet(const BuildSettings* settings)
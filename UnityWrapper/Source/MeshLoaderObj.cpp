@@ -17,9 +17,13 @@
 //
 
 #include "MeshLoaderObj.h"
+#include "MappedFile.h"
+#include "Recast.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <cstring>
+#include <float.h>
 #include <math.h>
 
 rcMeshLoaderObj::rcMeshLoaderObj() :
@@ -28,192 +32,404 @@ rcMeshLoaderObj::rcMeshLoaderObj() :
 	m_tris(0),
 	m_normals(0),
 	m_vertCount(0),
-	m_triCount(0)
+	m_triCount(0),
+	m_ownsData(true)
 {
 }
 
 rcMeshLoaderObj::~rcMeshLoaderObj()
 {
-	delete [] m_verts;
-	delete [] m_normals;
-	delete [] m_tris;
+	clear();
 }
-		
-void rcMeshLoaderObj::addVertex(float x, float y, float z, int& cap)
+
+void rcMeshLoaderObj::clear()
 {
-	if (m_vertCount+1 > cap)
+	if (m_ownsData)
 	{
-		cap = !cap ? 8 : cap*2;
-		float* nv = new float[cap*3];
-		if (m_vertCount)
-			memcpy(nv, m_verts, m_vertCount*3*sizeof(float));
 		delete [] m_verts;
-		m_verts = nv;
+		delete [] m_normals;
+		delete [] m_tris;
 	}
-	float* dst = &m_verts[m_vertCount*3];
-	*dst++ = x*m_scale;
-	*dst++ = y*m_scale;
-	*dst++ = z*m_scale;
-	m_vertCount++;
+	m_verts = 0;
+	m_normals = 0;
+	m_tris = 0;
+	m_vertCount = 0;
+	m_triCount = 0;
+	m_ownsData = true;
 }
 
-void rcMeshLoaderObj::addTriangle(int a, int b, int c, int& cap)
+void rcMeshLoaderObj::setMeshData(const std::string& fileName, const float* verts, const int vertCount,
+								  const int* tris, const float* normals, const int triCount)
 {
-	if (m_triCount+1 > cap)
-	{
-		cap = !cap ? 8 : cap*2;
-		int* nv = new int[cap*3];
-		if (m_triCount)
-			memcpy(nv, m_tris, m_triCount*3*sizeof(int));
-		delete [] m_tris;
-		m_tris = nv;
-	}
-	int* dst = &m_tris[m_triCount*3];
-	*dst++ = a;
-	*dst++ = b;
-	*dst++ = c;
-	m_triCount++;
+	clear();
+	m_verts = verts;
+	m_tris = tris;
+	m_normals = normals;
+	m_vertCount = vertCount;
+	m_triCount = triCount;
+	m_ownsData = false;
+	m_filename = fileName;
+}
+
+static bool isBlank(const char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+/// Returns the start of the next row at or after @p p, skipping empty rows and leading white space.
+static const char* skipToRow(const char* p, const char* end)
+{
+	while (p < end && (isBlank(*p) || *p == '\n' || *p == '\\'))
+		p++;
+	return p;
+}
+
+/// Returns the end of the row starting at @p p, the newline or @p end.
+static const char* findRowEnd(const char* p, const char* end)
+{
+	const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+	return nl ? nl : end;
+}
+
+/// Returns true if the row [p, end) is a vertex position.
+static bool isVertexRow(const char* p, const char* end)
+{
+	return p[0] == 'v' && (p+1 == end || (p[1] != 'n' && p[1] != 't'));
 }
 
-static char* parseRow(char* buf, char* bufEnd, char* row, int len)
+// Powers of ten that are exact in a double.
+static const double POW10[] =
 {
-	bool start = true;
-	bool done = false;
-	int n = 0;
-	while (!done && buf < bufEnd)
-	{
-		char c = *buf;
-		buf++;
-		// multirow
-		switch (c)
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int MAX_EXACT_POW10 = 22;
+
+/// Parses the float at @p p, up to @p end, and returns the position after it.
+/// Numbers with a mantissa and a power of ten that are exact in a double are converted with one
+/// multiply or divide, which rounds correctly. The rest go through sscanf.
+static const char* parseFloat(const char* p, const char* end, float& value)
+{
+	const char* start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool exact = true;
+	bool anyDigits = false;
+	for (; p < end && *p >= '0' && *p <= '9'; ++p)
+	{
+		anyDigits = true;
+		if (digits < 19)
 		{
-			case '\\':
-				break;
-			case '\n':
-				if (start) break;
-				done = true;
-				break;
-			case '\r':
-				break;
-			case '\t':
-			case ' ':
-				if (start) break;
-				// else falls through
-			default:
-				start = false;
-				row[n++] = c;
-				if (n >= len-1)
-					done = true;
-				break;
+			mantissa = mantissa*10 + (uint64_t)(*p - '0');
+			if (mantissa) digits++;
+		}
+		else
+		{
+			exact = false;
+		}
+	}
+	if (p < end && *p == '.')
+	{
+		for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+		{
+			anyDigits = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa*10 + (uint64_t)(*p - '0');
+				if (mantissa) digits++;
+				exponent--;
+			}
+			else
+			{
+				exact = false;
+			}
+		}
+	}
+	if (anyDigits && p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* q = p+1;
+		bool negativeExp = false;
+		if (q < end && (*q == '-' || *q == '+'))
+		{
+			negativeExp = *q == '-';
+			q++;
+		}
+		if (q < end && *q >= '0' && *q <= '9')
+		{
+			int e = 0;
+			for (; q < end && *q >= '0' && *q <= '9'; ++q)
+			{
+				if (e < 10000)
+					e = e*10 + (*q - '0');
+			}
+			exponent += negativeExp ? -e : e;
+			p = q;
 		}
 	}
-	row[n] = '\0';
-	return buf;
-}
 
-static int parseFace(char* row, int* data, int n, int vcnt)
-{
-	int j = 0;
-	while (*row != '\0')
-	{
-		// Skip initial white space
-		while (*row != '\0' && (*row == ' ' || *row == '\t'))
-			row++;
-		char* s = row;
-		// Find vertex delimiter and terminated the string there for conversion.
-		while (*row != '\0' && *row != ' ' && *row != '\t')
+	// Anything else that does not end at white space, like 'inf' or 'nan', takes the slow path.
+	if (p < end && !isBlank(*p))
+		exact = false;
+
+	if (anyDigits && exact && mantissa <= ((uint64_t)1 << 53) && exponent >= -MAX_EXACT_POW10 && exponent <= MAX_EXACT_POW10)
+	{
+		double d = (double)mantissa;
+		d = exponent < 0 ? d / POW10[-exponent] : d * POW10[exponent];
+		// Rounding the double to a float rounds twice, which differs from rounding once only when the
+		// double lands exactly halfway between two floats. Those, and the denormals, take the slow path.
+		uint64_t bits;
+		memcpy(&bits, &d, sizeof(bits));
+		if ((bits & 0x1fffffff) != 0x10000000 && (d == 0.0 || (d >= FLT_MIN && d <= FLT_MAX)))
 		{
-			if (*row == '/') *row = '\0';
-			row++;
+			value = (float)(negative ? -d : d);
+			return p;
 		}
-		if (*s == '\0')
-			continue;
-		int vi = atoi(s);
-		data[j++] = vi < 0 ? vi+vcnt : vi-1;
-		if (j >= n) return j;
 	}
-	return j;
+
+	// Slow path, the token copied to a terminated buffer and scanned like before.
+	const char* tokenEnd = p;
+	while (tokenEnd < end && !isBlank(*tokenEnd))
+		tokenEnd++;
+	char buf[64];
+	const int n = rcMin((int)(tokenEnd - start), (int)sizeof(buf)-1);
+	memcpy(buf, start, (size_t)n);
+	buf[n] = '\0';
+	value = 0.0f;
+	sscanf(buf, "%f", &value);
+	return tokenEnd;
 }
 
-bool rcMeshLoaderObj::load(const std::string& filename)
+/// Parses the integer at @p p, up to @p end, like atoi.
+static int parseInt(const char* p, const char* end)
 {
-	char* buf = 0;
-	FILE* fp = fopen(filename.c_str(), "rb");
-	if (!fp)
-		return false;
-	if (fseek(fp, 0, SEEK_END) != 0)
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
 	{
-		fclose(fp);
-		return false;
+		negative = *p == '-';
+		p++;
 	}
-	long bufSize = ftell(fp);
-	if (bufSize < 0)
+	int value = 0;
+	for (; p < end && *p >= '0' && *p <= '9'; ++p)
+		value = value*10 + (*p - '0');
+	return negative ? -value : value;
+}
+
+/// A range of whole rows of the file, parsed by one task.
+struct ObjChunk
+{
+	const char* begin;
+	const char* end;
+	int vertOffset;
+	int vertCount;
+	int* tris;
+	int triCount;
+	int triCap;
+};
+
+/// Parses the chunks of an OBJ file. The first pass only counts the vertices of each chunk, so that
+/// the second can write the vertices straight to their place in the mesh and resolve the faces.
+struct ParseObjChunksTasks : public rcTaskSet
+{
+	ParseObjChunksTasks(ObjChunk* chunks_, float* verts_, const float scale_) :
+		chunks(chunks_), verts(verts_), scale(scale_)
 	{
-		fclose(fp);
-		return false;
 	}
-	if (fseek(fp, 0, SEEK_SET) != 0)
+
+	virtual void runTask(const int taskIndex)
 	{
-		fclose(fp);
-		return false;
+		if (verts)
+			parseChunk(chunks[taskIndex]);
+		else
+			countVertices(chunks[taskIndex]);
 	}
-	buf = new char[bufSize];
-	if (!buf)
+
+	ObjChunk* chunks;
+	float* verts;
+	float scale;
+
+private:
+	static void countVertices(ObjChunk& chunk)
 	{
-		fclose(fp);
-		return false;
+		int count = 0;
+		const char* src = chunk.begin;
+		while (src < chunk.end)
+		{
+			src = skipToRow(src, chunk.end);
+			if (src >= chunk.end)
+				break;
+			const char* rowEnd = findRowEnd(src, chunk.end);
+			if (isVertexRow(src, rowEnd))
+				count++;
+			src = rowEnd;
+		}
+		chunk.vertCount = count;
 	}
-	size_t readLen = fread(buf, bufSize, 1, fp);
-	fclose(fp);
 
-	if (readLen != 1)
+	void parseChunk(ObjChunk& chunk)
 	{
-		delete[] buf;
-		return false;
+		float* dst = &verts[chunk.vertOffset*3];
+		int vcnt = chunk.vertOffset;
+		int face[32];
+
+		const char* src = chunk.begin;
+		while (src < chunk.end)
+		{
+			src = skipToRow(src, chunk.end);
+			if (src >= chunk.end)
+				break;
+			const char* row = src;
+			const char* rowEnd = findRowEnd(row, chunk.end);
+			src = rowEnd;
+
+			if (isVertexRow(row, rowEnd))
+			{
+				// Vertex pos
+				const char* p = row+1;
+				for (int j = 0; j < 3; ++j)
+				{
+					while (p < rowEnd && isBlank(*p))
+						p++;
+					float v = 0.0f;
+					if (p < rowEnd)
+						p = parseFloat(p, rowEnd, v);
+					*dst++ = v*scale;
+				}
+				vcnt++;
+			}
+			else if (row[0] == 'f')
+			{
+				// Faces
+				const int nv = parseFace(row+1, rowEnd, face, 32, vcnt);
+				for (int i = 2; i < nv; ++i)
+				{
+					const int a = face[0];
+					const int b = face[i-1];
+					const int c = face[i];
+					if (a < 0 || a >= vcnt || b < 0 || b >= vcnt || c < 0 || c >= vcnt)
+						continue;
+					addTriangle(chunk, a, b, c);
+				}
+			}
+		}
 	}
 
-	char* src = buf;
-	char* srcEnd = buf + bufSize;
-	char row[512];
-	int face[32];
-	float x,y,z;
-	int nv;
-	int vcap = 0;
-	int tcap = 0;
-	
+	static int parseFace(const char* p, const char* end, int* data, int n, int vcnt)
+	{
+		int j = 0;
+		while (p < end)
+		{
+			// Skip initial white space
+			while (p < end && isBlank(*p))
+				p++;
+			if (p >= end)
+				break;
+			// The index is the part before the first vertex delimiter.
+			const char* s = p;
+			while (p < end && !isBlank(*p))
+				p++;
+			int vi = parseInt(s, p);
+			data[j++] = vi < 0 ? vi+vcnt : vi-1;
+			if (j >= n) return j;
+		}
+		return j;
+	}
+
+	static void addTriangle(ObjChunk& chunk, int a, int b, int c)
+	{
+		if (chunk.triCount+1 > chunk.triCap)
+		{
+			chunk.triCap = !chunk.triCap ? 1024 : chunk.triCap*2;
+			int* nt = new int[chunk.triCap*3];
+			if (chunk.triCount)
+				memcpy(nt, chunk.tris, chunk.triCount*3*sizeof(int));
+			delete [] chunk.tris;
+			chunk.tris = nt;
+		}
+		int* dst = &chunk.tris[chunk.triCount*3];
+		*dst++ = a;
+		*dst++ = b;
+		*dst++ = c;
+		chunk.triCount++;
+	}
+};
+
+// Size of the chunks of the file parsed by a task.
+static const size_t OBJ_CHUNK_SIZE = 1024*1024;
+
+bool rcMeshLoaderObj::load(const std::string& filename, rcContext* ctx)
+{
+	clear();
+
+	MappedFile file;
+	if (!file.open(filename.c_str()))
+		return false;
+
+	// Split the file into chunks of whole rows.
+	const char* src = file.getData();
+	const char* srcEnd = file.getData() + file.getSize();
+	const int maxChunks = (int)(file.getSize() / OBJ_CHUNK_SIZE) + 1;
+	ObjChunk* chunks = new ObjChunk[maxChunks];
+	int nchunks = 0;
 	while (src < srcEnd)
 	{
-		// Parse one row
-		row[0] = '\0';
-		src = parseRow(src, srcEnd, row, sizeof(row)/sizeof(char));
-		// Skip comments
-		if (row[0] == '#') continue;
-		if (row[0] == 'v' && row[1] != 'n' && row[1] != 't')
+		ObjChunk& chunk = chunks[nchunks++];
+		memset(&chunk, 0, sizeof(chunk));
+		chunk.begin = src;
+		if ((size_t)(srcEnd - src) <= OBJ_CHUNK_SIZE)
 		{
-			// Vertex pos
-			sscanf(row+1, "%f %f %f", &x, &y, &z);
-			addVertex(x, y, z, vcap);
+			chunk.end = srcEnd;
 		}
-		if (row[0] == 'f')
+		else
 		{
-			// Faces
-			nv = parseFace(row+1, face, 32, m_vertCount);
-			for (int i = 2; i < nv; ++i)
-			{
-				const int a = face[0];
-				const int b = face[i-1];
-				const int c = face[i];
-				if (a < 0 || a >= m_vertCount || b < 0 || b >= m_vertCount || c < 0 || c >= m_vertCount)
-					continue;
-				addTriangle(a, b, c, tcap);
-			}
+			const char* nl = (const char*)memchr(src + OBJ_CHUNK_SIZE, '\n', (size_t)(srcEnd - src) - OBJ_CHUNK_SIZE);
+			chunk.end = nl ? nl+1 : srcEnd;
 		}
+		src = chunk.end;
+	}
+
+	rcContext serial(false);
+	if (!ctx)
+		ctx = &serial;
+
+	// Count the vertices of each chunk, and place the chunks in the vertex array.
+	ParseObjChunksTasks countTasks(chunks, 0, m_scale);
+	ctx->runTasks(countTasks, nchunks);
+	for (int i = 0; i < nchunks; ++i)
+	{
+		chunks[i].vertOffset = m_vertCount;
+		m_vertCount += chunks[i].vertCount;
 	}
 
-	delete [] buf;
+	float* verts = new float[m_vertCount*3];
+	m_verts = verts;
+	ParseObjChunksTasks parseTasks(chunks, verts, m_scale);
+	ctx->runTasks(parseTasks, nchunks);
+
+	for (int i = 0; i < nchunks; ++i)
+		m_triCount += chunks[i].triCount;
+	int* tris = new int[m_triCount*3];
+	m_tris = tris;
+	int* dst = tris;
+	for (int i = 0; i < nchunks; ++i)
+	{
+		if (chunks[i].triCount)
+			memcpy(dst, chunks[i].tris, chunks[i].triCount*3*sizeof(int));
+		dst += chunks[i].triCount*3;
+		delete [] chunks[i].tris;
+	}
+	delete [] chunks;
 
 	// Calculate normals.
-	m_normals = new float[m_triCount*3];
+	float* normals = new float[m_triCount*3];
+	m_normals = normals;
 	for (int i = 0; i < m_triCount*3; i += 3)
 	{
 		const float* v0 = &m_verts[m_tris[i]*3];
@@ -225,7 +441,7 @@ bool rcMeshLoaderObj::load(const std::string& filename)
 			e0[j] = v1[j] - v0[j];
 			e1[j] = v2[j] - v0[j];
 		}
-		float* n = &m_normals[i];
+		float* n = &normals[i];
 		n[0] = e0[1]*e1[2] - e0[2]*e1[1];
 		n[1] = e0[2]*e1[0] - e0[0]*e1[2];
 		n[2] = e0[0]*e1[1] - e0[1]*e1[0];
@@ -238,7 +454,7 @@ bool rcMeshLoaderObj::load(const std::string& filename)
 			n[2] *= d;
 		}
 	}
-	
+
 	m_filename = filename;
 	return true;
 }
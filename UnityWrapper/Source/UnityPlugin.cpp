@@ -1,7 +1,11 @@
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 // RecastNavigation includes
 #include "Recast.h"
@@ -64,6 +68,33 @@ void CleanupLibrary()
 }
 #endif
 
+// Build context that runs the task sets of the build on all hardware threads.
+class ThreadedBuildContext : public rcContext
+{
+protected:
+    void doRunTasks(rcTaskSet& tasks, const int taskCount) override
+    {
+        const int threadCount = std::min((int)std::thread::hardware_concurrency(), taskCount);
+        if (threadCount <= 1)
+        {
+            rcContext::doRunTasks(tasks, taskCount);
+            return;
+        }
+
+        std::atomic<int> next(0);
+        auto worker = [&]() {
+            for (int i = next++; i < taskCount; i = next++)
+                tasks.runTask(i);
+        };
+        std::vector<std::thread> threads;
+        for (int t = 1; t < threadCount; ++t)
+            threads.emplace_back(worker);
+        worker();
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+};
+
 extern "C" {
 
 // NavMesh file format structures (from RecastDemo)
@@ -110,7 +141,7 @@ EXPORT_API bool GenerateNavMeshFromObj(
         LogHelper::LogPrintf("UnityWrapper Starting NavMesh generation from: %s\n", objFilePath);
         
         // Create build context
-        rcContext ctx;
+        ThreadedBuildContext ctx;
         
         // Load input geometry
         InputGeom geom;